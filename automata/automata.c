@@ -5,21 +5,9 @@ uint32_t pbdrv_clock_get_ms(void);
 
 void pb_color_map_rgb_to_hsv(const pbio_color_rgb_t *rgb, pbio_color_hsv_t *hsv);
 
-// implemented:
-void do_events(void) {
-    int count = process_run();
-    while (count > 0) {
-        count = process_run();
-    }
-}
-
-void delay(int milliseconds) {
-    uint32_t arrived_at = pbdrv_clock_get_ms();
-    while (arrived_at + milliseconds > pbdrv_clock_get_ms()) {
-        do_events();
-    }
-}
+void pb_event_poll_hook_leave(void);
 
+// implemented:
 bool end() {
     if (pbsys_status_test(PBIO_PYBRICKS_STATUS_POWER_BUTTON_PRESSED)
         || pbsys_status_test(PBIO_PYBRICKS_STATUS_SHUTDOWN_REQUEST)
@@ -33,537 +21,301 @@ bool end() {
 
 int debug_mode = 0;
 
-int start_automata(void) {
-    pbio_error_t err = PBIO_SUCCESS;
-    parameters[0] = &err;
-    do_events();
-
-    while (!end()) {
-        delay(200);
-        uint8_t data[10];
-        uint32_t size = 10;
-        pbsys_bluetooth_rx(data, &size);
-        if (size > 0) {
-            char message[size + 1];
-            strcpy(message, (char *) data);
-            message[1] = '\0';
-            parameters[10] = message;
-            print_message();
-            switch (message[0]) {
-                case '0':
-                    parameters[10] = "Starting follow automata...";
-                    print_message();
-                    follow();
-                    break;
-                case '1':
-                    parameters[10] = "Starting discover automata...";
-                    print_message();
-                    discover();
-                    break;
-                case '2':
-                    parameters[10] = "Starting tilt automata...";
-                    print_message();
-                    tilt();
-                    break;
-                case 'd':
-                    if (debug_mode == 0) {
-                        parameters[10] = "Debug mode on.";
-                        debug_mode++;
-                    } else if (debug_mode == 1) {
-                        parameters[10] = "Debug mode off.";
-                        debug_mode--;
-                    }
-                    print_message();
-                    break;
-                default:
-                    parameters[10] = "Unspecified code...";
-                    print_message();
-            }
-        }
-    }
-
-    return 0;
-}
+PROCESS(automata_process, "automata");
 
 /**
- * states:<br>
- * 0 => middle<br>
- * 1 => right<br>
- * -1 => left<br>
- * 2 => up<br>
- * -2 => down
+ * Event posted to automata_process for each byte received on stdin. Data is the byte.
  */
-void tilt() {
-    /**
-     * 0 => middle<br>
-     * 1 => right<br>
-     * -1 => left<br>
-     * 2 => up<br>
-     * -2 => down
-     */
-    int state = 0;
-    int32_t x = 2;
-    int32_t y = 2;
-    int32_t bright = 100;
-    uint32_t last_print = 0;
-    parameters[3] = pbsys_hub_light_matrix;
-    matrix_clear();
-    if (end()) {
-        parameters[10] = "Exit tilt because matrix_clear: ";
-        print_error();
-        return;
-    }
-    do_events();
-
-    parameters[4] = &x;
-    parameters[5] = &y;
-    parameters[6] = &bright;
-    matrix_set_pixel();
-    if (end()) {
-        parameters[10] = "Exit tilt because matrix_set_pixel: ";
-        print_error();
-        return;
-    }
-    do_events();
+static process_event_t automata_event_command;
 
-    gyro_init();
-    if (end()) {
-        parameters[10] = "Exit tilt because gyro_init: ";
-        print_error();
-        return;
-    }
-    bool ready = false;
-    parameters[1] = &ready;
-    gyro_is_ready();
-    if (!ready || end()) {
-        parameters[10] = "Exit tilt because gyro_init: ";
-        print_error();
-        return;
-    }
+/**
+ * Error which ended automata process, parameters_0 points to it.
+ */
+static pbio_error_t exit_code;
 
-//    uint8_t index = 15;
-//    int8_t sign = 7;
-//    pbio_geometry_side_get_axis(PBIO_GEOMETRY_SIDE_FRONT, &index, &sign);
-//    gyro_is_ready();
-//    parameters[10] = "imu ";
-//    parameters[11] = (bool *) parameters[1];
-//    print_value();
-//    parameters[10] = "index ";
-//    parameters[11] = &index;
-//    print_value();
-//    parameters[10] = "sign ";
-//    parameters[11] = &sign;
-//    print_value();
+/**
+ * Automaton uploaded as user program, NULL if there is none.
+ */
+static const automata_table_t *uploaded_table;
 
-    while (!end()) {
-        do_events();
-
-        float angle_x = 0.0;
-        pbio_geometry_xyz_t geo;
-        geo.x = 1;
-        geo.y = 0;
-        geo.z = 0;
-        parameters[1] = &angle_x;
-        parameters[3] = &geo;
-        gyro_get_axis_rotation();
-        angle_x = *(float *) parameters[1];
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
-
-        float angle_y = 0.0;
-        geo.x = 0;
-        geo.y = 1;
-        geo.z = 0;
-        parameters[1] = &angle_y;
-        gyro_get_axis_rotation();
-        angle_y = *(float *) parameters[1];
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
-
-        float angle_z = 0.0;
-        geo.x = 0;
-        geo.y = 0;
-        geo.z = 1;
-        parameters[1] = &angle_z;
-        gyro_get_axis_rotation();
-        angle_z = *(float *) parameters[1];
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
-
-        if (debug_mode == 1 && pbdrv_clock_get_ms() - last_print > 200) {
-            parameters[10] = "Angle X: ";
-            parameters[11] = &angle_x;
-            print_float();
-            parameters[10] = "Angle Y: ";
-            parameters[11] = &angle_y;
-            print_float();
-            parameters[10] = "Angle Z: ";
-            parameters[11] = &angle_z;
-            print_float();
-            parameters[10] = "State: ";
-            parameters[11] = &state;
-            print_value();
-            last_print = pbdrv_clock_get_ms();
-        }
+bool automata_stdin_event(uint8_t c) {
+    process_post(&automata_process, automata_event_command, (process_data_t) (uintptr_t) c);
+    return true;
+}
 
-        parameters[3] = pbsys_hub_light_matrix;
-        parameters[4] = &x;
-        parameters[5] = &y;
-        parameters[6] = &bright;
-
-        if (state == 0) {
-            if (angle_y >= 35.0) {
-                state = 1;
-                matrix_clear();
-                x = 0;
-                matrix_set_pixel();
-            } else if (angle_y <= -35.0) {
-                state = -1;
-                matrix_clear();
-                x = 4;
-                matrix_set_pixel();
-            } else if (angle_x >= 35.0) {
-                state = 2;
-                matrix_clear();
-                y = 4;
-                matrix_set_pixel();
-            } else if (angle_x<= -35.0) {
-                state = -2;
-                matrix_clear();
-                y = 0;
-                matrix_set_pixel();
-            }
-        } else {
-            if (angle_x > -25.0 && angle_x < 25.0 &&
-                angle_y > -25.0 && angle_y < 25.0)
-                state = 0;
-        }
+static void print_start(const automata_table_t *table) {
+    char message[64];
+    strcpy(message, "Starting ");
+    strncat(message, table->name, sizeof(message) - sizeof("Starting  automata..."));
+    strcat(message, " automata...");
+    parameters[10] = message;
+    print_message();
+}
 
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
+static void start_table(const automata_table_t *table) {
+    print_start(table);
+    pbio_error_t err = automata_scheduler_start(table, NULL);
+    if (err == PBIO_ERROR_BUSY) {
+        parameters[10] = "Can not start automata, it or its ports are in use.";
+        print_message();
+    } else if (err != PBIO_SUCCESS) {
+        parameters[10] = "Can not start automata.";
+        print_message();
     }
+}
 
-    parameters[10] = "Ending tilt automata with exit code ";
-    print_error();
-    parameters[3] = pbsys_hub_light_matrix;
-    matrix_clear();
+static void print_timing(const char *name, const pbio_motor_process_timing_t *timing, uint32_t count) {
+    automata_print("%s [us]: min %lu avg %lu max %lu\r\n", name, (unsigned long) timing->min,
+        (unsigned long) (count ? timing->total / count : 0), (unsigned long) timing->max);
 }
 
-void discover() {
-    pbdrv_legodev_dev_t *legodev_ultra;
-    pbdrv_legodev_dev_t *legodev_color;
-    pbio_servo_t *srv1;
-    pbio_servo_t *srv2;
-    pbio_drivebase_t *base;
-    pbio_port_id_t port;
-    pbio_direction_t direction;
-
-    port = PBIO_PORT_ID_B;
-    parameters[3] = &port;
-    get_medium_motor();
-    srv1 = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit discover because srv1: ";
-        print_error();
+/**
+ * Print how much of the motor control loop period is used. The histogram
+ * counts whole updates in steps of a tenth of the period.
+ */
+static void print_control_stats(void) {
+    _Static_assert(PBIO_MOTOR_PROCESS_NUM_BINS == 11, "histogram is printed with 11 values");
+    const pbio_motor_process_stats_t *stats = pbio_motor_process_get_stats();
+    if (!stats) {
         return;
     }
-    do_events();
-
-    port = PBIO_PORT_ID_D;
-    parameters[3] = &port;
-    get_medium_motor();
-    srv2 = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit discover because srv2: ";
-        print_error();
+    automata_print("Control loops: %lu, period %lu ms\r\n", (unsigned long) stats->count, (unsigned long) pbio_control_settings_get_loop_time());
+    print_timing("Battery", &stats->battery, stats->count);
+    print_timing("Drive base", &stats->drivebase, stats->count);
+    print_timing("Servo", &stats->servo, stats->count);
+    print_timing("Total", &stats->total, stats->count);
+    automata_print("Overruns: %lu, missed: %lu\r\n", (unsigned long) stats->overruns, (unsigned long) stats->missed);
+    automata_print("Jitter [us]: avg %lu max %lu\r\n",
+        (unsigned long) (stats->count > 1 ? stats->jitter_total / (stats->count - 1) : 0), (unsigned long) stats->jitter_max);
+
+    const uint32_t *bins = stats->total.histogram;
+    automata_print("Histogram: %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu\r\n",
+        (unsigned long) bins[0], (unsigned long) bins[1], (unsigned long) bins[2], (unsigned long) bins[3],
+        (unsigned long) bins[4], (unsigned long) bins[5], (unsigned long) bins[6], (unsigned long) bins[7],
+        (unsigned long) bins[8], (unsigned long) bins[9], (unsigned long) bins[10]);
+
+    pbio_motor_process_reset_stats();
+}
+
+/**
+ * Print how much of the time between IMU samples the frame handler uses,
+ * measured by the driver, and reset it.
+ */
+static void print_imu_stats(void) {
+    #if PBDRV_CONFIG_IMU
+    pbdrv_imu_dev_t *imu_dev;
+    pbdrv_imu_config_t *imu_config;
+    if (pbdrv_imu_get_imu(&imu_dev, &imu_config) != PBIO_SUCCESS) {
         return;
     }
-    do_events();
-
-    direction = PBIO_DIRECTION_CLOCKWISE;
-    parameters[3] = srv1;
-    parameters[4] = &direction;
-    motor_medium_setup();
-    if (end()) {
-        parameters[10] = "Exit discover because setup srv1: ";
-        print_error();
+    pbdrv_imu_handler_stats_t stats;
+    pbdrv_imu_get_handler_stats(imu_dev, &stats);
+    float cycles_per_frame = stats.frames ? (float) stats.cycles / stats.frames : 0.0f;
+    automata_print("IMU frames: %lu, handler [us]: avg %.2f max %.2f, budget %.0f\r\n", (unsigned long) stats.frames,
+        (double) (cycles_per_frame / stats.cycles_per_us), (double) ((float) stats.max_frame_cycles / stats.cycles_per_us),
+        (double) (imu_config->sample_time * 1000000.0f));
+
+    pbdrv_imu_reset_handler_stats(imu_dev);
+    #endif
+}
+
+/**
+ * Switch control loop to the next available loop time, so that automata can
+ * be compared at each of them. Motors must not be controlled meanwhile.
+ */
+static void next_loop_time(void) {
+    uint32_t ms = pbio_control_settings_get_loop_time();
+    do {
+        ms = ms % 100 + 1;
+    } while (!PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(ms));
+
+    pbio_error_t err = pbio_motor_process_set_loop_time(ms);
+    if (err == PBIO_ERROR_BUSY) {
+        automata_print("Can not change control loop while motors run.\r\n");
         return;
     }
-    do_events();
-
-    direction = PBIO_DIRECTION_COUNTERCLOCKWISE;
-    parameters[3] = srv2;
-    parameters[4] = &direction;
-    motor_medium_setup();
-    if (end()) {
-        parameters[10] = "Exit discover because setup srv2: ";
-        print_error();
+    if (err != PBIO_SUCCESS) {
+        automata_print("Err set_loop_time: %d\r\n", err);
         return;
     }
-    do_events();
-
-    parameters[4] = srv1;
-    parameters[5] = srv2;
-    get_base();
-    base = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit discover because base: ";
-        print_error();
-    }
-    do_events();
-
-    port = PBIO_PORT_ID_C;
-    parameters[3] = &port;
-    parameters[1] = legodev_ultra;
-    get_distance_sensor();
-    legodev_ultra = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit discover because legodev_ultra: ";
-        print_error();
-        return;
+    automata_print("Control loop period %lu ms\r\n", (unsigned long) ms);
+}
+
+/**
+ * Handle one command byte.<br>
+ * digit => start automaton with this index next to the running ones<br>
+ * s => stop all automata<br>
+ * u => start uploaded automaton<br>
+ * p => print statistics of running automata<br>
+ * c => print statistics of motor control loop and IMU and reset them<br>
+ * t => toggle binary telemetry<br>
+ * r => print recorded transitions<br>
+ * d => toggle debug mode<br>
+ * l => switch control loop to the next available loop time
+ */
+static void handle_command(char command) {
+    char message[2] = {command, '\0'};
+    parameters[10] = message;
+    print_message();
+
+    switch (command) {
+        case 'd':
+            if (debug_mode == 0) {
+                parameters[10] = "Debug mode on.";
+                debug_mode++;
+            } else if (debug_mode == 1) {
+                parameters[10] = "Debug mode off.";
+                debug_mode--;
+            }
+            print_message();
+            break;
+        case 's':
+            automata_scheduler_stop_all();
+            break;
+        case 'p':
+            automata_scheduler_print_stats();
+            automata_print("Dropped lines: %lu\r\n", (unsigned long) automata_print_get_dropped());
+            automata_print("Dropped frames: %lu\r\n", (unsigned long) automata_telemetry_get_dropped());
+            break;
+        case 'c':
+            print_control_stats();
+            print_imu_stats();
+            break;
+        case 'l':
+            next_loop_time();
+            break;
+        case 'r':
+            automata_trace_dump_start();
+            break;
+        case 't':
+            automata_telemetry_enable(!automata_telemetry_is_enabled());
+            parameters[10] = automata_telemetry_is_enabled() ? "Telemetry on." : "Telemetry off.";
+            print_message();
+            break;
+        case 'u':
+            if (!uploaded_table) {
+                parameters[10] = "No automata uploaded.";
+                print_message();
+                break;
+            }
+            start_table(uploaded_table);
+            break;
+        default:
+            if (command >= '0' && command < '0' + automata_num_tables) {
+                start_table(automata_tables[command - '0']);
+                break;
+            }
+            parameters[10] = "Unspecified code...";
+            print_message();
     }
-    do_events();
-
-    port = PBIO_PORT_ID_F;
-    parameters[3] = &port;
-    parameters[1] = legodev_color;
-    get_color_sensor();
-    legodev_color = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit discover because legodev_color: ";
-        print_error();
-        return;
+}
+
+/**
+ * Handles commands and runs scheduler of automata. Timer is set to
+ * the nearest deadline of running automata, so between ticks and
+ * commands the hub can sleep. Sensor data events tick automata which
+ * read the sensor right away instead.
+ */
+PROCESS_THREAD(automata_process, ev, data) {
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    if (uploaded_table) {
+        start_table(uploaded_table);
     }
-    do_events();
-
-    /**
-     * 1 = run<br>
-     * 2 = stop<br>
-     * 3 = start_turn<br>
-     * 4 = end_turn<br>
-     */
-    int state = 4;
-    int32_t radius = 0;
-    int32_t speed = -200;
-    int32_t angle = 0;
-    uint32_t last_print = 0;
 
     while (!end()) {
-        do_events();
-
-        parameters[3] = legodev_ultra;
-        get_low_distance_data();
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
-        int distance = *(int16_t *) parameters[1];
-        if (distance < 0) distance = 2000;
-
-        parameters[3] = legodev_color;
-        get_color_data();
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
-        int color = *(int8_t *) parameters[1];
-
-        if (debug_mode == 1 && pbdrv_clock_get_ms() - last_print > 200) {
-            parameters[10] = "Distance: ";
-            parameters[11] = &distance;
-            print_value();
-            parameters[10] = "Color: ";
-            parameters[11] = &color;
-            print_value();
-            parameters[10] = "State: ";
-            parameters[11] = &state;
-            print_value();
-            last_print = pbdrv_clock_get_ms();
+        if (ev == automata_event_command) {
+            handle_command((uintptr_t) data);
+        }
+        if (ev == PBIO_EVENT_LEGODEV_DATA) {
+            automata_scheduler_wake(pbdrv_clock_get_ms(), data);
         }
 
-        parameters[3] = base;
-
-        if (state == 1) {
-            if (distance < 140) {
-                base_stop();
-                state = 2;
-            }
-        } else if (state == 2) {
-            if (color == -1) continue;
-            parameters[4] = &radius;
-            if (color == 0) angle = 300; //black
-            if (color == 10) angle = 150; //white
-            if (color == 7) angle = -150; //yellow
-            if (color == 3) angle = -300; //blue
-            if (color == 5) angle = -450; //turquoise
-            if (color == 9) angle = 450; //red
-            parameters[5] = &angle;
-            base_run_angle();
-            state = 3;
-        } else if (state == 3) {
-            bool done = false;
-            parameters[1] = &done;
-            base_is_done();
-            if (done) {
-                state = 4;
-            }
-        } else if (state == 4) {
-            if (distance > 150) {
-                angle = 0;
-                parameters[4] = &speed;
-                parameters[5] = &angle;
-                base_run_forever();
-                state = 1;
-            } else {
-                state = 2;
-            }
+        uint32_t wait = UINT32_MAX;
+        if (automata_scheduler_is_running()) {
+            wait = automata_scheduler_run(pbdrv_clock_get_ms());
+        }
+        if (automata_trace_dump_continue() && wait > AUTOMATA_TRACE_DUMP_WAIT_MS) {
+            wait = AUTOMATA_TRACE_DUMP_WAIT_MS;
+        }
+        if (automata_telemetry_is_enabled() && automata_telemetry_flush() && wait > AUTOMATA_TELEMETRY_FLUSH_WAIT_MS) {
+            wait = AUTOMATA_TELEMETRY_FLUSH_WAIT_MS;
         }
 
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
+        if (wait != UINT32_MAX) {
+            // Wait at least 1 ms, so other processes get events too.
+            etimer_set(&timer, wait > 0 ? wait : 1);
+        } else {
+            etimer_stop(&timer);
+        }
 
+        PROCESS_WAIT_EVENT();
     }
-    parameters[10] = "Ending discover automata with exit code ";
-    print_error();
-    parameters[3] = base;
-    base_stop();
+
+    automata_scheduler_stop_all();
+
+    PROCESS_END();
 }
 
 /**
- * states:<br>
- * -1 => back<br>
- * 0 => stop<br>
- * 1 => forward
+ * Load automaton from the uploaded user program, if the program is automaton bytecode.
  */
-void follow() {
-    pbdrv_legodev_dev_t *legodev_ultra;
-    pbio_servo_t *srv1;
-    pbio_servo_t *srv2;
-    pbio_drivebase_t *base;
-    pbio_port_id_t port;
-    pbio_direction_t direction;
-
-    port = PBIO_PORT_ID_B;
-    parameters[3] = &port;
-    get_medium_motor();
-    srv1 = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit follow because srv1: ";
-        print_error();
-        return;
-    }
-    do_events();
-
-    port = PBIO_PORT_ID_D;
-    parameters[3] = &port;
-    get_medium_motor();
-    srv2 = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit follow because srv2: ";
-        print_error();
-        return;
-    }
-    do_events();
-
-    direction = PBIO_DIRECTION_CLOCKWISE;
-    parameters[3] = srv1;
-    parameters[4] = &direction;
-    motor_medium_setup();
-    if (end()) {
-        parameters[10] = "Exit follow because setup srv1: ";
-        print_error();
-        return;
-    }
-    do_events();
-
-    direction = PBIO_DIRECTION_COUNTERCLOCKWISE;
-    parameters[3] = srv2;
-    parameters[4] = &direction;
-    motor_medium_setup();
-    if (end()) {
-        parameters[10] = "Exit follow because setup srv2: ";
-        print_error();
+static void load_uploaded_table(const pbsys_main_program_t *program) {
+    const uint8_t *data = program->code_start;
+    uint32_t size = (const uint8_t *) program->code_end - data;
+
+    uploaded_table = NULL;
+    if (program->run_builtin || !automata_bytecode_is_automaton(data, size)) {
         return;
     }
-    do_events();
-
-    parameters[4] = srv1;
-    parameters[5] = srv2;
-    get_base();
-    base = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit follow because base: ";
-        print_error();
-    }
-    do_events();
-
-    port = PBIO_PORT_ID_C;
-    parameters[3] = &port;
-    parameters[1] = legodev_ultra;
-    get_distance_sensor();
-    legodev_ultra = parameters[1];
-    if (end()) {
-        parameters[10] = "Exit follow because legodev_ultra: ";
-        print_error();
-        return;
+
+    pbio_error_t err = automata_bytecode_load(data, size, &uploaded_table);
+    if (err != PBIO_SUCCESS) {
+        long code = err;
+        parameters[10] = "Err bytecode_load: ";
+        parameters[11] = &code;
+        print_value();
+        uploaded_table = NULL;
     }
-    do_events();
-
-    /**
-     * -1 => back<br>
-     * 0 => stop<br>
-     * 1 => forward
-     */
-    int state = 0;
-    int32_t speed = 250;
-    int32_t angle = 0;
-    uint32_t last_print = 0;
+}
 
-    while (!end()) {
-        do_events();
-
-        parameters[3] = legodev_ultra;
-        get_low_distance_data();
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
-        int distance = *(int16_t *) parameters[1];
-        if (distance < 0) distance = 2000;
-
-        if (debug_mode == 1 && pbdrv_clock_get_ms() - last_print > 200) {
-            parameters[10] = "Distance: ";
-            parameters[11] = &distance;
-            print_value();
-            parameters[10] = "State: ";
-            parameters[11] = &state;
-            print_value();
-            last_print = pbdrv_clock_get_ms();
-        }
+int start_automata(const pbsys_main_program_t *program) {
+    exit_code = PBIO_SUCCESS;
+    parameters[0] = &exit_code;
 
-        parameters[3] = base;
-        parameters[4] = &speed;
-        parameters[5] = &angle;
+    load_uploaded_table(program);
 
-        if (state == -1) {
-            if (distance > 150) {
-                base_stop();
-                state = 0;
-            }
-        } else if (state == 1) {
-            if (distance < 300) {
-                base_stop();
-                state = 0;
-            }
-        } else if (state == 0) {
-            if (distance < 140) {
-                if (speed < 0) speed *= -1;
-                base_run_forever();
-                state = -1;
-            } else if (distance > 310) {
-                if (speed > 0) speed *= -1;
-                base_run_forever();
-                state = 1;
-            }
+    automata_event_command = process_alloc_event();
+    pbsys_bluetooth_rx_set_callback(automata_stdin_event);
+    process_start(&automata_process);
+
+    // Everything runs in contiki processes. When there are no pending
+    // events, hub sleeps until next interrupt (timer, Bluetooth, sensors).
+    while (process_is_running(&automata_process)) {
+        if (!pbio_do_one_event()) {
+            pb_event_poll_hook_leave();
         }
+    }
 
-        if (*(pbio_error_t *) parameters[0] != PBIO_SUCCESS) break;
+    // Last lines, e.g. exit codes of automata, are still sent if Bluetooth
+    // keeps up, then printing stops before the next program runs.
+    uint32_t stop_time = pbdrv_clock_get_ms();
+    while (automata_print_get_free() < AUTOMATA_PRINT_BUFFER_SIZE
+           && pbdrv_clock_get_ms() - stop_time < AUTOMATA_PRINT_STOP_TIMEOUT_MS) {
+        if (!pbio_do_one_event()) {
+            pb_event_poll_hook_leave();
+        }
     }
+    automata_print_stop();
 
-    parameters[10] = "Ending follow automata with exit code ";
-    print_error();
-    parameters[3] = base;
-    base_stop();
+    if (exit_code == PBIO_SUCCESS) {
+        exit_code = automata_scheduler_get_last_error();
+    }
+    return exit_code;
 }
 
-//JSON parser: https://zserge.com/jsmn/
-
 //pointer to function example:
 //    #include <stdio.h>
 //
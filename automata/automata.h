@@ -7,7 +7,12 @@
 #include <contiki.h>
 #include <lib/memb.h>
 
+#include <pbio/event.h>
+#include <pbio/main.h>
+#include <pbio/motor_process.h>
+
 #include <pbdrv/counter.h>
+#include <pbdrv/imu.h>
 #include <pbdrv/legodev.h>
 #include <pbdrv/sound.h>
 
@@ -22,6 +27,7 @@
 #include <pbio/protocol.h>
 
 #include <pbsys/light.h>
+#include <pbsys/main.h>
 #include <pbsys/status.h>
 
 #include "print.h"
@@ -29,15 +35,37 @@
 #include "motor.h"
 #include "modules.h"
 #include "parameters.h"
+#include "engine.h"
+#include "tables.h"
+#include "scheduler.h"
+#include "snapshot.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "bytecode.h"
 
-void do_events(void);
-
-void delay(int milliseconds);
+/**
+ * 1 if values of inputs and state are printed while automaton runs.
+ */
+extern int debug_mode;
 
-int start_automata(void);
+/**
+ * Default period of automaton ticks [ms].
+ */
+#define AUTOMATA_TICK_MS (10)
 
-void follow();
+/**
+ * Automaton should end because of error, shutdown or power button.
+ */
+bool end();
 
-void discover();
+/**
+ * Stdin callback, every received byte is posted as command to automata process.
+ */
+bool automata_stdin_event(uint8_t c);
 
-void tilt();
\ No newline at end of file
+/**
+ * Run automata process until shutdown or error. If the user program
+ * is automaton bytecode, the uploaded automaton is started at once.
+ * <br><br> Returns error which ended the last automaton.
+ */
+int start_automata(const pbsys_main_program_t *program);
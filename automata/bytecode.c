@@ -0,0 +1,201 @@
+#include <pbio/util.h>
+
+#include "automata.h"
+
+#define STATE_SIZE (2)
+#define TRANSITION_SIZE (5)
+#define GUARD_SIZE (4)
+#define ACTION_SIZE (7)
+#define CRC_SIZE (4)
+
+static automata_state_t states[AUTOMATA_BYTECODE_MAX_STATES];
+static automata_transition_t transitions[AUTOMATA_BYTECODE_MAX_TRANSITIONS];
+static automata_guard_t guards[AUTOMATA_BYTECODE_MAX_GUARDS];
+static automata_action_t actions[AUTOMATA_BYTECODE_MAX_ACTIONS];
+
+static automata_table_t uploaded_table = {
+    .name = "uploaded",
+    .states = states,
+    .transitions = transitions,
+    .guards = guards,
+    .actions = actions,
+};
+
+static uint32_t crc32(const uint8_t *data, uint32_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static bool range_is_valid(automata_range_t range, uint8_t size) {
+    return range.first + range.count <= size;
+}
+
+static automata_range_t get_range(const uint8_t *data) {
+    automata_range_t range = {data[0], data[1]};
+    return range;
+}
+
+/**
+ * Devices which must be set up to read the input.
+ */
+static uint8_t input_devices(uint8_t input) {
+    switch (input) {
+        case AUTOMATA_INPUT_DISTANCE:
+            return AUTOMATA_DEVICE_ULTRASONIC;
+        case AUTOMATA_INPUT_COLOR:
+            return AUTOMATA_DEVICE_COLOR;
+        case AUTOMATA_INPUT_ANGLE_X:
+        case AUTOMATA_INPUT_ANGLE_Y:
+        case AUTOMATA_INPUT_ANGLE_Z:
+            return AUTOMATA_DEVICE_IMU;
+        default:
+            return AUTOMATA_DEVICE_BASE;
+    }
+}
+
+/**
+ * Devices which must be set up to call the action.
+ */
+static uint8_t action_devices(uint8_t code) {
+    switch (code) {
+        case AUTOMATA_ACTION_BASE_STOP:
+        case AUTOMATA_ACTION_BASE_RUN_FOREVER:
+        case AUTOMATA_ACTION_BASE_RUN_ANGLE:
+            return AUTOMATA_DEVICE_BASE;
+        default:
+            return 0;
+    }
+}
+
+static pbio_error_t load_header(const uint8_t *data) {
+    automata_table_t *table = &uploaded_table;
+
+    if (data[4] != AUTOMATA_BYTECODE_VERSION) {
+        return PBIO_ERROR_NOT_SUPPORTED;
+    }
+
+    table->num_states = data[5];
+    table->initial_state = data[9];
+    table->priority = data[10];
+    table->devices = data[11];
+    table->period = pbio_get_uint16_le(&data[12]);
+    table->inputs = pbio_get_uint16_le(&data[14]);
+    table->ports.left_motor = data[16];
+    table->ports.left_direction = data[17];
+    table->ports.right_motor = data[18];
+    table->ports.right_direction = data[19];
+    table->ports.ultrasonic = data[20];
+    table->ports.color = data[21];
+    table->start = get_range(&data[22]);
+    table->exit = get_range(&data[24]);
+
+    if (table->num_states == 0 || table->initial_state >= table->num_states) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+        if ((table->inputs & AUTOMATA_INPUT_MASK(i)) && !(table->devices & input_devices(i))) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+    if (table->inputs >> AUTOMATA_NUM_INPUTS) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t automata_bytecode_load(const uint8_t *data, uint32_t size, const automata_table_t **table) {
+    if (!automata_bytecode_is_automaton(data, size) || size < AUTOMATA_BYTECODE_HEADER_SIZE + CRC_SIZE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    uint8_t num_states = data[5];
+    uint8_t num_transitions = data[6];
+    uint8_t num_guards = data[7];
+    uint8_t num_actions = data[8];
+    if (num_states > AUTOMATA_BYTECODE_MAX_STATES
+        || num_transitions > AUTOMATA_BYTECODE_MAX_TRANSITIONS
+        || num_guards > AUTOMATA_BYTECODE_MAX_GUARDS
+        || num_actions > AUTOMATA_BYTECODE_MAX_ACTIONS) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    uint32_t expected_size = AUTOMATA_BYTECODE_HEADER_SIZE
+        + num_states * STATE_SIZE
+        + num_transitions * TRANSITION_SIZE
+        + num_guards * GUARD_SIZE
+        + num_actions * ACTION_SIZE
+        + CRC_SIZE;
+    if (size != expected_size) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    if (crc32(data, size - CRC_SIZE) != pbio_get_uint32_le(&data[size - CRC_SIZE])) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    pbio_error_t err = load_header(data);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    const uint8_t *record = data + AUTOMATA_BYTECODE_HEADER_SIZE;
+
+    for (uint8_t i = 0; i < num_states; i++, record += STATE_SIZE) {
+        states[i].name = NULL;
+        states[i].transitions = get_range(record);
+        if (!range_is_valid(states[i].transitions, num_transitions)) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+
+    for (uint8_t i = 0; i < num_transitions; i++, record += TRANSITION_SIZE) {
+        transitions[i].guards = get_range(&record[0]);
+        transitions[i].actions = get_range(&record[2]);
+        transitions[i].target = record[4];
+        if (!range_is_valid(transitions[i].guards, num_guards)
+            || !range_is_valid(transitions[i].actions, num_actions)
+            || transitions[i].target >= num_states) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+
+    for (uint8_t i = 0; i < num_guards; i++, record += GUARD_SIZE) {
+        guards[i].input = record[0];
+        guards[i].op = record[1];
+        guards[i].value = (int16_t) pbio_get_uint16_le(&record[2]);
+        // Always true guard does not read its input.
+        if (guards[i].op > AUTOMATA_OP_CHANGED
+            || guards[i].input >= AUTOMATA_NUM_INPUTS
+            || (guards[i].op != AUTOMATA_OP_ALWAYS && !(uploaded_table.inputs & AUTOMATA_INPUT_MASK(guards[i].input)))) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+
+    for (uint8_t i = 0; i < num_actions; i++, record += ACTION_SIZE) {
+        actions[i].code = record[0];
+        for (uint8_t j = 0; j < PBIO_ARRAY_SIZE(actions[i].args); j++) {
+            actions[i].args[j] = (int16_t) pbio_get_uint16_le(&record[1 + 2 * j]);
+        }
+        if (actions[i].code >= AUTOMATA_NUM_ACTIONS
+            || (action_devices(actions[i].code) & ~uploaded_table.devices)) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+
+    if (!range_is_valid(uploaded_table.start, num_actions) || !range_is_valid(uploaded_table.exit, num_actions)) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    *table = &uploaded_table;
+    return PBIO_SUCCESS;
+}
+
+bool automata_bytecode_is_automaton(const uint8_t *data, uint32_t size) {
+    return size >= sizeof(AUTOMATA_BYTECODE_MAGIC) - 1
+           && memcmp(data, AUTOMATA_BYTECODE_MAGIC, sizeof(AUTOMATA_BYTECODE_MAGIC) - 1) == 0;
+}
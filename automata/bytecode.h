@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <pbio/error.h>
+
+#include "engine.h"
+
+/**
+ * Bytecode of an automaton uploaded over Bluetooth as user program.
+ * All numbers are little endian.
+ * <br><br> Header (28 bytes):<br>
+ * 0 => magic "AUTB"<br>
+ * 4 => version (AUTOMATA_BYTECODE_VERSION)<br>
+ * 5 => number of states, transitions, guards and actions (1 byte each)<br>
+ * 9 => initial state, priority, devices (1 byte each)<br>
+ * 12 => period [ms] (2 bytes), inputs mask (2 bytes)<br>
+ * 16 => ports: left motor, left direction, right motor, right direction, ultrasonic, color (1 byte each)<br>
+ * 22 => start actions first, count, exit actions first, count (1 byte each)<br>
+ * 26 => reserved (2 bytes)
+ * <br><br> Then records follow in this order:<br>
+ * state => transitions first, count (2 bytes)<br>
+ * transition => guards first, count, actions first, count, target (5 bytes)<br>
+ * guard => input, op, value (int16) (4 bytes)<br>
+ * action => code, 3 args (int16) (7 bytes)
+ * <br><br> Last 4 bytes are CRC-32 (same as zlib.crc32) of everything before them.
+ */
+#define AUTOMATA_BYTECODE_MAGIC "AUTB"
+
+#define AUTOMATA_BYTECODE_VERSION (1)
+
+#define AUTOMATA_BYTECODE_HEADER_SIZE (28)
+
+#define AUTOMATA_BYTECODE_MAX_STATES (32)
+#define AUTOMATA_BYTECODE_MAX_TRANSITIONS (64)
+#define AUTOMATA_BYTECODE_MAX_GUARDS (64)
+#define AUTOMATA_BYTECODE_MAX_ACTIONS (64)
+
+/**
+ * Data starts with bytecode magic, so it is meant to be an automaton.
+ */
+bool automata_bytecode_is_automaton(const uint8_t *data, uint32_t size);
+
+/**
+ * Check the bytecode and decode it to the table of uploaded automaton.
+ * Table must not be running, because its arrays are overwritten.
+ * <br><br> Returns PBIO_ERROR_INVALID_ARG if bytecode is damaged or describes
+ * automaton which can not run (out of range index, unknown opcode,
+ * device missing for input or action).
+ * PBIO_ERROR_NOT_SUPPORTED if bytecode has other version.
+ */
+pbio_error_t automata_bytecode_load(const uint8_t *data, uint32_t size, const automata_table_t **table);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <pbio/error.h>
+
+/**
+ * Context of one running automaton.
+ * Typed calls report errors through their return value and keep the first
+ * failure here, so each instance can check its own state once per tick.
+ */
+typedef struct {
+    /** First error returned by a call, PBIO_SUCCESS if none. */
+    pbio_error_t err;
+    /** Message describing the call which failed, e.g. "Err motor_stop: ". */
+    const char *err_message;
+} automata_ctx_t;
+
+#define AUTOMATA_CTX_INIT { .err = PBIO_SUCCESS, .err_message = NULL }
+
+/**
+ * Record error of a call into context.
+ * <br><br> Returns @p err, so it can be used directly as return value of typed calls.
+ */
+static inline pbio_error_t automata_ctx_check(automata_ctx_t *ctx, pbio_error_t err, const char *message) {
+    if (err != PBIO_SUCCESS && ctx->err == PBIO_SUCCESS) {
+        ctx->err = err;
+        ctx->err_message = message;
+    }
+    return err;
+}
+
+/**
+ * Forget recorded error.
+ */
+static inline void automata_ctx_reset(automata_ctx_t *ctx) {
+    ctx->err = PBIO_SUCCESS;
+    ctx->err_message = NULL;
+}
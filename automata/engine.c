@@ -0,0 +1,510 @@
+#include "automata.h"
+
+static const char *const input_names[AUTOMATA_NUM_INPUTS] = {
+    [AUTOMATA_INPUT_DISTANCE] = "Distance: ",
+    [AUTOMATA_INPUT_COLOR] = "Color: ",
+    [AUTOMATA_INPUT_ANGLE_X] = "Angle X: ",
+    [AUTOMATA_INPUT_ANGLE_Y] = "Angle Y: ",
+    [AUTOMATA_INPUT_ANGLE_Z] = "Angle Z: ",
+    [AUTOMATA_INPUT_BASE_DONE] = "Done: ",
+};
+
+/**
+ * Source of sensor inputs, NULL if they are read from devices.
+ */
+static automata_input_source_t input_source;
+
+void automata_engine_set_input_source(automata_input_source_t source) {
+    input_source = source;
+}
+
+/**
+ * Print message with error code of the engine.
+ */
+static void print_engine_error(const automata_engine_t *engine, const char *message) {
+    long code = engine->ctx.err;
+    parameters[10] = (char *) message;
+    parameters[11] = &code;
+    print_value();
+    if (engine->ctx.err_message) {
+        parameters[10] = (char *) engine->ctx.err_message;
+        parameters[11] = &code;
+        print_value();
+    }
+}
+
+static pbio_error_t setup_motor(automata_engine_t *engine, pbio_port_id_t port, pbio_direction_t direction, pbio_servo_t **srv) {
+    if (automata_motor_get(&engine->ctx, port, PBDRV_LEGODEV_TYPE_ID_SPIKE_M_MOTOR, srv) != PBIO_SUCCESS) {
+        return engine->ctx.err;
+    }
+    return automata_motor_setup(&engine->ctx, *srv, PBDRV_LEGODEV_TYPE_ID_SPIKE_M_MOTOR, direction);
+}
+
+static pbio_error_t setup_devices(automata_engine_t *engine) {
+    const automata_table_t *table = engine->table;
+    automata_ctx_t *ctx = &engine->ctx;
+
+    if (table->devices & AUTOMATA_DEVICE_BASE) {
+        pbio_servo_t *srv1;
+        pbio_servo_t *srv2;
+        if (setup_motor(engine, table->ports.left_motor, table->ports.left_direction, &srv1) != PBIO_SUCCESS
+            || setup_motor(engine, table->ports.right_motor, table->ports.right_direction, &srv2) != PBIO_SUCCESS
+            || automata_base_get(ctx, srv1, srv2, &engine->base) != PBIO_SUCCESS) {
+            return ctx->err;
+        }
+    }
+
+    // Sensors are replaced by input source.
+    if (input_source) {
+        return PBIO_SUCCESS;
+    }
+
+    // Sensors which the table reads wake it when their data changes.
+    if (table->devices & AUTOMATA_DEVICE_ULTRASONIC) {
+        if (automata_sensor_get(ctx, table->ports.ultrasonic, PBDRV_LEGODEV_TYPE_ID_SPIKE_ULTRASONIC_SENSOR, &engine->ultrasonic) != PBIO_SUCCESS) {
+            return ctx->err;
+        }
+        if (table->inputs & AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_DISTANCE)
+            && automata_sensor_notify(ctx, engine->ultrasonic, PBDRV_LEGODEV_MODE_PUP_ULTRASONIC_SENSOR__DISTL, NULL) != PBIO_SUCCESS) {
+            return ctx->err;
+        }
+    }
+
+    if (table->devices & AUTOMATA_DEVICE_COLOR) {
+        if (automata_sensor_get(ctx, table->ports.color, PBDRV_LEGODEV_TYPE_ID_SPIKE_COLOR_SENSOR, &engine->color) != PBIO_SUCCESS) {
+            return ctx->err;
+        }
+        if (table->inputs & AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_COLOR)
+            && automata_sensor_notify(ctx, engine->color, PBDRV_LEGODEV_MODE_PUP_COLOR_SENSOR__COLOR, NULL) != PBIO_SUCCESS) {
+            return ctx->err;
+        }
+    }
+
+    if (table->devices & AUTOMATA_DEVICE_IMU) {
+        #if PBIO_CONFIG_IMU
+        pbio_imu_init();
+        if (!pbio_imu_is_ready()) {
+            return automata_ctx_check(ctx, PBIO_ERROR_FAILED, "Err gyro_init: ");
+        }
+        #else
+        return automata_ctx_check(ctx, PBIO_ERROR_NOT_SUPPORTED, "Err gyro_init: ");
+        #endif
+    }
+
+    return PBIO_SUCCESS;
+}
+
+pbio_light_matrix_t *automata_engine_get_light_matrix(void) {
+    #if PBSYS_CONFIG_HUB_LIGHT_MATRIX
+    return pbsys_hub_light_matrix;
+    #else
+    return NULL;
+    #endif
+}
+
+static pbio_error_t call_action(automata_engine_t *engine, const automata_action_t *action) {
+    automata_ctx_t *ctx = &engine->ctx;
+    const int16_t *args = action->args;
+
+    switch (action->code) {
+        case AUTOMATA_ACTION_BASE_STOP:
+            return automata_base_stop(ctx, engine->base);
+        case AUTOMATA_ACTION_BASE_RUN_FOREVER:
+            return automata_base_run_forever(ctx, engine->base, args[0], args[1]);
+        case AUTOMATA_ACTION_BASE_RUN_ANGLE:
+            return automata_base_run_angle(ctx, engine->base, args[0], args[1]);
+        case AUTOMATA_ACTION_MATRIX_CLEAR:
+            return automata_matrix_clear(ctx, automata_engine_get_light_matrix());
+        case AUTOMATA_ACTION_MATRIX_SET_PIXEL:
+            return automata_matrix_set_pixel(ctx, automata_engine_get_light_matrix(), args[0], args[1], args[2]);
+        default:
+            return automata_ctx_check(ctx, PBIO_ERROR_NOT_SUPPORTED, "Err action: ");
+    }
+}
+
+static pbio_error_t call_actions(automata_engine_t *engine, automata_range_t range) {
+    for (uint8_t i = 0; i < range.count; i++) {
+        pbio_error_t err = call_action(engine, &engine->table->actions[range.first + i]);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+    return PBIO_SUCCESS;
+}
+
+static uint8_t get_parent(const automata_table_t *table, uint8_t state) {
+    return table->parents ? table->parents[state] : AUTOMATA_NO_STATE;
+}
+
+static uint8_t get_first_child(const automata_table_t *table, uint8_t state) {
+    if (!table->parents) {
+        return AUTOMATA_NO_STATE;
+    }
+    for (uint8_t i = 0; i < table->num_states; i++) {
+        if (table->parents[i] == state) {
+            return i;
+        }
+    }
+    return AUTOMATA_NO_STATE;
+}
+
+/**
+ * Check that initial state and parents are states of table and that no
+ * state is nested deeper than AUTOMATA_MAX_DEPTH, which also rules out
+ * cycles of parents.
+ */
+static bool table_is_valid(const automata_table_t *table) {
+    if (table->initial_state >= table->num_states) {
+        return false;
+    }
+    for (uint8_t i = 0; i < table->num_states; i++) {
+        uint8_t depth = 0;
+        for (uint8_t s = i; s != AUTOMATA_NO_STATE; s = get_parent(table, s)) {
+            if (s >= table->num_states || ++depth > AUTOMATA_MAX_DEPTH) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Fill path with top level ancestor of state first and state itself last.
+ * Path has room for AUTOMATA_MAX_DEPTH states, see table_is_valid().
+ * <br><br> Returns number of states in path.
+ */
+static uint8_t get_path(const automata_table_t *table, uint8_t state, uint8_t *path) {
+    uint8_t depth = 0;
+    for (uint8_t s = state; s != AUTOMATA_NO_STATE; s = get_parent(table, s)) {
+        depth++;
+    }
+    uint8_t s = state;
+    for (uint8_t i = depth; i > 0; i--) {
+        path[i - 1] = s;
+        s = get_parent(table, s);
+    }
+    return depth;
+}
+
+/**
+ * Enter states of path from index first and then first children until state without children.
+ */
+static void enter_path(automata_engine_t *engine, const uint8_t *path, uint8_t first, uint8_t depth) {
+    const automata_table_t *table = engine->table;
+    for (uint8_t i = first; i < depth; i++) {
+        call_actions(engine, table->states[path[i]].entry);
+    }
+    uint8_t state = path[depth - 1];
+    for (uint8_t child; (child = get_first_child(table, state)) != AUTOMATA_NO_STATE; state = child) {
+        call_actions(engine, table->states[child].entry);
+    }
+    engine->state = state;
+}
+
+/**
+ * Leave current state and its parents down to index last of its path.
+ */
+static void exit_path(automata_engine_t *engine, const uint8_t *path, uint8_t last, uint8_t depth) {
+    for (uint8_t i = depth; i > last; i--) {
+        call_actions(engine, engine->table->states[path[i - 1]].exit);
+    }
+}
+
+static void take_transition(automata_engine_t *engine, const automata_transition_t *transition) {
+    const automata_table_t *table = engine->table;
+    uint8_t from_path[AUTOMATA_MAX_DEPTH];
+    uint8_t to_path[AUTOMATA_MAX_DEPTH];
+    uint8_t from_depth = get_path(table, engine->state, from_path);
+    uint8_t to_depth = get_path(table, transition->target, to_path);
+
+    // States shared by both paths are not left.
+    uint8_t common = 0;
+    while (common < from_depth && common < to_depth && from_path[common] == to_path[common]) {
+        common++;
+    }
+    // Target is the current state or its parent, so it is left and entered again.
+    if (common == to_depth) {
+        common--;
+    }
+
+    exit_path(engine, from_path, common, from_depth);
+    call_actions(engine, transition->actions);
+    enter_path(engine, to_path, common, to_depth);
+}
+
+static pbio_error_t read_angle(automata_engine_t *engine, int8_t x, int8_t y, int8_t z, int32_t *value) {
+    float angle = 0.0;
+    pbio_geometry_xyz_t axis;
+    axis.x = x;
+    axis.y = y;
+    axis.z = z;
+    pbio_error_t err = automata_gyro_get_axis_rotation(&engine->ctx, &axis, &angle);
+    *value = angle;
+    return err;
+}
+
+/**
+ * Read roll or pitch [deg] of the estimated attitude. It is corrected by
+ * gravity, so unlike the integrated rotation it does not drift.
+ */
+static pbio_error_t read_tilt(bool roll, int32_t *value) {
+    #if PBIO_CONFIG_IMU
+    float angles[3];
+    pbio_imu_get_roll_pitch_yaw(&angles[0], &angles[1], &angles[2]);
+    *value = roll ? angles[0] : angles[1];
+    return PBIO_SUCCESS;
+    #else
+    return PBIO_ERROR_NOT_SUPPORTED;
+    #endif
+}
+
+/**
+ * Device which provides the input, used as key of snapshot sample.
+ * There is only one IMU, so its inputs have no device.
+ */
+static const void *input_device(const automata_engine_t *engine, uint8_t input) {
+    switch (input) {
+        case AUTOMATA_INPUT_DISTANCE:
+            return engine->ultrasonic;
+        case AUTOMATA_INPUT_COLOR:
+            return engine->color;
+        case AUTOMATA_INPUT_BASE_DONE:
+            return engine->base;
+        default:
+            return NULL;
+    }
+}
+
+static pbio_error_t read_input(automata_engine_t *engine, uint8_t input, int32_t *value) {
+    automata_ctx_t *ctx = &engine->ctx;
+
+    if (input_source) {
+        return automata_ctx_check(ctx, input_source(input, value), "Err input_source: ");
+    }
+
+    switch (input) {
+        case AUTOMATA_INPUT_DISTANCE:
+            if (automata_distance_get(ctx, engine->ultrasonic, value) != PBIO_SUCCESS) {
+                return ctx->err;
+            }
+            if (*value < 0) {
+                *value = 2000;
+            }
+            return PBIO_SUCCESS;
+        case AUTOMATA_INPUT_COLOR:
+            return automata_color_get(ctx, engine->color, value);
+        case AUTOMATA_INPUT_ANGLE_X:
+            return read_tilt(true, value);
+        case AUTOMATA_INPUT_ANGLE_Y:
+            return read_tilt(false, value);
+        case AUTOMATA_INPUT_ANGLE_Z:
+            return read_angle(engine, 0, 0, 1, value);
+        case AUTOMATA_INPUT_BASE_DONE:
+            *value = automata_base_is_done(engine->base);
+            return PBIO_SUCCESS;
+        default:
+            return automata_ctx_check(ctx, PBIO_ERROR_NOT_SUPPORTED, "Err input: ");
+    }
+}
+
+/**
+ * Read all inputs used by table. Device which was already read in current
+ * snapshot (e.g. by other automaton) is not read again.
+ */
+static pbio_error_t read_inputs(automata_engine_t *engine) {
+    engine->changed = 0;
+
+    for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+        if (!(engine->table->inputs & AUTOMATA_INPUT_MASK(i))) {
+            continue;
+        }
+
+        const void *device = input_device(engine, i);
+        const automata_sample_t *sample = automata_snapshot_get(device, i);
+        if (!sample) {
+            int32_t value;
+            if (read_input(engine, i, &value) != PBIO_SUCCESS) {
+                return engine->ctx.err;
+            }
+            sample = automata_snapshot_put(device, i, value);
+        }
+
+        engine->values[i] = sample->value;
+        if (sample->seq != engine->seq[i]) {
+            engine->seq[i] = sample->seq;
+            engine->changed |= AUTOMATA_INPUT_MASK(i);
+        }
+    }
+
+    return PBIO_SUCCESS;
+}
+
+static bool guard_holds(const automata_engine_t *engine, const automata_guard_t *guard) {
+    int32_t value = engine->values[guard->input];
+
+    switch (guard->op) {
+        case AUTOMATA_OP_ALWAYS:
+            return true;
+        case AUTOMATA_OP_LT:
+            return value < guard->value;
+        case AUTOMATA_OP_LE:
+            return value <= guard->value;
+        case AUTOMATA_OP_GT:
+            return value > guard->value;
+        case AUTOMATA_OP_GE:
+            return value >= guard->value;
+        case AUTOMATA_OP_EQ:
+            return value == guard->value;
+        case AUTOMATA_OP_NE:
+            return value != guard->value;
+        case AUTOMATA_OP_CHANGED:
+            return engine->changed & AUTOMATA_INPUT_MASK(guard->input);
+        default:
+            return false;
+    }
+}
+
+static bool guards_hold(const automata_engine_t *engine, automata_range_t range) {
+    for (uint8_t i = 0; i < range.count; i++) {
+        if (!guard_holds(engine, &engine->table->guards[range.first + i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_inputs(automata_engine_t *engine) {
+    for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+        if (engine->table->inputs & AUTOMATA_INPUT_MASK(i)) {
+            long value = engine->values[i];
+            parameters[10] = (char *) input_names[i];
+            parameters[11] = &value;
+            print_value();
+        }
+    }
+    long state = engine->state;
+    parameters[10] = "State: ";
+    parameters[11] = &state;
+    print_value();
+    engine->last_print = pbdrv_clock_get_ms();
+}
+
+/**
+ * Make ports free for other automata and stop data events of sensors.
+ */
+static void release_devices(automata_engine_t *engine) {
+    if (engine->base) {
+        automata_base_release(engine->base);
+    }
+    if (engine->ultrasonic) {
+        pbdrv_legodev_clear_data_notify(engine->ultrasonic);
+    }
+    if (engine->color) {
+        pbdrv_legodev_clear_data_notify(engine->color);
+    }
+}
+
+bool automata_engine_start(automata_engine_t *engine, const automata_table_t *table) {
+    memset(engine, 0, sizeof(*engine));
+    automata_ctx_reset(&engine->ctx);
+    engine->table = table;
+    engine->state = table->initial_state;
+
+    if (!table_is_valid(table)) {
+        automata_ctx_check(&engine->ctx, PBIO_ERROR_INVALID_ARG, "Err table: ");
+        print_engine_error(engine, "Exit automata because table: ");
+        return false;
+    }
+
+    if (setup_devices(engine) != PBIO_SUCCESS) {
+        print_engine_error(engine, "Exit automata because setup: ");
+        release_devices(engine);
+        return false;
+    }
+
+    if (call_actions(engine, table->start) != PBIO_SUCCESS) {
+        print_engine_error(engine, "Exit automata because start actions: ");
+        release_devices(engine);
+        return false;
+    }
+
+    uint8_t path[AUTOMATA_MAX_DEPTH];
+    enter_path(engine, path, 0, get_path(table, table->initial_state, path));
+    if (engine->ctx.err != PBIO_SUCCESS) {
+        print_engine_error(engine, "Exit automata because entry actions: ");
+        release_devices(engine);
+        return false;
+    }
+    return true;
+}
+
+void automata_engine_tick(automata_engine_t *engine) {
+    const automata_table_t *table = engine->table;
+
+    if (read_inputs(engine) != PBIO_SUCCESS) {
+        return;
+    }
+
+    if (debug_mode == 1 && pbdrv_clock_get_ms() - engine->last_print > 200) {
+        print_inputs(engine);
+    }
+
+    // Guards depend only on inputs and state. If neither changed since
+    // last tick, which took no transition, none can be taken now.
+    if (!engine->changed && !engine->moved) {
+        return;
+    }
+    engine->moved = false;
+    uint8_t from = engine->state;
+
+    if (table->step) {
+        engine->moved = table->step(engine);
+        if (engine->moved) {
+            automata_trace_record(engine, from, AUTOMATA_TRACE_COMPILED);
+        }
+        return;
+    }
+
+    // Only outgoing transitions of the current state and its parents
+    // are checked, parents first.
+    uint8_t path[AUTOMATA_MAX_DEPTH];
+    uint8_t depth = get_path(table, from, path);
+    for (uint8_t level = 0; level < depth; level++) {
+        const automata_state_t *state = &table->states[path[level]];
+        for (uint8_t i = 0; i < state->transitions.count; i++) {
+            const automata_transition_t *transition = &table->transitions[state->transitions.first + i];
+            if (guards_hold(engine, transition->guards)) {
+                take_transition(engine, transition);
+                engine->moved = true;
+                automata_trace_record(engine, from, state->transitions.first + i);
+                return;
+            }
+        }
+    }
+}
+
+void automata_engine_stop(automata_engine_t *engine) {
+    // Exit actions run even after error, which is restored after them.
+    automata_ctx_t err_ctx = engine->ctx;
+    automata_ctx_reset(&engine->ctx);
+    uint8_t path[AUTOMATA_MAX_DEPTH];
+    exit_path(engine, path, 0, get_path(engine->table, engine->state, path));
+    call_actions(engine, engine->table->exit);
+    engine->ctx = err_ctx;
+
+    release_devices(engine);
+}
+
+bool automata_engine_uses_sensor(const automata_engine_t *engine, const pbdrv_legodev_dev_t *sensor) {
+    return sensor && (engine->ultrasonic == sensor || engine->color == sensor);
+}
+
+bool automata_engine_should_end(const automata_engine_t *engine) {
+    return engine->ctx.err != PBIO_SUCCESS
+           || pbsys_status_test(PBIO_PYBRICKS_STATUS_POWER_BUTTON_PRESSED)
+           || pbsys_status_test(PBIO_PYBRICKS_STATUS_SHUTDOWN_REQUEST);
+}
+
+void automata_engine_print_exit(const automata_engine_t *engine) {
+    print_engine_error(engine, "Ending automata with exit code ");
+}
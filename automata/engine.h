@@ -0,0 +1,259 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <pbdrv/legodev.h>
+
+#include <pbio/drivebase.h>
+#include <pbio/light_matrix.h>
+#include <pbio/port.h>
+#include <pbio/servo.h>
+
+#include "context.h"
+
+/**
+ * Values that guards can compare. Each automaton reads only inputs
+ * listed in its automata_table_t::inputs mask.
+ */
+typedef enum {
+    /** Ultrasonic distance [mm], no object is reported as 2000. */
+    AUTOMATA_INPUT_DISTANCE,
+    /** Color sensor color id (color enum is in SPIKE Prime documentations). */
+    AUTOMATA_INPUT_COLOR,
+    /** Roll, tilt around hub x axis relative to gravity [whole deg]. */
+    AUTOMATA_INPUT_ANGLE_X,
+    /** Pitch, tilt around hub y axis relative to gravity [whole deg]. */
+    AUTOMATA_INPUT_ANGLE_Y,
+    /** Rotation around hub z axis [whole deg]. */
+    AUTOMATA_INPUT_ANGLE_Z,
+    /** 1 if drive base finished its last command, 0 otherwise. */
+    AUTOMATA_INPUT_BASE_DONE,
+    AUTOMATA_NUM_INPUTS,
+} automata_input_t;
+
+#define AUTOMATA_INPUT_MASK(input) (1 << (input))
+
+/**
+ * Compare operator of a guard.
+ */
+typedef enum {
+    /** Guard is always true. */
+    AUTOMATA_OP_ALWAYS,
+    AUTOMATA_OP_LT,
+    AUTOMATA_OP_LE,
+    AUTOMATA_OP_GT,
+    AUTOMATA_OP_GE,
+    AUTOMATA_OP_EQ,
+    AUTOMATA_OP_NE,
+    /** Input changed since last tick of this automaton, value is not used. */
+    AUTOMATA_OP_CHANGED,
+} automata_op_t;
+
+/**
+ * Action opcodes. Arguments are in automata_action_t::args.
+ */
+typedef enum {
+    /** Stop drive base. */
+    AUTOMATA_ACTION_BASE_STOP,
+    /** Run drive base forever. args: speed [mm/s], turn rate [deg/s]. */
+    AUTOMATA_ACTION_BASE_RUN_FOREVER,
+    /** Run drive base for the angle. args: radius [mm], angle [deg]. */
+    AUTOMATA_ACTION_BASE_RUN_ANGLE,
+    /** Clear hub light matrix. */
+    AUTOMATA_ACTION_MATRIX_CLEAR,
+    /** Set matrix pixel. args: row, column, brightness [%]. */
+    AUTOMATA_ACTION_MATRIX_SET_PIXEL,
+    AUTOMATA_NUM_ACTIONS,
+} automata_action_code_t;
+
+/**
+ * Devices which have to be set up before the automaton starts.
+ */
+typedef enum {
+    AUTOMATA_DEVICE_BASE = 1 << 0,
+    AUTOMATA_DEVICE_ULTRASONIC = 1 << 1,
+    AUTOMATA_DEVICE_COLOR = 1 << 2,
+    AUTOMATA_DEVICE_IMU = 1 << 3,
+} automata_device_t;
+
+/**
+ * Range of items in one of the automaton tables.
+ */
+typedef struct {
+    uint8_t first;
+    uint8_t count;
+} automata_range_t;
+
+/**
+ * Guard compares one input with constant value.
+ */
+typedef struct {
+    uint8_t input;
+    uint8_t op;
+    int16_t value;
+} automata_guard_t;
+
+typedef struct {
+    uint8_t code;
+    int16_t args[3];
+} automata_action_t;
+
+/**
+ * Transition is taken if all of its guards are true.
+ * Then its actions are called in order and state is set to target.
+ */
+typedef struct {
+    automata_range_t guards;
+    automata_range_t actions;
+    uint8_t target;
+} automata_transition_t;
+
+/**
+ * No state, e.g. parent of top level state.
+ */
+#define AUTOMATA_NO_STATE (0xFF)
+
+/**
+ * Maximum nesting of states, top level states have depth 1. Automata with
+ * deeper nested states do not start.
+ */
+#define AUTOMATA_MAX_DEPTH (4)
+
+/**
+ * State only points to its outgoing transitions, which are checked in order.
+ * <br><br> States can be nested, see automata_table_t::parents. Transitions of
+ * parent are checked before transitions of its children, so guard shared by
+ * all children (e.g. emergency stop) is written and evaluated only once.
+ * Transition to parent state enters its first child (child with lowest index).
+ */
+typedef struct {
+    const char *name;
+    automata_range_t transitions;
+    /** Actions called when state is entered by transition from outside. */
+    automata_range_t entry;
+    /** Actions called when state is left by transition to outside. */
+    automata_range_t exit;
+} automata_state_t;
+
+/**
+ * Ports and directions of devices used by automaton.
+ */
+typedef struct {
+    pbio_port_id_t left_motor;
+    pbio_direction_t left_direction;
+    pbio_port_id_t right_motor;
+    pbio_direction_t right_direction;
+    pbio_port_id_t ultrasonic;
+    pbio_port_id_t color;
+} automata_ports_t;
+
+typedef struct _automata_engine_t automata_engine_t;
+
+/**
+ * Complete automaton description. All arrays are constant,
+ * so one table can be placed in flash and run by automata_engine_t.
+ */
+typedef struct {
+    const char *name;
+    const automata_state_t *states;
+    const automata_transition_t *transitions;
+    const automata_guard_t *guards;
+    const automata_action_t *actions;
+    /** Parent of each state or AUTOMATA_NO_STATE. NULL if all states are top level. */
+    const uint8_t *parents;
+    uint8_t num_states;
+    uint8_t initial_state;
+    /** Lower number runs first when more automata should tick at once. */
+    uint8_t priority;
+    /** Period of ticks [ms], 0 means AUTOMATA_TICK_MS. */
+    uint16_t period;
+    /** Mask of automata_input_t values read on every tick. */
+    uint16_t inputs;
+    /** Mask of automata_device_t. */
+    uint8_t devices;
+    automata_ports_t ports;
+    /** Actions called after devices are set up. */
+    automata_range_t start;
+    /** Actions called when automaton ends. */
+    automata_range_t exit;
+    /**
+     * Transitions compiled to C by tools/automata_compile.py, called after
+     * inputs are read. Returns true if transition was taken.
+     * NULL means transitions of states are interpreted.
+     */
+    bool (*step)(automata_engine_t *engine);
+} automata_table_t;
+
+/**
+ * Running instance of automaton.
+ */
+struct _automata_engine_t {
+    const automata_table_t *table;
+    /** Error state of this instance. */
+    automata_ctx_t ctx;
+    /** Current state, it never has children. */
+    uint8_t state;
+    int32_t values[AUTOMATA_NUM_INPUTS];
+    /** Sequence numbers of snapshot samples of values. */
+    uint32_t seq[AUTOMATA_NUM_INPUTS];
+    /** Mask of inputs which changed since last tick. */
+    uint16_t changed;
+    /** Last tick took a transition. */
+    bool moved;
+    pbio_drivebase_t *base;
+    pbdrv_legodev_dev_t *ultrasonic;
+    pbdrv_legodev_dev_t *color;
+    uint32_t last_print;
+};
+
+/**
+ * Setup devices of the table, call its start actions and enter initial state.
+ * <br><br> Returns false if automaton can not be started.
+ */
+bool automata_engine_start(automata_engine_t *engine, const automata_table_t *table);
+
+/**
+ * Read inputs and take first enabled transition of the current state.
+ * Transitions are not checked again if inputs did not change.
+ */
+void automata_engine_tick(automata_engine_t *engine);
+
+/**
+ * Leave current state and its parents and call exit actions of the table.
+ */
+void automata_engine_stop(automata_engine_t *engine);
+
+/**
+ * Light matrix of the hub, NULL if the hub has none. Matrix actions of
+ * interpreted and compiled automata use it.
+ */
+pbio_light_matrix_t *automata_engine_get_light_matrix(void);
+
+/**
+ * Sensor is set up by this automaton, so its data events concern it.
+ */
+bool automata_engine_uses_sensor(const automata_engine_t *engine, const pbdrv_legodev_dev_t *sensor);
+
+/**
+ * Automaton should end because of its own error, shutdown or power button.
+ */
+bool automata_engine_should_end(const automata_engine_t *engine);
+
+/**
+ * Print error code which ended the automaton.
+ */
+void automata_engine_print_exit(const automata_engine_t *engine);
+
+/**
+ * Reads input instead of its device.
+ * <br><br> Returns error if the input can not be read.
+ */
+typedef pbio_error_t (*automata_input_source_t)(uint8_t input, int32_t *value);
+
+/**
+ * Read all inputs of automata started after this call from @p source,
+ * e.g. in simulator or replay of recorded run. Sensors are then not set up,
+ * drive base is still set up for actions. NULL reads devices again.
+ */
+void automata_engine_set_input_source(automata_input_source_t source);
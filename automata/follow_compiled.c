@@ -0,0 +1,71 @@
+// Generated by tools/automata_compile.py from automata/descriptions/follow.json, do not edit.
+
+#include "automata.h"
+
+static const automata_state_t follow_compiled_states[] = {
+    {"stop", {0, 0}},
+    {"back", {0, 0}},
+    {"forward", {0, 0}},
+};
+
+static const automata_action_t follow_compiled_actions[] = {
+    {AUTOMATA_ACTION_BASE_STOP, {0}},
+};
+
+static bool follow_compiled_step(automata_engine_t *engine) {
+    automata_ctx_t *ctx = &engine->ctx;
+    const int32_t distance = engine->values[AUTOMATA_INPUT_DISTANCE];
+
+    switch (engine->state) {
+        case 0: // stop
+            if (distance < 140) {
+                engine->state = 1;
+                automata_base_run_forever(ctx, engine->base, 250, 0);
+                return true;
+            }
+            if (distance > 310) {
+                engine->state = 2;
+                automata_base_run_forever(ctx, engine->base, -250, 0);
+                return true;
+            }
+            return false;
+        case 1: // back
+            if (distance > 150) {
+                engine->state = 0;
+                automata_base_stop(ctx, engine->base);
+                return true;
+            }
+            return false;
+        case 2: // forward
+            if (distance < 300) {
+                engine->state = 0;
+                automata_base_stop(ctx, engine->base);
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+const automata_table_t automata_follow_compiled_table = {
+    .name = "follow_compiled",
+    .states = follow_compiled_states,
+    .actions = follow_compiled_actions,
+    .num_states = PBIO_ARRAY_SIZE(follow_compiled_states),
+    .initial_state = 0,
+    .priority = 1,
+    .period = 10,
+    .inputs = AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_DISTANCE),
+    .devices = AUTOMATA_DEVICE_BASE | AUTOMATA_DEVICE_ULTRASONIC,
+    .ports = {
+        .left_motor = PBIO_PORT_ID_B,
+        .left_direction = PBIO_DIRECTION_CLOCKWISE,
+        .right_motor = PBIO_PORT_ID_D,
+        .right_direction = PBIO_DIRECTION_COUNTERCLOCKWISE,
+        .ultrasonic = PBIO_PORT_ID_C,
+    },
+    .start = {0, 0},
+    .exit = {0, 1},
+    .step = follow_compiled_step,
+};
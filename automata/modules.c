@@ -1,14 +1,11 @@
 #include "modules.h"
 
 void matrix_clear() {
-    pbio_error_t err =
-            pbio_light_matrix_clear(
-                    (pbio_light_matrix_t *) parameters[3]);
-    *(pbio_error_t *) parameters[0] = err;
-    if (PBIO_SUCCESS != err) {
-        parameters[10] = "Err matrix_clear: ";
-        print_error();
-    }
+    automata_ctx_t ctx = AUTOMATA_CTX_INIT;
+    automata_matrix_clear(
+            &ctx,
+            (pbio_light_matrix_t *) parameters[3]);
+    parameters_store_error(&ctx);
 }
 
 void matrix_get_size() {
@@ -20,15 +17,12 @@ void matrix_get_size() {
 }
 
 void matrix_set_row() {
-    pbio_error_t err =
-            pbio_light_matrix_set_rows(
-                    (pbio_light_matrix_t *) parameters[3],
-                    (const uint8_t *) parameters[4]);
-    *(pbio_error_t *) parameters[0] = err;
-    if (PBIO_SUCCESS != err) {
-        parameters[10] = "Err matrix_set_row: ";
-        print_error();
-    }
+    automata_ctx_t ctx = AUTOMATA_CTX_INIT;
+    automata_matrix_set_row(
+            &ctx,
+            (pbio_light_matrix_t *) parameters[3],
+            (const uint8_t *) parameters[4]);
+    parameters_store_error(&ctx);
 }
 
 void matrix_orientation() {
@@ -39,29 +33,23 @@ void matrix_orientation() {
 }
 
 void matrix_set_pixel() {
-    pbio_error_t err =
-            pbio_light_matrix_set_pixel(
-                    (pbio_light_matrix_t *) parameters[3],
-                    *((uint8_t *) parameters[4]),
-                    *((uint8_t *) parameters[5]),
-                    *((uint8_t *) parameters[6]));
-    *(pbio_error_t *) parameters[0] = err;
-    if (PBIO_SUCCESS != err) {
-        parameters[10] = "Err matrix_set_pixel: ";
-        print_error();
-    }
+    automata_ctx_t ctx = AUTOMATA_CTX_INIT;
+    automata_matrix_set_pixel(
+            &ctx,
+            (pbio_light_matrix_t *) parameters[3],
+            *((uint8_t *) parameters[4]),
+            *((uint8_t *) parameters[5]),
+            *((uint8_t *) parameters[6]));
+    parameters_store_error(&ctx);
 }
 
 void matrix_set_image() {
-    pbio_error_t err =
-            pbio_light_matrix_set_image(
-                    (pbio_light_matrix_t *) parameters[3],
-                    (uint8_t *) parameters[4]);
-    *(pbio_error_t *) parameters[0] = err;
-    if (PBIO_SUCCESS != err) {
-        parameters[10] = "Err matrix_set_image: ";
-        print_error();
-    }
+    automata_ctx_t ctx = AUTOMATA_CTX_INIT;
+    automata_matrix_set_image(
+            &ctx,
+            (pbio_light_matrix_t *) parameters[3],
+            (uint8_t *) parameters[4]);
+    parameters_store_error(&ctx);
 }
 
 void matrix_animation_start() {
@@ -101,10 +89,12 @@ void gyro_get_geometry_axis() {
 }
 
 void gyro_get_axis_rotation() {
-    *(pbio_error_t *) parameters[0] = PBIO_SUCCESS;
-    pbio_imu_get_single_axis_rotation(
+    automata_ctx_t ctx = AUTOMATA_CTX_INIT;
+    automata_gyro_get_axis_rotation(
+            &ctx,
             (pbio_geometry_xyz_t *) parameters[3],
             (float *) parameters[1]);
+    parameters_store_error(&ctx);
 }
 
 void gyro_init() {
@@ -114,17 +104,18 @@ void gyro_init() {
 
 void gyro_is_ready() {
     *(pbio_error_t *) parameters[0] = PBIO_SUCCESS;
+    #if PBIO_CONFIG_IMU
     bool ready = pbio_imu_is_ready();
+    #else
+    bool ready = false;
+    #endif
     *(bool *) parameters[1] = ready;
 }
 
 void button_pressed() {
-    pbio_error_t err =
-            pbdrv_button_is_pressed(
-                    (pbio_button_flags_t *) parameters[1]);
-    *(pbio_error_t *) parameters[0] = err;
-    if (PBIO_SUCCESS != err) {
-        parameters[10] = "Err button_pressed: ";
-        print_error();
-    }
+    automata_ctx_t ctx = AUTOMATA_CTX_INIT;
+    automata_button_pressed(
+            &ctx,
+            (pbio_button_flags_t *) parameters[1]);
+    parameters_store_error(&ctx);
 }
\ No newline at end of file
@@ -11,8 +11,79 @@
 #include <pbio/imu.h>
 
 #include "print.h"
+#include "context.h"
 #include "parameters.h"
 
+/*
+ * Typed interface. Every call takes context of the automaton, returns error
+ * code directly and records the first failure in the context.
+ * Calls which can not fail are used directly from pbio.
+ */
+
+/**
+ * Clear matrix. Matrix calls return PBIO_ERROR_NOT_SUPPORTED if matrix is
+ * NULL, on hubs without light matrix.
+ */
+static inline pbio_error_t automata_matrix_clear(automata_ctx_t *ctx, pbio_light_matrix_t *matrix) {
+    if (!matrix) {
+        return automata_ctx_check(ctx, PBIO_ERROR_NOT_SUPPORTED, "Err matrix_clear: ");
+    }
+    return automata_ctx_check(ctx, pbio_light_matrix_clear(matrix), "Err matrix_clear: ");
+}
+
+/**
+ * Set brightness [%] of each row, see matrix_set_row().
+ */
+static inline pbio_error_t automata_matrix_set_row(automata_ctx_t *ctx, pbio_light_matrix_t *matrix, const uint8_t *rows) {
+    if (!matrix) {
+        return automata_ctx_check(ctx, PBIO_ERROR_NOT_SUPPORTED, "Err matrix_set_row: ");
+    }
+    return automata_ctx_check(ctx, pbio_light_matrix_set_rows(matrix, rows), "Err matrix_set_row: ");
+}
+
+/**
+ * Set matrix pixel brightness [%].
+ */
+static inline pbio_error_t automata_matrix_set_pixel(automata_ctx_t *ctx, pbio_light_matrix_t *matrix, uint8_t row, uint8_t col, uint8_t brightness) {
+    if (!matrix) {
+        return automata_ctx_check(ctx, PBIO_ERROR_NOT_SUPPORTED, "Err matrix_set_pixel: ");
+    }
+    return automata_ctx_check(ctx, pbio_light_matrix_set_pixel(matrix, row, col, brightness), "Err matrix_set_pixel: ");
+}
+
+/**
+ * Set matrix image, brightness [%] of each pixel.
+ */
+static inline pbio_error_t automata_matrix_set_image(automata_ctx_t *ctx, pbio_light_matrix_t *matrix, const uint8_t *image) {
+    if (!matrix) {
+        return automata_ctx_check(ctx, PBIO_ERROR_NOT_SUPPORTED, "Err matrix_set_image: ");
+    }
+    return automata_ctx_check(ctx, pbio_light_matrix_set_image(matrix, image), "Err matrix_set_image: ");
+}
+
+/**
+ * Get rotation [deg] around axis given in hub frame. Returns
+ * PBIO_ERROR_NOT_SUPPORTED on hubs without IMU.
+ */
+static inline pbio_error_t automata_gyro_get_axis_rotation(automata_ctx_t *ctx, pbio_geometry_xyz_t *axis, float *angle) {
+    #if PBIO_CONFIG_IMU
+    return automata_ctx_check(ctx, pbio_imu_get_single_axis_rotation(axis, angle), "Err gyro_get_axis_rotation: ");
+    #else
+    return automata_ctx_check(ctx, PBIO_ERROR_NOT_SUPPORTED, "Err gyro_get_axis_rotation: ");
+    #endif
+}
+
+/**
+ * Get flags of pressed buttons.
+ */
+static inline pbio_error_t automata_button_pressed(automata_ctx_t *ctx, pbio_button_flags_t *button_flag) {
+    return automata_ctx_check(ctx, pbdrv_button_is_pressed(button_flag), "Err button_pressed: ");
+}
+
+/*
+ * Compatibility interface. Arguments are passed through global parameters array.
+ */
+
 /**
  * Clear matrix.
  * <br><br> parameters_0 is pointer to pbio_error_t *error_code.
@@ -15,8 +15,147 @@
 #include <pbdrv/legodev.h>
 
 #include "print.h"
+#include "context.h"
 #include "parameters.h"
 
+/*
+ * Typed interface. Every call takes context of the automaton, returns error
+ * code directly and records the first failure in the context.
+ */
+
+/**
+ * Setup motor of given type. Gear ratio is 1:1 and angle is reset.
+ */
+static inline pbio_error_t automata_motor_setup(automata_ctx_t *ctx, pbio_servo_t *motor, pbdrv_legodev_type_id_t type, pbio_direction_t direction) {
+    return automata_ctx_check(ctx, pbio_servo_setup(motor, type, direction, 1000, true, 0), "Err motor_setup: ");
+}
+
+/**
+ * Getting instance of motor of given type on the port.
+ */
+static inline pbio_error_t automata_motor_get(automata_ctx_t *ctx, pbio_port_id_t port, pbdrv_legodev_type_id_t type, pbio_servo_t **motor) {
+    pbdrv_legodev_dev_t *lego_device;
+    pbio_error_t err = pbdrv_legodev_get_device(port, &type, &lego_device);
+    if (err != PBIO_SUCCESS) {
+        return automata_ctx_check(ctx, err, "Err get_motor/device: ");
+    }
+    return automata_ctx_check(ctx, pbio_servo_get_servo(lego_device, motor), "Err get_motor/servo: ");
+}
+
+/**
+ * Getting angle [deg] and speed [deg/s] of motor.
+ */
+static inline pbio_error_t automata_motor_get_status(automata_ctx_t *ctx, pbio_servo_t *motor, int32_t *angle, int32_t *speed) {
+    return automata_ctx_check(ctx, pbio_servo_get_state_user(motor, angle, speed), "Err motor_get_status: ");
+}
+
+/**
+ * Run the motor with speed [deg/s] for the time [ms].
+ */
+static inline pbio_error_t automata_motor_run_time(automata_ctx_t *ctx, pbio_servo_t *motor, int32_t speed, int32_t time) {
+    return automata_ctx_check(ctx, pbio_servo_run_time(motor, speed, time, PBIO_CONTROL_ON_COMPLETION_BRAKE), "Err motor_run_time: ");
+}
+
+/**
+ * Run the motor with speed [deg/s] forever.
+ */
+static inline pbio_error_t automata_motor_run_forever(automata_ctx_t *ctx, pbio_servo_t *motor, int32_t speed) {
+    return automata_ctx_check(ctx, pbio_servo_run_forever(motor, speed), "Err motor_run_forever: ");
+}
+
+/**
+ * Run the motor with speed [deg/s] for the angle [deg].
+ */
+static inline pbio_error_t automata_motor_run_angle(automata_ctx_t *ctx, pbio_servo_t *motor, int32_t speed, int32_t angle) {
+    return automata_ctx_check(ctx, pbio_servo_run_angle(motor, speed, angle, PBIO_CONTROL_ON_COMPLETION_BRAKE), "Err motor_run_angle: ");
+}
+
+/**
+ * Stop motor.
+ */
+static inline pbio_error_t automata_motor_stop(automata_ctx_t *ctx, pbio_servo_t *motor) {
+    return automata_ctx_check(ctx, pbio_servo_stop(motor, PBIO_CONTROL_ON_COMPLETION_BRAKE), "Err motor_stop: ");
+}
+
+/**
+ * Getting instance of drive base.
+ */
+static inline pbio_error_t automata_base_get(automata_ctx_t *ctx, pbio_servo_t *left_motor, pbio_servo_t *right_motor, pbio_drivebase_t **drive_base) {
+    return automata_ctx_check(ctx, pbio_drivebase_get_drivebase_spike(drive_base, left_motor, right_motor), "Err get_base: ");
+}
+
+/**
+ * Coast motors of the drive base and release them, so that the next
+ * automaton can set them up again. Same as the end of a user program.
+ */
+static inline void automata_base_release(pbio_drivebase_t *drive_base) {
+    pbio_servo_t *servos[] = {drive_base->left, drive_base->right};
+    for (uint8_t i = 0; i < 2; i++) {
+        pbio_dcmotor_coast(servos[i]->dcmotor);
+        pbio_parent_stop(&servos[i]->dcmotor->parent, true);
+    }
+}
+
+/**
+ * Drive base finished its last command.
+ */
+static inline bool automata_base_is_done(pbio_drivebase_t *drive_base) {
+    return pbio_drivebase_is_done(drive_base);
+}
+
+/**
+ * Run the drive base with speed [mm/s] and turn rate [deg/s] forever.
+ */
+static inline pbio_error_t automata_base_run_forever(automata_ctx_t *ctx, pbio_drivebase_t *drive_base, int32_t speed, int32_t turn_rate) {
+    return automata_ctx_check(ctx, pbio_drivebase_drive_forever(drive_base, speed, turn_rate), "Err base_run_forever: ");
+}
+
+/**
+ * Stop the drive base.
+ */
+static inline pbio_error_t automata_base_stop(automata_ctx_t *ctx, pbio_drivebase_t *drive_base) {
+    return automata_ctx_check(ctx, pbio_drivebase_stop(drive_base, PBIO_CONTROL_ON_COMPLETION_BRAKE), "Err base_stop: ");
+}
+
+/**
+ * Run the drive base for the distance [mm].
+ */
+static inline pbio_error_t automata_base_run_distance(automata_ctx_t *ctx, pbio_drivebase_t *drive_base, int32_t distance) {
+    return automata_ctx_check(ctx, pbio_drivebase_drive_straight(drive_base, distance, PBIO_CONTROL_ON_COMPLETION_BRAKE), "Err base_run_distance: ");
+}
+
+/**
+ * Run the drive base on circle with radius [mm] for the angle [deg].
+ */
+static inline pbio_error_t automata_base_run_angle(automata_ctx_t *ctx, pbio_drivebase_t *drive_base, int32_t radius, int32_t angle) {
+    return automata_ctx_check(ctx, pbio_drivebase_drive_curve(drive_base, radius, angle, PBIO_CONTROL_ON_COMPLETION_BRAKE), "Err base_run_angle: ");
+}
+
+/**
+ * Run the drive base forever with left and right speed [deg/s].
+ */
+static inline pbio_error_t automata_base_run_forever_different(automata_ctx_t *ctx, pbio_drivebase_t *drive_base, int32_t left_speed, int32_t right_speed) {
+    return automata_ctx_check(ctx, pbio_drivebase_spike_drive_forever(drive_base, left_speed, right_speed), "Err base_run_forever_different: ");
+}
+
+/**
+ * Run the drive base with left and right speed [deg/s] for the time [ms].
+ */
+static inline pbio_error_t automata_base_run_time_different(automata_ctx_t *ctx, pbio_drivebase_t *drive_base, int32_t left_speed, int32_t right_speed, int32_t time) {
+    return automata_ctx_check(ctx, pbio_drivebase_spike_drive_time(drive_base, left_speed, right_speed, time, PBIO_CONTROL_ON_COMPLETION_BRAKE), "Err base_run_time_different: ");
+}
+
+/**
+ * Run the drive base with left and right speed [deg/s] until faster motor travel angle [deg].
+ */
+static inline pbio_error_t automata_base_run_angle_different(automata_ctx_t *ctx, pbio_drivebase_t *drive_base, int32_t left_speed, int32_t right_speed, int32_t angle) {
+    return automata_ctx_check(ctx, pbio_drivebase_spike_drive_angle(drive_base, left_speed, right_speed, angle, PBIO_CONTROL_ON_COMPLETION_BRAKE), "Err base_run_angle_different: ");
+}
+
+/*
+ * Compatibility interface. Arguments are passed through global parameters array.
+ */
+
 /**
  * Setup large motor.
  * <br><br> parameters_0 is pointer to pbio_error_t *error_code.
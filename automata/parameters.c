@@ -1,7 +1,16 @@
 #include "parameters.h"
+#include "print.h"
 
 void *parameters[MAX_NUMBER_OF_PARAMETERS];
 
+void parameters_store_error(const automata_ctx_t *ctx) {
+    *(pbio_error_t *) parameters[0] = ctx->err;
+    if (PBIO_SUCCESS != ctx->err) {
+        parameters[10] = (char *) ctx->err_message;
+        print_error();
+    }
+}
+
 //char *get_param_as_str(int index) {
 //    return (char *) (parameters[index]);
 //}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "context.h"
+
 #define MAX_NUMBER_OF_PARAMETERS 12
 
 /**
@@ -8,4 +10,10 @@
  * Indexes 1 and 2 are reserved for output variables and next for input variables.
  * Last [10, 11] indexes are reserved for message and value to print.
  */
-extern void *parameters[MAX_NUMBER_OF_PARAMETERS];
\ No newline at end of file
+extern void *parameters[MAX_NUMBER_OF_PARAMETERS];
+
+/**
+ * Store error of a typed call to parameters_0 and print it if call failed.
+ * It is used by compatibility wrappers around typed calls.
+ */
+void parameters_store_error(const automata_ctx_t *ctx);
\ No newline at end of file
@@ -1,102 +1,248 @@
+#include <stdarg.h>
+#include <math.h>
+
+#include <lwrb/lwrb.h>
+
 #include "print.h"
 #include "string.h"
 
-void print_message() {
-    char *message_raw = (char *) parameters[10];
-    char *new_line = "\r\n";
-    size_t new_message_size = strlen(message_raw) + strlen(new_line) + 1;
-    char new_message[new_message_size];
-    strcpy(new_message, message_raw);
-    strcat(new_message, new_line);
-
-    const char *message = new_message;
-    uint32_t message_size = strlen(message);
-    uint32_t already_written = 0;
-    uint32_t send = message_size;
-    pbio_error_t err = PBIO_ERROR_INVALID_ARG;
-
-    while (send != 0) {
-        err = pbsys_bluetooth_tx((unsigned char *) message + already_written, &send);
-        if (err == PBIO_ERROR_AGAIN)
-            continue;
-        if (err == PBIO_ERROR_INVALID_OP || err == PBIO_ERROR_NOT_SUPPORTED)
-            break;
-        already_written += send;
-        send = message_size - already_written;
-        delay(10);
+static uint8_t ring_data[AUTOMATA_PRINT_BUFFER_SIZE + 1];
+static lwrb_t ring;
+static uint32_t dropped;
+
+/**
+ * Line which is formatted before it is written to ring buffer as whole.
+ */
+typedef struct {
+    char data[AUTOMATA_PRINT_LINE_SIZE];
+    uint16_t size;
+} line_t;
+
+static void put_char(line_t *line, char c) {
+    if (line->size < sizeof(line->data)) {
+        line->data[line->size++] = c;
+    }
+}
 
+static void put_string(line_t *line, const char *string) {
+    while (*string) {
+        put_char(line, *string++);
     }
-    if (err != PBIO_SUCCESS) {
-        *(pbio_error_t *) parameters[0] = err;
+}
+
+static void put_unsigned(line_t *line, unsigned long value, uint8_t base, uint8_t width, char pad) {
+    char digits[32];
+    uint8_t count = 0;
+    do {
+        digits[count++] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value);
+    while (width > count) {
+        put_char(line, pad);
+        width--;
+    }
+    while (count) {
+        put_char(line, digits[--count]);
+    }
+}
+
+static void put_signed(line_t *line, long value, uint8_t width, char pad) {
+    if (value < 0) {
+        put_char(line, '-');
+        put_unsigned(line, -(unsigned long) value, 10, width ? width - 1 : 0, pad);
+        return;
     }
+    put_unsigned(line, value, 10, width, pad);
 }
 
-void int_to_str(long *number_raw, char *string) {
-    long number = *number_raw;
-    long number_copy = number;
-    int digits = 1;
-    long constant = 1;
+static void put_float(line_t *line, float value, uint8_t precision) {
+    if (isnan(value)) {
+        put_string(line, "nan");
+        return;
+    }
+    if (value < 0) {
+        put_char(line, '-');
+        value = -value;
+    }
+    if (isinf(value)) {
+        put_string(line, "inf");
+        return;
+    }
 
-    while (number_copy /= 10) {
-        digits++;
-        constant *= 10;
+    // More digits do not fit into float anyway.
+    if (precision > 6) {
+        precision = 6;
     }
 
-    if (number < 0) {
-        *(string++) = '-';
-        number = -number;
+    // Values which do not fit to integer part are printed with exponent.
+    int8_t exponent = 0;
+    while (value >= 1e9f || (exponent && value >= 10)) {
+        value /= 10;
+        exponent++;
+    }
+
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < precision; i++) {
+        scale *= 10;
+    }
+    // Rounded in integers, so 0.9996 with precision 3 is 1.000.
+    uint64_t scaled = (uint64_t) (value * scale + 0.5f);
+    put_unsigned(line, scaled / scale, 10, 0, '0');
+    if (precision) {
+        put_char(line, '.');
+        put_unsigned(line, scaled % scale, 10, precision, '0');
     }
-    while (constant > 0) {
-        *(string++) = '0' + number / constant;
-        number = number % constant;
-        constant /= 10;
+    if (exponent) {
+        put_char(line, 'e');
+        put_signed(line, exponent, 0, '0');
     }
-    *string = 0;
 }
 
+static void format_line(line_t *line, const char *format, va_list args) {
+    for (; *format; format++) {
+        if (*format != '%') {
+            put_char(line, *format);
+            continue;
+        }
+        format++;
+
+        char pad = ' ';
+        if (*format == '0') {
+            pad = '0';
+            format++;
+        }
+        uint8_t width = 0;
+        while (*format >= '0' && *format <= '9') {
+            width = width * 10 + *format++ - '0';
+        }
+        uint8_t precision = AUTOMATA_PRINT_FLOAT_PRECISION;
+        if (*format == '.') {
+            format++;
+            precision = 0;
+            while (*format >= '0' && *format <= '9') {
+                precision = precision * 10 + *format++ - '0';
+            }
+        }
+        bool is_long = false;
+        if (*format == 'l') {
+            is_long = true;
+            format++;
+        }
+
+        switch (*format) {
+            case 'd':
+            case 'i':
+                put_signed(line, is_long ? va_arg(args, long) : va_arg(args, int), width, pad);
+                break;
+            case 'u':
+                put_unsigned(line, is_long ? va_arg(args, unsigned long) : va_arg(args, unsigned int), 10, width, pad);
+                break;
+            case 'x':
+                put_unsigned(line, is_long ? va_arg(args, unsigned long) : va_arg(args, unsigned int), 16, width, pad);
+                break;
+            case 'f':
+                put_float(line, va_arg(args, double), precision);
+                break;
+            case 'c':
+                put_char(line, va_arg(args, int));
+                break;
+            case 's':
+                put_string(line, va_arg(args, const char *));
+                break;
+            case '%':
+                put_char(line, '%');
+                break;
+            default:
+                // Unknown conversion, also if format ends with '%'.
+                return;
+        }
+    }
+}
 
-void print_value() {
-    char string_value[23];
-    int_to_str((long *) parameters[11], string_value);
+static void print_tx_done(void) {
+    automata_print_flush();
+}
 
-    char *message_raw = parameters[10];
-    size_t new_message_size = strlen(message_raw) + strlen(string_value) + 1;
-    char new_message[new_message_size];
+static void init_ring(void) {
+    if (!lwrb_is_ready(&ring)) {
+        lwrb_init(&ring, ring_data, sizeof(ring_data));
+    }
+    pbsys_bluetooth_tx_set_callback(print_tx_done);
+}
+
+pbio_error_t automata_print(const char *format, ...) {
+    init_ring();
+
+    line_t line;
+    line.size = 0;
+    va_list args;
+    va_start(args, format);
+    format_line(&line, format, args);
+    va_end(args);
+
+    // Lines are never split, so the host can always parse them.
+    if (lwrb_get_free(&ring) < line.size) {
+        dropped++;
+    } else {
+        lwrb_write(&ring, line.data, line.size);
+    }
 
-    strcpy(new_message, message_raw);
-    strcat(new_message, string_value);
-    parameters[10] = new_message;
-    print_message();
+    return automata_print_flush();
 }
 
-void print_float() {
-    char string_value[23];
-    long x = *(float *) parameters[11];
-    int_to_str(&x, string_value);
+pbio_error_t automata_print_flush(void) {
+    while (lwrb_get_full(&ring)) {
+        uint32_t size = lwrb_get_linear_block_read_length(&ring);
+        pbio_error_t err = pbsys_bluetooth_tx(lwrb_get_linear_block_read_address(&ring), &size);
+        if (err == PBIO_ERROR_AGAIN) {
+            // Rest is written when Bluetooth sends the data.
+            return PBIO_SUCCESS;
+        }
+        if (err != PBIO_SUCCESS) {
+            lwrb_reset(&ring);
+            return err;
+        }
+        lwrb_skip(&ring, size);
+    }
+    return PBIO_SUCCESS;
+}
 
-    char *message_raw = parameters[10];
-    size_t new_message_size = strlen(message_raw) + strlen(string_value) + 1;
-    char new_message[new_message_size];
+void automata_print_stop(void) {
+    pbsys_bluetooth_tx_set_callback(NULL);
+    if (lwrb_is_ready(&ring)) {
+        lwrb_reset(&ring);
+    }
+}
 
-    strcpy(new_message, message_raw);
-    strcat(new_message, string_value);
-    parameters[10] = new_message;
-    print_message();
+uint32_t automata_print_get_free(void) {
+    init_ring();
+    return lwrb_get_free(&ring);
+}
+
+uint32_t automata_print_get_dropped(void) {
+    return dropped;
+}
+
+static void store_print_error(pbio_error_t err) {
+    if (err != PBIO_SUCCESS) {
+        *(pbio_error_t *) parameters[0] = err;
+    }
+}
+
+void print_message() {
+    store_print_error(automata_print("%s\r\n", (char *) parameters[10]));
+}
+
+void print_value() {
+    store_print_error(automata_print("%s%ld\r\n", (char *) parameters[10], *(long *) parameters[11]));
+}
+
+void print_float() {
+    store_print_error(automata_print("%s%f\r\n", (char *) parameters[10], *(float *) parameters[11]));
 }
 
 
 
 void print_error() {
-    char string_value[23];
-    long error = *(pbio_error_t *) parameters[0];
-    int_to_str(&error, string_value);
-
-    char *message_raw = parameters[10];
-    size_t new_message_size = strlen(message_raw) + strlen(string_value) + 1;
-    char new_message[new_message_size];
-
-    strcpy(new_message, message_raw);
-    strcat(new_message, string_value);
-    parameters[10] = new_message;
-    print_message();
-}
\ No newline at end of file
+    store_print_error(automata_print("%s%d\r\n", (char *) parameters[10], *(pbio_error_t *) parameters[0]));
+}
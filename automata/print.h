@@ -7,10 +7,65 @@
 #include "parameters.h"
 #include "automata.h"
 
+/**
+ * Size of ring buffer for lines waiting to be sent over Bluetooth [bytes].
+ */
+#define AUTOMATA_PRINT_BUFFER_SIZE (512)
+
+/**
+ * Longest formatted line, longer lines are cut [bytes].
+ */
+#define AUTOMATA_PRINT_LINE_SIZE (128)
+
+/**
+ * Digits after decimal point of %f without precision.
+ */
+#define AUTOMATA_PRINT_FLOAT_PRECISION (3)
+
+/**
+ * Longest wait for Bluetooth to send buffered lines when automata end [ms].
+ */
+#define AUTOMATA_PRINT_STOP_TIMEOUT_MS (500)
+
+/**
+ * Format line into static ring buffer and start sending it, without waiting.
+ * The rest of the buffer is sent each time Bluetooth sends previous data.
+ * Line which does not fit into the buffer is dropped as whole.
+ * <br><br> Supports %d, %i, %u, %x (with l, width and 0 flag), %f (with precision), %c, %s and %%.
+ * <br><br> Returns error of Bluetooth other than full buffer, e.g. if hub is disconnected.
+ */
+pbio_error_t automata_print(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * Move as much of buffered data to Bluetooth as fits there.
+ */
+pbio_error_t automata_print_flush(void);
+
+/**
+ * Stop sending buffered data each time Bluetooth sends previous data and
+ * drop data which was not sent yet. Called when automata end, so that
+ * Bluetooth does not call them any more.
+ */
+void automata_print_stop(void);
+
+/**
+ * Free space in the buffer [bytes].
+ */
+uint32_t automata_print_get_free(void);
+
+/**
+ * Number of lines dropped because buffer was full.
+ */
+uint32_t automata_print_get_dropped(void);
+
+/**
+ * Compatibility interface. Arguments are passed through global parameters array.
+ */
+
 void print_message();
 
 void print_value();
 
 void print_float();
 
-void print_error();
\ No newline at end of file
+void print_error();
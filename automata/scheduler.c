@@ -0,0 +1,231 @@
+#include "automata.h"
+
+static automata_instance_t instances[AUTOMATA_SCHEDULER_MAX_INSTANCES];
+
+/**
+ * Active instances sorted by priority, highest priority first.
+ */
+static automata_instance_t *order[AUTOMATA_SCHEDULER_MAX_INSTANCES];
+static uint8_t num_active;
+
+static pbio_error_t last_error;
+
+static uint32_t get_period(const automata_instance_t *instance) {
+    uint16_t period = instance->engine.table->period;
+    return period ? period : AUTOMATA_TICK_MS;
+}
+
+static void insert_by_priority(automata_instance_t *instance) {
+    uint8_t i = num_active;
+    while (i > 0 && order[i - 1]->engine.table->priority > instance->engine.table->priority) {
+        order[i] = order[i - 1];
+        i--;
+    }
+    order[i] = instance;
+    num_active++;
+}
+
+static void remove_from_order(automata_instance_t *instance) {
+    for (uint8_t i = 0; i < num_active; i++) {
+        if (order[i] == instance) {
+            for (; i + 1 < num_active; i++) {
+                order[i] = order[i + 1];
+            }
+            num_active--;
+            return;
+        }
+    }
+}
+
+/**
+ * Collect ports of devices which table sets up.
+ */
+static uint8_t get_ports(const automata_table_t *table, pbio_port_id_t *ports) {
+    uint8_t n = 0;
+    if (table->devices & AUTOMATA_DEVICE_BASE) {
+        ports[n++] = table->ports.left_motor;
+        ports[n++] = table->ports.right_motor;
+    }
+    if (table->devices & AUTOMATA_DEVICE_ULTRASONIC) {
+        ports[n++] = table->ports.ultrasonic;
+    }
+    if (table->devices & AUTOMATA_DEVICE_COLOR) {
+        ports[n++] = table->ports.color;
+    }
+    return n;
+}
+
+/**
+ * Some running instance uses a port of the table.
+ */
+static bool ports_in_use(const automata_table_t *table) {
+    pbio_port_id_t ports[4];
+    pbio_port_id_t used[4];
+    uint8_t n = get_ports(table, ports);
+    for (uint8_t i = 0; i < num_active; i++) {
+        uint8_t m = get_ports(order[i]->engine.table, used);
+        for (uint8_t j = 0; j < n; j++) {
+            for (uint8_t k = 0; k < m; k++) {
+                if (ports[j] == used[k]) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+pbio_error_t automata_scheduler_start(const automata_table_t *table, automata_instance_t **started) {
+    automata_instance_t *instance = NULL;
+    for (uint8_t i = 0; i < AUTOMATA_SCHEDULER_MAX_INSTANCES; i++) {
+        if (instances[i].active && instances[i].engine.table == table) {
+            // Same automaton would share its devices.
+            return PBIO_ERROR_BUSY;
+        }
+        if (!instances[i].active && !instance) {
+            instance = &instances[i];
+        }
+    }
+    if (!instance) {
+        return PBIO_ERROR_BUSY;
+    }
+
+    // Two automata driving the same motors or reading the same sensors
+    // would reconfigure them under each other.
+    if (ports_in_use(table)) {
+        return PBIO_ERROR_BUSY;
+    }
+
+    memset(&instance->stats, 0, sizeof(instance->stats));
+    if (!automata_engine_start(&instance->engine, table)) {
+        last_error = instance->engine.ctx.err;
+        return last_error;
+    }
+
+    instance->active = true;
+    instance->next_tick = pbdrv_clock_get_ms();
+    insert_by_priority(instance);
+    if (started) {
+        *started = instance;
+    }
+    return PBIO_SUCCESS;
+}
+
+void automata_scheduler_stop(automata_instance_t *instance) {
+    if (!instance->active) {
+        return;
+    }
+    automata_engine_print_exit(&instance->engine);
+    automata_engine_stop(&instance->engine);
+    if (instance->engine.ctx.err != PBIO_SUCCESS) {
+        last_error = instance->engine.ctx.err;
+    }
+    instance->active = false;
+    remove_from_order(instance);
+}
+
+void automata_scheduler_stop_all(void) {
+    while (num_active > 0) {
+        automata_scheduler_stop(order[num_active - 1]);
+    }
+}
+
+bool automata_scheduler_is_running(void) {
+    return num_active > 0;
+}
+
+static void tick_instance(automata_instance_t *instance, uint32_t now) {
+    automata_stats_t *stats = &instance->stats;
+    uint32_t period = get_period(instance);
+
+    uint32_t start = pbdrv_clock_get_us();
+    automata_engine_tick(&instance->engine);
+    uint32_t duration = pbdrv_clock_get_us() - start;
+
+    if (automata_telemetry_is_enabled()) {
+        automata_telemetry_tick(instance - instances, &instance->engine);
+    }
+
+    stats->ticks++;
+    stats->cpu_time += duration;
+    if (duration > stats->max_tick_time) {
+        stats->max_tick_time = duration;
+    }
+
+    // Keep ticks aligned to the period. If a whole period was missed,
+    // count it and continue from now instead of running missed ticks.
+    instance->next_tick += period;
+    if ((int32_t) (now - instance->next_tick) >= 0) {
+        stats->overruns++;
+        instance->next_tick = now + period;
+    }
+}
+
+uint32_t automata_scheduler_run(uint32_t now) {
+    // Instances ticking now share values of devices.
+    automata_snapshot_begin();
+
+    // Instances are ordered by priority, so higher priority runs first
+    // when more deadlines passed at once.
+    uint8_t i = 0;
+    while (i < num_active) {
+        automata_instance_t *instance = order[i];
+        if ((int32_t) (now - instance->next_tick) >= 0) {
+            tick_instance(instance, now);
+            if (automata_engine_should_end(&instance->engine)) {
+                if (instance->engine.ctx.err != PBIO_SUCCESS) {
+                    // Post-mortem of transitions which led to the error.
+                    automata_trace_dump_start();
+                }
+                // Next instance is shifted to this index.
+                automata_scheduler_stop(instance);
+                continue;
+            }
+        }
+        i++;
+    }
+
+    uint32_t wait = UINT32_MAX;
+    for (uint8_t i = 0; i < num_active; i++) {
+        int32_t remaining = order[i]->next_tick - now;
+        if (remaining <= 0) {
+            return 0;
+        }
+        if ((uint32_t) remaining < wait) {
+            wait = remaining;
+        }
+    }
+    return wait;
+}
+
+void automata_scheduler_wake(uint32_t now, const pbdrv_legodev_dev_t *sensor) {
+    for (uint8_t i = 0; i < num_active; i++) {
+        if (automata_engine_uses_sensor(&order[i]->engine, sensor)) {
+            order[i]->next_tick = now;
+        }
+    }
+}
+
+pbio_error_t automata_scheduler_get_last_error(void) {
+    return last_error;
+}
+
+static void print_stat(const char *message, uint32_t value) {
+    long number = value;
+    parameters[10] = (char *) message;
+    parameters[11] = &number;
+    print_value();
+}
+
+void automata_scheduler_print_stats(void) {
+    for (uint8_t i = 0; i < num_active; i++) {
+        const automata_instance_t *instance = order[i];
+        const automata_stats_t *stats = &instance->stats;
+        parameters[10] = (char *) instance->engine.table->name;
+        print_message();
+        print_stat("Ticks: ", stats->ticks);
+        print_stat("Overruns: ", stats->overruns);
+        print_stat("Avg tick [us]: ", stats->ticks ? stats->cpu_time / stats->ticks : 0);
+        print_stat("Max tick [us]: ", stats->max_tick_time);
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "engine.h"
+
+/**
+ * Maximum number of automata running at the same time.
+ */
+#define AUTOMATA_SCHEDULER_MAX_INSTANCES (4)
+
+/**
+ * Run time statistics of one instance.
+ */
+typedef struct {
+    /** Number of ticks. */
+    uint32_t ticks;
+    /** Ticks which started more than one period after their deadline. */
+    uint32_t overruns;
+    /** Total time spent in ticks [us]. */
+    uint32_t cpu_time;
+    /** Longest tick [us]. */
+    uint32_t max_tick_time;
+} automata_stats_t;
+
+/**
+ * Automaton scheduled with its own period and priority.
+ */
+typedef struct {
+    automata_engine_t engine;
+    automata_stats_t stats;
+    /** Time of next tick [ms]. */
+    uint32_t next_tick;
+    bool active;
+} automata_instance_t;
+
+/**
+ * Start new instance of automaton. Period and priority are taken from table.
+ * @param [in]  table       Automaton to start.
+ * @param [out] started     Started instance, may be NULL.
+ * @return                  ::PBIO_ERROR_BUSY if there is no free slot, the
+ *                          automaton already runs or another running automaton
+ *                          uses one of its ports, otherwise error of starting.
+ */
+pbio_error_t automata_scheduler_start(const automata_table_t *table, automata_instance_t **started);
+
+/**
+ * Call exit actions of instance and remove it from scheduler.
+ */
+void automata_scheduler_stop(automata_instance_t *instance);
+
+/**
+ * Stop all running instances.
+ */
+void automata_scheduler_stop_all(void);
+
+/**
+ * Some instance is running.
+ */
+bool automata_scheduler_is_running(void);
+
+/**
+ * Tick all instances whose deadline passed, in order of priority.
+ * Instances which end are stopped and removed.
+ * <br><br> Returns time until next deadline [ms].
+ */
+uint32_t automata_scheduler_run(uint32_t now);
+
+/**
+ * Make instances which use the sensor due now, so the next run ticks them
+ * without waiting for their period. Used when data of the sensor changed.
+ */
+void automata_scheduler_wake(uint32_t now, const pbdrv_legodev_dev_t *sensor);
+
+/**
+ * Error which ended the last stopped instance.
+ */
+pbio_error_t automata_scheduler_get_last_error(void);
+
+/**
+ * Print statistics of all running instances.
+ */
+void automata_scheduler_print_stats(void);
@@ -5,6 +5,62 @@
 #include <pbdrv/legodev.h>
 
 #include "automata.h"
+#include "context.h"
+
+/*
+ * Typed interface. Every call takes context of the automaton, returns error
+ * code directly and records the first failure in the context.
+ */
+
+/**
+ * Getting instance of sensor of given type on the port.
+ */
+static inline pbio_error_t automata_sensor_get(automata_ctx_t *ctx, pbio_port_id_t port, pbdrv_legodev_type_id_t type, pbdrv_legodev_dev_t **sensor) {
+    return automata_ctx_check(ctx, pbdrv_legodev_get_device(port, &type, sensor), "Err get_sensor: ");
+}
+
+/**
+ * Getting pointer to data of sensor in given mode. Format of data depends on mode.
+ */
+static inline pbio_error_t automata_sensor_get_data(automata_ctx_t *ctx, pbdrv_legodev_dev_t *sensor, uint8_t mode, void **data) {
+    return automata_ctx_check(ctx, pbdrv_legodev_get_data(sensor, mode, data), "Err sensor_get_data: ");
+}
+
+/**
+ * Waking automata when data of sensor in given mode changes, so they do not
+ * wait for their next tick. With filter, only crossing of its thresholds wakes them.
+ */
+static inline pbio_error_t automata_sensor_notify(automata_ctx_t *ctx, pbdrv_legodev_dev_t *sensor, uint8_t mode, const pbdrv_legodev_data_filter_t *filter) {
+    return automata_ctx_check(ctx, pbdrv_legodev_set_data_notify(sensor, mode, filter), "Err sensor_notify: ");
+}
+
+/**
+ * Getting low data of the distance [mm], -1 if there is no object.
+ */
+static inline pbio_error_t automata_distance_get(automata_ctx_t *ctx, pbdrv_legodev_dev_t *sensor, int32_t *distance) {
+    int16_t *data;
+    pbio_error_t err = automata_sensor_get_data(ctx, sensor, PBDRV_LEGODEV_MODE_PUP_ULTRASONIC_SENSOR__DISTL, (void **) &data);
+    if (err == PBIO_SUCCESS) {
+        *distance = *data;
+    }
+    return err;
+}
+
+/**
+ * Getting color (color enum is in SPIKE Prime documentations).
+ */
+static inline pbio_error_t automata_color_get(automata_ctx_t *ctx, pbdrv_legodev_dev_t *sensor, int32_t *color) {
+    int8_t *data;
+    pbio_error_t err = automata_sensor_get_data(ctx, sensor, PBDRV_LEGODEV_MODE_PUP_COLOR_SENSOR__COLOR, (void **) &data);
+    if (err == PBIO_SUCCESS) {
+        *color = *data;
+    }
+    return err;
+}
+
+/*
+ * Compatibility interface. Arguments are passed through global parameters array.
+ */
 
 /**
  * Getting instance of the distance sensor.
@@ -0,0 +1,79 @@
+#include "automata.h"
+
+typedef struct {
+    const void *device;
+    uint8_t input;
+    bool used;
+    /** Snapshot in which sample was read. */
+    uint32_t snapshot;
+    automata_sample_t sample;
+} entry_t;
+
+static entry_t entries[AUTOMATA_SNAPSHOT_SIZE];
+
+/**
+ * Current snapshot, starts at 1 so unused entries are never current.
+ */
+static uint32_t snapshot = 1;
+
+/**
+ * Last sequence number, shared by all samples, so that a reused entry
+ * never repeats number of the sample it replaced.
+ */
+static uint32_t last_seq;
+
+static entry_t *find_entry(const void *device, uint8_t input) {
+    for (uint8_t i = 0; i < AUTOMATA_SNAPSHOT_SIZE; i++) {
+        if (entries[i].used && entries[i].device == device && entries[i].input == input) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Free entry, or the one which was not read for the longest time.
+ */
+static entry_t *new_entry(void) {
+    entry_t *oldest = &entries[0];
+    for (uint8_t i = 0; i < AUTOMATA_SNAPSHOT_SIZE; i++) {
+        if (!entries[i].used) {
+            return &entries[i];
+        }
+        if (entries[i].snapshot < oldest->snapshot) {
+            oldest = &entries[i];
+        }
+    }
+    return oldest;
+}
+
+void automata_snapshot_begin(void) {
+    snapshot++;
+}
+
+const automata_sample_t *automata_snapshot_get(const void *device, uint8_t input) {
+    entry_t *entry = find_entry(device, input);
+    if (!entry || entry->snapshot != snapshot) {
+        return NULL;
+    }
+    return &entry->sample;
+}
+
+const automata_sample_t *automata_snapshot_put(const void *device, uint8_t input, int32_t value) {
+    entry_t *entry = find_entry(device, input);
+    if (!entry) {
+        entry = new_entry();
+        entry->device = device;
+        entry->input = input;
+        entry->used = true;
+        entry->sample.seq = 0;
+    }
+
+    if (entry->sample.seq == 0 || entry->sample.value != value) {
+        entry->sample.seq = ++last_seq;
+        entry->sample.value = value;
+    }
+    entry->sample.time = pbdrv_clock_get_ms();
+    entry->snapshot = snapshot;
+    return &entry->sample;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "scheduler.h"
+
+/**
+ * Number of cached samples. Every instance can read each of its inputs.
+ */
+#define AUTOMATA_SNAPSHOT_SIZE (AUTOMATA_SCHEDULER_MAX_INSTANCES * AUTOMATA_NUM_INPUTS)
+
+/**
+ * Value of one input of one device.
+ */
+typedef struct {
+    int32_t value;
+    /** Changes whenever value differs from the previous read, never 0. */
+    uint32_t seq;
+    /** Time of the read [ms]. */
+    uint32_t time;
+} automata_sample_t;
+
+/**
+ * Start new snapshot. Samples read before are kept only to compare
+ * with new values, so each device is read at most once per snapshot.
+ */
+void automata_snapshot_begin(void);
+
+/**
+ * Sample of the input of device read in current snapshot.
+ * <br><br> Returns NULL if it was not read yet.
+ */
+const automata_sample_t *automata_snapshot_get(const void *device, uint8_t input);
+
+/**
+ * Store value which was read from the input of device in current snapshot.
+ * <br><br> Returns the stored sample.
+ */
+const automata_sample_t *automata_snapshot_put(const void *device, uint8_t input, int32_t value);
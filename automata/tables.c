@@ -0,0 +1,269 @@
+#include <pbio/util.h>
+
+#include "tables.h"
+
+#define ALWAYS {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_ALWAYS, 0}
+
+/**
+ * follow states:<br>
+ * 0 => stop<br>
+ * 1 => back<br>
+ * 2 => forward
+ */
+enum {
+    FOLLOW_STOP,
+    FOLLOW_BACK,
+    FOLLOW_FORWARD,
+};
+
+static const automata_guard_t follow_guards[] = {
+    /* 0 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_GT, 150},
+    /* 1 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_LT, 300},
+    /* 2 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_LT, 140},
+    /* 3 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_GT, 310},
+};
+
+static const automata_action_t follow_actions[] = {
+    /* 0 */ {AUTOMATA_ACTION_BASE_STOP, {0}},
+    /* 1 */ {AUTOMATA_ACTION_BASE_RUN_FOREVER, {250, 0}},
+    /* 2 */ {AUTOMATA_ACTION_BASE_RUN_FOREVER, {-250, 0}},
+};
+
+static const automata_transition_t follow_transitions[] = {
+    // stop
+    {.guards = {2, 1}, .actions = {1, 1}, .target = FOLLOW_BACK},
+    {.guards = {3, 1}, .actions = {2, 1}, .target = FOLLOW_FORWARD},
+    // back
+    {.guards = {0, 1}, .actions = {0, 1}, .target = FOLLOW_STOP},
+    // forward
+    {.guards = {1, 1}, .actions = {0, 1}, .target = FOLLOW_STOP},
+};
+
+static const automata_state_t follow_states[] = {
+    [FOLLOW_STOP] = {"stop", {0, 2}},
+    [FOLLOW_BACK] = {"back", {2, 1}},
+    [FOLLOW_FORWARD] = {"forward", {3, 1}},
+};
+
+const automata_table_t automata_follow_table = {
+    .name = "follow",
+    .states = follow_states,
+    .transitions = follow_transitions,
+    .guards = follow_guards,
+    .actions = follow_actions,
+    .num_states = PBIO_ARRAY_SIZE(follow_states),
+    .initial_state = FOLLOW_STOP,
+    .priority = 1,
+    .period = 10,
+    .inputs = AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_DISTANCE),
+    .devices = AUTOMATA_DEVICE_BASE | AUTOMATA_DEVICE_ULTRASONIC,
+    .ports = {
+        .left_motor = PBIO_PORT_ID_B,
+        .left_direction = PBIO_DIRECTION_CLOCKWISE,
+        .right_motor = PBIO_PORT_ID_D,
+        .right_direction = PBIO_DIRECTION_COUNTERCLOCKWISE,
+        .ultrasonic = PBIO_PORT_ID_C,
+    },
+    .exit = {0, 1},
+};
+
+/**
+ * discover states:<br>
+ * 0 => run (in active)<br>
+ * 1 => stop (in active)<br>
+ * 2 => start_turn (in turn)<br>
+ * 3 => end_turn (in turn)<br>
+ * 4 => turn (in active)<br>
+ * 5 => active<br>
+ * 6 => halt
+ */
+enum {
+    DISCOVER_RUN,
+    DISCOVER_STOP,
+    DISCOVER_START_TURN,
+    DISCOVER_END_TURN,
+    DISCOVER_TURN,
+    DISCOVER_ACTIVE,
+    DISCOVER_HALT,
+};
+
+static const automata_guard_t discover_guards[] = {
+    /* 0 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_LT, 140},
+    /* 1 */ {AUTOMATA_INPUT_COLOR, AUTOMATA_OP_EQ, 0}, // black
+    /* 2 */ {AUTOMATA_INPUT_COLOR, AUTOMATA_OP_EQ, 10}, // white
+    /* 3 */ {AUTOMATA_INPUT_COLOR, AUTOMATA_OP_EQ, 7}, // yellow
+    /* 4 */ {AUTOMATA_INPUT_COLOR, AUTOMATA_OP_EQ, 3}, // blue
+    /* 5 */ {AUTOMATA_INPUT_COLOR, AUTOMATA_OP_EQ, 5}, // turquoise
+    /* 6 */ {AUTOMATA_INPUT_COLOR, AUTOMATA_OP_EQ, 9}, // red
+    /* 7 */ {AUTOMATA_INPUT_BASE_DONE, AUTOMATA_OP_EQ, 1},
+    /* 8 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_GT, 150},
+    /* 9 */ ALWAYS,
+    /* 10 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_LT, 50},
+};
+
+static const automata_action_t discover_actions[] = {
+    /* 0 */ {AUTOMATA_ACTION_BASE_STOP, {0}},
+    /* 1 */ {AUTOMATA_ACTION_BASE_RUN_ANGLE, {0, 300}},
+    /* 2 */ {AUTOMATA_ACTION_BASE_RUN_ANGLE, {0, 150}},
+    /* 3 */ {AUTOMATA_ACTION_BASE_RUN_ANGLE, {0, -150}},
+    /* 4 */ {AUTOMATA_ACTION_BASE_RUN_ANGLE, {0, -300}},
+    /* 5 */ {AUTOMATA_ACTION_BASE_RUN_ANGLE, {0, -450}},
+    /* 6 */ {AUTOMATA_ACTION_BASE_RUN_ANGLE, {0, 450}},
+    /* 7 */ {AUTOMATA_ACTION_BASE_RUN_FOREVER, {-200, 0}},
+};
+
+static const automata_transition_t discover_transitions[] = {
+    // run
+    {.guards = {0, 1}, .actions = {0, 1}, .target = DISCOVER_STOP},
+    // stop, unknown color keeps robot in this state
+    {.guards = {1, 1}, .actions = {1, 1}, .target = DISCOVER_TURN},
+    {.guards = {2, 1}, .actions = {2, 1}, .target = DISCOVER_TURN},
+    {.guards = {3, 1}, .actions = {3, 1}, .target = DISCOVER_TURN},
+    {.guards = {4, 1}, .actions = {4, 1}, .target = DISCOVER_TURN},
+    {.guards = {5, 1}, .actions = {5, 1}, .target = DISCOVER_TURN},
+    {.guards = {6, 1}, .actions = {6, 1}, .target = DISCOVER_TURN},
+    // start_turn
+    {.guards = {7, 1}, .actions = {0, 0}, .target = DISCOVER_END_TURN},
+    // end_turn
+    {.guards = {8, 1}, .actions = {7, 1}, .target = DISCOVER_RUN},
+    {.guards = {9, 1}, .actions = {0, 0}, .target = DISCOVER_STOP},
+    // active, emergency stop in any substate, checked before their transitions
+    {.guards = {10, 1}, .actions = {0, 1}, .target = DISCOVER_HALT},
+    // halt, obstacle was removed
+    {.guards = {8, 1}, .actions = {7, 1}, .target = DISCOVER_ACTIVE},
+};
+
+static const automata_state_t discover_states[] = {
+    [DISCOVER_RUN] = {"run", {0, 1}},
+    [DISCOVER_STOP] = {"stop", {1, 6}},
+    [DISCOVER_START_TURN] = {"start_turn", {7, 1}},
+    [DISCOVER_END_TURN] = {"end_turn", {8, 2}},
+    // Turn starts in start_turn, its first child.
+    [DISCOVER_TURN] = {"turn", {0, 0}},
+    // Active starts in run.
+    [DISCOVER_ACTIVE] = {"active", {10, 1}},
+    [DISCOVER_HALT] = {"halt", {11, 1}},
+};
+
+static const uint8_t discover_parents[] = {
+    [DISCOVER_RUN] = DISCOVER_ACTIVE,
+    [DISCOVER_STOP] = DISCOVER_ACTIVE,
+    [DISCOVER_START_TURN] = DISCOVER_TURN,
+    [DISCOVER_END_TURN] = DISCOVER_TURN,
+    [DISCOVER_TURN] = DISCOVER_ACTIVE,
+    [DISCOVER_ACTIVE] = AUTOMATA_NO_STATE,
+    [DISCOVER_HALT] = AUTOMATA_NO_STATE,
+};
+
+const automata_table_t automata_discover_table = {
+    .name = "discover",
+    .states = discover_states,
+    .transitions = discover_transitions,
+    .guards = discover_guards,
+    .actions = discover_actions,
+    .parents = discover_parents,
+    .num_states = PBIO_ARRAY_SIZE(discover_states),
+    .initial_state = DISCOVER_END_TURN,
+    .priority = 1,
+    .period = 10,
+    .inputs = AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_DISTANCE)
+        | AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_COLOR)
+        | AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_BASE_DONE),
+    .devices = AUTOMATA_DEVICE_BASE | AUTOMATA_DEVICE_ULTRASONIC | AUTOMATA_DEVICE_COLOR,
+    .ports = {
+        .left_motor = PBIO_PORT_ID_B,
+        .left_direction = PBIO_DIRECTION_CLOCKWISE,
+        .right_motor = PBIO_PORT_ID_D,
+        .right_direction = PBIO_DIRECTION_COUNTERCLOCKWISE,
+        .ultrasonic = PBIO_PORT_ID_C,
+        .color = PBIO_PORT_ID_F,
+    },
+    .exit = {0, 1},
+};
+
+/**
+ * tilt states:<br>
+ * 0 => middle<br>
+ * 1 => right<br>
+ * 2 => left<br>
+ * 3 => up<br>
+ * 4 => down
+ */
+enum {
+    TILT_MIDDLE,
+    TILT_RIGHT,
+    TILT_LEFT,
+    TILT_UP,
+    TILT_DOWN,
+};
+
+static const automata_guard_t tilt_guards[] = {
+    /* 0 */ {AUTOMATA_INPUT_ANGLE_Y, AUTOMATA_OP_GE, 35},
+    /* 1 */ {AUTOMATA_INPUT_ANGLE_Y, AUTOMATA_OP_LE, -35},
+    /* 2 */ {AUTOMATA_INPUT_ANGLE_X, AUTOMATA_OP_GE, 35},
+    /* 3 */ {AUTOMATA_INPUT_ANGLE_X, AUTOMATA_OP_LE, -35},
+    // back in the middle
+    /* 4 */ {AUTOMATA_INPUT_ANGLE_X, AUTOMATA_OP_GT, -25},
+    /* 5 */ {AUTOMATA_INPUT_ANGLE_X, AUTOMATA_OP_LT, 25},
+    /* 6 */ {AUTOMATA_INPUT_ANGLE_Y, AUTOMATA_OP_GT, -25},
+    /* 7 */ {AUTOMATA_INPUT_ANGLE_Y, AUTOMATA_OP_LT, 25},
+};
+
+static const automata_action_t tilt_actions[] = {
+    /* 0 */ {AUTOMATA_ACTION_MATRIX_CLEAR, {0}},
+    /* 1 */ {AUTOMATA_ACTION_MATRIX_SET_PIXEL, {2, 2, 100}},
+    /* 2 */ {AUTOMATA_ACTION_MATRIX_CLEAR, {0}},
+    /* 3 */ {AUTOMATA_ACTION_MATRIX_SET_PIXEL, {0, 2, 100}},
+    /* 4 */ {AUTOMATA_ACTION_MATRIX_CLEAR, {0}},
+    /* 5 */ {AUTOMATA_ACTION_MATRIX_SET_PIXEL, {4, 2, 100}},
+    /* 6 */ {AUTOMATA_ACTION_MATRIX_CLEAR, {0}},
+    /* 7 */ {AUTOMATA_ACTION_MATRIX_SET_PIXEL, {2, 4, 100}},
+    /* 8 */ {AUTOMATA_ACTION_MATRIX_CLEAR, {0}},
+    /* 9 */ {AUTOMATA_ACTION_MATRIX_SET_PIXEL, {2, 0, 100}},
+};
+
+static const automata_transition_t tilt_transitions[] = {
+    // middle, every transition clears matrix and sets one pixel
+    {.guards = {0, 1}, .actions = {2, 2}, .target = TILT_RIGHT},
+    {.guards = {1, 1}, .actions = {4, 2}, .target = TILT_LEFT},
+    {.guards = {2, 1}, .actions = {6, 2}, .target = TILT_UP},
+    {.guards = {3, 1}, .actions = {8, 2}, .target = TILT_DOWN},
+    // right, left, up, down
+    {.guards = {4, 4}, .actions = {0, 0}, .target = TILT_MIDDLE},
+};
+
+static const automata_state_t tilt_states[] = {
+    [TILT_MIDDLE] = {"middle", {0, 4}},
+    [TILT_RIGHT] = {"right", {4, 1}},
+    [TILT_LEFT] = {"left", {4, 1}},
+    [TILT_UP] = {"up", {4, 1}},
+    [TILT_DOWN] = {"down", {4, 1}},
+};
+
+const automata_table_t automata_tilt_table = {
+    .name = "tilt",
+    .states = tilt_states,
+    .transitions = tilt_transitions,
+    .guards = tilt_guards,
+    .actions = tilt_actions,
+    .num_states = PBIO_ARRAY_SIZE(tilt_states),
+    .initial_state = TILT_MIDDLE,
+    .priority = 2,
+    .period = 20,
+    .inputs = AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_ANGLE_X)
+        | AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_ANGLE_Y)
+        | AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_ANGLE_Z),
+    .devices = AUTOMATA_DEVICE_IMU,
+    .start = {0, 2},
+    .exit = {0, 1},
+};
+
+const automata_table_t *const automata_tables[] = {
+    &automata_follow_table,
+    &automata_discover_table,
+    &automata_tilt_table,
+    &automata_follow_compiled_table,
+    &automata_tilt_compiled_table,
+};
+
+const uint8_t automata_num_tables = PBIO_ARRAY_SIZE(automata_tables);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "engine.h"
+
+/**
+ * Robot keeps distance from object in front of ultrasonic sensor.
+ */
+extern const automata_table_t automata_follow_table;
+
+/**
+ * Robot drives until wall and turns by color under color sensor.
+ */
+extern const automata_table_t automata_discover_table;
+
+/**
+ * Hub light matrix shows side to which the hub is tilted.
+ */
+extern const automata_table_t automata_tilt_table;
+
+/**
+ * Same as follow, compiled from automata/descriptions/follow.json
+ * by tools/automata_compile.py.
+ */
+extern const automata_table_t automata_follow_compiled_table;
+
+/**
+ * Same as tilt, compiled from automata/descriptions/tilt.json
+ * by tools/automata_compile.py.
+ */
+extern const automata_table_t automata_tilt_compiled_table;
+
+/**
+ * Built-in automata, index is command number sent over Bluetooth.
+ */
+extern const automata_table_t *const automata_tables[];
+
+extern const uint8_t automata_num_tables;
@@ -0,0 +1,209 @@
+#include <lwrb/lwrb.h>
+
+#include <pbio/util.h>
+
+#include "automata.h"
+
+#define SYNC_SIZE (7)
+#define HEADER_SIZE (3)
+#define TICK_SIZE (HEADER_SIZE + 3)
+#define FLOAT_SIZE (HEADER_SIZE + 1 + sizeof(float))
+
+_Static_assert(AUTOMATA_TELEMETRY_MIN_FRAME_SIZE == TICK_SIZE, "tick frame is the shortest");
+
+static uint8_t ring_data[AUTOMATA_TELEMETRY_BUFFER_SIZE + 1];
+static lwrb_t ring;
+
+/**
+ * Frames are copied here and sent together in one event.
+ */
+static uint8_t payload[AUTOMATA_TELEMETRY_BUFFER_SIZE];
+
+static bool enabled;
+
+/**
+ * Time of the last queued frame. Sync frame is queued first if it is not valid.
+ */
+static uint32_t last_time;
+static bool last_time_valid;
+
+static uint32_t dropped;
+
+/**
+ * Frames dropped since the last sync frame.
+ */
+static uint16_t gap;
+
+void automata_telemetry_enable(bool enable) {
+    if (!lwrb_is_ready(&ring)) {
+        lwrb_init(&ring, ring_data, sizeof(ring_data));
+    }
+    lwrb_reset(&ring);
+    enabled = enable;
+    last_time_valid = false;
+    gap = 0;
+}
+
+bool automata_telemetry_is_enabled(void) {
+    return enabled;
+}
+
+uint32_t automata_telemetry_get_dropped(void) {
+    return dropped;
+}
+
+static void drop_frames(uint32_t count) {
+    dropped += count;
+    gap = gap + count > UINT16_MAX ? UINT16_MAX : gap + count;
+    // Receiver learns about the gap from the next sync frame.
+    last_time_valid = false;
+}
+
+/**
+ * Drop all queued frames. Gaps announced by queued sync frames are added
+ * to the next sync frame, so the receiver still learns about them.
+ */
+static void drop_queued(void) {
+    uint32_t full = lwrb_get_full(&ring);
+    uint32_t count = 0;
+    for (uint32_t offset = 0; offset < full;) {
+        uint8_t header[SYNC_SIZE];
+        lwrb_peek(&ring, offset, header, sizeof(header));
+        if (header[0] == AUTOMATA_TELEMETRY_FRAME_SYNC) {
+            count += pbio_get_uint16_le(&header[5]);
+        } else {
+            dropped++;
+            count++;
+        }
+        offset += automata_telemetry_get_frame_size(header);
+    }
+    lwrb_reset(&ring);
+    gap = gap + count > UINT16_MAX ? UINT16_MAX : gap + count;
+    last_time_valid = false;
+}
+
+uint32_t automata_telemetry_get_frame_size(const uint8_t *frame) {
+    switch (frame[0]) {
+        case AUTOMATA_TELEMETRY_FRAME_SYNC:
+            return SYNC_SIZE;
+        case AUTOMATA_TELEMETRY_FRAME_TICK: {
+            uint32_t size = TICK_SIZE;
+            for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+                if (frame[5] & AUTOMATA_INPUT_MASK(i)) {
+                    size += 2;
+                }
+            }
+            return size;
+        }
+        default:
+            return FLOAT_SIZE;
+    }
+}
+
+bool automata_telemetry_flush(void) {
+    uint32_t max_size = pbsys_bluetooth_tx_app_data_get_max_size();
+
+    while (lwrb_get_full(&ring)) {
+        // Whole frames which fit into one event.
+        uint32_t full = lwrb_get_full(&ring);
+        uint32_t size = 0;
+        while (size < full) {
+            uint8_t header[AUTOMATA_TELEMETRY_MIN_FRAME_SIZE];
+            lwrb_peek(&ring, size, header, sizeof(header));
+            uint32_t frame_size = automata_telemetry_get_frame_size(header);
+            if (size + frame_size > max_size) {
+                break;
+            }
+            size += frame_size;
+        }
+        lwrb_peek(&ring, 0, payload, size);
+
+        pbio_error_t err = pbsys_bluetooth_tx_app_data(payload, size);
+        if (err == PBIO_ERROR_AGAIN) {
+            // Previous event is not sent yet.
+            return true;
+        }
+        if (err != PBIO_SUCCESS) {
+            // Nobody receives the frames, e.g. hub is disconnected.
+            drop_queued();
+            return false;
+        }
+        lwrb_skip(&ring, size);
+    }
+    return false;
+}
+
+/**
+ * Write time delta into frame and queue it, after sync frame if time must be
+ * synchronized first. Frame which does not fit is dropped.
+ */
+static void queue_frame(uint8_t *frame, uint32_t size, uint32_t now) {
+    bool sync = !last_time_valid || now - last_time > UINT16_MAX;
+    if (lwrb_get_free(&ring) < size + (sync ? SYNC_SIZE : 0)) {
+        drop_frames(1);
+        return;
+    }
+
+    if (sync) {
+        uint8_t sync_frame[SYNC_SIZE];
+        sync_frame[0] = AUTOMATA_TELEMETRY_FRAME_SYNC;
+        pbio_set_uint32_le(&sync_frame[1], now);
+        pbio_set_uint16_le(&sync_frame[5], gap);
+        lwrb_write(&ring, sync_frame, sizeof(sync_frame));
+        last_time = now;
+        gap = 0;
+    }
+
+    pbio_set_uint16_le(&frame[1], now - last_time);
+    lwrb_write(&ring, frame, size);
+    last_time = now;
+    last_time_valid = true;
+
+    automata_telemetry_flush();
+}
+
+static int16_t saturate(int32_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return value;
+}
+
+void automata_telemetry_tick(uint8_t instance, const automata_engine_t *engine) {
+    uint8_t frame[TICK_SIZE + 2 * AUTOMATA_NUM_INPUTS];
+
+    if (!enabled) {
+        return;
+    }
+
+    uint8_t size = HEADER_SIZE;
+    frame[0] = AUTOMATA_TELEMETRY_FRAME_TICK;
+    frame[size++] = instance;
+    frame[size++] = engine->state;
+    frame[size++] = engine->table->inputs;
+    for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+        if (engine->table->inputs & AUTOMATA_INPUT_MASK(i)) {
+            pbio_set_uint16_le(&frame[size], saturate(engine->values[i]));
+            size += 2;
+        }
+    }
+    queue_frame(frame, size, pbdrv_clock_get_ms());
+}
+
+void automata_telemetry_float(uint8_t id, float value) {
+    uint8_t frame[FLOAT_SIZE];
+
+    if (!enabled) {
+        return;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    frame[0] = AUTOMATA_TELEMETRY_FRAME_FLOAT;
+    frame[HEADER_SIZE] = id;
+    pbio_set_uint32_le(&frame[HEADER_SIZE + 1], bits);
+    queue_frame(frame, sizeof(frame), pbdrv_clock_get_ms());
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "engine.h"
+
+/**
+ * Size of queue of frames waiting for Bluetooth [bytes].
+ */
+#define AUTOMATA_TELEMETRY_BUFFER_SIZE (256)
+
+/**
+ * Interval of sending queued frames when Bluetooth is busy [ms].
+ */
+#define AUTOMATA_TELEMETRY_FLUSH_WAIT_MS (5)
+
+/**
+ * Binary telemetry frames sent in Pybricks application data events. One event
+ * carries as many whole frames as fit into it, the receiver splits them by
+ * their sizes. All numbers are little endian. Each frame except sync starts
+ * with type and time since previous frame (uint16) [ms].
+ * tools/automata_telemetry.py decodes them.
+ */
+typedef enum {
+    /**
+     * Absolute time (uint32) [ms], number of frames dropped before this
+     * frame (uint16, saturated). Sent first, when time delta does not fit
+     * and after frames were dropped because the queue was full.
+     */
+    AUTOMATA_TELEMETRY_FRAME_SYNC,
+    /**
+     * Tick of automaton. instance (uint8), state (uint8), inputs mask (uint8),
+     * values of inputs in the mask in order of automata_input_t (int16, saturated).
+     */
+    AUTOMATA_TELEMETRY_FRAME_TICK,
+    /** Any value. id (uint8), value (float). */
+    AUTOMATA_TELEMETRY_FRAME_FLOAT,
+} automata_telemetry_frame_t;
+
+/**
+ * Every frame is at least this long [bytes].
+ */
+#define AUTOMATA_TELEMETRY_MIN_FRAME_SIZE (6)
+
+/**
+ * Size of frame from its first AUTOMATA_TELEMETRY_MIN_FRAME_SIZE bytes [bytes].
+ */
+uint32_t automata_telemetry_get_frame_size(const uint8_t *frame);
+
+/**
+ * Start or stop sending telemetry. Queued frames are dropped.
+ */
+void automata_telemetry_enable(bool enable);
+
+bool automata_telemetry_is_enabled(void);
+
+/**
+ * Queue state and input values of instance after its tick.
+ */
+void automata_telemetry_tick(uint8_t instance, const automata_engine_t *engine);
+
+/**
+ * Queue value with id chosen by caller.
+ */
+void automata_telemetry_float(uint8_t id, float value);
+
+/**
+ * Send queued frames while Bluetooth takes them.
+ * <br><br> Returns true if frames are still waiting.
+ */
+bool automata_telemetry_flush(void);
+
+/**
+ * Number of frames which were not sent because the queue was full or
+ * the hub was disconnected.
+ */
+uint32_t automata_telemetry_get_dropped(void);
@@ -0,0 +1,101 @@
+// Generated by tools/automata_compile.py from automata/descriptions/tilt.json, do not edit.
+
+#include "automata.h"
+
+static const automata_state_t tilt_compiled_states[] = {
+    {"middle", {0, 0}},
+    {"right", {0, 0}},
+    {"left", {0, 0}},
+    {"up", {0, 0}},
+    {"down", {0, 0}},
+};
+
+static const automata_action_t tilt_compiled_actions[] = {
+    {AUTOMATA_ACTION_MATRIX_CLEAR, {0}},
+    {AUTOMATA_ACTION_MATRIX_SET_PIXEL, {2, 2, 100}},
+    {AUTOMATA_ACTION_MATRIX_CLEAR, {0}},
+};
+
+static bool tilt_compiled_step(automata_engine_t *engine) {
+    automata_ctx_t *ctx = &engine->ctx;
+    const int32_t angle_x = engine->values[AUTOMATA_INPUT_ANGLE_X];
+    const int32_t angle_y = engine->values[AUTOMATA_INPUT_ANGLE_Y];
+
+    switch (engine->state) {
+        case 0: // middle
+            if (angle_y >= 35) {
+                engine->state = 1;
+                if (automata_matrix_clear(ctx, automata_engine_get_light_matrix()) != PBIO_SUCCESS) {
+                    return true;
+                }
+                automata_matrix_set_pixel(ctx, automata_engine_get_light_matrix(), 0, 2, 100);
+                return true;
+            }
+            if (angle_y <= -35) {
+                engine->state = 2;
+                if (automata_matrix_clear(ctx, automata_engine_get_light_matrix()) != PBIO_SUCCESS) {
+                    return true;
+                }
+                automata_matrix_set_pixel(ctx, automata_engine_get_light_matrix(), 4, 2, 100);
+                return true;
+            }
+            if (angle_x >= 35) {
+                engine->state = 3;
+                if (automata_matrix_clear(ctx, automata_engine_get_light_matrix()) != PBIO_SUCCESS) {
+                    return true;
+                }
+                automata_matrix_set_pixel(ctx, automata_engine_get_light_matrix(), 2, 4, 100);
+                return true;
+            }
+            if (angle_x <= -35) {
+                engine->state = 4;
+                if (automata_matrix_clear(ctx, automata_engine_get_light_matrix()) != PBIO_SUCCESS) {
+                    return true;
+                }
+                automata_matrix_set_pixel(ctx, automata_engine_get_light_matrix(), 2, 0, 100);
+                return true;
+            }
+            return false;
+        case 1: // right
+            if (angle_x >= -24 && angle_x <= 24 && angle_y >= -24 && angle_y <= 24) {
+                engine->state = 0;
+                return true;
+            }
+            return false;
+        case 2: // left
+            if (angle_x >= -24 && angle_x <= 24 && angle_y >= -24 && angle_y <= 24) {
+                engine->state = 0;
+                return true;
+            }
+            return false;
+        case 3: // up
+            if (angle_x >= -24 && angle_x <= 24 && angle_y >= -24 && angle_y <= 24) {
+                engine->state = 0;
+                return true;
+            }
+            return false;
+        case 4: // down
+            if (angle_x >= -24 && angle_x <= 24 && angle_y >= -24 && angle_y <= 24) {
+                engine->state = 0;
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+const automata_table_t automata_tilt_compiled_table = {
+    .name = "tilt_compiled",
+    .states = tilt_compiled_states,
+    .actions = tilt_compiled_actions,
+    .num_states = PBIO_ARRAY_SIZE(tilt_compiled_states),
+    .initial_state = 0,
+    .priority = 2,
+    .period = 20,
+    .inputs = AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_ANGLE_X) | AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_ANGLE_Y),
+    .devices = AUTOMATA_DEVICE_IMU,
+    .start = {0, 2},
+    .exit = {2, 1},
+    .step = tilt_compiled_step,
+};
@@ -0,0 +1,77 @@
+#include "automata.h"
+
+static automata_trace_entry_t entries[AUTOMATA_TRACE_SIZE];
+
+/**
+ * Number of recorded transitions, next one is written at count % size.
+ */
+static uint32_t count;
+
+/**
+ * Next entry to print and end of the dump.
+ */
+static uint32_t dump_next;
+static uint32_t dump_end;
+
+void automata_trace_record(const automata_engine_t *engine, uint8_t from, uint8_t transition) {
+    automata_trace_entry_t *entry = &entries[count++ & (AUTOMATA_TRACE_SIZE - 1)];
+    entry->table = engine->table;
+    entry->time = pbdrv_clock_get_ms();
+    entry->from = from;
+    entry->to = engine->state;
+    entry->transition = transition;
+    for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+        entry->values[i] = engine->values[i];
+    }
+}
+
+void automata_trace_dump_start(void) {
+    // Older entries were overwritten.
+    dump_next = count > AUTOMATA_TRACE_SIZE ? count - AUTOMATA_TRACE_SIZE : 0;
+    dump_end = count;
+    automata_print("Trace of %lu transitions:\r\n", (unsigned long) (dump_end - dump_next));
+}
+
+static const char *state_name(const automata_table_t *table, uint8_t state, char *number) {
+    if (table->states[state].name) {
+        return table->states[state].name;
+    }
+    number[0] = '0' + state / 100;
+    number[1] = '0' + state / 10 % 10;
+    number[2] = '0' + state % 10;
+    number[3] = '\0';
+    return number;
+}
+
+static void print_entry(const automata_trace_entry_t *entry) {
+    const automata_table_t *table = entry->table;
+    char from[4];
+    char to[4];
+
+    automata_print("%lu %s %s->%s t%u",
+        (unsigned long) entry->time, table->name,
+        state_name(table, entry->from, from), state_name(table, entry->to, to),
+        entry->transition);
+    for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+        if (table->inputs & AUTOMATA_INPUT_MASK(i)) {
+            automata_print(" %d", entry->values[i]);
+        }
+    }
+    automata_print("\r\n");
+}
+
+bool automata_trace_dump_continue(void) {
+    // Entries which were overwritten while printing are skipped.
+    if (count - dump_next > AUTOMATA_TRACE_SIZE) {
+        dump_next = count - AUTOMATA_TRACE_SIZE;
+    }
+
+    while (dump_next < dump_end) {
+        // One entry is split into more print calls, so whole entry must fit.
+        if (automata_print_get_free() < AUTOMATA_PRINT_LINE_SIZE) {
+            return true;
+        }
+        print_entry(&entries[dump_next++ & (AUTOMATA_TRACE_SIZE - 1)]);
+    }
+    return false;
+}
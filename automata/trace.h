@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "engine.h"
+
+/**
+ * Number of recorded transitions, power of 2.
+ */
+#define AUTOMATA_TRACE_SIZE (64)
+
+/**
+ * Transition index of transitions taken by compiled step function.
+ */
+#define AUTOMATA_TRACE_COMPILED (0xFF)
+
+/**
+ * Interval of printing the rest of dump when print buffer is full [ms].
+ */
+#define AUTOMATA_TRACE_DUMP_WAIT_MS (20)
+
+/**
+ * One taken transition.
+ */
+typedef struct {
+    const automata_table_t *table;
+    /** Time of the tick [ms]. */
+    uint32_t time;
+    uint8_t from;
+    uint8_t to;
+    /** Index of transition in automata_table_t::transitions, its guards fired. */
+    uint8_t transition;
+    /** Inputs of the tick, cut to int16. */
+    int16_t values[AUTOMATA_NUM_INPUTS];
+} automata_trace_entry_t;
+
+/**
+ * Record taken transition. It only copies values, so it can stay on.
+ */
+void automata_trace_record(const automata_engine_t *engine, uint8_t from, uint8_t transition);
+
+/**
+ * Start printing recorded transitions, oldest first.
+ */
+void automata_trace_dump_start(void);
+
+/**
+ * Print next recorded transitions while they fit into print buffer.
+ * <br><br> Returns true if there is more to print.
+ */
+bool automata_trace_dump_continue(void);
@@ -210,6 +210,7 @@ PBIO_SRC_C = $(addprefix lib/pbio/,\
 	src/light/light_matrix.c \
 	src/logger.c \
 	src/main.c \
+	src/motion_group.c \
 	src/motor_process.c \
 	src/motor/servo_settings.c \
 	src/observer.c \
@@ -240,6 +241,15 @@ PBIO_SRC_C = $(addprefix lib/pbio/,\
 	../../automata/motor.c \
 	../../automata/modules.c \
 	../../automata/parameters.c \
+	../../automata/engine.c \
+	../../automata/tables.c \
+	../../automata/scheduler.c \
+	../../automata/snapshot.c \
+	../../automata/telemetry.c \
+	../../automata/trace.c \
+	../../automata/bytecode.c \
+	../../automata/follow_compiled.c \
+	../../automata/tilt_compiled.c \
 	)
 
 # MicroPython math library
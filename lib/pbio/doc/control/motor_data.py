@@ -27,7 +27,6 @@ print(
         w_0=13.3,
         a=math.radians(880 / 0.04),
         Lm=0.0008 * 30,
-        h=0.005,
     )
 )
 
@@ -44,7 +43,6 @@ print(
         w_0=16.6,
         a=math.radians(920 / 0.035),
         Lm=0.0008 * 30,
-        h=0.005,
     )
 )
 
@@ -61,7 +59,6 @@ print(
         w_0=16.6,
         a=math.radians(800 / 0.04),
         Lm=0.0004 * 30,
-        h=0.005,
     )
 )
 
@@ -79,7 +76,6 @@ print(
         w_0=rpm_to_rad_s(255),
         a=math.radians(3000 / 0.1),
         Lm=0.0002 * 30,
-        h=0.005,
     )
 )
 
@@ -96,7 +92,6 @@ print(
         w_0=rpm_to_rad_s(315),
         a=math.radians(3000 / 0.1),
         Lm=0.0003 * 30,
-        h=0.005,
     )
 )
 
@@ -113,7 +108,6 @@ print(
         w_0=rpm_to_rad_s(330),
         a=math.radians(3000 / 0.1),
         Lm=0.0002 * 30,
-        h=0.005,
     )
 )
 
@@ -132,7 +126,6 @@ print(
         w_0=rpm_to_rad_s(350),
         a=math.radians(3000 / 0.1),
         Lm=0.0002 * 30,
-        h=0.005,
     )
 )
 
@@ -155,7 +148,6 @@ print(
         w_0=rpm_to_rad_s(175),
         a=math.radians(1000 / 0.1),
         Lm=0.0005 * 30,
-        h=0.01,
     )
 )
 
@@ -172,7 +164,6 @@ print(
         w_0=rpm_to_rad_s(260),
         a=math.radians(2000 / 0.1),
         Lm=0.0005 * 30,
-        h=0.01,
     )
 )
 print("\n#endif // PBIO_CONFIG_SERVO_EV3_NXT")
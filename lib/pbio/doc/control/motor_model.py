@@ -112,6 +112,7 @@ HEADER = textwrap.dedent(
     #define PRESCALE_TORQUE ({PRESCALE_TORQUE})
 
     typedef struct _pbio_observer_model_t {{
+        uint32_t loop_time;
         int32_t d_angle_d_speed;
         int32_t d_speed_d_speed;
         int32_t d_current_d_speed;
@@ -134,7 +135,13 @@ HEADER = textwrap.dedent(
 )
 
 
-def make_model(name, *, V, tau_0, tau_x, w_0, w_x, i_0, i_x, a, Lm, h):
+# Control loop times in ms for which models are generated. Platforms include
+# the model for their default loop time, or all of them if the loop time can
+# be changed at runtime.
+LOOP_TIMES = (2, 5, 10)
+
+
+def make_model(name, *, V, tau_0, tau_x, w_0, w_x, i_0, i_x, a, Lm):
     """Initialize the model using experimental data"""
 
     # Compute system parameters from motor curve data:
@@ -153,8 +160,17 @@ def make_model(name, *, V, tau_0, tau_x, w_0, w_x, i_0, i_x, a, Lm, h):
     # Substitute parameters into model to get numeric system matrices
     exponent_numeric = numpy.array(exponent.subs(model).evalf().tolist()).astype(numpy.float64)
 
+    entries = "".join(
+        make_model_entry(model, exponent_numeric, tau_s, loop_time) for loop_time in LOOP_TIMES
+    )
+    return f"\nstatic const pbio_observer_model_t model_{name}[] = {{{entries}\n}};"
+
+
+def make_model_entry(model, exponent_numeric, tau_s, loop_time):
+    """Discretize the model for one control loop time"""
+
     # Get matrix exponential and system matrices
-    exponential = scipy.linalg.expm(exponent_numeric * h)
+    exponential = scipy.linalg.expm(exponent_numeric * loop_time / 1000)
     A = exponential[0:3, 0:3]
     B = exponential[0:3, 3:5]
 
@@ -171,27 +187,33 @@ def make_model(name, *, V, tau_0, tau_x, w_0, w_x, i_0, i_x, a, Lm, h):
     #
     # The term (speed_prescale / a_01) is stored as a single integer.
     #
-    return textwrap.dedent(
-        f"""
-        static const pbio_observer_model_t model_{name} = {{
-            .d_angle_d_speed = {round(PRESCALE_SPEED / A[0, 1])},
-            .d_speed_d_speed = {round(PRESCALE_SPEED / A[1, 1])},
-            .d_current_d_speed = {round(PRESCALE_SPEED / A[2, 1])},
-            .d_angle_d_current = {round(PRESCALE_CURRENT / A[0, 2])},
-            .d_speed_d_current = {round(PRESCALE_CURRENT / A[1, 2])},
-            .d_current_d_current = {round(PRESCALE_CURRENT / A[2, 2])},
-            .d_angle_d_voltage = {round(PRESCALE_VOLTAGE / B[0, 0])},
-            .d_speed_d_voltage = {round(PRESCALE_VOLTAGE / B[1, 0])},
-            .d_current_d_voltage = {round(PRESCALE_VOLTAGE / B[2, 0])},
-            .d_angle_d_torque = {round(PRESCALE_TORQUE / B[0, 1])},
-            .d_speed_d_torque = {round(PRESCALE_TORQUE / B[1, 1])},
-            .d_current_d_torque = {round(PRESCALE_TORQUE / B[2, 1])},
-            .d_voltage_d_torque = {round(PRESCALE_TORQUE / dv_dtau.subs(model).evalf())},
-            .d_torque_d_voltage = {round(PRESCALE_VOLTAGE / dtau_dv.subs(model).evalf())},
-            .d_torque_d_speed = {round(PRESCALE_SPEED / dtau_dw.subs(model).evalf())},
-            .d_torque_d_acceleration = {round(PRESCALE_ACCELERATION / dtau_da.subs(model).evalf())},
-            .torque_friction = {round(tau_s * c_tau)},
-        }};"""
+    return textwrap.indent(
+        textwrap.dedent(
+            f"""
+            #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE({loop_time})
+            {{
+                .loop_time = {loop_time},
+                .d_angle_d_speed = {round(PRESCALE_SPEED / A[0, 1])},
+                .d_speed_d_speed = {round(PRESCALE_SPEED / A[1, 1])},
+                .d_current_d_speed = {round(PRESCALE_SPEED / A[2, 1])},
+                .d_angle_d_current = {round(PRESCALE_CURRENT / A[0, 2])},
+                .d_speed_d_current = {round(PRESCALE_CURRENT / A[1, 2])},
+                .d_current_d_current = {round(PRESCALE_CURRENT / A[2, 2])},
+                .d_angle_d_voltage = {round(PRESCALE_VOLTAGE / B[0, 0])},
+                .d_speed_d_voltage = {round(PRESCALE_VOLTAGE / B[1, 0])},
+                .d_current_d_voltage = {round(PRESCALE_VOLTAGE / B[2, 0])},
+                .d_angle_d_torque = {round(PRESCALE_TORQUE / B[0, 1])},
+                .d_speed_d_torque = {round(PRESCALE_TORQUE / B[1, 1])},
+                .d_current_d_torque = {round(PRESCALE_TORQUE / B[2, 1])},
+                .d_voltage_d_torque = {round(PRESCALE_TORQUE / dv_dtau.subs(model).evalf())},
+                .d_torque_d_voltage = {round(PRESCALE_VOLTAGE / dtau_dv.subs(model).evalf())},
+                .d_torque_d_speed = {round(PRESCALE_SPEED / dtau_dw.subs(model).evalf())},
+                .d_torque_d_acceleration = {round(PRESCALE_ACCELERATION / dtau_da.subs(model).evalf())},
+                .torque_friction = {round(tau_s * c_tau)},
+            }},
+            #endif"""
+        ),
+        "    ",
     )
 
 
@@ -215,7 +237,5 @@ if __name__ == "__main__":
             # Estimated acceleration and inductance:
             a=math.radians(920 / 0.035),
             Lm=0.0008 * 30,
-            # System model sample time
-            h=0.005,
         )
     )
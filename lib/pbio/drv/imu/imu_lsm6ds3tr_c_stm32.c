@@ -36,6 +36,26 @@ typedef enum {
     IMU_INIT_STATE_COMPLETE,
 } imu_init_state_t;
 
+/** Number of values in one frame: gyro (xyz) followed by accelerometer (xyz). */
+#define NUM_FRAME_VALUES (6)
+
+/** The size of one frame in bytes. */
+#define NUM_FRAME_BYTES (NUM_FRAME_VALUES * sizeof(int16_t))
+
+/** All data rate dependent values should be defined here so it is clear
+ *  what needs to be changed when the data rate is changed. */
+#define LSM6DS3TR_INITIAL_DATA_RATE (1666)
+#define LSM6DS3TR_GYRO_DATA_RATE (LSM6DS3TR_C_GY_ODR_1k66Hz)
+#define LSM6DS3TR_ACCL_DATA_RATE (LSM6DS3TR_C_XL_ODR_1k66Hz)
+#define LSM6DS3TR_FIFO_DATA_RATE (LSM6DS3TR_C_FIFO_1k66Hz)
+
+/** Number of frames in the FIFO that triggers INT1. This sets the latency
+ *  and the number of wakeups per second, ~2.4 ms and ~416/s respectively. */
+#define LSM6DS3TR_FIFO_WATERMARK_FRAMES (4)
+
+/** Maximum number of frames read from the FIFO in one burst. */
+#define LSM6DS3TR_FIFO_MAX_FRAMES (16)
+
 struct _pbdrv_imu_dev_t {
     /** Driver context for external library. */
     stmdev_ctx_t ctx;
@@ -43,12 +63,16 @@ struct _pbdrv_imu_dev_t {
     I2C_HandleTypeDef hi2c;
     /** IMU configuration to convert raw data to phsyical units. */
     pbdrv_imu_config_t config;
-    /** Callback to process one frame of unfiltered gyro and accelerometer data. */
+    /** Callback to process frames of unfiltered gyro and accelerometer data. */
     pbdrv_imu_handle_frame_data_func_t handle_frame_data;
     /* Callback to process unfiltered gyro and accelerometer data recorded while stationary. */
     pbdrv_imu_handle_stationary_data_func_t handle_stationary_data;
-    /** Raw data. */
-    int16_t data[6];
+    /** Raw FIFO status registers, from FIFO_STATUS1 to FIFO_STATUS4. */
+    uint8_t fifo_status[4];
+    /** Number of frames in the last burst read from the FIFO. */
+    uint32_t num_frames;
+    /** Raw data of frames read from the FIFO in one burst. */
+    int16_t data[LSM6DS3TR_FIFO_MAX_FRAMES][NUM_FRAME_VALUES];
     /** Start time of window in which stationary samples are recorded (us)*/
     uint32_t stationary_time_start;
     /** Raw data point to which new samples are compared to detect stationary. */
@@ -65,17 +89,10 @@ struct _pbdrv_imu_dev_t {
     imu_init_state_t init_state;
     /** INT1 oneshot. */
     volatile bool int1;
+    /** Time spent in the frame data handler, in CPU cycles. */
+    pbdrv_imu_handler_stats_t handler_stats;
 };
 
-/** The size of the data field in pbdrv_imu_dev_t in bytes. */
-#define NUM_DATA_BYTES sizeof(((struct _pbdrv_imu_dev_t *)0)->data)
-
-/** All data rate dependent values should be defined here so it is clear
- *  what needs to be changed when the data rate is changed. */
-#define LSM6DS3TR_INITIAL_DATA_RATE (833)
-#define LSM6DS3TR_GYRO_DATA_RATE (LSM6DS3TR_C_GY_ODR_833Hz)
-#define LSM6DS3TR_ACCL_DATA_RATE (LSM6DS3TR_C_XL_ODR_833Hz)
-
 static pbdrv_imu_dev_t global_imu_dev;
 PROCESS(pbdrv_imu_lsm6ds3tr_c_stm32_process, "LSM6DS3TR-C");
 
@@ -231,17 +248,20 @@ static PT_THREAD(pbdrv_imu_lsm6ds3tr_c_stm32_init(struct pt *pt)) {
     imu_dev->config.gyro_stationary_threshold = 71; // 5 deg/s
     imu_dev->config.accel_stationary_threshold = 1044; // 2500 mm/s^2, or approx 25% of gravity
 
-    // Configure INT1 to trigger when new gyro data is ready.
+    // Store every gyro and accel sample in the FIFO. With equal decimation,
+    // each frame holds gyro (xyz) followed by accel (xyz), just like the
+    // output registers.
+    PT_SPAWN(pt, &child, lsm6ds3tr_c_fifo_gy_batch_set(&child, ctx, LSM6DS3TR_C_FIFO_GY_NO_DEC));
+    PT_SPAWN(pt, &child, lsm6ds3tr_c_fifo_xl_batch_set(&child, ctx, LSM6DS3TR_C_FIFO_XL_NO_DEC));
+    PT_SPAWN(pt, &child, lsm6ds3tr_c_fifo_watermark_set(&child, ctx, LSM6DS3TR_FIFO_WATERMARK_FRAMES * NUM_FRAME_VALUES));
+    PT_SPAWN(pt, &child, lsm6ds3tr_c_fifo_data_rate_set(&child, ctx, LSM6DS3TR_FIFO_DATA_RATE));
+    PT_SPAWN(pt, &child, lsm6ds3tr_c_fifo_mode_set(&child, ctx, LSM6DS3TR_C_STREAM_MODE));
+
+    // Configure INT1 to trigger when the FIFO reaches the watermark.
     PT_SPAWN(pt, &child, lsm6ds3tr_c_pin_int1_route_set(&child, ctx, (lsm6ds3tr_c_int1_route_t) {
-        .int1_drdy_g = 1,
+        .int1_fth = 1,
     }));
 
-    // If we leave the default latched mode, sometimes we don't get the INT1 interrupt.
-    PT_SPAWN(pt, &child, lsm6ds3tr_c_data_ready_mode_set(&child, ctx, LSM6DS3TR_C_DRDY_PULSED));
-
-    // Enable rounding mode so we can get gyro + accel in continuous reads.
-    PT_SPAWN(pt, &child, lsm6ds3tr_c_rounding_mode_set(&child, ctx, LSM6DS3TR_C_ROUND_GY_XL));
-
     if (HAL_I2C_GetError(hi2c) != HAL_I2C_ERROR_NONE) {
         imu_dev->init_state = IMU_INIT_STATE_FAILED;
         PT_EXIT(pt);
@@ -256,40 +276,40 @@ static inline bool is_bounded(int16_t diff, int16_t threshold) {
     return diff < threshold && diff > -threshold;
 }
 
-static void pbdrv_imu_lsm6ds3tr_c_stm32_reset_stationary_buffer(pbdrv_imu_dev_t *imu_dev) {
+static void pbdrv_imu_lsm6ds3tr_c_stm32_reset_stationary_buffer(pbdrv_imu_dev_t *imu_dev, uint32_t frame_time) {
     imu_dev->stationary_sample_count = 0;
-    imu_dev->stationary_time_start = pbdrv_clock_get_us();
+    imu_dev->stationary_time_start = frame_time;
     memset(&imu_dev->stationary_accel_data_sum, 0, sizeof(imu_dev->stationary_accel_data_sum));
     memset(&imu_dev->stationary_gyro_data_sum, 0, sizeof(imu_dev->stationary_gyro_data_sum));
 }
 
-static void pbdrv_imu_lsm6ds3tr_c_stm32_update_stationary_status(pbdrv_imu_dev_t *imu_dev) {
+static void pbdrv_imu_lsm6ds3tr_c_stm32_update_stationary_status(pbdrv_imu_dev_t *imu_dev, const int16_t *data, uint32_t frame_time) {
 
     // Check whether still stationary compared to constant start sample.
-    if (!is_bounded(imu_dev->data[0] - imu_dev->stationary_data_start[0], imu_dev->config.gyro_stationary_threshold) ||
-        !is_bounded(imu_dev->data[1] - imu_dev->stationary_data_start[1], imu_dev->config.gyro_stationary_threshold) ||
-        !is_bounded(imu_dev->data[2] - imu_dev->stationary_data_start[2], imu_dev->config.gyro_stationary_threshold) ||
-        !is_bounded(imu_dev->data[3] - imu_dev->stationary_data_start[3], imu_dev->config.accel_stationary_threshold) ||
-        !is_bounded(imu_dev->data[4] - imu_dev->stationary_data_start[4], imu_dev->config.accel_stationary_threshold) ||
-        !is_bounded(imu_dev->data[5] - imu_dev->stationary_data_start[5], imu_dev->config.accel_stationary_threshold)
+    if (!is_bounded(data[0] - imu_dev->stationary_data_start[0], imu_dev->config.gyro_stationary_threshold) ||
+        !is_bounded(data[1] - imu_dev->stationary_data_start[1], imu_dev->config.gyro_stationary_threshold) ||
+        !is_bounded(data[2] - imu_dev->stationary_data_start[2], imu_dev->config.gyro_stationary_threshold) ||
+        !is_bounded(data[3] - imu_dev->stationary_data_start[3], imu_dev->config.accel_stationary_threshold) ||
+        !is_bounded(data[4] - imu_dev->stationary_data_start[4], imu_dev->config.accel_stationary_threshold) ||
+        !is_bounded(data[5] - imu_dev->stationary_data_start[5], imu_dev->config.accel_stationary_threshold)
         ) {
         // Not stationary anymore, so reset counter and gyro sum data so we can start over.
         imu_dev->stationary_now = false;
-        pbdrv_imu_lsm6ds3tr_c_stm32_reset_stationary_buffer(imu_dev);
+        pbdrv_imu_lsm6ds3tr_c_stm32_reset_stationary_buffer(imu_dev, frame_time);
 
         // Current sample becomes new starting value to compare to.
-        memcpy(&imu_dev->stationary_data_start[0], &imu_dev->data[0], NUM_DATA_BYTES);
+        memcpy(&imu_dev->stationary_data_start[0], data, NUM_FRAME_BYTES);
         return;
     }
 
     // Updating running sum of stationary data.
     imu_dev->stationary_sample_count++;
-    imu_dev->stationary_gyro_data_sum[0] += imu_dev->data[0];
-    imu_dev->stationary_gyro_data_sum[1] += imu_dev->data[1];
-    imu_dev->stationary_gyro_data_sum[2] += imu_dev->data[2];
-    imu_dev->stationary_accel_data_sum[0] += imu_dev->data[3];
-    imu_dev->stationary_accel_data_sum[1] += imu_dev->data[4];
-    imu_dev->stationary_accel_data_sum[2] += imu_dev->data[5];
+    imu_dev->stationary_gyro_data_sum[0] += data[0];
+    imu_dev->stationary_gyro_data_sum[1] += data[1];
+    imu_dev->stationary_gyro_data_sum[2] += data[2];
+    imu_dev->stationary_accel_data_sum[0] += data[3];
+    imu_dev->stationary_accel_data_sum[1] += data[4];
+    imu_dev->stationary_accel_data_sum[2] += data[5];
 
     // Exit if we don't have enough samples yet.
     if (imu_dev->stationary_sample_count < LSM6DS3TR_INITIAL_DATA_RATE) {
@@ -300,7 +320,7 @@ static void pbdrv_imu_lsm6ds3tr_c_stm32_update_stationary_status(pbdrv_imu_dev_t
     imu_dev->stationary_now = true;
 
     // The actual sampling rate is slightly different from the configured rate, so measure it.
-    imu_dev->config.sample_time = (pbdrv_clock_get_us() - imu_dev->stationary_time_start) / 1000000.0f / imu_dev->stationary_sample_count;
+    imu_dev->config.sample_time = (frame_time - imu_dev->stationary_time_start) / 1000000.0f / imu_dev->stationary_sample_count;
 
     // Process the data recorded while stationary.
     if (imu_dev->handle_stationary_data) {
@@ -308,7 +328,7 @@ static void pbdrv_imu_lsm6ds3tr_c_stm32_update_stationary_status(pbdrv_imu_dev_t
     }
 
     // Reset counter and gyro sum data so we can start over.
-    pbdrv_imu_lsm6ds3tr_c_stm32_reset_stationary_buffer(imu_dev);
+    pbdrv_imu_lsm6ds3tr_c_stm32_reset_stationary_buffer(imu_dev, frame_time);
 }
 
 PROCESS_THREAD(pbdrv_imu_lsm6ds3tr_c_stm32_process, ev, data) {
@@ -316,7 +336,6 @@ PROCESS_THREAD(pbdrv_imu_lsm6ds3tr_c_stm32_process, ev, data) {
     I2C_HandleTypeDef *hi2c = &imu_dev->hi2c;
 
     static struct pt child;
-    static uint8_t buf[NUM_DATA_BYTES];
 
     PROCESS_BEGIN();
 
@@ -329,65 +348,110 @@ PROCESS_THREAD(pbdrv_imu_lsm6ds3tr_c_stm32_process, ev, data) {
         PROCESS_EXIT();
     }
 
-retry:
-    // Write the register address of the start of the gyro and accel data.
-    buf[0] = LSM6DS3TR_C_OUTX_L_G;
-    imu_dev->ctx.read_write_done = false;
-    HAL_StatusTypeDef ret = HAL_I2C_Master_Seq_Transmit_IT(
-        &imu_dev->hi2c, LSM6DS3TR_C_I2C_ADD_L, buf, 1, I2C_FIRST_FRAME);
-
-    if (ret != HAL_OK) {
-        pbdrv_imu_lsm6ds3tr_c_stm32_i2c_reset(hi2c);
-        goto retry;
-    }
-
-    PROCESS_WAIT_UNTIL(imu_dev->ctx.read_write_done);
-
-    if (HAL_I2C_GetError(hi2c) != HAL_I2C_ERROR_NONE) {
-        pbdrv_imu_lsm6ds3tr_c_stm32_i2c_reset(hi2c);
-        goto retry;
-    }
-
-    // Since we configured the IMU to enable "rounding" on the accel and gyro
-    // data registers, we can just keep reading forever and it automatically
-    // loops around. This way we don't have to keep writing the register
-    // value each time we want to read new data. This saves CPU usage since
-    // we have fewer interrupts per sample.
+    // Time the frame data handler with the cycle counter, which is much finer
+    // than the microsecond clock.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
     for (;;) {
-        PROCESS_WAIT_EVENT_UNTIL(atomic_exchange(&imu_dev->int1, false));
-
-        imu_dev->ctx.read_write_done = false;
-        ret = HAL_I2C_Master_Seq_Receive_IT(
-            &imu_dev->hi2c, LSM6DS3TR_C_I2C_ADD_L, buf, NUM_DATA_BYTES, I2C_NEXT_FRAME);
-
-        if (ret != HAL_OK) {
-            pbdrv_imu_lsm6ds3tr_c_stm32_i2c_reset(hi2c);
-            goto retry;
-        }
-
-        PROCESS_WAIT_UNTIL(imu_dev->ctx.read_write_done);
-
-        if (HAL_I2C_GetError(hi2c) != HAL_I2C_ERROR_NONE) {
-            pbdrv_imu_lsm6ds3tr_c_stm32_i2c_reset(hi2c);
-            goto retry;
+        // Drain all complete frames from the FIFO. The watermark is a level
+        // signal, so INT1 only fires again once the FIFO has been read down
+        // below the watermark.
+        for (;;) {
+            imu_dev->ctx.read_write_done = false;
+            HAL_StatusTypeDef ret = HAL_I2C_Mem_Read_IT(hi2c, LSM6DS3TR_C_I2C_ADD_L,
+                LSM6DS3TR_C_FIFO_STATUS1, I2C_MEMADD_SIZE_8BIT, imu_dev->fifo_status, sizeof(imu_dev->fifo_status));
+
+            if (ret != HAL_OK) {
+                pbdrv_imu_lsm6ds3tr_c_stm32_i2c_reset(hi2c);
+                continue;
+            }
+
+            PROCESS_WAIT_UNTIL(imu_dev->ctx.read_write_done);
+
+            if (HAL_I2C_GetError(hi2c) != HAL_I2C_ERROR_NONE) {
+                pbdrv_imu_lsm6ds3tr_c_stm32_i2c_reset(hi2c);
+                continue;
+            }
+
+            lsm6ds3tr_c_fifo_status2_t *status2 = (void *)&imu_dev->fifo_status[1];
+            lsm6ds3tr_c_fifo_status4_t *status4 = (void *)&imu_dev->fifo_status[3];
+            uint16_t num_words = imu_dev->fifo_status[0] | (status2->diff_fifo << 8);
+            uint16_t pattern = imu_dev->fifo_status[2] | (status4->fifo_pattern << 8);
+
+            // If samples were lost, or a failed read left the next word
+            // somewhere in the middle of a frame, restart the FIFO so that
+            // the next frame starts with gyro x again.
+            if (status2->over_run || pattern != 0) {
+                PROCESS_PT_SPAWN(&child, lsm6ds3tr_c_fifo_mode_set(&child, &imu_dev->ctx, LSM6DS3TR_C_BYPASS_MODE));
+                PROCESS_PT_SPAWN(&child, lsm6ds3tr_c_fifo_mode_set(&child, &imu_dev->ctx, LSM6DS3TR_C_STREAM_MODE));
+                continue;
+            }
+
+            imu_dev->num_frames = num_words / NUM_FRAME_VALUES;
+            if (imu_dev->num_frames == 0) {
+                break;
+            }
+            if (imu_dev->num_frames > LSM6DS3TR_FIFO_MAX_FRAMES) {
+                imu_dev->num_frames = LSM6DS3TR_FIFO_MAX_FRAMES;
+            }
+
+            // Read all frames in one burst. The register address wraps around
+            // to the start of the FIFO output register after each word.
+            imu_dev->ctx.read_write_done = false;
+            ret = HAL_I2C_Mem_Read_IT(hi2c, LSM6DS3TR_C_I2C_ADD_L, LSM6DS3TR_C_FIFO_DATA_OUT_L,
+                I2C_MEMADD_SIZE_8BIT, (uint8_t *)imu_dev->data, imu_dev->num_frames * NUM_FRAME_BYTES);
+
+            if (ret != HAL_OK) {
+                pbdrv_imu_lsm6ds3tr_c_stm32_i2c_reset(hi2c);
+                continue;
+            }
+
+            PROCESS_WAIT_UNTIL(imu_dev->ctx.read_write_done);
+
+            if (HAL_I2C_GetError(hi2c) != HAL_I2C_ERROR_NONE) {
+                pbdrv_imu_lsm6ds3tr_c_stm32_i2c_reset(hi2c);
+                continue;
+            }
+
+            // All frames of a burst arrive at once. The last one was sampled
+            // just now, and the others one sample time apart before it. Time
+            // them by their position, so that windows of stationary frames
+            // measure the sample time correctly even if they start or end in
+            // the middle of a burst.
+            uint32_t burst_time = pbdrv_clock_get_us();
+
+            for (uint32_t i = 0; i < imu_dev->num_frames; i++) {
+                int16_t *frame = imu_dev->data[i];
+                uint32_t frame_time = burst_time - (uint32_t)((imu_dev->num_frames - 1 - i) * imu_dev->config.sample_time * 1000000.0f);
+
+                // Account for mounting orientation in hub. Any other tranformations
+                // are applied at the higher level in pbio.
+                frame[0] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_X;
+                frame[1] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_Y;
+                frame[2] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_Z;
+                frame[3] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_X;
+                frame[4] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_Y;
+                frame[5] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_Z;
+
+                pbdrv_imu_lsm6ds3tr_c_stm32_update_stationary_status(imu_dev, frame, frame_time);
+            }
+
+            if (imu_dev->handle_frame_data) {
+                uint32_t start = DWT->CYCCNT;
+                imu_dev->handle_frame_data(imu_dev->data[0], imu_dev->num_frames);
+                uint32_t cycles = DWT->CYCCNT - start;
+
+                pbdrv_imu_handler_stats_t *stats = &imu_dev->handler_stats;
+                stats->frames += imu_dev->num_frames;
+                stats->cycles += cycles;
+                if (cycles / imu_dev->num_frames > stats->max_frame_cycles) {
+                    stats->max_frame_cycles = cycles / imu_dev->num_frames;
+                }
+            }
         }
 
-        memcpy(&imu_dev->data[0], buf, NUM_DATA_BYTES);
-
-        // Account for mounting orientation in hub. Any other tranformations
-        // are applied at the higher level in pbio.
-        imu_dev->data[0] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_X;
-        imu_dev->data[1] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_Y;
-        imu_dev->data[2] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_Z;
-        imu_dev->data[3] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_X;
-        imu_dev->data[4] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_Y;
-        imu_dev->data[5] *= PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32_SIGN_Z;
-
-        pbdrv_imu_lsm6ds3tr_c_stm32_update_stationary_status(imu_dev);
-        if (imu_dev->handle_frame_data) {
-            imu_dev->handle_frame_data(imu_dev->data);
-        }
+        PROCESS_WAIT_EVENT_UNTIL(atomic_exchange(&imu_dev->int1, false));
     }
 
     PROCESS_END();
@@ -426,4 +490,13 @@ bool pbdrv_imu_is_stationary(pbdrv_imu_dev_t *imu_dev) {
     return imu_dev->stationary_now;
 }
 
+void pbdrv_imu_get_handler_stats(pbdrv_imu_dev_t *imu_dev, pbdrv_imu_handler_stats_t *stats) {
+    *stats = imu_dev->handler_stats;
+    stats->cycles_per_us = SystemCoreClock / 1000000;
+}
+
+void pbdrv_imu_reset_handler_stats(pbdrv_imu_dev_t *imu_dev) {
+    memset(&imu_dev->handler_stats, 0, sizeof(imu_dev->handler_stats));
+}
+
 #endif // PBDRV_CONFIG_IMU_LSM6S3TR_C_STM32
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+// Software IMU implementation for simulating a gyro in tests
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_IMU_TEST
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <pbdrv/clock.h>
+#include <pbdrv/imu.h>
+#include <pbio/error.h>
+
+/** Time between samples (us). This is about 1666 Hz, like the hub IMUs. */
+#define IMU_TEST_FRAME_TIME (600)
+
+/** Number of frames buffered before they are passed on, like a FIFO watermark. */
+#define IMU_TEST_WATERMARK_FRAMES (4)
+
+/** Raw accelerometer value for standard gravity. */
+#define IMU_TEST_ACCEL_1G (4096)
+
+/** Number of frames after which stationary data is passed on. */
+#define IMU_TEST_STATIONARY_FRAMES (1000)
+
+struct _pbdrv_imu_dev_t {
+    /** IMU configuration to convert raw data to phsyical units. */
+    pbdrv_imu_config_t config;
+    /** Callback to process frames of unfiltered gyro and accelerometer data. */
+    pbdrv_imu_handle_frame_data_func_t handle_frame_data;
+    /* Callback to process unfiltered gyro and accelerometer data recorded while stationary. */
+    pbdrv_imu_handle_stationary_data_func_t handle_stationary_data;
+    /** Raw data of frames that have not been passed on yet. */
+    int16_t data[IMU_TEST_WATERMARK_FRAMES][6];
+    /** Number of frames in data. */
+    uint32_t num_frames;
+    /** Whether the rotation has been set at least once. */
+    bool started;
+    /** Raw accelerometer data of each frame. */
+    int16_t accel[3];
+    /** Gyro bias added to each frame (deg/s). */
+    float gyro_bias[3];
+    /** Whether the hub is reported as stationary. */
+    bool stationary;
+    /** Sum of raw gyro data of stationary frames not passed on yet. */
+    int32_t stationary_gyro_sum[3];
+    /** Sum of raw accelerometer data of stationary frames not passed on yet. */
+    int32_t stationary_accel_sum[3];
+    /** Number of stationary frames not passed on yet. */
+    uint32_t stationary_frames;
+    /** Rotation about the z axis given by the previous update (deg). */
+    float rotation;
+    /** Time of the previous update (us). */
+    uint32_t update_time;
+    /** Time of the next sample (us). */
+    uint32_t frame_time;
+    /** Time spent in the frame data handler, in ns of host time. */
+    pbdrv_imu_handler_stats_t handler_stats;
+};
+
+static pbdrv_imu_dev_t global_imu_dev;
+
+/**
+ * Sets the simulated acceleration, which frames measure from now on.
+ *
+ * @param [in]  x           Acceleration along the hub x axis (mm/s^2).
+ * @param [in]  y           Acceleration along the hub y axis (mm/s^2).
+ * @param [in]  z           Acceleration along the hub z axis (mm/s^2).
+ */
+void pbio_test_imu_set_acceleration(float x, float y, float z) {
+    pbdrv_imu_dev_t *imu_dev = &global_imu_dev;
+    imu_dev->accel[0] = lroundf(x / imu_dev->config.accel_scale);
+    imu_dev->accel[1] = lroundf(y / imu_dev->config.accel_scale);
+    imu_dev->accel[2] = lroundf(z / imu_dev->config.accel_scale);
+}
+
+/**
+ * Sets the simulated gyro bias, which frames measure from now on.
+ *
+ * @param [in]  x           Bias about the hub x axis (deg/s).
+ * @param [in]  y           Bias about the hub y axis (deg/s).
+ * @param [in]  z           Bias about the hub z axis (deg/s).
+ */
+void pbio_test_imu_set_gyro_bias(float x, float y, float z) {
+    pbdrv_imu_dev_t *imu_dev = &global_imu_dev;
+    imu_dev->gyro_bias[0] = x;
+    imu_dev->gyro_bias[1] = y;
+    imu_dev->gyro_bias[2] = z;
+}
+
+/**
+ * Sets whether the hub is reported as stationary. While it is, the data of
+ * each IMU_TEST_STATIONARY_FRAMES frames is also passed on as stationary data.
+ *
+ * @param [in]  stationary  Whether the hub is stationary.
+ */
+void pbio_test_imu_set_stationary(bool stationary) {
+    pbdrv_imu_dev_t *imu_dev = &global_imu_dev;
+    imu_dev->stationary = stationary;
+    imu_dev->stationary_frames = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        imu_dev->stationary_gyro_sum[i] = 0;
+        imu_dev->stationary_accel_sum[i] = 0;
+    }
+}
+
+/**
+ * Adds a frame to the stationary data, and passes it on once complete.
+ *
+ * @param [in]  imu_dev     The IMU device.
+ * @param [in]  frame       Raw gyro and accelerometer data of the frame.
+ */
+static void pbdrv_imu_test_update_stationary(pbdrv_imu_dev_t *imu_dev, const int16_t *frame) {
+    if (!imu_dev->stationary) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        imu_dev->stationary_gyro_sum[i] += frame[i];
+        imu_dev->stationary_accel_sum[i] += frame[i + 3];
+    }
+
+    if (++imu_dev->stationary_frames < IMU_TEST_STATIONARY_FRAMES) {
+        return;
+    }
+
+    if (imu_dev->handle_stationary_data) {
+        imu_dev->handle_stationary_data(imu_dev->stationary_gyro_sum, imu_dev->stationary_accel_sum, imu_dev->stationary_frames);
+    }
+    pbio_test_imu_set_stationary(true);
+}
+
+static uint64_t pbdrv_imu_test_get_host_time_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Passes on buffered frames and measures how long the handler takes on the
+ * host, so tests can benchmark it like the cycle counter does on the hub.
+ *
+ * @param [in]  imu_dev     The IMU device instance.
+ */
+static void pbdrv_imu_test_handle_frame_data(pbdrv_imu_dev_t *imu_dev) {
+    uint64_t start = pbdrv_imu_test_get_host_time_ns();
+    imu_dev->handle_frame_data(imu_dev->data[0], imu_dev->num_frames);
+    uint32_t duration = pbdrv_imu_test_get_host_time_ns() - start;
+
+    pbdrv_imu_handler_stats_t *stats = &imu_dev->handler_stats;
+    stats->frames += imu_dev->num_frames;
+    stats->cycles += duration;
+    if (duration / imu_dev->num_frames > stats->max_frame_cycles) {
+        stats->max_frame_cycles = duration / imu_dev->num_frames;
+    }
+}
+
+/**
+ * Sets the simulated rotation about the hub z axis at the current time.
+ *
+ * The gyro samples taken since the previous call measure the average rate of
+ * change. They are passed on in batches, so the last few samples are held
+ * back until more samples follow.
+ *
+ * @param [in]  rotation    Rotation about the z axis (deg).
+ */
+void pbio_test_imu_set_rotation(float rotation) {
+    pbdrv_imu_dev_t *imu_dev = &global_imu_dev;
+    uint32_t now = pbdrv_clock_get_us();
+
+    if (!imu_dev->started || now == imu_dev->update_time) {
+        imu_dev->started = true;
+        imu_dev->rotation = rotation;
+        imu_dev->update_time = now;
+        imu_dev->frame_time = now + IMU_TEST_FRAME_TIME;
+        return;
+    }
+
+    float rate = (rotation - imu_dev->rotation) * 1000000.0f / (now - imu_dev->update_time);
+
+    while ((int32_t)(now - imu_dev->frame_time) >= 0) {
+        int16_t *frame = imu_dev->data[imu_dev->num_frames++];
+        frame[0] = lroundf(imu_dev->gyro_bias[0] / imu_dev->config.gyro_scale);
+        frame[1] = lroundf(imu_dev->gyro_bias[1] / imu_dev->config.gyro_scale);
+        frame[2] = lroundf((rate + imu_dev->gyro_bias[2]) / imu_dev->config.gyro_scale);
+        frame[3] = imu_dev->accel[0];
+        frame[4] = imu_dev->accel[1];
+        frame[5] = imu_dev->accel[2];
+        imu_dev->frame_time += IMU_TEST_FRAME_TIME;
+        pbdrv_imu_test_update_stationary(imu_dev, frame);
+
+        if (imu_dev->num_frames == IMU_TEST_WATERMARK_FRAMES) {
+            if (imu_dev->handle_frame_data) {
+                pbdrv_imu_test_handle_frame_data(imu_dev);
+            }
+            imu_dev->num_frames = 0;
+        }
+    }
+
+    imu_dev->rotation = rotation;
+    imu_dev->update_time = now;
+}
+
+void pbdrv_imu_init(void) {
+    pbdrv_imu_config_t *config = &global_imu_dev.config;
+    config->sample_time = IMU_TEST_FRAME_TIME / 1000000.0f;
+    config->gyro_scale = 0.07f;
+    config->accel_scale = 9806.65f / IMU_TEST_ACCEL_1G;
+    config->gyro_stationary_threshold = 71;
+    config->accel_stationary_threshold = 1024;
+
+    // The hub is flat unless a test tilts it.
+    global_imu_dev.accel[2] = IMU_TEST_ACCEL_1G;
+}
+
+pbio_error_t pbdrv_imu_get_imu(pbdrv_imu_dev_t **imu_dev, pbdrv_imu_config_t **config) {
+    *imu_dev = &global_imu_dev;
+    *config = &global_imu_dev.config;
+    return PBIO_SUCCESS;
+}
+
+void pbdrv_imu_set_data_handlers(pbdrv_imu_dev_t *imu_dev, pbdrv_imu_handle_frame_data_func_t frame_data_func, pbdrv_imu_handle_stationary_data_func_t stationary_data_func) {
+    imu_dev->handle_frame_data = frame_data_func;
+    imu_dev->handle_stationary_data = stationary_data_func;
+}
+
+bool pbdrv_imu_is_stationary(pbdrv_imu_dev_t *imu_dev) {
+    return imu_dev->stationary;
+}
+
+void pbdrv_imu_get_handler_stats(pbdrv_imu_dev_t *imu_dev, pbdrv_imu_handler_stats_t *stats) {
+    *stats = imu_dev->handler_stats;
+    stats->cycles_per_us = 1000;
+}
+
+void pbdrv_imu_reset_handler_stats(pbdrv_imu_dev_t *imu_dev) {
+    memset(&imu_dev->handler_stats, 0, sizeof(imu_dev->handler_stats));
+}
+
+#endif // PBDRV_CONFIG_IMU_TEST
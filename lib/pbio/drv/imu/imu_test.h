@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#ifndef _INTERNAL_PBDRV_IMU_TEST_H_
+#define _INTERNAL_PBDRV_IMU_TEST_H_
+
+#include <stdbool.h>
+
+#include <pbdrv/config.h>
+
+#if PBDRV_CONFIG_IMU_TEST
+
+// this can be used by tests that consume the imu driver
+void pbio_test_imu_set_rotation(float rotation);
+void pbio_test_imu_set_acceleration(float x, float y, float z);
+void pbio_test_imu_set_gyro_bias(float x, float y, float z);
+void pbio_test_imu_set_stationary(bool stationary);
+
+#endif // PBDRV_CONFIG_IMU_TEST
+
+#endif // _INTERNAL_PBDRV_IMU_TEST_H_
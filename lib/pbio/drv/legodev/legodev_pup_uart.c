@@ -152,6 +152,23 @@ typedef struct {
     uint32_t time;
 } pbdrv_legodev_pup_uart_data_set_t;
 
+typedef struct {
+    /** Whether data events are sent. */
+    bool enabled;
+    /** Whether an event was sent since the data of the mode became ready. */
+    bool announced;
+    /** The mode for which data events are sent. */
+    uint8_t mode;
+    #if PBDRV_CONFIG_LEGODEV_MODE_INFO
+    /** Whether events are sent only when the filtered value crosses a threshold. */
+    bool filtered;
+    /** Filtered value state at the last event: 1 if high, -1 if low, 0 if not known yet. */
+    int8_t side;
+    /** The threshold filter. */
+    pbdrv_legodev_data_filter_t filter;
+    #endif
+} pbdrv_legodev_pup_uart_notify_t;
+
 /**
  * struct ev3_uart_port_data - Data for EV3/LPF2 UART Sensor communication
  */
@@ -183,6 +200,10 @@ struct _pbdrv_legodev_pup_uart_dev_t {
     pbdrv_legodev_pup_uart_mode_switch_t mode_switch;
     /** Data set buffer and status. */
     pbdrv_legodev_pup_uart_data_set_t *data_set;
+    /** Data event settings and status. */
+    pbdrv_legodev_pup_uart_notify_t notify;
+    /** The legodev instance of this device, sent along with data events. */
+    pbdrv_legodev_dev_t *legodev;
     /** Extra mode adder for Powered Up devices (for modes > LUMP_MAX_MODE). */
     uint8_t ext_mode;
     /** New baud rate that will be set with ev3_uart_change_bitrate. */
@@ -231,8 +252,9 @@ static pbdrv_legodev_pup_uart_data_set_t data_set_bufs[PBDRV_CONFIG_LEGODEV_PUP_
 
 #define PBIO_PT_WAIT_READY(pt, expr) PT_WAIT_UNTIL((pt), (expr) != PBIO_ERROR_AGAIN)
 
-pbdrv_legodev_pup_uart_dev_t *pbdrv_legodev_pup_uart_configure(uint8_t device_index, uint8_t uart_driver_index, pbio_dcmotor_t *dcmotor) {
+pbdrv_legodev_pup_uart_dev_t *pbdrv_legodev_pup_uart_configure(pbdrv_legodev_dev_t *legodev, uint8_t device_index, uint8_t uart_driver_index, pbio_dcmotor_t *dcmotor) {
     pbdrv_legodev_pup_uart_dev_t *ludev = &ludevs[device_index];
+    ludev->legodev = legodev;
     ludev->dcmotor = dcmotor;
     ludev->tx_msg = &bufs[device_index][BUF_TX_MSG][0];
     ludev->rx_msg = &bufs[device_index][BUF_RX_MSG][0];
@@ -262,6 +284,139 @@ static void pbdrv_legodev_request_data_set(pbdrv_legodev_pup_uart_dev_t *ludev,
     pbdrv_legodev_pup_uart_process_poll();
 }
 
+/**
+ * Checks if the LEGO UART device has data available for reading or is ready to write.
+ *
+ * @param [in]  ludev       The LEGO UART device instance.
+ * @return                  ::PBIO_SUCCESS if ready.
+ *                          ::PBIO_ERROR_AGAIN if not ready yet.
+ *                          ::PBIO_ERROR_NO_DEV if no device is attached.
+ */
+static pbio_error_t pbdrv_legodev_pup_uart_is_ready(pbdrv_legodev_pup_uart_dev_t *ludev) {
+
+    if (ludev->status == PBDRV_LEGODEV_PUP_UART_STATUS_ERR) {
+        return PBIO_ERROR_NO_DEV;
+    }
+
+    if (ludev->status != PBDRV_LEGODEV_PUP_UART_STATUS_DATA) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    uint32_t time = pbdrv_clock_get_ms();
+
+    // Not ready if waiting for mode change
+    if (ludev->device_info.mode != ludev->mode_switch.desired_mode) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    // Not ready if waiting for stale data to be discarded.
+    if (time - ludev->mode_switch.time <= pbdrv_legodev_spec_stale_data_delay(ludev->device_info.type_id, ludev->device_info.mode)) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    // Not ready if just recently set new data.
+    if (ludev->data_set->size > 0 || time - ludev->data_set->time <= pbdrv_legodev_spec_data_set_delay(ludev->device_info.type_id, ludev->device_info.mode)) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+#if PBDRV_CONFIG_LEGODEV_MODE_INFO
+/**
+ * Gets one value from the most recent data of the current mode.
+ *
+ * @param [in]  ludev       The LEGO UART device instance.
+ * @param [in]  index       Index of the value.
+ * @return                  The value, with floats truncated to integers.
+ */
+static int32_t pbdrv_legodev_pup_uart_get_value(pbdrv_legodev_pup_uart_dev_t *ludev, uint8_t index) {
+    switch (ludev->device_info.mode_info[ludev->device_info.mode].data_type) {
+        case PBDRV_LEGODEV_DATA_TYPE_INT8:
+            return ((int8_t *)ludev->bin_data)[index];
+        case PBDRV_LEGODEV_DATA_TYPE_INT16:
+            return ((int16_t *)ludev->bin_data)[index];
+        case PBDRV_LEGODEV_DATA_TYPE_INT32:
+            return ((int32_t *)ludev->bin_data)[index];
+        case PBDRV_LEGODEV_DATA_TYPE_FLOAT:
+            return ((float *)ludev->bin_data)[index];
+    }
+    return 0;
+}
+#endif // PBDRV_CONFIG_LEGODEV_MODE_INFO
+
+/**
+ * Broadcasts a data event if the most recent data is relevant to subscribers.
+ *
+ * @param [in]  ludev       The LEGO UART device instance.
+ * @param [in]  changed     Whether the data differs from the previous data.
+ */
+static void pbdrv_legodev_pup_uart_notify_data(pbdrv_legodev_pup_uart_dev_t *ludev, bool changed) {
+    pbdrv_legodev_pup_uart_notify_t *notify = &ludev->notify;
+
+    if (!notify->enabled || ludev->device_info.mode != notify->mode) {
+        return;
+    }
+
+    // Data that can't be read yet is not announced, so the first data that
+    // can be read always is.
+    if (pbdrv_legodev_pup_uart_is_ready(ludev) != PBIO_SUCCESS) {
+        notify->announced = false;
+        #if PBDRV_CONFIG_LEGODEV_MODE_INFO
+        notify->side = 0;
+        #endif
+        return;
+    }
+
+    #if PBDRV_CONFIG_LEGODEV_MODE_INFO
+    // Only crossing a threshold counts as a change for filtered data. A
+    // device attached later may not have the filtered value in this mode.
+    if (notify->filtered) {
+        if (notify->filter.index >= ludev->device_info.mode_info[notify->mode].num_values) {
+            return;
+        }
+        int32_t value = pbdrv_legodev_pup_uart_get_value(ludev, notify->filter.index);
+        int8_t side = notify->side;
+        if (value > notify->filter.upper) {
+            side = 1;
+        } else if (value < notify->filter.lower) {
+            side = -1;
+        }
+        changed = side != notify->side;
+        notify->side = side;
+    }
+    #endif
+
+    if (!changed && notify->announced) {
+        return;
+    }
+    notify->announced = true;
+
+    // REVISIT: this can drop events if event queue is full
+    process_post(PROCESS_BROADCAST, PBIO_EVENT_LEGODEV_DATA, ludev->legodev);
+}
+
+/**
+ * Lets subscribers know that the device is gone, if they were told about its
+ * data. The subscription is kept, so the first data of a device that is
+ * attached again is announced like after subscribing.
+ *
+ * @param [in]  ludev       The LEGO UART device instance.
+ */
+static void pbdrv_legodev_pup_uart_notify_reset(pbdrv_legodev_pup_uart_dev_t *ludev) {
+    pbdrv_legodev_pup_uart_notify_t *notify = &ludev->notify;
+
+    if (notify->enabled && notify->announced) {
+        // REVISIT: this can drop events if event queue is full
+        process_post(PROCESS_BROADCAST, PBIO_EVENT_LEGODEV_DATA, ludev->legodev);
+    }
+
+    notify->announced = false;
+    #if PBDRV_CONFIG_LEGODEV_MODE_INFO
+    notify->side = 0;
+    #endif
+}
+
 static inline bool test_and_set_bit(uint8_t bit, uint32_t *flags) {
     bool result = *flags & (1 << bit);
     *flags |= (1 << bit);
@@ -606,7 +761,9 @@ static void pbdrv_legodev_pup_uart_parse_msg(pbdrv_legodev_pup_uart_dev_t *ludev
             #endif
 
             // Data is for requested mode.
+            bool changed = false;
             if (mode == ludev->mode_switch.desired_mode) {
+                changed = ludev->device_info.mode != mode || memcmp(ludev->bin_data, ludev->rx_msg + 1, msg_size - 2) != 0;
                 memcpy(ludev->bin_data, ludev->rx_msg + 1, msg_size - 2);
 
                 if (ludev->device_info.mode != mode) {
@@ -615,6 +772,7 @@ static void pbdrv_legodev_pup_uart_parse_msg(pbdrv_legodev_pup_uart_dev_t *ludev
                 }
             }
             ludev->device_info.mode = mode;
+            pbdrv_legodev_pup_uart_notify_data(ludev, changed);
 
             ludev->data_rec = true;
             if (ludev->num_data_err) {
@@ -718,6 +876,7 @@ static PT_THREAD(pbdrv_legodev_pup_uart_synchronize_thread(pbdrv_legodev_pup_uar
 
     // reset state for new device
     ludev->device_info.type_id = PBDRV_LEGODEV_TYPE_ID_NONE;
+    pbdrv_legodev_pup_uart_notify_reset(ludev);
     ludev->device_info.mode = 0;
     ludev->ext_mode = 0;
     #if PBDRV_CONFIG_LEGODEV_MODE_INFO
@@ -1116,32 +1275,10 @@ size_t pbdrv_legodev_size_of(pbdrv_legodev_data_type_t type) {
 pbio_error_t pbdrv_legodev_is_ready(pbdrv_legodev_dev_t *legodev) {
 
     pbdrv_legodev_pup_uart_dev_t *ludev = pbdrv_legodev_get_uart_dev(legodev);
-    if (!ludev || ludev->status == PBDRV_LEGODEV_PUP_UART_STATUS_ERR) {
+    if (!ludev) {
         return PBIO_ERROR_NO_DEV;
     }
-
-    if (ludev->status != PBDRV_LEGODEV_PUP_UART_STATUS_DATA) {
-        return PBIO_ERROR_AGAIN;
-    }
-
-    uint32_t time = pbdrv_clock_get_ms();
-
-    // Not ready if waiting for mode change
-    if (ludev->device_info.mode != ludev->mode_switch.desired_mode) {
-        return PBIO_ERROR_AGAIN;
-    }
-
-    // Not ready if waiting for stale data to be discarded.
-    if (time - ludev->mode_switch.time <= pbdrv_legodev_spec_stale_data_delay(ludev->device_info.type_id, ludev->device_info.mode)) {
-        return PBIO_ERROR_AGAIN;
-    }
-
-    // Not ready if just recently set new data.
-    if (ludev->data_set->size > 0 || time - ludev->data_set->time <= pbdrv_legodev_spec_data_set_delay(ludev->device_info.type_id, ludev->device_info.mode)) {
-        return PBIO_ERROR_AGAIN;
-    }
-
-    return PBIO_SUCCESS;
+    return pbdrv_legodev_pup_uart_is_ready(ludev);
 }
 
 /**
@@ -1261,4 +1398,73 @@ pbio_error_t pbdrv_legodev_get_info(pbdrv_legodev_dev_t *legodev, pbdrv_legodev_
     return pbdrv_legodev_is_ready(legodev);
 }
 
+/**
+ * Starts broadcasting data events for a LEGO UART device.
+ *
+ * @param [in]  legodev     The legodev instance.
+ * @param [in]  mode        The mode for which to send events.
+ * @param [in]  filter      The threshold filter, or NULL to send events on any change.
+ * @return                  ::PBIO_SUCCESS on success.
+ *                          ::PBIO_ERROR_NO_DEV if the port does not have a device attached.
+ *                          ::PBIO_ERROR_AGAIN if the device is not ready for this operation.
+ *                          ::PBIO_ERROR_INVALID_ARG if the mode or filter is not valid.
+ *                          ::PBIO_ERROR_NOT_SUPPORTED if filters are not available.
+ */
+pbio_error_t pbdrv_legodev_set_data_notify(pbdrv_legodev_dev_t *legodev, uint8_t mode, const pbdrv_legodev_data_filter_t *filter) {
+
+    pbdrv_legodev_pup_uart_dev_t *ludev = pbdrv_legodev_get_uart_dev(legodev);
+    if (!ludev || ludev->status == PBDRV_LEGODEV_PUP_UART_STATUS_ERR) {
+        return PBIO_ERROR_NO_DEV;
+    }
+
+    // Modes are known only once synchronized.
+    if (ludev->status != PBDRV_LEGODEV_PUP_UART_STATUS_DATA) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    pbdrv_legodev_pup_uart_notify_t *notify = &ludev->notify;
+
+    #if PBDRV_CONFIG_LEGODEV_MODE_INFO
+    if (mode >= ludev->device_info.num_modes) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    // Filtered value must exist in this mode.
+    if (filter && (filter->index >= ludev->device_info.mode_info[mode].num_values || filter->lower > filter->upper)) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    notify->filtered = filter != NULL;
+    if (filter) {
+        notify->filter = *filter;
+    }
+    notify->side = 0;
+    #else
+    // Values can't be decoded without the data type of the mode.
+    if (filter) {
+        return PBIO_ERROR_NOT_SUPPORTED;
+    }
+    #endif
+
+    notify->mode = mode;
+    notify->announced = false;
+    notify->enabled = true;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Stops broadcasting data events for a LEGO UART device.
+ *
+ * @param [in]  legodev     The legodev instance.
+ * @return                  ::PBIO_SUCCESS on success.
+ *                          ::PBIO_ERROR_NO_DEV if the port does not have a device attached.
+ */
+pbio_error_t pbdrv_legodev_clear_data_notify(pbdrv_legodev_dev_t *legodev) {
+
+    pbdrv_legodev_pup_uart_dev_t *ludev = pbdrv_legodev_get_uart_dev(legodev);
+    if (!ludev) {
+        return PBIO_ERROR_NO_DEV;
+    }
+    ludev->notify.enabled = false;
+    return PBIO_SUCCESS;
+}
+
 #endif // PBDRV_CONFIG_LEGODEV_PUP_UART
@@ -17,7 +17,7 @@ typedef struct _pbdrv_legodev_pup_uart_dev_t pbdrv_legodev_pup_uart_dev_t;
 
 #if PBDRV_CONFIG_LEGODEV_PUP_UART
 
-pbdrv_legodev_pup_uart_dev_t *pbdrv_legodev_pup_uart_configure(uint8_t device_index, uint8_t uart_driver_index, pbio_dcmotor_t *dcmotor);
+pbdrv_legodev_pup_uart_dev_t *pbdrv_legodev_pup_uart_configure(pbdrv_legodev_dev_t *legodev, uint8_t device_index, uint8_t uart_driver_index, pbio_dcmotor_t *dcmotor);
 
 pbdrv_legodev_pup_uart_dev_t *pbdrv_legodev_get_uart_dev(pbdrv_legodev_dev_t *legodev);
 
@@ -27,7 +27,7 @@ void pbdrv_legodev_pup_uart_process_poll(void);
 
 #else // PBDRV_CONFIG_LEGODEV_PUP_UART
 
-static inline pbdrv_legodev_pup_uart_dev_t *pbdrv_legodev_pup_uart_configure(uint8_t device_index, uint8_t uart_driver_index, pbio_dcmotor_t *dcmotor) {
+static inline pbdrv_legodev_pup_uart_dev_t *pbdrv_legodev_pup_uart_configure(pbdrv_legodev_dev_t *legodev, uint8_t device_index, uint8_t uart_driver_index, pbio_dcmotor_t *dcmotor) {
     return NULL;
 }
 
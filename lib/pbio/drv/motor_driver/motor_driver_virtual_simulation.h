@@ -16,6 +16,11 @@
 
 #include <pbdrv/motor_driver.h>
 
+/**
+ * Endstop angle of motor which can turn forever (mdeg).
+ */
+#define PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP (1e100)
+
 /**
  * Description of virtual motor environment.
  */
@@ -36,6 +36,20 @@ typedef struct {
     int16_t accel_stationary_threshold;
 } pbdrv_imu_config_t;
 
+/**
+ * Time spent in the frame data handler, to compare it with the sample time.
+ */
+typedef struct {
+    /** Number of frames passed to the handler. */
+    uint32_t frames;
+    /** Total time spent in the handler in cycles. */
+    uint64_t cycles;
+    /** Longest time per frame of one call to the handler in cycles. */
+    uint32_t max_frame_cycles;
+    /** Number of cycles per microsecond. */
+    uint32_t cycles_per_us;
+} pbdrv_imu_handler_stats_t;
+
 #if PBDRV_CONFIG_IMU
 
 /**
@@ -58,11 +72,13 @@ pbio_error_t pbdrv_imu_get_imu(pbdrv_imu_dev_t **imu_dev, pbdrv_imu_config_t **c
 bool pbdrv_imu_is_stationary(pbdrv_imu_dev_t *imu_dev);
 
 /**
- * Callback to process one frame of unfiltered gyro and accelerometer data.
+ * Callback to process consecutive frames of unfiltered gyro and accelerometer
+ * data, in the order they were sampled.
  *
- * @param [in]  data        Array with unscaled gyro (xyz) and acceleration (xyz) samples to process.
+ * @param [in]  data        Array of @p num_frames frames, each with unscaled gyro (xyz) and acceleration (xyz) samples to process.
+ * @param [in]  num_frames  Number of frames in @p data.
  */
-typedef void (*pbdrv_imu_handle_frame_data_func_t)(int16_t *data);
+typedef void (*pbdrv_imu_handle_frame_data_func_t)(int16_t *data, uint32_t num_frames);
 
 /**
  * Callback to process @p num_samples unfiltered gyro and accelerometer data
@@ -78,11 +94,26 @@ typedef void (*pbdrv_imu_handle_stationary_data_func_t)(const int32_t *gyro_data
  * Sets the data handlers for processing new data.
  *
  * @param [in]  imu_dev                The IMU device instance.
- * @param [in]  frame_data_func        Callback that handles one data frame.
+ * @param [in]  frame_data_func        Callback that handles one or more data frames.
  * @param [in]  stationary_data_func   Callback that handles multiple stationary data frames.
  */
 void pbdrv_imu_set_data_handlers(pbdrv_imu_dev_t *imu_dev, pbdrv_imu_handle_frame_data_func_t frame_data_func, pbdrv_imu_handle_stationary_data_func_t stationary_data_func);
 
+/**
+ * Gets the time spent in the frame data handler since the last reset.
+ *
+ * @param [in]  imu_dev     The IMU device instance.
+ * @param [out] stats       The statistics.
+ */
+void pbdrv_imu_get_handler_stats(pbdrv_imu_dev_t *imu_dev, pbdrv_imu_handler_stats_t *stats);
+
+/**
+ * Resets the time spent in the frame data handler.
+ *
+ * @param [in]  imu_dev     The IMU device instance.
+ */
+void pbdrv_imu_reset_handler_stats(pbdrv_imu_dev_t *imu_dev);
+
 #else // PBDRV_CONFIG_IMU
 
 static inline pbio_error_t pbdrv_imu_get_imu(pbdrv_imu_dev_t **imu_dev, pbdrv_imu_config_t **config) {
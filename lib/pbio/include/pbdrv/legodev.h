@@ -484,6 +484,23 @@ typedef struct {
     #endif
 } pbdrv_legodev_info_t;
 
+/**
+ * Threshold filter for data events of a legodev device.
+ *
+ * The filtered value is high once it rises above the upper threshold and low
+ * once it drops below the lower threshold. In between, it keeps its previous
+ * state, so the gap between the thresholds acts as hysteresis. Float values
+ * are truncated to integers before comparing.
+ */
+typedef struct {
+    /** Index of the value in the data of the filtered mode. */
+    uint8_t index;
+    /** The value becomes low when it drops below this threshold. */
+    int32_t lower;
+    /** The value becomes high when it rises above this threshold. */
+    int32_t upper;
+} pbdrv_legodev_data_filter_t;
+
 #if PBDRV_CONFIG_LEGODEV
 
 /**
@@ -636,6 +653,54 @@ static inline pbio_error_t pbdrv_legodev_get_data(pbdrv_legodev_dev_t *legodev,
 
 #endif // PBDRV_CONFIG_LEGODEV
 
+#if PBDRV_CONFIG_LEGODEV_PUP_UART
+
+/**
+ * Starts broadcasting ::PBIO_EVENT_LEGODEV_DATA for new data of the legodev
+ * device, so that processes can wait for changes instead of polling
+ * ::pbdrv_legodev_get_data.
+ *
+ * Without a filter, the event is sent whenever data of the given mode differs
+ * from the previous data. With a filter, it is sent only when the filtered
+ * value crosses from low to high or the other way around. In both cases, the
+ * first data that is ready for reading is always announced.
+ *
+ * The subscription is kept if the device is unplugged. An event is sent when
+ * it is lost, and the first data of a device that is attached again is
+ * announced as above.
+ *
+ * @param [in]  legodev   The legodev device instance.
+ * @param [in]  mode      The mode for which to send events.
+ * @param [in]  filter    The threshold filter, or NULL to send events on any change.
+ * @return                ::PBIO_SUCCESS on success.
+ *                        ::PBIO_ERROR_NO_DEV if no device is attached or does not support it.
+ *                        ::PBIO_ERROR_AGAIN if the device is not ready for this operation.
+ *                        ::PBIO_ERROR_INVALID_ARG if the mode or filter is not valid.
+ *                        ::PBIO_ERROR_NOT_SUPPORTED if filters are not available on this platform.
+ */
+pbio_error_t pbdrv_legodev_set_data_notify(pbdrv_legodev_dev_t *legodev, uint8_t mode, const pbdrv_legodev_data_filter_t *filter);
+
+/**
+ * Stops broadcasting data events for the legodev device.
+ *
+ * @param [in]  legodev   The legodev device instance.
+ * @return                ::PBIO_SUCCESS on success.
+ *                        ::PBIO_ERROR_NO_DEV if no device is attached or does not support it.
+ */
+pbio_error_t pbdrv_legodev_clear_data_notify(pbdrv_legodev_dev_t *legodev);
+
+#else // PBDRV_CONFIG_LEGODEV_PUP_UART
+
+static inline pbio_error_t pbdrv_legodev_set_data_notify(pbdrv_legodev_dev_t *legodev, uint8_t mode, const pbdrv_legodev_data_filter_t *filter) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+static inline pbio_error_t pbdrv_legodev_clear_data_notify(pbdrv_legodev_dev_t *legodev) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
+#endif // PBDRV_CONFIG_LEGODEV_PUP_UART
+
 #endif // PBDRV_LEGODEV_H
 
 /** @} */
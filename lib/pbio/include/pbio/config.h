@@ -16,9 +16,29 @@
 #define PBIO_CONFIG_CONTROL_LOOP_TIME_MS (5)
 #endif
 
-// Angle differentiation time window, defined as a multiple of the loop time.
-// This is the time window used for calculating the average speed, so 100ms.
-#define PBIO_CONFIG_DIFFERENTIATOR_WINDOW_SIZE (100 / PBIO_CONFIG_CONTROL_LOOP_TIME_MS)
+// Whether the control loop time can be changed at runtime. If so, it can be
+// any of the loop times for which motor models are generated, else only
+// PBIO_CONFIG_CONTROL_LOOP_TIME_MS is available.
+#ifndef PBIO_CONFIG_CONTROL_LOOP_TIME_CONFIGURABLE
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_CONFIGURABLE (0)
+#endif
+
+#if PBIO_CONFIG_CONTROL_LOOP_TIME_CONFIGURABLE
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(ms) ((ms) == 2 || (ms) == 5 || (ms) == 10)
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_MS_MIN (2)
+#else
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(ms) ((ms) == PBIO_CONFIG_CONTROL_LOOP_TIME_MS)
+#define PBIO_CONFIG_CONTROL_LOOP_TIME_MS_MIN PBIO_CONFIG_CONTROL_LOOP_TIME_MS
+#endif
+
+#if !PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(PBIO_CONFIG_CONTROL_LOOP_TIME_MS)
+#error "PBIO_CONFIG_CONTROL_LOOP_TIME_MS must be one of the available loop times."
+#endif
+
+// Angle differentiation time window, defined as a multiple of the shortest
+// loop time. This is the longest window used for calculating the average
+// speed, which is always 100ms.
+#define PBIO_CONFIG_DIFFERENTIATOR_WINDOW_SIZE (100 / PBIO_CONFIG_CONTROL_LOOP_TIME_MS_MIN)
 
 // Total number of position samples to store in the differentiator buffer.
 // Must be > PBIO_CONFIG_DIFFERENTIATOR_WINDOW_SIZE. This allows a user
@@ -28,6 +48,25 @@
 #define PBIO_CONFIG_DIFFERENTIATOR_BUFFER_SIZE (PBIO_CONFIG_DIFFERENTIATOR_WINDOW_SIZE * 3 + 1)
 #endif
 
+// Number of computed trajectories to keep, so that repeated maneuvers with
+// the same speed, acceleration, and distance or duration are not computed
+// again. Zero disables the cache.
+#ifndef PBIO_CONFIG_TRAJECTORY_CACHE_SIZE
+#define PBIO_CONFIG_TRAJECTORY_CACHE_SIZE (0)
+#endif
+
+// Number of position maneuvers each controller can queue after the ongoing
+// one, so that they blend without stopping in between. Zero disables queues.
+#ifndef PBIO_CONFIG_CONTROL_QUEUE_SIZE
+#define PBIO_CONFIG_CONTROL_QUEUE_SIZE (0)
+#endif
+
+// Number of motion groups, which run several servos along synchronized
+// trajectories so they complete at the same time. Zero disables them.
+#ifndef PBIO_CONFIG_MOTION_GROUP_NUM_DEV
+#define PBIO_CONFIG_MOTION_GROUP_NUM_DEV (0)
+#endif
+
 #define PBIO_CONFIG_NUM_DRIVEBASES (PBIO_CONFIG_SERVO_NUM_DEV / 2)
 
 #endif // _PBIO_CONFIG_H_
@@ -17,6 +17,7 @@
 #include <stdint.h>
 
 #include <pbio/angle.h>
+#include <pbio/config.h>
 #include <pbio/control_settings.h>
 #include <pbio/error.h>
 #include <pbio/port.h>
@@ -125,6 +126,74 @@ typedef enum {
     PBIO_CONTROL_STATUS_COMPLETE = 1 << 1,
 } pbio_control_status_flag_t;
 
+/**
+ * Position maneuver that waits in the queue of a controller.
+ */
+typedef struct _pbio_control_segment_t {
+    /**
+     * Trajectory of this segment, planned ahead from the end of the previous one.
+     */
+    pbio_trajectory_t trajectory;
+    /**
+     * Top speed of this segment (control units), used to plan it again.
+     */
+    int32_t speed;
+    /**
+     * What to do when this segment completes. This is ::PBIO_CONTROL_ON_COMPLETION_CONTINUE
+     * or ::PBIO_CONTROL_ON_COMPLETION_HOLD if another segment follows.
+     */
+    pbio_control_on_completion_t on_completion;
+} pbio_control_segment_t;
+
+/**
+ * Position maneuvers that run after the ongoing one.
+ */
+typedef struct _pbio_control_queue_t {
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    /**
+     * Whether the ongoing maneuver was started from the queue, so that new
+     * segments may follow it.
+     */
+    bool active;
+    /**
+     * Top speed of the ongoing maneuver (control units).
+     */
+    int32_t speed;
+    /**
+     * Number of segments that wait in the queue.
+     */
+    uint8_t length;
+    /**
+     * Segments that wait in the queue, in order of execution.
+     */
+    pbio_control_segment_t segments[PBIO_CONFIG_CONTROL_QUEUE_SIZE];
+    #endif
+} pbio_control_queue_t;
+
+/**
+ * Changes that queue one more segment. They are planned first and applied
+ * only if planning succeeds, so that controllers that queue together either
+ * all change or none of them do.
+ */
+typedef struct _pbio_control_queue_plan_t {
+    /**
+     * Whether nothing runs from the queue, so the segment starts right away.
+     */
+    bool start;
+    /**
+     * The last trajectory, planned again to lead into the new segment.
+     */
+    pbio_trajectory_t last;
+    /**
+     * What to do when the last trajectory completes.
+     */
+    pbio_control_on_completion_t last_on_completion;
+    /**
+     * The new segment.
+     */
+    pbio_control_segment_t segment;
+} pbio_control_queue_plan_t;
+
 /**
  * Controller status and state.
  */
@@ -147,6 +216,10 @@ typedef struct _pbio_control_t {
      * last-used trajectory.
      */
     pbio_trajectory_t trajectory;
+    /**
+     * Position maneuvers that follow the ongoing one without stopping.
+     */
+    pbio_control_queue_t queue;
     /**
      * Integrator of the speed error. Used when timed speed control is active.
      */
@@ -199,11 +272,20 @@ pbio_dcmotor_actuation_t pbio_control_passive_completion_to_actuation_type(pbio_
 
 // Start new control command:
 
-pbio_error_t pbio_control_start_position_control(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t position, int32_t speed, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_control_start_position_control(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t position, int32_t speed, pbio_control_on_completion_t on_completion, bool allow_trajectory_shift);
 pbio_error_t pbio_control_start_position_control_relative(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion, bool allow_trajectory_shift);
 pbio_error_t pbio_control_start_position_control_hold(pbio_control_t *ctl, uint32_t time_now, int32_t position);
 pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, uint32_t duration, int32_t speed, pbio_control_on_completion_t on_completion);
 
+// Queue control commands:
+
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+pbio_error_t pbio_control_queue_prepare(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_queue_plan_t *plan);
+pbio_error_t pbio_control_queue_add(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion, pbio_control_queue_plan_t *plan);
+void pbio_control_queue_commit(pbio_control_t *ctl, uint32_t time_now, const pbio_control_queue_plan_t *plan);
+pbio_error_t pbio_control_queue_position_control_relative(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion);
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 #endif // _PBIO_CONTROL_H_
 
 /** @} */
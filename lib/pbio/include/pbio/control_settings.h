@@ -77,6 +77,11 @@ typedef struct _pbio_control_settings_t {
      * Absolute rate of change of the speed during off-ramp of the maneuver.
      */
     int32_t deceleration;
+    /**
+     * Shape of the speed profile during the on-ramp and off-ramp. With an
+     * S-curve, acceleration and deceleration are the peak values.
+     */
+    pbio_trajectory_profile_t trajectory_profile;
     /**
      * Maximum feedback actuation value. On a motor this is the maximum torque.
      */
@@ -124,6 +129,11 @@ typedef struct _pbio_control_settings_t {
     uint32_t smart_passive_hold_time;
 } pbio_control_settings_t;
 
+// Control loop time:
+
+uint32_t pbio_control_settings_get_loop_time(void);
+pbio_error_t pbio_control_settings_set_loop_time(uint32_t ms);
+
 // Unit conversion functions:
 
 uint32_t pbio_control_time_ms_to_ticks(uint32_t ms);
@@ -146,6 +156,8 @@ int32_t pbio_control_settings_div_by_gain(int32_t value, int32_t gain);
 
 void pbio_control_settings_get_trajectory_limits(const pbio_control_settings_t *s, int32_t *speed, int32_t *acceleration, int32_t *deceleration);
 pbio_error_t pbio_control_settings_set_trajectory_limits(pbio_control_settings_t *s, int32_t speed, int32_t acceleration, int32_t deceleration);
+pbio_trajectory_profile_t pbio_control_settings_get_trajectory_profile(const pbio_control_settings_t *s);
+pbio_error_t pbio_control_settings_set_trajectory_profile(pbio_control_settings_t *s, pbio_trajectory_profile_t profile);
 int32_t pbio_control_settings_get_actuation_limit(const pbio_control_settings_t *s);
 pbio_error_t pbio_control_settings_set_actuation_limit(pbio_control_settings_t *s, int32_t limit);
 void pbio_control_settings_get_pid(const pbio_control_settings_t *s, int32_t *pid_kp, int32_t *pid_ki, int32_t *pid_kd, int32_t *integral_deadzone, int32_t *integral_change_max);
@@ -37,8 +37,9 @@ pbio_error_t pbio_drivebase_get_drivebase(pbio_drivebase_t **db_address, pbio_se
 
 // Drive base status:
 
-void pbio_drivebase_update_all(void);
+void pbio_drivebase_update_all(uint32_t time_now);
 bool pbio_drivebase_update_loop_is_running(pbio_drivebase_t *db);
+bool pbio_drivebase_control_is_active_any(void);
 bool pbio_drivebase_is_done(const pbio_drivebase_t *db);
 pbio_error_t pbio_drivebase_is_stalled(pbio_drivebase_t *db, bool *stalled, uint32_t *stall_duration);
 
@@ -47,6 +48,15 @@ pbio_error_t pbio_drivebase_is_stalled(pbio_drivebase_t *db, bool *stalled, uint
 pbio_error_t pbio_drivebase_drive_straight(pbio_drivebase_t *db, int32_t distance, pbio_control_on_completion_t on_completion);
 pbio_error_t pbio_drivebase_drive_curve(pbio_drivebase_t *db, int32_t radius, int32_t angle, pbio_control_on_completion_t on_completion);
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+// Queued point to point control:
+
+pbio_error_t pbio_drivebase_queue_straight(pbio_drivebase_t *db, int32_t distance, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_drivebase_queue_curve(pbio_drivebase_t *db, int32_t radius, int32_t angle, pbio_control_on_completion_t on_completion);
+
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 // Infinite driving:
 
 pbio_error_t pbio_drivebase_drive_forever(pbio_drivebase_t *db, int32_t speed, int32_t turn_rate);
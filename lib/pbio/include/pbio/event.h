@@ -12,6 +12,8 @@ typedef enum {
     PBIO_EVENT_STATUS_SET,
     /** System status indicator was cleared. Data is ::pbio_pybricks_status_t. */
     PBIO_EVENT_STATUS_CLEARED,
+    /** New data of a legodev device is relevant to subscribers. Data is ::pbdrv_legodev_dev_t. */
+    PBIO_EVENT_LEGODEV_DATA,
 } pbio_event_t;
 
 #endif // _PBIO_EVENT_H_
@@ -40,6 +40,10 @@ pbio_error_t pbio_imu_get_single_axis_rotation(pbio_geometry_xyz_t *axis, float
 
 pbio_geometry_side_t pbio_imu_get_up_side(void);
 
+void pbio_imu_get_gravity(pbio_geometry_xyz_t *values);
+
+void pbio_imu_get_roll_pitch_yaw(float *roll, float *pitch, float *yaw);
+
 float pbio_imu_get_heading(void);
 
 void pbio_imu_set_heading(float desired_heading);
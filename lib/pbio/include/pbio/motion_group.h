@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+/**
+ * @addtogroup MotionGroup pbio/motion_group: Synchronized multi-servo motion
+ *
+ * Runs several servos along trajectories that start and complete together.
+ * @{
+ */
+
+#ifndef _PBIO_MOTION_GROUP_H_
+#define _PBIO_MOTION_GROUP_H_
+
+#include <pbio/servo.h>
+
+#if PBIO_CONFIG_MOTION_GROUP_NUM_DEV > 0
+
+typedef struct _pbio_motion_group_t {
+    /**
+     * True while the servos run a maneuver started by this group, else false.
+     */
+    bool active;
+    /**
+     * Synchronization state to indicate that one or more controllers are paused.
+     */
+    bool control_paused;
+    /**
+     * Whether any controller paused in the ongoing control loop iteration.
+     * This becomes control_paused for the next iteration.
+     */
+    bool control_paused_next;
+    /**
+     * Number of servos in this group.
+     */
+    uint8_t num_servos;
+    /**
+     * The servos in this group. The first servo is not special. Any servo can
+     * take the lead, depending on which maneuver takes the longest.
+     */
+    pbio_servo_t *servos[PBIO_CONFIG_SERVO_NUM_DEV];
+} pbio_motion_group_t;
+
+pbio_error_t pbio_motion_group_get_motion_group(pbio_motion_group_t **group_address, pbio_servo_t **servos, uint8_t num_servos);
+
+// Motion group status:
+
+bool pbio_motion_group_update_loop_is_running(pbio_motion_group_t *group);
+bool pbio_motion_group_is_done(const pbio_motion_group_t *group);
+
+// Synchronization of servo controllers in the servo update loop:
+
+pbio_motion_group_t *pbio_motion_group_get_active(const pbio_servo_t *srv);
+void pbio_motion_group_update_all(uint32_t time_now);
+
+// Finite point to point control:
+
+pbio_error_t pbio_motion_group_run_target(pbio_motion_group_t *group, int32_t speed, const int32_t *targets, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_motion_group_run_angle(pbio_motion_group_t *group, int32_t speed, const int32_t *angles, pbio_control_on_completion_t on_completion);
+pbio_error_t pbio_motion_group_stop(pbio_motion_group_t *group, pbio_control_on_completion_t on_completion);
+
+#endif // PBIO_CONFIG_MOTION_GROUP_NUM_DEV > 0
+
+#endif // _PBIO_MOTION_GROUP_H_
+
+/** @} */
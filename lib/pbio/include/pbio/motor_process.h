@@ -11,7 +11,85 @@
 #ifndef _PBIO_MOTOR_PROCESS_H_
 #define _PBIO_MOTOR_PROCESS_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <pbio/config.h>
+#include <pbio/error.h>
+
+/**
+ * Number of bins of the update duration histograms.
+ */
+#define PBIO_MOTOR_PROCESS_NUM_BINS (11)
+
+/**
+ * Duration statistics of one part of the control loop update.
+ */
+typedef struct _pbio_motor_process_timing_t {
+    /**
+     * Shortest update in microseconds.
+     */
+    uint32_t min;
+    /**
+     * Longest update in microseconds.
+     */
+    uint32_t max;
+    /**
+     * Total duration of all updates in microseconds, used for the average.
+     */
+    uint64_t total;
+    /**
+     * Number of updates by duration, in steps of one tenth of the control
+     * loop period. The last bin counts updates that took the whole period or
+     * longer.
+     */
+    uint32_t histogram[PBIO_MOTOR_PROCESS_NUM_BINS];
+} pbio_motor_process_timing_t;
+
+/**
+ * Statistics of the control loop, to see how much of its time budget is used.
+ */
+typedef struct _pbio_motor_process_stats_t {
+    /**
+     * Number of control loop iterations.
+     */
+    uint32_t count;
+    /**
+     * Duration of the battery voltage update.
+     */
+    pbio_motor_process_timing_t battery;
+    /**
+     * Duration of the drivebase updates.
+     */
+    pbio_motor_process_timing_t drivebase;
+    /**
+     * Duration of sampling and updating the servos.
+     */
+    pbio_motor_process_timing_t servo;
+    /**
+     * Duration of the whole update.
+     */
+    pbio_motor_process_timing_t total;
+    /**
+     * Number of updates that took longer than the control loop period.
+     */
+    uint32_t overruns;
+    /**
+     * Number of iterations that started so late that the loop timer had to
+     * be reset, skipping at least one period.
+     */
+    uint32_t missed;
+    /**
+     * Largest deviation of the time between two iterations from the control
+     * loop period, in microseconds.
+     */
+    uint32_t jitter_max;
+    /**
+     * Total deviation of the time between iterations in microseconds, used
+     * for the average.
+     */
+    uint64_t jitter_total;
+} pbio_motor_process_stats_t;
 
 #if PBIO_CONFIG_MOTOR_PROCESS
 
@@ -21,12 +99,26 @@
 #endif
 
 void pbio_motor_process_start(void);
+const pbio_motor_process_stats_t *pbio_motor_process_get_stats(void);
+void pbio_motor_process_reset_stats(void);
+pbio_error_t pbio_motor_process_set_loop_time(uint32_t ms);
 
 #else
 
 static inline void pbio_motor_process_start(void) {
 }
 
+static inline const pbio_motor_process_stats_t *pbio_motor_process_get_stats(void) {
+    return NULL;
+}
+
+static inline void pbio_motor_process_reset_stats(void) {
+}
+
+static inline pbio_error_t pbio_motor_process_set_loop_time(uint32_t ms) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
+
 #endif // PBIO_CONFIG_MOTOR_PROCESS
 
 #endif // _PBIO_MOTOR_PROCESS_H_
@@ -25,6 +25,10 @@
  * Device-type specific constants that describe the motor model.
  */
 typedef struct _pbio_observer_model_t {
+    /**
+     * Control loop time (ms) for which the discrete time model is generated.
+     */
+    uint32_t loop_time;
     int32_t d_angle_d_speed;
     int32_t d_speed_d_speed;
     int32_t d_current_d_speed;
@@ -179,6 +179,17 @@ typedef enum {
      * @since Pybricks Profile v1.3.0
      */
     PBIO_PYBRICKS_EVENT_WRITE_STDOUT = 1,
+
+    /**
+     * Data written to application data event.
+     *
+     * The payload is a variable number of bytes of application specific data,
+     * such as binary telemetry frames. Unlike stdout, the data of one event
+     * is never split or merged with other events.
+     *
+     * @since Pybricks Profile v1.4.0
+     */
+    PBIO_PYBRICKS_EVENT_WRITE_APP_DATA = 2,
 } pbio_pybricks_event_t;
 
 /**
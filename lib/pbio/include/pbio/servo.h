@@ -79,6 +79,19 @@ typedef struct _pbio_servo_t {
      * Link to parent object that uses this servo, like a drive base.
      */
     pbio_parent_t parent;
+    /**
+     * Constant parameters of this type of motor, NULL if not set up.
+     */
+    const struct _pbio_servo_settings_reduced_t *settings_reduced;
+    /**
+     * State sampled at the start of the ongoing control loop iteration. The
+     * servo and its parent controllers are all updated from this sample.
+     */
+    pbio_control_state_t state_sampled;
+    /**
+     * Result of sampling the state, which fails if the tacho can't be read.
+     */
+    pbio_error_t state_sampled_err;
     /**
      * Internal flag used to set whether the servo state update loop should
      * keep running. This is false when the servo is unplugged or other errors
@@ -109,9 +122,14 @@ typedef struct _pbio_servo_settings_reduced_t {
      */
     pbdrv_legodev_type_id_t id;
     /**
-     * Physical model parameter for this type of motor
+     * Physical model parameters for this type of motor, one for each
+     * available control loop time.
+     */
+    const pbio_observer_model_t *models;
+    /**
+     * Number of models.
      */
-    const pbio_observer_model_t *model;
+    uint8_t num_models;
     /**
      * The rated maximum speed (deg/s), approximately equivalent to "100%" speed in other apps.
      */
@@ -143,7 +161,11 @@ pbio_error_t pbio_servo_setup(pbio_servo_t *srv, pbdrv_legodev_type_id_t type, p
 /** @cond INTERNAL */
 pbio_error_t pbio_servo_actuate(pbio_servo_t *srv, pbio_dcmotor_actuation_t actuation_type, int32_t payload);
 const pbio_servo_settings_reduced_t *pbio_servo_get_reduced_settings(pbdrv_legodev_type_id_t id);
-void pbio_servo_update_all(void);
+void pbio_servo_sample_all(void);
+pbio_error_t pbio_servo_get_state_sampled(pbio_servo_t *srv, pbio_control_state_t *state);
+void pbio_servo_update_all(uint32_t time_now);
+bool pbio_servo_control_is_active_any(void);
+void pbio_servo_select_model_all(void);
 /** @endcond */
 
 /** @name Status Functions */
@@ -165,6 +187,9 @@ pbio_error_t pbio_servo_run_time(pbio_servo_t *srv, int32_t speed, uint32_t dura
 pbio_error_t pbio_servo_run_until_stalled(pbio_servo_t *srv, int32_t speed, int32_t torque_limit, pbio_control_on_completion_t on_completion);
 pbio_error_t pbio_servo_run_angle(pbio_servo_t *srv, int32_t speed, int32_t angle, pbio_control_on_completion_t on_completion);
 pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, int32_t speed, int32_t target, pbio_control_on_completion_t on_completion);
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+pbio_error_t pbio_servo_queue_angle(pbio_servo_t *srv, int32_t speed, int32_t angle, pbio_control_on_completion_t on_completion);
+#endif
 pbio_error_t pbio_servo_track_target(pbio_servo_t *srv, int32_t target);
 /**@}*/
 
@@ -28,6 +28,23 @@
 // acceleration part of the maneuver.
 #define PBIO_TRAJECTORY_DURATION_FOREVER_MS (5 * 60 * 1000)
 
+/**
+ * Shape of the speed during the acceleration and deceleration phases.
+ */
+typedef enum {
+    /**
+     * Speed changes linearly, so acceleration steps between zero and its
+     * maximum at the start and end of each ramp.
+     */
+    PBIO_TRAJECTORY_PROFILE_TRAPEZOID = 0,
+    /**
+     * Speed changes smoothly, so acceleration rises and falls with limited
+     * jerk. Acceleration peaks at the given value halfway through each ramp,
+     * so ramps take 3/2 as long as with the trapezoid profile.
+     */
+    PBIO_TRAJECTORY_PROFILE_S_CURVE = 1,
+} pbio_trajectory_profile_t;
+
 /**
  * Minimal set of trajectory parameters from which a full trajectory is
  * calculated. All values in control units and time in ticks.
@@ -43,6 +60,7 @@ typedef struct _pbio_trajectory_command_t {
     int32_t acceleration;          /**<  Encoder acceleration magnitude during in-phase */
     int32_t deceleration;          /**<  Encoder acceleration magnitude during out-phase */
     bool continue_running;         /**<  Whether it movement continues after t3 (true) or not (false) */
+    pbio_trajectory_profile_t profile; /**<  Shape of the acceleration and deceleration phases */
 } pbio_trajectory_command_t;
 
 /**
@@ -75,6 +93,7 @@ typedef struct _pbio_trajectory_t {
     int32_t w3;                          /**<  Encoder rate target after the maneuver ends */
     int32_t a0;                          /**<  Encoder acceleration during in-phase */
     int32_t a2;                          /**<  Encoder acceleration during out-phase */
+    pbio_trajectory_profile_t profile;   /**<  Shape of the acceleration phases. Positions and speeds at t1, t2, and t3 are the same for all shapes. */
 } pbio_trajectory_t;
 
 // Make or modify trajectories:
@@ -85,6 +104,7 @@ pbio_error_t pbio_trajectory_new_angle_command(pbio_trajectory_t *trj, const pbi
 pbio_error_t pbio_trajectory_new_time_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command);
 void pbio_trajectory_make_constant(pbio_trajectory_t *trj, const pbio_trajectory_command_t *command);
 void pbio_trajectory_stretch(pbio_trajectory_t *trj, const pbio_trajectory_t *leader);
+void pbio_trajectory_cache_clear(void);
 
 // Reference getter functions:
 
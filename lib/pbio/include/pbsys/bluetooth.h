@@ -23,6 +23,12 @@
  */
 typedef bool (*pbsys_bluetooth_stdin_event_callback_t)(uint8_t c);
 
+/**
+ * Callback function called when stdout data was sent and there is free space
+ * in the stdout buffer again.
+ */
+typedef void (*pbsys_bluetooth_stdout_done_callback_t)(void);
+
 #if PBSYS_CONFIG_BLUETOOTH
 
 void pbsys_bluetooth_init(void);
@@ -32,6 +38,9 @@ uint32_t pbsys_bluetooth_rx_get_available(void);
 pbio_error_t pbsys_bluetooth_rx(uint8_t *data, uint32_t *size);
 pbio_error_t pbsys_bluetooth_tx(const uint8_t *data, uint32_t *size);
 bool pbsys_bluetooth_tx_is_idle(void);
+void pbsys_bluetooth_tx_set_callback(pbsys_bluetooth_stdout_done_callback_t callback);
+uint32_t pbsys_bluetooth_tx_app_data_get_max_size(void);
+pbio_error_t pbsys_bluetooth_tx_app_data(const uint8_t *data, uint32_t size);
 
 #else // PBSYS_CONFIG_BLUETOOTH
 
@@ -39,6 +48,7 @@ bool pbsys_bluetooth_tx_is_idle(void);
 #define pbsys_bluetooth_rx_set_callback(callback)
 #define pbsys_bluetooth_rx_flush()
 #define pbsys_bluetooth_rx_get_available() 0
+#define pbsys_bluetooth_tx_set_callback(callback)
 
 static inline pbio_error_t pbsys_bluetooth_rx(uint8_t *data, uint32_t *size) {
     return PBIO_ERROR_NOT_SUPPORTED;
@@ -49,6 +59,12 @@ static inline pbio_error_t pbsys_bluetooth_tx(const uint8_t *data, uint32_t *siz
 static inline bool pbsys_bluetooth_tx_is_idle(void) {
     return false;
 }
+static inline uint32_t pbsys_bluetooth_tx_app_data_get_max_size(void) {
+    return 0;
+}
+static inline pbio_error_t pbsys_bluetooth_tx_app_data(const uint8_t *data, uint32_t size) {
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
 
 #endif // PBSYS_CONFIG_BLUETOOTH
 
@@ -14,6 +14,9 @@
 #define PBDRV_CONFIG_CLOCK                          (1)
 #define PBDRV_CONFIG_CLOCK_TEST                     (1)
 
+#define PBDRV_CONFIG_IMU                            (1)
+#define PBDRV_CONFIG_IMU_TEST                       (1)
+
 #define PBDRV_CONFIG_LED                            (1)
 #define PBDRV_CONFIG_LED_NUM_DEV                    (0)
 
@@ -45,8 +45,6 @@ const pbdrv_legodev_test_platform_data_t pbdrv_legodev_test_platform_data[PBDRV_
     },
 };
 
-#define INFINITY (1e100)
-
 const pbdrv_motor_driver_virtual_simulation_platform_data_t
     pbdrv_motor_driver_virtual_simulation_platform_data[PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV] = {
     {
@@ -54,16 +52,16 @@ const pbdrv_motor_driver_virtual_simulation_platform_data_t
         .type_id = PBDRV_LEGODEV_TYPE_ID_SPIKE_M_MOTOR,
         .initial_angle = 123456,
         .initial_speed = 0,
-        .endstop_angle_negative = -INFINITY,
-        .endstop_angle_positive = INFINITY,
+        .endstop_angle_negative = -PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
+        .endstop_angle_positive = PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
     },
     {
         .port_id = PBIO_PORT_ID_B,
         .type_id = PBDRV_LEGODEV_TYPE_ID_SPIKE_M_MOTOR,
         .initial_angle = 0,
         .initial_speed = 0,
-        .endstop_angle_negative = -INFINITY,
-        .endstop_angle_positive = INFINITY,
+        .endstop_angle_negative = -PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
+        .endstop_angle_positive = PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
     },
     {
         .port_id = PBIO_PORT_ID_C,
@@ -78,23 +76,23 @@ const pbdrv_motor_driver_virtual_simulation_platform_data_t
         .type_id = PBDRV_LEGODEV_TYPE_ID_NONE,
         .initial_angle = 0,
         .initial_speed = 0,
-        .endstop_angle_negative = -INFINITY,
-        .endstop_angle_positive = INFINITY,
+        .endstop_angle_negative = -PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
+        .endstop_angle_positive = PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
     },
     {
         .port_id = PBIO_PORT_ID_E,
         .type_id = PBDRV_LEGODEV_TYPE_ID_SPIKE_S_MOTOR,
         .initial_angle = 0,
         .initial_speed = 0,
-        .endstop_angle_negative = -INFINITY,
-        .endstop_angle_positive = INFINITY,
+        .endstop_angle_negative = -PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
+        .endstop_angle_positive = PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
     },
     {
         .port_id = PBIO_PORT_ID_F,
         .type_id = PBDRV_LEGODEV_TYPE_ID_SPIKE_L_MOTOR,
         .initial_angle = 45000,
         .initial_speed = 0,
-        .endstop_angle_negative = -INFINITY,
-        .endstop_angle_positive = INFINITY,
+        .endstop_angle_negative = -PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
+        .endstop_angle_positive = PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP,
     },
 };
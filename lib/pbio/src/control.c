@@ -5,6 +5,7 @@
 // Copyright (c) 2020-2023 LEGO System A/S
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include <pbdrv/clock.h>
@@ -223,6 +224,49 @@ static int32_t pbio_control_get_pid_kp(const pbio_control_settings_t *settings,
     return pbio_int_math_max(kp_pwa, kp_target);
 }
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+/**
+ * Discards all queued segments. This is called when a maneuver starts that
+ * was not queued, or when control stops.
+ *
+ * @param [in]  ctl             The control instance.
+ */
+static void pbio_control_queue_clear(pbio_control_t *ctl) {
+    ctl->queue.active = false;
+    ctl->queue.length = 0;
+}
+
+/**
+ * Starts the next queued segment once the ongoing maneuver has passed its
+ * endpoint. The segment was planned to start there, so the reference is
+ * continuous.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  time_now        The wall time (ticks).
+ */
+static void pbio_control_queue_advance(pbio_control_t *ctl, uint32_t time_now) {
+    if (ctl->queue.length == 0) {
+        return;
+    }
+    pbio_trajectory_reference_t end;
+    pbio_trajectory_get_endpoint(&ctl->trajectory, &end);
+    if (!pbio_control_settings_time_is_later(pbio_control_get_ref_time(ctl, time_now), end.time)) {
+        return;
+    }
+
+    // The control type stays the same, so the integrators carry on.
+    pbio_control_segment_t *next = &ctl->queue.segments[0];
+    ctl->trajectory = next->trajectory;
+    ctl->queue.speed = next->speed;
+    ctl->on_completion = next->on_completion;
+    ctl->queue.length--;
+    memmove(&ctl->queue.segments[0], &ctl->queue.segments[1], ctl->queue.length * sizeof(pbio_control_segment_t));
+    pbio_control_status_set(ctl, PBIO_CONTROL_STATUS_COMPLETE, false);
+}
+
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 /**
  * Updates the PID controller state to calculate the next actuation step.
  *
@@ -244,6 +288,11 @@ void pbio_control_update(
     int32_t *control,
     bool *external_pause) {
 
+    // Move on to the next queued maneuver if the ongoing one has ended.
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    pbio_control_queue_advance(ctl, time_now);
+    #endif
+
     // Get reference signals at the reference time point in the trajectory.
     // This compensates for any time we may have spent pausing when the motor was stalled.
     pbio_trajectory_get_reference(&ctl->trajectory, pbio_control_get_ref_time(ctl, time_now), ref);
@@ -342,7 +391,8 @@ void pbio_control_update(
         pbio_control_check_completion(ctl, ref->time, state, &ref_end));
 
     // Save (low-pass filtered) load for diagnostics
-    ctl->pid_average = (ctl->pid_average * (100 - PBIO_CONFIG_CONTROL_LOOP_TIME_MS) + torque * PBIO_CONFIG_CONTROL_LOOP_TIME_MS) / 100;
+    int32_t loop_time = pbio_control_settings_get_loop_time();
+    ctl->pid_average = (ctl->pid_average * (100 - loop_time) + torque * loop_time) / 100;
 
     // Decide actuation based on control status.
     if (// Not on target yet, so keep actuating.
@@ -422,6 +472,9 @@ void pbio_control_update(
  */
 void pbio_control_stop(pbio_control_t *ctl) {
     ctl->type = PBIO_CONTROL_TYPE_NONE;
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    pbio_control_queue_clear(ctl);
+    #endif
     pbio_control_status_set(ctl, PBIO_CONTROL_STATUS_COMPLETE, true);
     pbio_control_status_set(ctl, PBIO_CONTROL_STATUS_STALLED, false);
     ctl->pid_average = 0;
@@ -447,6 +500,11 @@ static void pbio_control_set_control_type(pbio_control_t *ctl, uint32_t time_now
     // Set on completion action for this maneuver.
     ctl->on_completion = on_completion;
 
+    // A maneuver that was not queued replaces all queued ones.
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    pbio_control_queue_clear(ctl);
+    #endif
+
     // Reset maximum actuation value used for this run.
     ctl->settings.actuation_max_temporary = ctl->settings.actuation_max;
 
@@ -506,6 +564,7 @@ static pbio_error_t _pbio_control_start_position_control(pbio_control_t *ctl, ui
         .acceleration = ctl->settings.acceleration,
         .deceleration = ctl->settings.deceleration,
         .continue_running = on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE,
+        .profile = ctl->settings.trajectory_profile,
     };
 
 
@@ -594,36 +653,30 @@ static pbio_error_t _pbio_control_start_position_control(pbio_control_t *ctl, ui
  * @param [in]  position       The target position to run to (application units).
  * @param [in]  speed          The top speed on the way to the target (application units). The sign is ignored. If zero, default speed is used.
  * @param [in]  on_completion  What to do when reaching the target position.
+ * @param [in]  allow_trajectory_shift Whether trajectory may be time-shifted for better performance in tight loops (true) or not (false).
  * @return                     Error code.
  */
-pbio_error_t pbio_control_start_position_control(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t position, int32_t speed, pbio_control_on_completion_t on_completion) {
+pbio_error_t pbio_control_start_position_control(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t position, int32_t speed, pbio_control_on_completion_t on_completion, bool allow_trajectory_shift) {
 
     // Convert target position to control units.
     pbio_angle_t target;
     pbio_control_settings_app_to_ctl_long(&ctl->settings, position, &target);
 
     // Start position control in control units.
-    return _pbio_control_start_position_control(ctl, time_now, state, &target, pbio_control_settings_app_to_ctl(&ctl->settings, speed), on_completion, true);
+    return _pbio_control_start_position_control(ctl, time_now, state, &target, pbio_control_settings_app_to_ctl(&ctl->settings, speed), on_completion, allow_trajectory_shift);
 }
 
 /**
- * Starts the controller to run by a given distance.
- *
- * In a servo application, this means running by the given angle.
+ * Gets the target position of a maneuver that runs by a given distance.
  *
- * This function computes what the new target position will be, and then
- * calls pbio_control_start_position_control to get there.
- *
- * @param [in]  ctl                    The control instance.
- * @param [in]  time_now               The wall time (ticks).
- * @param [in]  state                  The current state of the system being controlled (control units).
- * @param [in]  distance               The distance to run by (application units).
- * @param [in]  speed                  The top speed on the way to the target (application units). Negative speed flips the distance sign.
- * @param [in]  on_completion          What to do when reaching the target position.
- * @param [in]  allow_trajectory_shift Whether trajectory may be time-shifted for better performance in tight loops (true) or not (false).
- * @return                             Error code.
+ * @param [in]  ctl            The control instance.
+ * @param [in]  time_now       The wall time (ticks).
+ * @param [in]  state          The current state of the system being controlled (control units).
+ * @param [in]  distance       The distance to run by (application units).
+ * @param [in]  speed          The top speed (application units). Negative speed flips the distance sign.
+ * @param [out] target         The target position (control units).
  */
-pbio_error_t pbio_control_start_position_control_relative(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion, bool allow_trajectory_shift) {
+static void pbio_control_get_relative_target(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_angle_t *target) {
 
     // Convert distance to control units.
     pbio_angle_t increment;
@@ -631,13 +684,11 @@ pbio_error_t pbio_control_start_position_control_relative(pbio_control_t *ctl, u
 
     // We need to decide where the relative motion starts from, and use that
     // to compute the position target by adding the increment.
-    pbio_angle_t target;
-
     if (pbio_control_is_active(ctl)) {
         // If control is already active, restart from current reference.
         pbio_trajectory_reference_t ref;
         pbio_control_get_reference(ctl, time_now, state, &ref);
-        pbio_angle_sum(&ref.position, &increment, &target);
+        pbio_angle_sum(&ref.position, &increment, target);
     } else {
         // Control is inactive. We still have two options.
         // If the previous command used smart coast and we're still close to
@@ -650,13 +701,37 @@ pbio_error_t pbio_control_start_position_control_relative(pbio_control_t *ctl, u
             pbio_int_math_abs(pbio_angle_diff_mdeg(&prev_end.position, &state->position)) < ctl->settings.position_tolerance * 2) {
             // We're close enough, so make the new target relative to the
             // endpoint of the last one.
-            pbio_angle_sum(&prev_end.position, &increment, &target);
+            pbio_angle_sum(&prev_end.position, &increment, target);
         } else {
             // No special cases apply, so the best we can do is just start from
             // the current state.
-            pbio_angle_sum(&state->position, &increment, &target);
+            pbio_angle_sum(&state->position, &increment, target);
         }
     }
+}
+
+/**
+ * Starts the controller to run by a given distance.
+ *
+ * In a servo application, this means running by the given angle.
+ *
+ * This function computes what the new target position will be, and then
+ * calls pbio_control_start_position_control to get there.
+ *
+ * @param [in]  ctl                    The control instance.
+ * @param [in]  time_now               The wall time (ticks).
+ * @param [in]  state                  The current state of the system being controlled (control units).
+ * @param [in]  distance               The distance to run by (application units).
+ * @param [in]  speed                  The top speed on the way to the target (application units). Negative speed flips the distance sign.
+ * @param [in]  on_completion          What to do when reaching the target position.
+ * @param [in]  allow_trajectory_shift Whether trajectory may be time-shifted for better performance in tight loops (true) or not (false).
+ * @return                             Error code.
+ */
+pbio_error_t pbio_control_start_position_control_relative(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion, bool allow_trajectory_shift) {
+
+    // Compute the target position from where the relative motion starts.
+    pbio_angle_t target;
+    pbio_control_get_relative_target(ctl, time_now, state, distance, speed, &target);
 
     return _pbio_control_start_position_control(ctl, time_now, state, &target, pbio_control_settings_app_to_ctl(&ctl->settings, speed), on_completion, allow_trajectory_shift);
 }
@@ -720,6 +795,7 @@ pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, uint32_t time
         .acceleration = ctl->settings.acceleration,
         .deceleration = ctl->settings.deceleration,
         .continue_running = on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE,
+        .profile = ctl->settings.trajectory_profile,
     };
 
     // Given the control status, fill in remaining commands and get trajectory.
@@ -789,6 +865,262 @@ pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, uint32_t time
     return PBIO_SUCCESS;
 }
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+/**
+ * Checks if the ongoing maneuver was started from the queue, so that new
+ * segments can follow it.
+ *
+ * @param [in]  ctl             The control instance.
+ * @return                      True if segments can be queued after the ongoing maneuver.
+ */
+static bool pbio_control_queue_is_running(const pbio_control_t *ctl) {
+    return ctl->queue.active && pbio_control_type_is_position(ctl);
+}
+
+/**
+ * Gets the trajectory that a newly queued segment follows. This is the last
+ * queued segment, or the ongoing maneuver if the queue is empty.
+ *
+ * @param [in]  ctl             The control instance.
+ * @return                      The last trajectory.
+ */
+static pbio_trajectory_t *pbio_control_queue_get_last_trajectory(pbio_control_t *ctl) {
+    if (ctl->queue.length == 0) {
+        return &ctl->trajectory;
+    }
+    return &ctl->queue.segments[ctl->queue.length - 1].trajectory;
+}
+
+/**
+ * Gets the top speed of a segment in control units.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  speed           The top speed (application units). The sign is ignored. If zero, default speed is used.
+ * @return                      The top speed (control units).
+ */
+static int32_t pbio_control_queue_get_speed(const pbio_control_t *ctl, int32_t speed) {
+    return speed == 0 ? ctl->settings.speed_default : pbio_control_settings_app_to_ctl(&ctl->settings, pbio_int_math_abs(speed));
+}
+
+/**
+ * Gets the target of a segment that follows the last one.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  distance        The distance to run by (application units).
+ * @param [in]  speed           The top speed (application units). Negative speed flips the distance sign.
+ * @param [out] target          The target position (control units).
+ */
+static void pbio_control_queue_get_target(pbio_control_t *ctl, int32_t distance, int32_t speed, pbio_angle_t *target) {
+    pbio_angle_t increment;
+    pbio_control_settings_app_to_ctl_long(&ctl->settings, (speed < 0 ? -distance : distance), &increment);
+
+    pbio_trajectory_reference_t end;
+    pbio_trajectory_get_endpoint(pbio_control_queue_get_last_trajectory(ctl), &end);
+    pbio_angle_sum(&end.position, &increment, target);
+}
+
+/**
+ * Plans the trajectory of a segment.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  start           Where the segment starts.
+ * @param [in]  target          The target position (control units).
+ * @param [in]  speed           The top speed (control units).
+ * @param [in]  continue_running Whether to keep running at the top speed at the target.
+ * @param [out] trj             The trajectory of the segment.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_control_queue_plan(const pbio_control_t *ctl, const pbio_trajectory_reference_t *start, const pbio_angle_t *target, int32_t speed, bool continue_running, pbio_trajectory_t *trj) {
+    pbio_trajectory_command_t command = {
+        .time_start = start->time,
+        .position_start = start->position,
+        .position_end = *target,
+        .speed_start = start->speed,
+        .speed_target = speed,
+        .speed_max = ctl->settings.speed_max,
+        .acceleration = ctl->settings.acceleration,
+        .deceleration = ctl->settings.deceleration,
+        .continue_running = continue_running,
+        .profile = ctl->settings.trajectory_profile,
+    };
+    return pbio_trajectory_new_angle_command(trj, &command);
+}
+
+/**
+ * Plans how the last segment leads into a new one.
+ *
+ * The last segment is planned again. If the new segment goes in the same
+ * direction, it keeps going at its top speed instead of stopping at its
+ * target. Otherwise it stops there and holds until the new segment starts.
+ *
+ * If no maneuver was started from the queue, this only marks the plan so
+ * that ::pbio_control_queue_add plans the new segment to start right away.
+ *
+ * This does not change the controller. See ::pbio_control_queue_commit.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  time_now        The wall time (ticks).
+ * @param [in]  state           The current state of the system being controlled (control units).
+ * @param [in]  distance        The distance of the new segment (application units).
+ * @param [in]  speed           The top speed of the new segment (application units). Negative speed flips the distance sign.
+ * @param [out] plan            The planned changes.
+ * @return                      ::PBIO_SUCCESS on success, ::PBIO_ERROR_BUSY if
+ *                              the queue is full, or errors from planning the
+ *                              trajectory.
+ */
+pbio_error_t pbio_control_queue_prepare(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_queue_plan_t *plan) {
+
+    plan->start = !pbio_control_queue_is_running(ctl);
+    if (plan->start) {
+        return PBIO_SUCCESS;
+    }
+    if (ctl->queue.length == PBIO_CONFIG_CONTROL_QUEUE_SIZE) {
+        return PBIO_ERROR_BUSY;
+    }
+
+    // Blend only if both segments move in the same direction.
+    pbio_angle_t target;
+    pbio_control_queue_get_target(ctl, distance, speed, &target);
+    pbio_trajectory_t *last = pbio_control_queue_get_last_trajectory(ctl);
+    pbio_trajectory_reference_t last_end;
+    pbio_trajectory_get_endpoint(last, &last_end);
+    int32_t direction = pbio_int_math_sign(pbio_angle_diff_mdeg(&target, &last_end.position));
+    bool blend = direction != 0 && direction == pbio_int_math_sign(last->th3);
+
+    // Queued segments complete actively, so the next one can take over.
+    pbio_control_on_completion_t on_completion = ctl->queue.length == 0 ?
+        ctl->on_completion : ctl->queue.segments[ctl->queue.length - 1].on_completion;
+    bool continue_running = blend || on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE;
+    plan->last_on_completion = continue_running ? PBIO_CONTROL_ON_COMPLETION_CONTINUE : PBIO_CONTROL_ON_COMPLETION_HOLD;
+
+    // The last segment is always planned again, which undoes any stretching
+    // so the caller can synchronize it with other controllers again. The
+    // ongoing maneuver branches off from the current reference, just like a
+    // new command would. A waiting segment starts where it did before.
+    pbio_trajectory_reference_t start;
+    int32_t last_speed;
+    if (ctl->queue.length == 0) {
+        pbio_control_get_reference(ctl, time_now, state, &start);
+        last_speed = ctl->queue.speed;
+    } else {
+        pbio_trajectory_get_endpoint(ctl->queue.length == 1 ? &ctl->trajectory : &ctl->queue.segments[ctl->queue.length - 2].trajectory, &start);
+        last_speed = ctl->queue.segments[ctl->queue.length - 1].speed;
+    }
+    return pbio_control_queue_plan(ctl, &start, &last_end.position, last_speed, continue_running, &plan->last);
+}
+
+/**
+ * Plans a segment that runs by a given distance after the last one.
+ *
+ * Its trajectory starts at the end of the last segment as planned by
+ * ::pbio_control_queue_prepare, so that it takes over in the control loop
+ * without delay. If no maneuver was started from the queue, it starts right
+ * away like ::pbio_control_start_position_control_relative.
+ *
+ * This does not change the controller. See ::pbio_control_queue_commit.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  time_now        The wall time (ticks).
+ * @param [in]  state           The current state of the system being controlled (control units).
+ * @param [in]  distance        The distance to run by (application units).
+ * @param [in]  speed           The top speed (application units). Negative speed flips the distance sign. If zero, default speed is used.
+ * @param [in]  on_completion   What to do when reaching the target, unless another segment follows.
+ * @param [in, out] plan        The planned changes.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_control_queue_add(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion, pbio_control_queue_plan_t *plan) {
+
+    pbio_control_segment_t *segment = &plan->segment;
+    segment->speed = pbio_control_queue_get_speed(ctl, speed);
+    segment->on_completion = on_completion;
+
+    pbio_angle_t target;
+    pbio_trajectory_reference_t start;
+    if (plan->start) {
+        // Start from the reference if control is active, or from the
+        // measured state if not, just like a new command would.
+        pbio_control_get_relative_target(ctl, time_now, state, distance, speed, &target);
+        if (pbio_control_is_active(ctl)) {
+            pbio_control_get_reference(ctl, time_now, state, &start);
+        } else {
+            start.time = time_now;
+            start.position = state->position;
+            start.speed = state->speed;
+        }
+    } else {
+        // Start from the end of the last segment.
+        pbio_control_queue_get_target(ctl, distance, speed, &target);
+        pbio_trajectory_get_endpoint(&plan->last, &start);
+    }
+    return pbio_control_queue_plan(ctl, &start, &target, segment->speed, on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE, &segment->trajectory);
+}
+
+/**
+ * Applies the changes planned by ::pbio_control_queue_prepare and
+ * ::pbio_control_queue_add.
+ *
+ * Call this only if planning succeeded, and without other commands in
+ * between. This cannot fail, so controllers that queue together can plan
+ * first and then all apply their plans.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  time_now        The wall time (ticks).
+ * @param [in]  plan            The planned changes.
+ */
+void pbio_control_queue_commit(pbio_control_t *ctl, uint32_t time_now, const pbio_control_queue_plan_t *plan) {
+
+    // If nothing runs from the queue, start right away.
+    if (plan->start) {
+        ctl->trajectory = plan->segment.trajectory;
+        pbio_control_set_control_type(ctl, time_now, PBIO_CONTROL_TYPE_POSITION, plan->segment.on_completion);
+        ctl->queue.active = true;
+        ctl->queue.speed = plan->segment.speed;
+        return;
+    }
+
+    // Otherwise, let the last segment lead into the new one.
+    *pbio_control_queue_get_last_trajectory(ctl) = plan->last;
+    if (ctl->queue.length == 0) {
+        ctl->on_completion = plan->last_on_completion;
+    } else {
+        ctl->queue.segments[ctl->queue.length - 1].on_completion = plan->last_on_completion;
+    }
+    ctl->queue.segments[ctl->queue.length++] = plan->segment;
+}
+
+/**
+ * Queues a position maneuver by a given distance after the last one, and
+ * blends the two if they move in the same direction.
+ *
+ * If the queue is full or planning fails, the controller does not change.
+ *
+ * @param [in]  ctl             The control instance.
+ * @param [in]  time_now        The wall time (ticks).
+ * @param [in]  state           The current state of the system being controlled (control units).
+ * @param [in]  distance        The distance to run by (application units).
+ * @param [in]  speed           The top speed (application units). Negative speed flips the distance sign. If zero, default speed is used.
+ * @param [in]  on_completion   What to do when reaching the target, unless another segment follows.
+ * @return                      ::PBIO_SUCCESS on success, ::PBIO_ERROR_BUSY if
+ *                              the queue is full, or errors from planning the
+ *                              trajectory.
+ */
+pbio_error_t pbio_control_queue_position_control_relative(pbio_control_t *ctl, uint32_t time_now, const pbio_control_state_t *state, int32_t distance, int32_t speed, pbio_control_on_completion_t on_completion) {
+    pbio_control_queue_plan_t plan;
+    pbio_error_t err = pbio_control_queue_prepare(ctl, time_now, state, distance, speed, &plan);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    err = pbio_control_queue_add(ctl, time_now, state, distance, speed, on_completion, &plan);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    pbio_control_queue_commit(ctl, time_now, &plan);
+    return PBIO_SUCCESS;
+}
+
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 
 
 /**
@@ -871,5 +1203,11 @@ bool pbio_control_is_stalled(const pbio_control_t *ctl, uint32_t *stall_duration
  * @return                      True if the controller is done, false if not.
  */
 bool pbio_control_is_done(const pbio_control_t *ctl) {
+    #if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+    // Queued maneuvers are part of the command.
+    if (pbio_control_is_active(ctl) && ctl->queue.length) {
+        return false;
+    }
+    #endif
     return !pbio_control_is_active(ctl) || pbio_control_status_test(ctl, PBIO_CONTROL_STATUS_COMPLETE);
 }
@@ -11,6 +11,36 @@
 #include <pbio/int_math.h>
 #include <pbio/observer.h>
 
+// Control loop time in milliseconds.
+static uint32_t loop_time = PBIO_CONFIG_CONTROL_LOOP_TIME_MS;
+
+/**
+ * Gets the control loop time.
+ *
+ * @return                    Control loop time in milliseconds.
+ */
+uint32_t pbio_control_settings_get_loop_time(void) {
+    return loop_time;
+}
+
+/**
+ * Sets the control loop time.
+ *
+ * This must only be changed while no controllers are running. Use
+ * ::pbio_motor_process_set_loop_time to ensure this.
+ *
+ * @param [in] ms             Control loop time in milliseconds.
+ * @return                    ::PBIO_SUCCESS on success, ::PBIO_ERROR_INVALID_ARG
+ *                            if no motor models are available for this time.
+ */
+pbio_error_t pbio_control_settings_set_loop_time(uint32_t ms) {
+    if (!PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(ms)) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    loop_time = ms;
+    return PBIO_SUCCESS;
+}
+
 /**
  * Converts milliseconds to time ticks used by controller.
  *
@@ -151,7 +181,7 @@ int32_t pbio_control_settings_div_by_gain(int32_t value, int32_t gain) {
  * @return                    Input scaled by loop time in seconds.
  */
 int32_t pbio_control_settings_mul_by_loop_time(int32_t input) {
-    return input / (1000 / PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+    return input / (1000 / (int32_t)loop_time);
 }
 
 /**
@@ -209,6 +239,33 @@ pbio_error_t pbio_control_settings_set_trajectory_limits(pbio_control_settings_t
     return PBIO_SUCCESS;
 }
 
+/**
+ * Gets the shape of the speed profile of new maneuvers.
+ *
+ * @param [in]  s             Control settings structure from which to read.
+ * @return                    The profile.
+ */
+pbio_trajectory_profile_t pbio_control_settings_get_trajectory_profile(const pbio_control_settings_t *s) {
+    return s->trajectory_profile;
+}
+
+/**
+ * Sets the shape of the speed profile of new maneuvers. It does not affect
+ * the ongoing maneuver.
+ *
+ * @param [in] s              Control settings structure to write to.
+ * @param [in] profile        The profile.
+ * @return                    ::PBIO_SUCCESS on success
+ *                            ::PBIO_ERROR_INVALID_ARG if the profile does not exist.
+ */
+pbio_error_t pbio_control_settings_set_trajectory_profile(pbio_control_settings_t *s, pbio_trajectory_profile_t profile) {
+    if (profile != PBIO_TRAJECTORY_PROFILE_TRAPEZOID && profile != PBIO_TRAJECTORY_PROFILE_S_CURVE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    s->trajectory_profile = profile;
+    return PBIO_SUCCESS;
+}
+
 /**
  * Gets the control limits for actuation, in application units.
  *
@@ -32,7 +32,8 @@ static int32_t pbio_differentiator_calc_speed(pbio_differentiator_t *dif, uint8_
     }
 
     // Each sample has units of mdeg, so take average and convert to mdeg/s.
-    return total * (1000 / PBIO_CONFIG_CONTROL_LOOP_TIME_MS) / window_size;
+    int32_t loop_time = pbio_control_settings_get_loop_time();
+    return total * (1000 / loop_time) / window_size;
 }
 
 /**
@@ -47,14 +48,15 @@ int32_t pbio_differentiator_update_and_get_speed(pbio_differentiator_t *dif, con
     // Increment index where latest difference will be stored.
     dif->index = (dif->index + 1) % PBIO_ARRAY_SIZE(dif->history);
 
-    // The difference is stored in millidegrees. Even at 6000 deg/s (well
-    // above the physical limits of the motors we use), this at most
-    // 6000 * 1000 * 0.005 = 30000, which fits in a 16-bit signed integer.
+    // The difference is stored in millidegrees as a 16-bit signed integer.
+    // With the longest loop time of 10 ms, this holds speeds up to
+    // 32767 / 1000 / 0.010 = 3276 deg/s, which is well above the physical
+    // limits of the motors we use. Faster changes are clamped.
     dif->history[dif->index] = pbio_int_math_clamp(pbio_angle_diff_mdeg(angle, &dif->prev_angle), INT16_MAX);
     dif->prev_angle = *angle;
 
-    // Calculate the speed.
-    return pbio_differentiator_calc_speed(dif, PBIO_CONFIG_DIFFERENTIATOR_WINDOW_SIZE);
+    // Calculate the speed across 100 ms.
+    return pbio_differentiator_calc_speed(dif, 100 / pbio_control_settings_get_loop_time());
 }
 
 /**
@@ -69,7 +71,8 @@ int32_t pbio_differentiator_update_and_get_speed(pbio_differentiator_t *dif, con
 pbio_error_t pbio_differentiator_get_speed(pbio_differentiator_t *dif, uint32_t window, int32_t *speed) {
 
     // Round window to nearest sample size.
-    uint8_t window_size = (window + PBIO_CONFIG_CONTROL_LOOP_TIME_MS / 2) / PBIO_CONFIG_CONTROL_LOOP_TIME_MS;
+    uint32_t loop_time = pbio_control_settings_get_loop_time();
+    uint32_t window_size = (window + loop_time / 2) / loop_time;
     if (window_size == 0 || window_size > PBIO_ARRAY_SIZE(dif->history) - 1) {
         return PBIO_ERROR_INVALID_ARG;
     }
@@ -83,6 +83,9 @@ static void drivebase_adopt_settings(pbio_control_settings_t *s_distance, pbio_c
         // Make acceleration, deceleration a bit slower for smoother driving.
         .acceleration = pbio_int_math_min(s_left->acceleration, s_right->acceleration) * 3 / 4,
         .deceleration = pbio_int_math_min(s_left->deceleration, s_right->deceleration) * 3 / 4,
+        // Use smoother ramps only if both motors do.
+        .trajectory_profile = s_left->trajectory_profile == s_right->trajectory_profile ?
+            s_left->trajectory_profile : PBIO_TRAJECTORY_PROFILE_TRAPEZOID,
         .actuation_max = actuation_max,
         .pid_kp = pid_kp,
         // Dynamic kp reduction is disabled for drivebases. Instead, it uses
@@ -113,6 +116,36 @@ static void drivebase_adopt_settings(pbio_control_settings_t *s_distance, pbio_c
     s_heading->actuation_max = s_distance->actuation_max * 2;
 }
 
+/**
+ * Combines the states of both servos into the drivebase state.
+ *
+ * @param [in]  db              The drivebase instance
+ * @param [in]  state_left      Physical and estimated state of the left servo.
+ * @param [in]  state_right     Physical and estimated state of the right servo.
+ * @param [out] state_distance  Physical and estimated state of the distance.
+ * @param [out] state_heading   Physical and estimated state of the heading.
+ */
+static void pbio_drivebase_combine_state(pbio_drivebase_t *db, const pbio_control_state_t *state_left, const pbio_control_state_t *state_right, pbio_control_state_t *state_distance, pbio_control_state_t *state_heading) {
+
+    // Take average to get distance state
+    pbio_angle_avg(&state_left->position, &state_right->position, &state_distance->position);
+    pbio_angle_avg(&state_left->position_estimate, &state_right->position_estimate, &state_distance->position_estimate);
+    state_distance->speed_estimate = (state_left->speed_estimate + state_right->speed_estimate) / 2;
+    state_distance->speed = (state_left->speed + state_right->speed) / 2;
+
+    // Take average difference to get heading state, which is implemented as:
+    // (left - right) / 2 = (left + right) / 2 - right = avg - right.
+    pbio_angle_diff(&state_distance->position, &state_right->position, &state_heading->position);
+    pbio_angle_diff(&state_distance->position_estimate, &state_right->position_estimate, &state_heading->position_estimate);
+    state_heading->speed_estimate = state_distance->speed_estimate - state_right->speed_estimate;
+    state_heading->speed = state_distance->speed - state_right->speed;
+
+    // Optionally use gyro to override the heading source for more accuracy.
+    if (db->use_gyro) {
+        pbio_imu_get_heading_scaled(&state_heading->position, &state_heading->speed, db->control_heading.settings.ctl_steps_per_app_step);
+    }
+}
+
 /**
  * Get the physical and estimated state of a drivebase in units of control.
  *
@@ -137,24 +170,34 @@ static pbio_error_t pbio_drivebase_get_state_control(pbio_drivebase_t *db, pbio_
         return err;
     }
 
-    // Take average to get distance state
-    pbio_angle_avg(&state_left.position, &state_right.position, &state_distance->position);
-    pbio_angle_avg(&state_left.position_estimate, &state_right.position_estimate, &state_distance->position_estimate);
-    state_distance->speed_estimate = (state_left.speed_estimate + state_right.speed_estimate) / 2;
-    state_distance->speed = (state_left.speed + state_right.speed) / 2;
+    pbio_drivebase_combine_state(db, &state_left, &state_right, state_distance, state_heading);
+    return PBIO_SUCCESS;
+}
 
-    // Take average difference to get heading state, which is implemented as:
-    // (left - right) / 2 = (left + right) / 2 - right = avg - right.
-    pbio_angle_diff(&state_distance->position, &state_right.position, &state_heading->position);
-    pbio_angle_diff(&state_distance->position_estimate, &state_right.position_estimate, &state_heading->position_estimate);
-    state_heading->speed_estimate = state_distance->speed_estimate - state_right.speed_estimate;
-    state_heading->speed = state_distance->speed - state_right.speed;
+/**
+ * Get the drivebase state in units of control, using the servo states that
+ * were sampled at the start of the ongoing control loop iteration.
+ *
+ * @param [in]  db              The drivebase instance
+ * @param [out] state_distance  Physical and estimated state of the distance.
+ * @param [out] state_heading   Physical and estimated state of the heading.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_drivebase_get_state_sampled(pbio_drivebase_t *db, pbio_control_state_t *state_distance, pbio_control_state_t *state_heading) {
 
-    // Optionally use gyro to override the heading source for more accuracy.
-    if (db->use_gyro) {
-        pbio_imu_get_heading_scaled(&state_heading->position, &state_heading->speed, db->control_heading.settings.ctl_steps_per_app_step);
+    pbio_control_state_t state_left;
+    pbio_error_t err = pbio_servo_get_state_sampled(db->left, &state_left);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    pbio_control_state_t state_right;
+    err = pbio_servo_get_state_sampled(db->right, &state_right);
+    if (err != PBIO_SUCCESS) {
+        return err;
     }
 
+    pbio_drivebase_combine_state(db, &state_left, &state_right, state_distance, state_heading);
     return PBIO_SUCCESS;
 }
 
@@ -403,26 +446,24 @@ bool pbio_drivebase_is_done(const pbio_drivebase_t *db) {
 /**
  * Updates one drivebase in the control loop.
  *
- * This reads the physical and estimated state, and updates the controller if
- * it is active.
+ * This gets the sampled physical and estimated state, and updates the
+ * controller if it is active.
  *
  * @param [in]  db          The drivebase instance
+ * @param [in]  time_now    Time at which the servo states were sampled.
  * @return                  Error code.
  */
-static pbio_error_t pbio_drivebase_update(pbio_drivebase_t *db) {
+static pbio_error_t pbio_drivebase_update(pbio_drivebase_t *db, uint32_t time_now) {
 
     // If passive, no need to update.
     if (!pbio_drivebase_control_is_active(db)) {
         return PBIO_SUCCESS;
     }
 
-    // Get current time
-    uint32_t time_now = pbio_control_get_time_ticks();
-
     // Get drive base state
     pbio_control_state_t state_distance;
     pbio_control_state_t state_heading;
-    pbio_error_t err = pbio_drivebase_get_state_control(db, &state_distance, &state_heading);
+    pbio_error_t err = pbio_drivebase_get_state_sampled(db, &state_distance, &state_heading);
     if (err != PBIO_SUCCESS) {
         return err;
     }
@@ -483,8 +524,13 @@ static pbio_error_t pbio_drivebase_update(pbio_drivebase_t *db) {
 
 /**
  * Updates all currently active (previously set up) drivebases.
+ *
+ * This gets called once on every control loop, after the state of all servos
+ * was sampled with ::pbio_servo_sample_all.
+ *
+ * @param [in]  time_now    Time at which the servo states were sampled.
  */
-void pbio_drivebase_update_all(void) {
+void pbio_drivebase_update_all(uint32_t time_now) {
     // Go through all drive base candidates
     for (uint8_t i = 0; i < PBIO_CONFIG_NUM_DRIVEBASES; i++) {
 
@@ -492,9 +538,54 @@ void pbio_drivebase_update_all(void) {
 
         // If it's registered for updates, run its update loop
         if (pbio_drivebase_update_loop_is_running(db)) {
-            pbio_drivebase_update(db);
+            pbio_drivebase_update(db, time_now);
+        }
+    }
+}
+
+/**
+ * Checks if the distance or heading controller of any drive base is active.
+ *
+ * @return                      True if at least one drive base is controlled, false if not.
+ */
+bool pbio_drivebase_control_is_active_any(void) {
+    for (uint8_t i = 0; i < PBIO_CONFIG_NUM_DRIVEBASES; i++) {
+        pbio_drivebase_t *db = &drivebases[i];
+        if (pbio_drivebase_update_loop_is_running(db) &&
+            (pbio_control_is_active(&db->control_distance) || pbio_control_is_active(&db->control_heading))) {
+            return true;
         }
     }
+    return false;
+}
+
+/**
+ * Makes the distance and heading trajectories take equally long, so that they
+ * complete at the same time. The shortest trajectory is re-computed to have
+ * the same duration as the longest.
+ *
+ * @param [in]  distance        Trajectory of the distance controller.
+ * @param [in]  heading         Trajectory of the heading controller.
+ */
+static void pbio_drivebase_synchronize(pbio_trajectory_t *distance, pbio_trajectory_t *heading) {
+
+    // First, find out which controller takes the lead
+    const pbio_trajectory_t *leader;
+    pbio_trajectory_t *follower;
+
+    if (pbio_trajectory_get_duration(distance) > pbio_trajectory_get_duration(heading)) {
+        // Distance control takes the longest, so it will take the lead
+        leader = distance;
+        follower = heading;
+    } else {
+        // Heading control takes the longest, so it will take the lead
+        leader = heading;
+        follower = distance;
+    }
+
+    // Revise follower trajectory so it takes as long as the leader, achieved
+    // by picking a lower speed and accelerations that makes the times match.
+    pbio_trajectory_stretch(follower, leader);
 }
 
 /**
@@ -542,26 +633,7 @@ static pbio_error_t pbio_drivebase_drive_relative(pbio_drivebase_t *db, int32_t
     }
 
     // At this point, the two trajectories may have different durations, so they won't complete at the same time
-    // To account for this, we re-compute the shortest trajectory to have the same duration as the longest.
-
-    // First, find out which controller takes the lead
-    const pbio_control_t *control_leader;
-    pbio_control_t *control_follower;
-
-    if (pbio_trajectory_get_duration(&db->control_distance.trajectory) >
-        pbio_trajectory_get_duration(&db->control_heading.trajectory)) {
-        // Distance control takes the longest, so it will take the lead
-        control_leader = &db->control_distance;
-        control_follower = &db->control_heading;
-    } else {
-        // Heading control takes the longest, so it will take the lead
-        control_leader = &db->control_heading;
-        control_follower = &db->control_distance;
-    }
-
-    // Revise follower trajectory so it takes as long as the leader, achieved
-    // by picking a lower speed and accelerations that makes the times match.
-    pbio_trajectory_stretch(&control_follower->trajectory, &control_leader->trajectory);
+    pbio_drivebase_synchronize(&db->control_distance.trajectory, &db->control_heading.trajectory);
 
     return PBIO_SUCCESS;
 }
@@ -604,6 +676,121 @@ pbio_error_t pbio_drivebase_drive_curve(pbio_drivebase_t *db, int32_t radius, in
     return pbio_drivebase_drive_relative(db, arc_length, 0, arc_angle, 0, on_completion);
 }
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+/**
+ * Queues a run by a given distance and angle after the maneuvers queued
+ * before it.
+ *
+ * Each controller keeps going at speed into the new maneuver if it moves in
+ * the same direction. If nothing was queued, this starts right away. Any
+ * other command discards the queue.
+ *
+ * @param [in]  db              The drivebase instance.
+ * @param [in]  distance        The distance to run by in mm.
+ * @param [in]  drive_speed     The drive speed in mm/s.
+ * @param [in]  angle           The angle to turn in deg.
+ * @param [in]  turn_speed      The turn speed in deg/s.
+ * @param [in]  on_completion   What to do when reaching the target, unless another maneuver follows.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_drivebase_queue_relative(pbio_drivebase_t *db, int32_t distance, int32_t drive_speed, int32_t angle, int32_t turn_speed, pbio_control_on_completion_t on_completion) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_drivebase_update_loop_is_running(db)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // Stop servo control in case it was running.
+    pbio_drivebase_stop_servo_control(db);
+
+    // Get current time
+    uint32_t time_now = pbio_control_get_time_ticks();
+
+    // Get drive base state
+    pbio_control_state_t state_distance;
+    pbio_control_state_t state_heading;
+    pbio_error_t err = pbio_drivebase_get_state_control(db, &state_distance, &state_heading);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Plan both controllers before changing either, so that a full queue or
+    // a failed plan leaves the drive base as it was.
+    pbio_control_queue_plan_t plan_distance;
+    pbio_control_queue_plan_t plan_heading;
+    err = pbio_control_queue_prepare(&db->control_distance, time_now, &state_distance, distance, drive_speed, &plan_distance);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    err = pbio_control_queue_prepare(&db->control_heading, time_now, &state_heading, angle, turn_speed, &plan_heading);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // The controllers queue together, but if either one is not running from
+    // the queue anymore, start both right away.
+    if (plan_distance.start != plan_heading.start) {
+        plan_distance.start = true;
+        plan_heading.start = true;
+    }
+
+    // Preparing may have changed the last trajectories, so synchronize them
+    // again before planning the new ones from their endpoints.
+    if (!plan_distance.start) {
+        pbio_drivebase_synchronize(&plan_distance.last, &plan_heading.last);
+    }
+
+    err = pbio_control_queue_add(&db->control_distance, time_now, &state_distance, distance, drive_speed, on_completion, &plan_distance);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    err = pbio_control_queue_add(&db->control_heading, time_now, &state_heading, angle, turn_speed, on_completion, &plan_heading);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    pbio_drivebase_synchronize(&plan_distance.segment.trajectory, &plan_heading.segment.trajectory);
+
+    pbio_control_queue_commit(&db->control_distance, time_now, &plan_distance);
+    pbio_control_queue_commit(&db->control_heading, time_now, &plan_heading);
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Queues a straight run by a given distance, at the default speed.
+ *
+ * @param [in]  db              The drivebase instance.
+ * @param [in]  distance        The distance to run by in mm.
+ * @param [in]  on_completion   What to do when reaching the target, unless another maneuver follows.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_drivebase_queue_straight(pbio_drivebase_t *db, int32_t distance, pbio_control_on_completion_t on_completion) {
+    return pbio_drivebase_queue_relative(db, distance, 0, 0, 0, on_completion);
+}
+
+/**
+ * Queues a run along an arc of given radius and angle, at the default speed.
+ *
+ * @param [in]  db              The drivebase instance.
+ * @param [in]  radius          Radius of the arc in mm.
+ * @param [in]  angle           Angle in degrees.
+ * @param [in]  on_completion   What to do when reaching the target, unless another maneuver follows.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_drivebase_queue_curve(pbio_drivebase_t *db, int32_t radius, int32_t angle, pbio_control_on_completion_t on_completion) {
+
+    // The angle is signed by the radius so we can go both ways.
+    int32_t arc_angle = radius < 0 ? -angle : angle;
+
+    // Arc length is computed accordingly.
+    int32_t arc_length = (10 * pbio_int_math_abs(angle) * radius) / 573;
+
+    return pbio_drivebase_queue_relative(db, arc_length, 0, arc_angle, 0, on_completion);
+}
+
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 /**
  * Starts the drivebase controllers to run for a given duration.
  *
@@ -216,3 +216,44 @@ pbio_error_t pbio_geometry_map_from_base_axes(pbio_geometry_xyz_t *x_axis, pbio_
 
     return PBIO_SUCCESS;
 }
+
+/**
+ * Normalizes a quaternion in place so it has unit length.
+ *
+ * @param [in, out] q   The quaternion to normalize.
+ * @return              ::PBIO_ERROR_INVALID_ARG if the quaternion has zero length, otherwise ::PBIO_SUCCESS.
+ */
+pbio_error_t pbio_geometry_quaternion_normalize(pbio_geometry_quaternion_t *q) {
+
+    float norm = sqrtf(q->w * q->w + q->x * q->x + q->y * q->y + q->z * q->z);
+
+    if (norm == 0.0f) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    q->w /= norm;
+    q->x /= norm;
+    q->y /= norm;
+    q->z /= norm;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Gets the rotation matrix of a unit quaternion.
+ *
+ * @param [in]  q           The unit quaternion.
+ * @param [out] rotation    The rotation matrix, which maps vectors in the same way as @p q.
+ */
+void pbio_geometry_quaternion_to_rotation_matrix(pbio_geometry_quaternion_t *q, pbio_geometry_matrix_3x3_t *rotation) {
+    *rotation = (pbio_geometry_matrix_3x3_t) {
+        .m11 = 1.0f - 2.0f * (q->y * q->y + q->z * q->z),
+        .m12 = 2.0f * (q->x * q->y - q->w * q->z),
+        .m13 = 2.0f * (q->x * q->z + q->w * q->y),
+        .m21 = 2.0f * (q->x * q->y + q->w * q->z),
+        .m22 = 1.0f - 2.0f * (q->x * q->x + q->z * q->z),
+        .m23 = 2.0f * (q->y * q->z - q->w * q->x),
+        .m31 = 2.0f * (q->x * q->z - q->w * q->y),
+        .m32 = 2.0f * (q->y * q->z + q->w * q->x),
+        .m33 = 1.0f - 2.0f * (q->x * q->x + q->y * q->y),
+    };
+}
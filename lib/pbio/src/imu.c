@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MIT
 // Copyright (c) 2022-2023 The Pybricks Authors
 
+#include <math.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -26,34 +27,241 @@ static pbio_geometry_xyz_t acceleration; // mm/s^2, in hub frame
 static pbio_geometry_xyz_t gyro_bias;
 static pbio_geometry_xyz_t single_axis_rotation; // deg, in hub frame
 
-// Called by driver to process one frame of unfiltered gyro and accelerometer data.
-static void pbio_imu_handle_frame_data_func(int16_t *data) {
-    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(angular_velocity.values); i++) {
-        // Update angular velocity and acceleration cache so user can read them.
-        angular_velocity.values[i] = data[i] * imu_config->gyro_scale - gyro_bias.values[i];
-        acceleration.values[i] = data[i + 3] * imu_config->accel_scale;
-
-        // Update "heading" on all axes. This is not useful for 3D attitude
-        // estimation, but it allows the user to get a 1D heading even with
-        // the hub mounted at an arbitrary orientation. Such a 1D heading
-        // is numerically more accurate, which is useful in drive base
-        // applications so long as the vehicle drives on a flat surface.
-        single_axis_rotation.values[i] += angular_velocity.values[i] * imu_config->sample_time;
+// Average angular velocity of the most recent batch of frames, and the time
+// at which it was received. Used to estimate rotation in between samples.
+static pbio_geometry_xyz_t angular_velocity_recent; // deg/s, in hub frame, already adjusted for bias.
+static uint32_t frame_time_recent; // us
+
+// Heading estimates are extrapolated by at most this much time (us), so a
+// stalled data stream does not make the heading run away.
+#define HEADING_EXTRAPOLATION_MAX (10000)
+
+// Standard gravity in mm/s^2.
+#define GRAVITY (9806.65f)
+
+#define DEG_TO_RAD (0.017453293f)
+
+// Gain (1/s) with which the attitude estimate is pulled towards the measured
+// gravity direction. This sets how fast gyro drift in tilt is corrected.
+#define ATTITUDE_GAIN (1.0f)
+
+// The accelerometer measures gravity plus linear acceleration. It is only
+// used to correct tilt if its magnitude is close to gravity, so that driving
+// and bumps don't distort the estimate.
+#define ATTITUDE_ACCEL_TOLERANCE (0.1f * GRAVITY)
+
+// Gain (1/s^2) with which the gyro bias is adjusted by the remaining error
+// between measured and estimated gravity direction, like the integral term of
+// a PI controller. This learns the bias of the axes that are horizontal, also
+// while moving. The time constant is ATTITUDE_GAIN / ATTITUDE_BIAS_GAIN.
+#define ATTITUDE_BIAS_GAIN (0.02f)
+
+// Estimated attitude, which rotates vectors in the hub frame to the inertial
+// frame. The inertial Z axis points up.
+static pbio_geometry_quaternion_t attitude = { .w = 1.0f };
+static bool attitude_initialized;
+
+// Duration (s) of the window in which each gyro axis is tested for zero rate.
+#define ZERO_RATE_WINDOW_TIME (0.5f)
+
+// An axis is considered not to rotate if its raw rate stays within this band
+// (deg/s) for the whole window. This is just above the noise level.
+#define ZERO_RATE_BAND (1.5f)
+
+// Once calibrated, a window average only counts as bias if it is at most this
+// far (deg/s) from the current bias. This rejects very slow steady rotations.
+#define ZERO_RATE_BIAS_CHANGE_MAX (2.0f)
+
+// Relative weight of one zero-rate window in the bias estimate.
+#define ZERO_RATE_WEIGHT (0.02f)
+
+// Window of raw gyro data (deg/s) in which each axis is tested for zero rate.
+static pbio_geometry_xyz_t zero_rate_sum;
+static pbio_geometry_xyz_t zero_rate_min;
+static pbio_geometry_xyz_t zero_rate_max;
+static uint32_t zero_rate_count;
+
+/**
+ * Initializes the attitude estimate to the tilt given by the measured gravity
+ * direction, with zero yaw.
+ *
+ * @param [in]  accel       Acceleration in mm/s^2 in the hub frame.
+ */
+static void pbio_imu_attitude_reset(pbio_geometry_xyz_t *accel) {
+    float half_roll = atan2f(accel->y, accel->z) / 2;
+    float half_pitch = atan2f(-accel->x, sqrtf(accel->y * accel->y + accel->z * accel->z)) / 2;
+
+    attitude.w = cosf(half_roll) * cosf(half_pitch);
+    attitude.x = sinf(half_roll) * cosf(half_pitch);
+    attitude.y = cosf(half_roll) * sinf(half_pitch);
+    attitude.z = -sinf(half_roll) * sinf(half_pitch);
+    attitude_initialized = true;
+}
+
+/**
+ * Updates the attitude estimate with one sample using a Mahony filter.
+ *
+ * The gyro rate is integrated on the quaternion. The error between the
+ * measured and estimated direction of gravity is fed back as an extra rate,
+ * which corrects roll and pitch but not yaw.
+ *
+ * @param [in]  gyro        Angular velocity in deg/s in the hub frame, adjusted for bias.
+ * @param [in]  accel       Acceleration in mm/s^2 in the hub frame.
+ * @param [in]  dt          Time since the previous sample in s.
+ */
+static void pbio_imu_attitude_update(pbio_geometry_xyz_t *gyro, pbio_geometry_xyz_t *accel, float dt) {
+
+    if (!attitude_initialized) {
+        pbio_imu_attitude_reset(accel);
+        return;
+    }
+
+    pbio_geometry_quaternion_t *q = &attitude;
+    float wx = gyro->x * DEG_TO_RAD;
+    float wy = gyro->y * DEG_TO_RAD;
+    float wz = gyro->z * DEG_TO_RAD;
+
+    float accel_norm = sqrtf(accel->x * accel->x + accel->y * accel->y + accel->z * accel->z);
+    if (accel_norm > GRAVITY - ATTITUDE_ACCEL_TOLERANCE && accel_norm < GRAVITY + ATTITUDE_ACCEL_TOLERANCE) {
+        // Estimated direction of up in the hub frame, which is the last row
+        // of the rotation matrix.
+        float vx = 2.0f * (q->x * q->z - q->w * q->y);
+        float vy = 2.0f * (q->y * q->z + q->w * q->x);
+        float vz = 1.0f - 2.0f * (q->x * q->x + q->y * q->y);
+
+        // The cross product of measured and estimated up is the rotation
+        // that brings the estimate closer to the measurement.
+        float gain = ATTITUDE_GAIN / accel_norm;
+        wx += gain * (accel->y * vz - accel->z * vy);
+        wy += gain * (accel->z * vx - accel->x * vz);
+        wz += gain * (accel->x * vy - accel->y * vx);
+
+        // Whatever error remains on average is due to gyro bias, so slowly
+        // adjust the bias to cancel it. The error has no component along
+        // gravity, so this only affects the horizontal axes.
+        float bias_gain = ATTITUDE_BIAS_GAIN * dt / ATTITUDE_GAIN / DEG_TO_RAD;
+        gyro_bias.x -= bias_gain * gain * (accel->y * vz - accel->z * vy);
+        gyro_bias.y -= bias_gain * gain * (accel->z * vx - accel->x * vz);
+        gyro_bias.z -= bias_gain * gain * (accel->x * vy - accel->y * vx);
     }
+
+    // Integrate the quaternion derivative, q' = q * (0, w) / 2.
+    float h = dt / 2;
+    pbio_geometry_quaternion_t dq = {
+        .w = h * (-q->x * wx - q->y * wy - q->z * wz),
+        .x = h * (q->w * wx + q->y * wz - q->z * wy),
+        .y = h * (q->w * wy - q->x * wz + q->z * wx),
+        .z = h * (q->w * wz + q->x * wy - q->y * wx),
+    };
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(q->values); i++) {
+        q->values[i] += dq.values[i];
+    }
+    pbio_geometry_quaternion_normalize(q);
 }
 
 // This counter is a measure for calibration accuracy, roughly equivalent
 // to the accumulative number of seconds it has been stationary in total.
 static uint32_t stationary_counter = 0;
-static uint32_t stationary_time_last;
+
+// Time of the last bias update, either while stationary or while moving.
+static uint32_t bias_time_last;
 
 /*
  * Tests if the imu is ready for use in a user program.
  *
- * @return    True if it has been stationary at least once in the last 10 minutes.
+ * The bias estimate is kept across programs. It keeps adapting while moving,
+ * so the hub only needs to be held still once after boot.
+ *
+ * @return    True if it has been stationary at least once, and the bias was
+ *            updated in the last 10 minutes.
 */
 bool pbio_imu_is_ready(void) {
-    return stationary_counter > 0 && pbdrv_clock_get_ms() - stationary_time_last < 10 * 60 * 1000;
+    return stationary_counter > 0 && pbdrv_clock_get_ms() - bias_time_last < 10 * 60 * 1000;
+}
+
+/**
+ * Updates the gyro bias of each axis that did not rotate in the last window.
+ *
+ * This works while the hub moves, as long as it does not rotate about some
+ * axis, such as the vertical axis of a vehicle driving straight, or the
+ * horizontal axes of a vehicle turning on a flat floor.
+ *
+ * Nothing is learned until the hub has been stationary once. Without a
+ * first estimate, a slow steady rotation could be taken for bias.
+ *
+ * @param [in]  gyro        Raw angular velocity in deg/s, not adjusted for bias.
+ */
+static void pbio_imu_zero_rate_update(pbio_geometry_xyz_t *gyro) {
+
+    if (stationary_counter == 0) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(gyro->values); i++) {
+        zero_rate_sum.values[i] += gyro->values[i];
+        if (zero_rate_count == 0 || gyro->values[i] < zero_rate_min.values[i]) {
+            zero_rate_min.values[i] = gyro->values[i];
+        }
+        if (zero_rate_count == 0 || gyro->values[i] > zero_rate_max.values[i]) {
+            zero_rate_max.values[i] = gyro->values[i];
+        }
+    }
+    zero_rate_count++;
+
+    // Exit if the window is not complete yet.
+    if (zero_rate_count * imu_config->sample_time < ZERO_RATE_WINDOW_TIME) {
+        return;
+    }
+
+    // If the estimate has gone stale, accept anything that could be bias.
+    float change_max = pbio_imu_is_ready() ? ZERO_RATE_BIAS_CHANGE_MAX : imu_config->gyro_stationary_threshold * imu_config->gyro_scale;
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(gyro->values); i++) {
+        float average = zero_rate_sum.values[i] / zero_rate_count;
+        if (zero_rate_max.values[i] - zero_rate_min.values[i] < ZERO_RATE_BAND &&
+            fabsf(average - gyro_bias.values[i]) < change_max) {
+            gyro_bias.values[i] = gyro_bias.values[i] * (1.0f - ZERO_RATE_WEIGHT) + ZERO_RATE_WEIGHT * average;
+            bias_time_last = pbdrv_clock_get_ms();
+        }
+        zero_rate_sum.values[i] = 0.0f;
+    }
+    zero_rate_count = 0;
+}
+
+// Called by driver to process frames of unfiltered gyro and accelerometer data.
+static void pbio_imu_handle_frame_data_func(int16_t *data, uint32_t num_frames) {
+
+    pbio_geometry_xyz_t angular_velocity_sum = { 0 };
+    pbio_geometry_xyz_t gyro_raw;
+
+    for (uint32_t frame = 0; frame < num_frames; frame++, data += 6) {
+        for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(angular_velocity.values); i++) {
+            // Update angular velocity and acceleration cache so user can read them.
+            gyro_raw.values[i] = data[i] * imu_config->gyro_scale;
+            angular_velocity.values[i] = gyro_raw.values[i] - gyro_bias.values[i];
+            acceleration.values[i] = data[i + 3] * imu_config->accel_scale;
+
+            // Update "heading" on all axes. This is not useful for 3D attitude
+            // estimation, but it allows the user to get a 1D heading even with
+            // the hub mounted at an arbitrary orientation. Such a 1D heading
+            // is numerically more accurate, which is useful in drive base
+            // applications so long as the vehicle drives on a flat surface.
+            single_axis_rotation.values[i] += angular_velocity.values[i] * imu_config->sample_time;
+            angular_velocity_sum.values[i] += angular_velocity.values[i];
+        }
+
+        // Update the full 3D attitude estimate.
+        pbio_imu_attitude_update(&angular_velocity, &acceleration, imu_config->sample_time);
+
+        // Learn the bias of axes that aren't rotating.
+        pbio_imu_zero_rate_update(&gyro_raw);
+    }
+
+    // Averaging the whole batch gives a less noisy rate than the last sample.
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(angular_velocity_recent.values); i++) {
+        angular_velocity_recent.values[i] = angular_velocity_sum.values[i] / num_frames;
+    }
+    frame_time_recent = pbdrv_clock_get_us();
 }
 
 // Called by driver to process unfiltered gyro and accelerometer data recorded while stationary.
@@ -65,7 +273,7 @@ static void pbio_imu_handle_stationary_data_func(const int32_t *gyro_data_sum, c
         stationary_counter = 0;
     }
 
-    stationary_time_last = pbdrv_clock_get_ms();
+    bias_time_last = pbdrv_clock_get_ms();
     stationary_counter++;
 
     // The relative weight of the new data in order to build a long term
@@ -201,10 +409,71 @@ pbio_error_t pbio_imu_get_single_axis_rotation(pbio_geometry_xyz_t *axis, float
  */
 pbio_geometry_side_t pbio_imu_get_up_side(void) {
     // Up is which side of a unit box intersects the +Z vector first.
-    // So read +Z vector of the inertial frame, in the body frame.
-    // For now, this is the gravity vector. In the future, we can make this
-    // slightly more accurate by using the full IMU orientation.
-    return pbio_geometry_side_from_vector(&acceleration);
+    // So read +Z vector of the inertial frame, in the body frame. This is
+    // the last row of the rotation matrix of the estimated attitude.
+    pbio_geometry_matrix_3x3_t rotation;
+    pbio_geometry_quaternion_to_rotation_matrix(&attitude, &rotation);
+    pbio_geometry_xyz_t up = {
+        .x = rotation.m31,
+        .y = rotation.m32,
+        .z = rotation.m33,
+    };
+    return pbio_geometry_side_from_vector(&up);
+}
+
+/**
+ * Gets the estimated gravity vector in mm/s^2.
+ *
+ * This is what the accelerometer would measure if the hub were stationary in
+ * its current orientation, so it points up. Unlike the acceleration, it is not
+ * affected by motion.
+ *
+ * @param [out] values      The gravity vector.
+ */
+void pbio_imu_get_gravity(pbio_geometry_xyz_t *values) {
+    pbio_geometry_matrix_3x3_t rotation;
+    pbio_geometry_quaternion_to_rotation_matrix(&attitude, &rotation);
+
+    // Up in the hub frame is the last row of the rotation matrix.
+    pbio_geometry_xyz_t gravity = {
+        .x = rotation.m31 * GRAVITY,
+        .y = rotation.m32 * GRAVITY,
+        .z = rotation.m33 * GRAVITY,
+    };
+    pbio_geometry_vector_map(&pbio_orientation_base_orientation, &gravity, values);
+}
+
+/**
+ * Gets the estimated attitude of the robot as roll, pitch, and yaw angles.
+ *
+ * The angles are intrinsic rotations about the Z, Y, and X axes of the robot
+ * frame, in that order. Roll and pitch are relative to gravity, so they do
+ * not drift. Yaw is relative to the orientation at startup, and drifts like
+ * the heading.
+ *
+ * @param [out] roll        Rotation about the X axis in degrees.
+ * @param [out] pitch       Rotation about the Y axis in degrees.
+ * @param [out] yaw         Rotation about the Z axis in degrees, counterclockwise positive.
+ */
+void pbio_imu_get_roll_pitch_yaw(float *roll, float *pitch, float *yaw) {
+    pbio_geometry_matrix_3x3_t rotation;
+    pbio_geometry_quaternion_to_rotation_matrix(&attitude, &rotation);
+
+    // Robot X axis in the inertial frame, which is the first row of the base
+    // orientation mapped by the attitude.
+    pbio_geometry_xyz_t front = {
+        .x = pbio_orientation_base_orientation.m11,
+        .y = pbio_orientation_base_orientation.m12,
+        .z = pbio_orientation_base_orientation.m13,
+    };
+    pbio_geometry_xyz_t front_inertial;
+    pbio_geometry_vector_map(&rotation, &front, &front_inertial);
+    *yaw = atan2f(front_inertial.y, front_inertial.x) / DEG_TO_RAD;
+
+    pbio_geometry_xyz_t gravity;
+    pbio_imu_get_gravity(&gravity);
+    *roll = atan2f(gravity.y, gravity.z) / DEG_TO_RAD;
+    *pitch = atan2f(-gravity.x, sqrtf(gravity.y * gravity.y + gravity.z * gravity.z)) / DEG_TO_RAD;
 }
 
 static float heading_offset = 0;
@@ -244,6 +513,11 @@ void pbio_imu_set_heading(float desired_heading) {
  * drivebase, which measures heading as the half the difference of the two
  * motor positions in millidegrees.
  *
+ * Samples arrive in batches, so the last one may be a few milliseconds old
+ * by the time the drivebase reads it. To make up for this latency, the
+ * heading is extrapolated to the current time using the average rate of the
+ * most recent batch. This rate is also given as the heading rate.
+ *
  * Heading is defined as clockwise positive.
  *
  * @param [out]  heading               The heading angle in control units.
@@ -252,8 +526,17 @@ void pbio_imu_set_heading(float desired_heading) {
  */
 void pbio_imu_get_heading_scaled(pbio_angle_t *heading, int32_t *heading_rate, int32_t ctl_steps_per_degree) {
 
-    // Heading in degrees of the robot.
-    float heading_degrees = pbio_imu_get_heading();
+    pbio_geometry_xyz_t angular_rate;
+    pbio_geometry_vector_map(&pbio_orientation_base_orientation, &angular_velocity_recent, &angular_rate);
+
+    // Time since the most recent sample was received.
+    uint32_t elapsed = pbdrv_clock_get_us() - frame_time_recent;
+    if (elapsed > HEADING_EXTRAPOLATION_MAX) {
+        elapsed = HEADING_EXTRAPOLATION_MAX;
+    }
+
+    // Heading in degrees of the robot, extrapolated to the current time.
+    float heading_degrees = pbio_imu_get_heading() - angular_rate.z * elapsed / 1000000.0f;
 
     // Number of whole rotations in control units (in terms of wheels, not robot).
     heading->rotations = heading_degrees / (360000 / ctl_steps_per_degree);
@@ -263,8 +546,6 @@ void pbio_imu_get_heading_scaled(pbio_angle_t *heading, int32_t *heading_rate, i
     heading->millidegrees = truncated * ctl_steps_per_degree;
 
     // The heading rate can be obtained by a simple scale because it always fits.
-    pbio_geometry_xyz_t angular_rate;
-    pbio_imu_get_angular_velocity(&angular_rate);
     *heading_rate = (int32_t)(-angular_rate.z * ctl_steps_per_degree);
 }
 
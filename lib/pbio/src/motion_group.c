@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <pbio/control.h>
+#include <pbio/error.h>
+#include <pbio/integrator.h>
+#include <pbio/motion_group.h>
+#include <pbio/parent.h>
+#include <pbio/servo.h>
+#include <pbio/trajectory.h>
+
+#if PBIO_CONFIG_MOTION_GROUP_NUM_DEV > 0
+
+// Motion group objects
+static pbio_motion_group_t motion_groups[PBIO_CONFIG_MOTION_GROUP_NUM_DEV];
+
+/**
+ * Gets the state of the motion group update loop.
+ *
+ * This becomes true after a successful call to
+ * pbio_motion_group_get_motion_group and becomes false when one of its servos
+ * has an error or is used by something else.
+ *
+ * @param [in]  group       The motion group instance.
+ * @return                  True if up and running, false if not.
+ */
+bool pbio_motion_group_update_loop_is_running(pbio_motion_group_t *group) {
+
+    // Motion group must have servos.
+    if (group->num_servos == 0) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < group->num_servos; i++) {
+        pbio_servo_t *srv = group->servos[i];
+
+        // Motion group must be the parent of all of its servos, and their
+        // update loops must be running, since each servo runs its own controller.
+        if (!pbio_parent_equals(&srv->parent, group) || !pbio_servo_update_loop_is_running(srv)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Stops synchronizing the servos of the motion group.
+ *
+ * This does not physically stop the motors if they are already moving.
+ *
+ * @param [in]  group       The motion group instance.
+ */
+static void pbio_motion_group_stop_group_control(pbio_motion_group_t *group) {
+    group->active = false;
+    group->control_paused = false;
+    group->control_paused_next = false;
+}
+
+/**
+ * Stops the servo controllers of the motion group and coasts the motors.
+ *
+ * @param [in]  group       The motion group instance.
+ * @return                  Error code.
+ */
+static pbio_error_t pbio_motion_group_coast_servos(pbio_motion_group_t *group) {
+    pbio_error_t err = PBIO_SUCCESS;
+    for (uint8_t i = 0; i < group->num_servos; i++) {
+        pbio_control_stop(&group->servos[i]->control);
+        pbio_error_t coast_err = pbio_dcmotor_coast(group->servos[i]->dcmotor);
+        if (coast_err != PBIO_SUCCESS) {
+            err = coast_err;
+        }
+    }
+    return err;
+}
+
+/**
+ * Motion group stop function that can be called from a servo.
+ *
+ * When a new command is issued to a servo, the servo calls this to stop the
+ * synchronized maneuver and to stop the other motors physically.
+ *
+ * @param [in]  motion_group    Void pointer to this motion group instance.
+ * @param [in]  clear_parent    Unused. There is currently no higher
+ *                              abstraction than a motion group.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_motion_group_stop_from_servo(void *motion_group, bool clear_parent) {
+
+    // A motion group has no parent, so clear_parent argument is not applicable.
+    (void)clear_parent;
+
+    // Specify pointer type.
+    pbio_motion_group_t *group = motion_group;
+
+    // If no group maneuver is active, there is nothing we need to do.
+    if (!group->active) {
+        return PBIO_SUCCESS;
+    }
+    pbio_motion_group_stop_group_control(group);
+
+    // Since we don't know which servo called the parent to stop, we stop all
+    // of them. We don't stop their parents to avoid escalating the stop calls
+    // up the chain (and back here) once again.
+    return pbio_motion_group_coast_servos(group);
+}
+
+/**
+ * Gets motion group instance from several servo instances.
+ *
+ * @param [out] group_address   Motion group instance if available.
+ * @param [in]  servos          The servo instances.
+ * @param [in]  num_servos      Number of servo instances.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_motion_group_get_motion_group(pbio_motion_group_t **group_address, pbio_servo_t **servos, uint8_t num_servos) {
+
+    if (num_servos == 0 || num_servos > PBIO_CONFIG_SERVO_NUM_DEV) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    for (uint8_t i = 0; i < num_servos; i++) {
+        // Each servo can be in the group only once.
+        for (uint8_t j = 0; j < i; j++) {
+            if (servos[i] == servos[j]) {
+                return PBIO_ERROR_INVALID_ARG;
+            }
+        }
+
+        // If a servo is already in use by a higher level
+        // abstraction like a drivebase, we can't re-use it.
+        if (pbio_parent_exists(&servos[i]->parent)) {
+            return PBIO_ERROR_BUSY;
+        }
+    }
+
+    // Now we know that the servos are free, there must be an available
+    // motion group. We can just use the first one that isn't running.
+    uint8_t index;
+    for (index = 0; index < PBIO_CONFIG_MOTION_GROUP_NUM_DEV; index++) {
+        if (!pbio_motion_group_update_loop_is_running(&motion_groups[index])) {
+            break;
+        }
+    }
+    // Verify result is in range.
+    if (index == PBIO_CONFIG_MOTION_GROUP_NUM_DEV) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    // So, this is the motion group we'll use.
+    pbio_motion_group_t *group = &motion_groups[index];
+    *group_address = group;
+
+    // Attach servos and set their parents, so they can stop this group.
+    group->num_servos = num_servos;
+    for (uint8_t i = 0; i < num_servos; i++) {
+        group->servos[i] = servos[i];
+        pbio_parent_set(&servos[i]->parent, group, pbio_motion_group_stop_from_servo);
+    }
+
+    // Reset all motors to a passive state.
+    pbio_motion_group_stop_group_control(group);
+    return pbio_motion_group_stop(group, PBIO_CONTROL_ON_COMPLETION_COAST);
+}
+
+/**
+ * Checks if all servos in a motion group have completed their maneuver.
+ *
+ * @param [in]  group       The motion group instance.
+ * @return                  True if all servos are done, false if not.
+ */
+bool pbio_motion_group_is_done(const pbio_motion_group_t *group) {
+    for (uint8_t i = 0; i < group->num_servos; i++) {
+        if (!pbio_control_is_done(&group->servos[i]->control)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Gets the motion group that is running a maneuver with the given servo.
+ *
+ * The servo update loop uses this to pause the controllers of all servos in
+ * the group when any one of them pauses, so that they stay synchronized.
+ *
+ * @param [in]  srv         The servo instance.
+ * @return                  The motion group, or NULL if the servo isn't running
+ *                          a motion group maneuver.
+ */
+pbio_motion_group_t *pbio_motion_group_get_active(const pbio_servo_t *srv) {
+    for (uint8_t i = 0; i < PBIO_CONFIG_MOTION_GROUP_NUM_DEV; i++) {
+        pbio_motion_group_t *group = &motion_groups[i];
+        if (group->active && pbio_parent_equals(&srv->parent, group)) {
+            return group;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Updates the synchronization state of all motion groups.
+ *
+ * This gets called once on every control loop, after all servos have been
+ * updated. If any servo controller paused in this iteration, the controllers
+ * of the other servos in its group pause from this iteration as well, and
+ * they all stay paused in the next iteration.
+ *
+ * @param [in]  time_now    The wall time (ticks) of this iteration.
+ */
+void pbio_motion_group_update_all(uint32_t time_now) {
+    for (uint8_t i = 0; i < PBIO_CONFIG_MOTION_GROUP_NUM_DEV; i++) {
+        pbio_motion_group_t *group = &motion_groups[i];
+
+        // Servos that were updated before the one that paused did not know
+        // about it yet, so pause them now. Their reference for this iteration
+        // is the same either way, since a pause starts from the current time.
+        if (group->active && group->control_paused_next && !group->control_paused) {
+            for (uint8_t j = 0; j < group->num_servos; j++) {
+                pbio_control_t *ctl = &group->servos[j]->control;
+                if (pbio_control_type_is_position(ctl)) {
+                    pbio_position_integrator_pause(&ctl->position_integrator, time_now);
+                }
+            }
+        }
+
+        group->control_paused = group->control_paused_next;
+        group->control_paused_next = false;
+    }
+}
+
+/**
+ * Starts the controller of one servo in a motion group.
+ *
+ * @param [in]  srv             The servo instance.
+ * @param [in]  time_now        The wall time (ticks) at which all servos start.
+ * @param [in]  speed           Top angular velocity in degrees per second. If zero, the servo uses its default speed.
+ * @param [in]  position        Target or angle in degrees.
+ * @param [in]  relative        Whether position is an angle to run by (true) or a target to run to (false).
+ * @param [in]  on_completion   What to do after becoming stationary.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_motion_group_start_servo(pbio_servo_t *srv, uint32_t time_now, int32_t speed, int32_t position, bool relative, pbio_control_on_completion_t on_completion) {
+
+    // Read the physical and estimated state
+    pbio_control_state_t state;
+    pbio_error_t err = pbio_servo_get_state_control(srv, &state);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Start without time-shift, so that all trajectories start together.
+    if (relative) {
+        return pbio_control_start_position_control_relative(&srv->control, time_now, &state, position, speed, on_completion, false);
+    }
+    return pbio_control_start_position_control(&srv->control, time_now, &state, position, speed, on_completion, false);
+}
+
+/**
+ * Starts the servo controllers of the motion group to run to given targets or
+ * by given angles, and makes all of them complete at the same time.
+ *
+ * If any servo can't start, all servos of the group stop and coast.
+ *
+ * @param [in]  group           The motion group instance.
+ * @param [in]  speed           Top angular velocity in degrees per second. If zero, each servo uses its default speed.
+ * @param [in]  positions       Target or angle for each servo in degrees.
+ * @param [in]  relative        Whether positions are angles to run by (true) or targets to run to (false).
+ * @param [in]  on_completion   What to do after becoming stationary.
+ * @return                      Error code.
+ */
+static pbio_error_t pbio_motion_group_run_common(pbio_motion_group_t *group, int32_t speed, const int32_t *positions, bool relative, pbio_control_on_completion_t on_completion) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_motion_group_update_loop_is_running(group)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // If the group isn't running a maneuver, the servos may be doing anything,
+    // with references that are paused by different amounts. Stop their control
+    // so that all trajectories start from the measured state at the same time.
+    if (!group->active) {
+        for (uint8_t i = 0; i < group->num_servos; i++) {
+            pbio_control_stop(&group->servos[i]->control);
+        }
+        group->control_paused = false;
+        group->control_paused_next = false;
+    }
+
+    // Get current time
+    uint32_t time_now = pbio_control_get_time_ticks();
+
+    // Start each servo controller, and find the one that takes the longest.
+    pbio_servo_t *leader = group->servos[0];
+    for (uint8_t i = 0; i < group->num_servos; i++) {
+        pbio_servo_t *srv = group->servos[i];
+        pbio_error_t err = pbio_motion_group_start_servo(srv, time_now, speed, positions[i], relative, on_completion);
+        if (err != PBIO_SUCCESS) {
+            // Don't leave some of the servos running without the others.
+            pbio_motion_group_stop_group_control(group);
+            pbio_motion_group_coast_servos(group);
+            return err;
+        }
+
+        if (pbio_trajectory_get_duration(&srv->control.trajectory) > pbio_trajectory_get_duration(&leader->control.trajectory)) {
+            leader = srv;
+        }
+    }
+
+    // Revise follower trajectories so they take as long as the leader,
+    // achieved by picking lower speeds and accelerations.
+    for (uint8_t i = 0; i < group->num_servos; i++) {
+        if (group->servos[i] != leader) {
+            pbio_trajectory_stretch(&group->servos[i]->control.trajectory, &leader->control.trajectory);
+        }
+    }
+
+    group->active = true;
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Runs the servos of a motion group to given target angles, such that they
+ * all start and stop at the same time.
+ *
+ * The servo with the longest maneuver at the given speed takes the lead. The
+ * other servos go slower, so that they arrive together.
+ *
+ * @param [in]  group           The motion group instance.
+ * @param [in]  speed           Top angular velocity in degrees per second. If zero, each servo uses its default speed.
+ * @param [in]  targets         Target angle for each servo in degrees.
+ * @param [in]  on_completion   What to do after becoming stationary at the targets.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_motion_group_run_target(pbio_motion_group_t *group, int32_t speed, const int32_t *targets, pbio_control_on_completion_t on_completion) {
+    return pbio_motion_group_run_common(group, speed, targets, false, on_completion);
+}
+
+/**
+ * Runs the servos of a motion group by given angles, such that they all start
+ * and stop at the same time.
+ *
+ * The sign convention for speed and angles is the same as for
+ * ::pbio_servo_run_angle.
+ *
+ * @param [in]  group           The motion group instance.
+ * @param [in]  speed           Top angular velocity in degrees per second. If zero, each servo uses its default speed.
+ * @param [in]  angles          Angle to run by for each servo in degrees.
+ * @param [in]  on_completion   What to do after becoming stationary at the final angles.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_motion_group_run_angle(pbio_motion_group_t *group, int32_t speed, const int32_t *angles, pbio_control_on_completion_t on_completion) {
+    return pbio_motion_group_run_common(group, speed, angles, true, on_completion);
+}
+
+/**
+ * Stops all servos of a motion group.
+ *
+ * @param [in]  group            The motion group instance.
+ * @param [in]  on_completion    Which stop type to use.
+ * @return                       Error code.
+ */
+pbio_error_t pbio_motion_group_stop(pbio_motion_group_t *group, pbio_control_on_completion_t on_completion) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_motion_group_update_loop_is_running(group)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // We're asked to stop, so continuing makes no sense.
+    if (on_completion == PBIO_CONTROL_ON_COMPLETION_CONTINUE) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Stop synchronization, so stopping the servos won't call back here.
+    pbio_motion_group_stop_group_control(group);
+
+    // Stop the servos and pass on requested stop type.
+    for (uint8_t i = 0; i < group->num_servos; i++) {
+        pbio_error_t err = pbio_servo_stop(group->servos[i], on_completion);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+    return PBIO_SUCCESS;
+}
+
+#endif // PBIO_CONFIG_MOTION_GROUP_NUM_DEV > 0
@@ -18,146 +18,489 @@
 // Model settings auto-generated by pbio/doc/control/motor_data.py
 #if PBIO_CONFIG_SERVO_PUP
 
-static const pbio_observer_model_t model_technic_s_angular = {
-    .d_angle_d_speed = 179217,
-    .d_speed_d_speed = 956,
-    .d_current_d_speed = -249247,
-    .d_angle_d_current = 1950303,
-    .d_speed_d_current = 7666,
-    .d_current_d_current = -9356019,
-    .d_angle_d_voltage = 5654927,
-    .d_speed_d_voltage = 11702,
-    .d_current_d_voltage = 349105,
-    .d_angle_d_torque = -425928,
-    .d_speed_d_torque = -1085,
-    .d_current_d_torque = 383927,
-    .d_voltage_d_torque = 22334,
-    .d_torque_d_voltage = 17203,
-    .d_torque_d_speed = 12282,
-    .d_torque_d_acceleration = 35129,
-    .torque_friction = 9182,
+static const pbio_observer_model_t model_technic_s_angular[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 433393,
+        .d_speed_d_speed = 882,
+        .d_current_d_speed = -296844,
+        .d_angle_d_current = 7328054,
+        .d_speed_d_current = 9130,
+        .d_current_d_current = 336352,
+        .d_angle_d_voltage = 59284971,
+        .d_speed_d_voltage = 43969,
+        .d_current_d_voltage = 415772,
+        .d_angle_d_torque = -2611638,
+        .d_speed_d_torque = -2624,
+        .d_current_d_torque = 1442564,
+        .d_voltage_d_torque = 22334,
+        .d_torque_d_voltage = 17203,
+        .d_torque_d_speed = 12282,
+        .d_torque_d_acceleration = 35129,
+        .torque_friction = 9182,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 179217,
+        .d_speed_d_speed = 956,
+        .d_current_d_speed = -249247,
+        .d_angle_d_current = 1950303,
+        .d_speed_d_current = 7666,
+        .d_current_d_current = -9356019,
+        .d_angle_d_voltage = 5654927,
+        .d_speed_d_voltage = 11702,
+        .d_current_d_voltage = 349105,
+        .d_angle_d_torque = -425928,
+        .d_speed_d_torque = -1085,
+        .d_current_d_torque = 383927,
+        .d_voltage_d_torque = 22334,
+        .d_torque_d_voltage = 17203,
+        .d_torque_d_speed = 12282,
+        .d_torque_d_acceleration = 35129,
+        .torque_friction = 9182,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 95791,
+        .d_speed_d_speed = 1110,
+        .d_current_d_speed = -280162,
+        .d_angle_d_current = 882377,
+        .d_speed_d_current = 8617,
+        .d_current_d_current = -2231101,
+        .d_angle_d_voltage = 1152167,
+        .d_speed_d_voltage = 5294,
+        .d_current_d_voltage = 392406,
+        .d_angle_d_torque = -110964,
+        .d_speed_d_torque = -580,
+        .d_current_d_torque = 173700,
+        .d_voltage_d_torque = 22334,
+        .d_torque_d_voltage = 17203,
+        .d_torque_d_speed = 12282,
+        .d_torque_d_acceleration = 35129,
+        .torque_friction = 9182,
+    },
+    #endif
 };
 
-static const pbio_observer_model_t model_technic_m_angular = {
-    .d_angle_d_speed = 177194,
-    .d_speed_d_speed = 934,
-    .d_current_d_speed = -165023,
-    .d_angle_d_current = 2407354,
-    .d_speed_d_current = 8311,
-    .d_current_d_current = 1058029,
-    .d_angle_d_voltage = 7431528,
-    .d_speed_d_voltage = 14444,
-    .d_current_d_voltage = 225610,
-    .d_angle_d_torque = -919183,
-    .d_speed_d_torque = -2332,
-    .d_current_d_torque = 629020,
-    .d_voltage_d_torque = 47606,
-    .d_torque_d_voltage = 8071,
-    .d_torque_d_speed = 5903,
-    .d_torque_d_acceleration = 16163,
-    .torque_friction = 21413,
+static const pbio_observer_model_t model_technic_m_angular[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 431879,
+        .d_speed_d_speed = 874,
+        .d_current_d_speed = -239578,
+        .d_angle_d_current = 10473910,
+        .d_speed_d_current = 12066,
+        .d_current_d_current = 181189,
+        .d_angle_d_voltage = 87976024,
+        .d_speed_d_voltage = 62844,
+        .d_current_d_voltage = 327537,
+        .d_angle_d_torque = -5665135,
+        .d_speed_d_torque = -5683,
+        .d_current_d_torque = 2736739,
+        .d_voltage_d_torque = 47606,
+        .d_torque_d_voltage = 8071,
+        .d_torque_d_speed = 5903,
+        .d_torque_d_acceleration = 16163,
+        .torque_friction = 21413,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 177194,
+        .d_speed_d_speed = 934,
+        .d_current_d_speed = -165023,
+        .d_angle_d_current = 2407354,
+        .d_speed_d_current = 8311,
+        .d_current_d_current = 1058029,
+        .d_angle_d_voltage = 7431528,
+        .d_speed_d_voltage = 14444,
+        .d_current_d_voltage = 225610,
+        .d_angle_d_torque = -919183,
+        .d_speed_d_torque = -2332,
+        .d_current_d_torque = 629020,
+        .d_voltage_d_torque = 47606,
+        .d_torque_d_voltage = 8071,
+        .d_torque_d_speed = 5903,
+        .d_torque_d_acceleration = 16163,
+        .torque_friction = 21413,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 93909,
+        .d_speed_d_speed = 1073,
+        .d_current_d_speed = -167290,
+        .d_angle_d_current = 974556,
+        .d_speed_d_current = 8425,
+        .d_current_d_current = -1780518,
+        .d_angle_d_voltage = 1358414,
+        .d_speed_d_voltage = 5847,
+        .d_current_d_voltage = 228710,
+        .d_angle_d_torque = -237803,
+        .d_speed_d_torque = -1236,
+        .d_current_d_torque = 254643,
+        .d_voltage_d_torque = 47606,
+        .d_torque_d_voltage = 8071,
+        .d_torque_d_speed = 5903,
+        .d_torque_d_acceleration = 16163,
+        .torque_friction = 21413,
+    },
+    #endif
 };
 
-static const pbio_observer_model_t model_technic_l_angular = {
-    .d_angle_d_speed = 174943,
-    .d_speed_d_speed = 904,
-    .d_current_d_speed = -58045,
-    .d_angle_d_current = 8368268,
-    .d_speed_d_current = 26508,
-    .d_current_d_current = 396164,
-    .d_angle_d_voltage = 13442903,
-    .d_speed_d_voltage = 25105,
-    .d_current_d_voltage = 86900,
-    .d_angle_d_torque = -3690545,
-    .d_speed_d_torque = -9310,
-    .d_current_d_torque = 975141,
-    .d_voltage_d_torque = 133763,
-    .d_torque_d_voltage = 2872,
-    .d_torque_d_speed = 1919,
-    .d_torque_d_acceleration = 3997,
-    .torque_friction = 23239,
+static const pbio_observer_model_t model_technic_l_angular[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 430616,
+        .d_speed_d_speed = 867,
+        .d_current_d_speed = -96727,
+        .d_angle_d_current = 39960350,
+        .d_speed_d_current = 44174,
+        .d_current_d_current = 135488,
+        .d_angle_d_voltage = 171185978,
+        .d_speed_d_voltage = 119882,
+        .d_current_d_voltage = 144812,
+        .d_angle_d_torque = -22874160,
+        .d_speed_d_torque = -22916,
+        .d_current_d_torque = 4656518,
+        .d_voltage_d_torque = 133763,
+        .d_torque_d_voltage = 2872,
+        .d_torque_d_speed = 1919,
+        .d_torque_d_acceleration = 3997,
+        .torque_friction = 23239,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 174943,
+        .d_speed_d_speed = 904,
+        .d_current_d_speed = -58045,
+        .d_angle_d_current = 8368268,
+        .d_speed_d_current = 26508,
+        .d_current_d_current = 396164,
+        .d_angle_d_voltage = 13442903,
+        .d_speed_d_voltage = 25105,
+        .d_current_d_voltage = 86900,
+        .d_angle_d_torque = -3690545,
+        .d_speed_d_torque = -9310,
+        .d_current_d_torque = 975141,
+        .d_voltage_d_torque = 133763,
+        .d_torque_d_voltage = 2872,
+        .d_torque_d_speed = 1919,
+        .d_torque_d_acceleration = 3997,
+        .torque_friction = 23239,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 90972,
+        .d_speed_d_speed = 997,
+        .d_current_d_speed = -51389,
+        .d_angle_d_current = 3066469,
+        .d_speed_d_current = 23468,
+        .d_current_d_current = -9848606,
+        .d_angle_d_voltage = 2259531,
+        .d_speed_d_voltage = 9199,
+        .d_current_d_voltage = 76935,
+        .d_angle_d_torque = -943439,
+        .d_speed_d_torque = -4841,
+        .d_current_d_torque = 357331,
+        .d_voltage_d_torque = 133763,
+        .d_torque_d_voltage = 2872,
+        .d_torque_d_speed = 1919,
+        .d_torque_d_acceleration = 3997,
+        .torque_friction = 23239,
+    },
+    #endif
 };
 
-static const pbio_observer_model_t model_interactive = {
-    .d_angle_d_speed = 179110,
-    .d_speed_d_speed = 941,
-    .d_current_d_speed = -316164,
-    .d_angle_d_current = 7311289,
-    .d_speed_d_current = 35750,
-    .d_current_d_current = -12014584,
-    .d_angle_d_voltage = 4603893,
-    .d_speed_d_voltage = 10967,
-    .d_current_d_voltage = 355664,
-    .d_angle_d_torque = -728461,
-    .d_speed_d_torque = -1850,
-    .d_current_d_torque = 668004,
-    .d_voltage_d_torque = 32225,
-    .d_torque_d_voltage = 11923,
-    .d_torque_d_speed = 10599,
-    .d_torque_d_acceleration = 20588,
-    .torque_friction = 11227,
+static const pbio_observer_model_t model_interactive[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 435143,
+        .d_speed_d_speed = 887,
+        .d_current_d_speed = -298727,
+        .d_angle_d_current = 19861665,
+        .d_speed_d_current = 33778,
+        .d_current_d_current = -18220678,
+        .d_angle_d_voltage = 34186416,
+        .d_speed_d_voltage = 29793,
+        .d_current_d_voltage = 336048,
+        .d_angle_d_torque = -4469365,
+        .d_speed_d_torque = -4495,
+        .d_current_d_torque = 1814683,
+        .d_voltage_d_torque = 32225,
+        .d_torque_d_voltage = 11923,
+        .d_torque_d_speed = 10599,
+        .d_torque_d_acceleration = 20588,
+        .torque_friction = 11227,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 179110,
+        .d_speed_d_speed = 941,
+        .d_current_d_speed = -316164,
+        .d_angle_d_current = 7311289,
+        .d_speed_d_current = 35750,
+        .d_current_d_current = -12014584,
+        .d_angle_d_voltage = 4603893,
+        .d_speed_d_voltage = 10967,
+        .d_current_d_voltage = 355664,
+        .d_angle_d_torque = -728461,
+        .d_speed_d_torque = -1850,
+        .d_current_d_torque = 668004,
+        .d_voltage_d_torque = 32225,
+        .d_torque_d_voltage = 11923,
+        .d_torque_d_speed = 10599,
+        .d_torque_d_acceleration = 20588,
+        .torque_friction = 11227,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 93950,
+        .d_speed_d_speed = 1038,
+        .d_current_d_speed = -348955,
+        .d_angle_d_current = 3704295,
+        .d_speed_d_current = 39457,
+        .d_current_d_current = -13260032,
+        .d_angle_d_voltage = 1112669,
+        .d_speed_d_voltage = 5556,
+        .d_current_d_voltage = 392551,
+        .d_angle_d_torque = -187981,
+        .d_speed_d_torque = -971,
+        .d_current_d_torque = 338447,
+        .d_voltage_d_torque = 32225,
+        .d_torque_d_voltage = 11923,
+        .d_torque_d_speed = 10599,
+        .d_torque_d_acceleration = 20588,
+        .torque_friction = 11227,
+    },
+    #endif
 };
 
-static const pbio_observer_model_t model_technic_l = {
-    .d_angle_d_speed = 175977,
-    .d_speed_d_speed = 912,
-    .d_current_d_speed = -159828,
-    .d_angle_d_current = 5728019,
-    .d_speed_d_current = 22787,
-    .d_current_d_current = -44152415,
-    .d_angle_d_voltage = 6164994,
-    .d_speed_d_voltage = 12888,
-    .d_current_d_voltage = 142828,
-    .d_angle_d_torque = -1377701,
-    .d_speed_d_torque = -3482,
-    .d_current_d_torque = 794862,
-    .d_voltage_d_torque = 62889,
-    .d_torque_d_voltage = 6110,
-    .d_torque_d_speed = 6837,
-    .d_torque_d_acceleration = 10751,
-    .torque_friction = 26430,
+static const pbio_observer_model_t model_technic_l[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 431629,
+        .d_speed_d_speed = 872,
+        .d_current_d_speed = -187035,
+        .d_angle_d_current = 20961376,
+        .d_speed_d_current = 26666,
+        .d_current_d_current = 400664,
+        .d_angle_d_voltage = 62930332,
+        .d_speed_d_voltage = 47163,
+        .d_current_d_voltage = 167140,
+        .d_angle_d_torque = -8515365,
+        .d_speed_d_torque = -8540,
+        .d_current_d_torque = 2908756,
+        .d_voltage_d_torque = 62889,
+        .d_torque_d_voltage = 6110,
+        .d_torque_d_speed = 6837,
+        .d_torque_d_acceleration = 10751,
+        .torque_friction = 26430,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 175977,
+        .d_speed_d_speed = 912,
+        .d_current_d_speed = -159828,
+        .d_angle_d_current = 5728019,
+        .d_speed_d_current = 22787,
+        .d_current_d_current = -44152415,
+        .d_angle_d_voltage = 6164994,
+        .d_speed_d_voltage = 12888,
+        .d_current_d_voltage = 142828,
+        .d_angle_d_torque = -1377701,
+        .d_speed_d_torque = -3482,
+        .d_current_d_torque = 794862,
+        .d_voltage_d_torque = 62889,
+        .d_torque_d_voltage = 6110,
+        .d_torque_d_speed = 6837,
+        .d_torque_d_acceleration = 10751,
+        .torque_friction = 26430,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 91334,
+        .d_speed_d_speed = 989,
+        .d_current_d_speed = -170232,
+        .d_angle_d_current = 2575585,
+        .d_speed_d_current = 24270,
+        .d_current_d_current = -4245458,
+        .d_angle_d_voltage = 1265482,
+        .d_speed_d_voltage = 5795,
+        .d_current_d_voltage = 152124,
+        .d_angle_d_torque = -352564,
+        .d_speed_d_torque = -1807,
+        .d_current_d_torque = 357407,
+        .d_voltage_d_torque = 62889,
+        .d_torque_d_voltage = 6110,
+        .d_torque_d_speed = 6837,
+        .d_torque_d_acceleration = 10751,
+        .torque_friction = 26430,
+    },
+    #endif
 };
 
-static const pbio_observer_model_t model_technic_xl = {
-    .d_angle_d_speed = 176559,
-    .d_speed_d_speed = 916,
-    .d_current_d_speed = -175173,
-    .d_angle_d_current = 8098298,
-    .d_speed_d_current = 35736,
-    .d_current_d_current = -7606150,
-    .d_angle_d_voltage = 5471477,
-    .d_speed_d_voltage = 12148,
-    .d_current_d_voltage = 156891,
-    .d_angle_d_torque = -1282598,
-    .d_speed_d_torque = -3244,
-    .d_current_d_torque = 729279,
-    .d_voltage_d_torque = 55617,
-    .d_torque_d_voltage = 6908,
-    .d_torque_d_speed = 7713,
-    .d_torque_d_acceleration = 11578,
-    .torque_friction = 12893,
+static const pbio_observer_model_t model_technic_xl[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 432407,
+        .d_speed_d_speed = 875,
+        .d_current_d_speed = -179102,
+        .d_angle_d_current = 25714917,
+        .d_speed_d_current = 36538,
+        .d_current_d_current = 1309069,
+        .d_angle_d_voltage = 48759503,
+        .d_speed_d_voltage = 38573,
+        .d_current_d_voltage = 160410,
+        .d_angle_d_torque = -7915893,
+        .d_speed_d_torque = -7944,
+        .d_current_d_torque = 2315715,
+        .d_voltage_d_torque = 55617,
+        .d_torque_d_voltage = 6908,
+        .d_torque_d_speed = 7713,
+        .d_torque_d_acceleration = 11578,
+        .torque_friction = 12893,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 176559,
+        .d_speed_d_speed = 916,
+        .d_current_d_speed = -175173,
+        .d_angle_d_current = 8098298,
+        .d_speed_d_current = 35736,
+        .d_current_d_current = -7606150,
+        .d_angle_d_voltage = 5471477,
+        .d_speed_d_voltage = 12148,
+        .d_current_d_voltage = 156891,
+        .d_angle_d_torque = -1282598,
+        .d_speed_d_torque = -3244,
+        .d_current_d_torque = 729279,
+        .d_voltage_d_torque = 55617,
+        .d_torque_d_voltage = 6908,
+        .d_torque_d_speed = 7713,
+        .d_torque_d_acceleration = 11578,
+        .torque_friction = 12893,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 91585,
+        .d_speed_d_speed = 989,
+        .d_current_d_speed = -188901,
+        .d_angle_d_current = 3871393,
+        .d_speed_d_current = 38537,
+        .d_current_d_current = -7362525,
+        .d_angle_d_voltage = 1216669,
+        .d_speed_d_voltage = 5807,
+        .d_current_d_voltage = 169186,
+        .d_angle_d_torque = -328364,
+        .d_speed_d_torque = -1683,
+        .d_current_d_torque = 348632,
+        .d_voltage_d_torque = 55617,
+        .d_torque_d_voltage = 6908,
+        .d_torque_d_speed = 7713,
+        .d_torque_d_acceleration = 11578,
+        .torque_friction = 12893,
+    },
+    #endif
 };
 
 #if PBIO_CONFIG_SERVO_PUP_MOVE_HUB
 
-static const pbio_observer_model_t model_movehub = {
-    .d_angle_d_speed = 176283,
-    .d_speed_d_speed = 913,
-    .d_current_d_speed = -202833,
-    .d_angle_d_current = 7437051,
-    .d_speed_d_current = 32807,
-    .d_current_d_current = -8118383,
-    .d_angle_d_voltage = 5022928,
-    .d_speed_d_voltage = 11156,
-    .d_current_d_voltage = 157720,
-    .d_angle_d_torque = -966059,
-    .d_speed_d_torque = -2442,
-    .d_current_d_torque = 636829,
-    .d_voltage_d_torque = 45536,
-    .d_torque_d_voltage = 8438,
-    .d_torque_d_speed = 10851,
-    .d_torque_d_acceleration = 15357,
-    .torque_friction = 24835,
+static const pbio_observer_model_t model_movehub[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 432226,
+        .d_speed_d_speed = 874,
+        .d_current_d_speed = -207559,
+        .d_angle_d_current = 23590449,
+        .d_speed_d_current = 33572,
+        .d_current_d_current = 1331897,
+        .d_angle_d_voltage = 44693167,
+        .d_speed_d_voltage = 35386,
+        .d_current_d_voltage = 161395,
+        .d_angle_d_torque = -5966423,
+        .d_speed_d_torque = -5986,
+        .d_current_d_torque = 2020033,
+        .d_voltage_d_torque = 45536,
+        .d_torque_d_voltage = 8438,
+        .d_torque_d_speed = 10851,
+        .d_torque_d_acceleration = 15357,
+        .torque_friction = 24835,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 176283,
+        .d_speed_d_speed = 913,
+        .d_current_d_speed = -202833,
+        .d_angle_d_current = 7437051,
+        .d_speed_d_current = 32807,
+        .d_current_d_current = -8118383,
+        .d_angle_d_voltage = 5022928,
+        .d_speed_d_voltage = 11156,
+        .d_current_d_voltage = 157720,
+        .d_angle_d_torque = -966059,
+        .d_speed_d_torque = -2442,
+        .d_current_d_torque = 636829,
+        .d_voltage_d_torque = 45536,
+        .d_torque_d_voltage = 8438,
+        .d_torque_d_speed = 10851,
+        .d_torque_d_acceleration = 15357,
+        .torque_friction = 24835,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 91252,
+        .d_speed_d_speed = 981,
+        .d_current_d_speed = -217777,
+        .d_angle_d_current = 3550715,
+        .d_speed_d_current = 35224,
+        .d_current_d_current = -7821546,
+        .d_angle_d_voltage = 1116697,
+        .d_speed_d_voltage = 5326,
+        .d_current_d_voltage = 169340,
+        .d_angle_d_torque = -246997,
+        .d_speed_d_torque = -1264,
+        .d_current_d_torque = 304045,
+        .d_voltage_d_torque = 45536,
+        .d_torque_d_voltage = 8438,
+        .d_torque_d_speed = 10851,
+        .d_torque_d_acceleration = 15357,
+        .torque_friction = 24835,
+    },
+    #endif
 };
 
 #endif // PBIO_CONFIG_SERVO_PUP_MOVE_HUB
@@ -166,44 +509,142 @@ static const pbio_observer_model_t model_movehub = {
 
 #if PBIO_CONFIG_SERVO_EV3_NXT
 
-static const pbio_observer_model_t model_ev3_l = {
-    .d_angle_d_speed = 88290,
-    .d_speed_d_speed = 921,
-    .d_current_d_speed = -61626,
-    .d_angle_d_current = 5755278,
-    .d_speed_d_current = 44574,
-    .d_current_d_current = 21338185,
-    .d_angle_d_voltage = 5240040,
-    .d_speed_d_voltage = 21582,
-    .d_current_d_voltage = 106130,
-    .d_angle_d_torque = -1887437,
-    .d_speed_d_torque = -9555,
-    .d_current_d_torque = 861143,
-    .d_voltage_d_torque = 107106,
-    .d_torque_d_voltage = 3587,
-    .d_torque_d_speed = 2083,
-    .d_torque_d_acceleration = 1965,
-    .torque_friction = 16476,
+static const pbio_observer_model_t model_ev3_l[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 429841,
+        .d_speed_d_speed = 863,
+        .d_current_d_speed = -110257,
+        .d_angle_d_current = 71040451,
+        .d_speed_d_current = 79749,
+        .d_current_d_current = 150488,
+        .d_angle_d_voltage = 377522478,
+        .d_speed_d_voltage = 266403,
+        .d_current_d_voltage = 189881,
+        .d_angle_d_torque = -46475930,
+        .d_speed_d_torque = -46520,
+        .d_current_d_torque = 10629546,
+        .d_voltage_d_torque = 107106,
+        .d_torque_d_voltage = 3587,
+        .d_torque_d_speed = 2083,
+        .d_torque_d_acceleration = 1965,
+        .torque_friction = 16476,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 173282,
+        .d_speed_d_speed = 881,
+        .d_current_d_speed = -69014,
+        .d_angle_d_current = 15363470,
+        .d_speed_d_current = 49919,
+        .d_current_d_current = 491835,
+        .d_angle_d_voltage = 30444180,
+        .d_speed_d_voltage = 57613,
+        .d_current_d_voltage = 118854,
+        .d_angle_d_torque = -7467749,
+        .d_speed_d_torque = -18754,
+        .d_current_d_torque = 2298785,
+        .d_voltage_d_torque = 107106,
+        .d_torque_d_voltage = 3587,
+        .d_torque_d_speed = 2083,
+        .d_torque_d_acceleration = 1965,
+        .torque_friction = 16476,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 88290,
+        .d_speed_d_speed = 921,
+        .d_current_d_speed = -61626,
+        .d_angle_d_current = 5755278,
+        .d_speed_d_current = 44574,
+        .d_current_d_current = 21338185,
+        .d_angle_d_voltage = 5240040,
+        .d_speed_d_voltage = 21582,
+        .d_current_d_voltage = 106130,
+        .d_angle_d_torque = -1887437,
+        .d_speed_d_torque = -9555,
+        .d_current_d_torque = 861143,
+        .d_voltage_d_torque = 107106,
+        .d_torque_d_voltage = 3587,
+        .d_torque_d_speed = 2083,
+        .d_torque_d_acceleration = 1965,
+        .torque_friction = 16476,
+    },
+    #endif
 };
 
-static const pbio_observer_model_t model_ev3_m = {
-    .d_angle_d_speed = 90029,
-    .d_speed_d_speed = 959,
-    .d_current_d_speed = -185122,
-    .d_angle_d_current = 2377978,
-    .d_speed_d_current = 21415,
-    .d_current_d_current = -4432336,
-    .d_angle_d_voltage = 1996477,
-    .d_speed_d_voltage = 8917,
-    .d_current_d_voltage = 202362,
-    .d_angle_d_torque = -401501,
-    .d_speed_d_torque = -2047,
-    .d_current_d_torque = 467397,
-    .d_voltage_d_torque = 47722,
-    .d_torque_d_voltage = 8051,
-    .d_torque_d_speed = 7365,
-    .d_torque_d_acceleration = 9355,
-    .torque_friction = 18317,
+static const pbio_observer_model_t model_ev3_m[] = {
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(2)
+    {
+        .loop_time = 2,
+        .d_angle_d_speed = 430851,
+        .d_speed_d_speed = 868,
+        .d_current_d_speed = -227116,
+        .d_angle_d_current = 21433555,
+        .d_speed_d_current = 26272,
+        .d_current_d_current = 291225,
+        .d_angle_d_voltage = 109172303,
+        .d_speed_d_voltage = 80376,
+        .d_current_d_voltage = 248266,
+        .d_angle_d_torque = -9776450,
+        .d_speed_d_torque = -9796,
+        .d_current_d_torque = 4212817,
+        .d_voltage_d_torque = 47722,
+        .d_torque_d_voltage = 8051,
+        .d_torque_d_speed = 7365,
+        .d_torque_d_acceleration = 9355,
+        .torque_friction = 18317,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(5)
+    {
+        .loop_time = 5,
+        .d_angle_d_speed = 174833,
+        .d_speed_d_speed = 899,
+        .d_current_d_speed = -179788,
+        .d_angle_d_current = 5508196,
+        .d_speed_d_current = 20798,
+        .d_current_d_current = 4313632,
+        .d_angle_d_voltage = 10143433,
+        .d_speed_d_voltage = 20656,
+        .d_current_d_voltage = 196531,
+        .d_angle_d_torque = -1577148,
+        .d_speed_d_torque = -3975,
+        .d_current_d_torque = 1082649,
+        .d_voltage_d_torque = 47722,
+        .d_torque_d_voltage = 8051,
+        .d_torque_d_speed = 7365,
+        .d_torque_d_acceleration = 9355,
+        .torque_friction = 18317,
+    },
+    #endif
+    #if PBIO_CONFIG_CONTROL_LOOP_TIME_IS_AVAILABLE(10)
+    {
+        .loop_time = 10,
+        .d_angle_d_speed = 90029,
+        .d_speed_d_speed = 959,
+        .d_current_d_speed = -185122,
+        .d_angle_d_current = 2377978,
+        .d_speed_d_current = 21415,
+        .d_current_d_current = -4432336,
+        .d_angle_d_voltage = 1996477,
+        .d_speed_d_voltage = 8917,
+        .d_current_d_voltage = 202362,
+        .d_angle_d_torque = -401501,
+        .d_speed_d_torque = -2047,
+        .d_current_d_torque = 467397,
+        .d_voltage_d_torque = 47722,
+        .d_torque_d_voltage = 8051,
+        .d_torque_d_speed = 7365,
+        .d_torque_d_acceleration = 9355,
+        .torque_friction = 18317,
+    },
+    #endif
 };
 
 #endif // PBIO_CONFIG_SERVO_EV3_NXT
@@ -212,7 +653,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     #if PBIO_CONFIG_SERVO_EV3_NXT
     {
         .id = PBDRV_LEGODEV_TYPE_ID_EV3_MEDIUM_MOTOR,
-        .model = &model_ev3_m,
+        .models = model_ev3_m,
+        .num_models = PBIO_ARRAY_SIZE(model_ev3_m),
         .rated_max_speed = 1200,
         .feedback_gain_low = 45,
         .precision_profile = 10,
@@ -220,7 +662,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     },
     {
         .id = PBDRV_LEGODEV_TYPE_ID_EV3_LARGE_MOTOR,
-        .model = &model_ev3_l,
+        .models = model_ev3_l,
+        .num_models = PBIO_ARRAY_SIZE(model_ev3_l),
         .rated_max_speed = 800,
         .feedback_gain_low = 45,
         .precision_profile = 10,
@@ -230,7 +673,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     #if PBIO_CONFIG_SERVO_PUP_MOVE_HUB
     {
         .id = PBDRV_LEGODEV_TYPE_ID_MOVE_HUB_MOTOR,
-        .model = &model_movehub,
+        .models = model_movehub,
+        .num_models = PBIO_ARRAY_SIZE(model_movehub),
         .rated_max_speed = 1500,
         .feedback_gain_low = 45,
         .precision_profile = 20,
@@ -240,7 +684,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     #if PBIO_CONFIG_SERVO_PUP
     {
         .id = PBDRV_LEGODEV_TYPE_ID_INTERACTIVE_MOTOR,
-        .model = &model_interactive,
+        .models = model_interactive,
+        .num_models = PBIO_ARRAY_SIZE(model_interactive),
         .rated_max_speed = 1000,
         .feedback_gain_low = 45,
         .precision_profile = 12,
@@ -248,7 +693,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     },
     {
         .id = PBDRV_LEGODEV_TYPE_ID_TECHNIC_L_MOTOR,
-        .model = &model_technic_l,
+        .models = model_technic_l,
+        .num_models = PBIO_ARRAY_SIZE(model_technic_l),
         .rated_max_speed = 1500,
         .feedback_gain_low = 45,
         .precision_profile = 20,
@@ -256,7 +702,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     },
     {
         .id = PBDRV_LEGODEV_TYPE_ID_TECHNIC_XL_MOTOR,
-        .model = &model_technic_xl,
+        .models = model_technic_xl,
+        .num_models = PBIO_ARRAY_SIZE(model_technic_xl),
         .rated_max_speed = 1500,
         .feedback_gain_low = 45,
         .precision_profile = 20,
@@ -264,7 +711,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     },
     {
         .id = PBDRV_LEGODEV_TYPE_ID_SPIKE_S_MOTOR,
-        .model = &model_technic_s_angular,
+        .models = model_technic_s_angular,
+        .num_models = PBIO_ARRAY_SIZE(model_technic_s_angular),
         .rated_max_speed = 620,
         .feedback_gain_low = 30,
         .precision_profile = 11,
@@ -272,7 +720,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     },
     {
         .id = PBDRV_LEGODEV_TYPE_ID_TECHNIC_L_ANGULAR_MOTOR,
-        .model = &model_technic_l_angular,
+        .models = model_technic_l_angular,
+        .num_models = PBIO_ARRAY_SIZE(model_technic_l_angular),
         .rated_max_speed = 1000,
         .feedback_gain_low = 45,
         .precision_profile = 11,
@@ -280,7 +729,8 @@ static const pbio_servo_settings_reduced_t servo_settings_reduced[] = {
     },
     {
         .id = PBDRV_LEGODEV_TYPE_ID_TECHNIC_M_ANGULAR_MOTOR,
-        .model = &model_technic_m_angular,
+        .models = model_technic_m_angular,
+        .num_models = PBIO_ARRAY_SIZE(model_technic_m_angular),
         .rated_max_speed = 1000,
         .feedback_gain_low = 45,
         .precision_profile = 11,
@@ -1,9 +1,15 @@
 // SPDX-License-Identifier: MIT
 // Copyright (c) 2018-2023 The Pybricks Authors
 
+#include <string.h>
+
+#include <pbdrv/clock.h>
+
 #include <pbio/battery.h>
 #include <pbio/control.h>
 #include <pbio/drivebase.h>
+#include <pbio/int_math.h>
+#include <pbio/motor_process.h>
 #include <pbio/servo.h>
 
 #include <contiki.h>
@@ -12,6 +18,31 @@
 
 PROCESS(pbio_motor_process, "servo");
 
+static pbio_motor_process_stats_t stats;
+
+// Start of the previous iteration, used for jitter.
+static uint32_t last_start_us;
+
+/**
+ * Adds the duration of one update to its statistics.
+ *
+ * @param [in]  timing      The statistics of this part of the update.
+ * @param [in]  duration    Duration of the update in microseconds.
+ * @param [in]  period      Control loop period in microseconds.
+ */
+static void pbio_motor_process_timing_add(pbio_motor_process_timing_t *timing, uint32_t duration, uint32_t period) {
+    if (stats.count == 0 || duration < timing->min) {
+        timing->min = duration;
+    }
+    if (duration > timing->max) {
+        timing->max = duration;
+    }
+    timing->total += duration;
+
+    uint32_t bin = duration * (PBIO_MOTOR_PROCESS_NUM_BINS - 1) / period;
+    timing->histogram[bin < PBIO_MOTOR_PROCESS_NUM_BINS ? bin : PBIO_MOTOR_PROCESS_NUM_BINS - 1]++;
+}
+
 PROCESS_THREAD(pbio_motor_process, ev, data) {
     static struct etimer timer;
 
@@ -23,19 +54,47 @@ PROCESS_THREAD(pbio_motor_process, ev, data) {
     // Initialize motors in stopped state.
     pbio_dcmotor_stop_all(true);
 
-    etimer_set(&timer, PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+    etimer_set(&timer, pbio_control_settings_get_loop_time());
 
     for (;;) {
         PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER && etimer_expired(&timer));
 
+        uint32_t start_us = pbdrv_clock_get_us();
+        uint32_t loop_time = pbio_control_settings_get_loop_time();
+
         // Update battery voltage.
         pbio_battery_update();
+        uint32_t battery_done_us = pbdrv_clock_get_us();
+
+        // Sample all servos at once, so that all controllers below are
+        // updated from the same instant.
+        uint32_t time_now = pbio_control_get_time_ticks();
+        pbio_servo_sample_all();
+        uint32_t sample_done_us = pbdrv_clock_get_us();
 
         // Update drivebase
-        pbio_drivebase_update_all();
+        pbio_drivebase_update_all(time_now);
+        uint32_t drivebase_done_us = pbdrv_clock_get_us();
 
         // Update servos
-        pbio_servo_update_all();
+        pbio_servo_update_all(time_now);
+        uint32_t servo_done_us = pbdrv_clock_get_us();
+
+        // Keep track of how much of the loop period was used.
+        if (stats.count > 0) {
+            uint32_t jitter = pbio_int_math_abs((int32_t)(start_us - last_start_us) - (int32_t)timer.timer.interval * 1000);
+            stats.jitter_max = pbio_int_math_max(stats.jitter_max, jitter);
+            stats.jitter_total += jitter;
+        }
+        last_start_us = start_us;
+        pbio_motor_process_timing_add(&stats.battery, battery_done_us - start_us, loop_time * 1000);
+        pbio_motor_process_timing_add(&stats.drivebase, drivebase_done_us - sample_done_us, loop_time * 1000);
+        pbio_motor_process_timing_add(&stats.servo, sample_done_us - battery_done_us + servo_done_us - drivebase_done_us, loop_time * 1000);
+        pbio_motor_process_timing_add(&stats.total, servo_done_us - start_us, loop_time * 1000);
+        if (servo_done_us - start_us > loop_time * 1000) {
+            stats.overruns++;
+        }
+        stats.count++;
 
         clock_time_t now = clock_time();
 
@@ -43,14 +102,16 @@ PROCESS_THREAD(pbio_motor_process, ev, data) {
         // poll is a minimum of 1ms in the future. If we don't, the poll loop
         // will not yield until and the next update will be called with a 0 time
         // diff which causes issues.
-        if (now - etimer_start_time(&timer) >= 2 * PBIO_CONFIG_CONTROL_LOOP_TIME_MS) {
-            timer.timer.start = now - (PBIO_CONFIG_CONTROL_LOOP_TIME_MS - 1);
+        if (now - etimer_start_time(&timer) >= 2 * timer.timer.interval) {
+            timer.timer.start = now - (timer.timer.interval - 1);
+            stats.missed++;
         }
 
         // Reset timer to wait for next update. Using etimer_reset() instead
         // of etimer_restart() makes average update period closer to the expected
-        // PBIO_CONFIG_CONTROL_LOOP_TIME_MS when occasional delays occur.
-        etimer_reset(&timer);
+        // loop time when occasional delays occur. A changed loop time takes
+        // effect from here.
+        etimer_reset_with_new_interval(&timer, loop_time);
     }
 
     PROCESS_END();
@@ -60,4 +121,50 @@ void pbio_motor_process_start(void) {
     process_start(&pbio_motor_process);
 }
 
+/**
+ * Sets the control loop time.
+ *
+ * Controller state and trajectories depend on the loop time, so this can only
+ * be changed while no servo or drive base is being controlled. Servos that are
+ * set up switch to the motor model for the new loop time. The new loop time
+ * takes effect from the next control loop iteration.
+ *
+ * @param [in]  ms          Control loop time in milliseconds.
+ * @return                  ::PBIO_SUCCESS on success, ::PBIO_ERROR_BUSY if a
+ *                          servo or drive base is being controlled,
+ *                          ::PBIO_ERROR_INVALID_ARG if this loop time is not
+ *                          available.
+ */
+pbio_error_t pbio_motor_process_set_loop_time(uint32_t ms) {
+    if (pbio_servo_control_is_active_any() || pbio_drivebase_control_is_active_any()) {
+        return PBIO_ERROR_BUSY;
+    }
+    pbio_error_t err = pbio_control_settings_set_loop_time(ms);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    pbio_servo_select_model_all();
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Gets the statistics of the control loop, collected since it started or
+ * since the last reset.
+ *
+ * Averages are obtained by dividing the totals by the number of iterations.
+ * There is one less jitter measurement than there are iterations.
+ *
+ * @return                  The statistics.
+ */
+const pbio_motor_process_stats_t *pbio_motor_process_get_stats(void) {
+    return &stats;
+}
+
+/**
+ * Resets the statistics of the control loop.
+ */
+void pbio_motor_process_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
 #endif // PBIO_CONFIG_MOTOR_PROCESS
@@ -14,6 +14,7 @@
 
 #include <pbio/angle.h>
 #include <pbio/int_math.h>
+#include <pbio/motion_group.h>
 #include <pbio/observer.h>
 #include <pbio/parent.h>
 #include <pbio/servo.h>
@@ -73,14 +74,90 @@ bool pbio_servo_update_loop_is_running(pbio_servo_t *srv) {
     return srv->run_update_loop;
 }
 
-static pbio_error_t pbio_servo_update(pbio_servo_t *srv) {
+/**
+ * Checks if the controller of any servo is active.
+ *
+ * @return                  True if at least one servo is controlled, false if not.
+ */
+bool pbio_servo_control_is_active_any(void) {
+    for (uint8_t i = 0; i < PBIO_CONFIG_SERVO_NUM_DEV; i++) {
+        if (servos[i].run_update_loop && pbio_control_is_active(&servos[i].control)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    // Get current time
-    uint32_t time_now = pbio_control_get_time_ticks();
+/**
+ * Selects the motor model of the servo for the current control loop time.
+ *
+ * @param [in]  srv         The servo instance.
+ * @return                  ::PBIO_SUCCESS on success, ::PBIO_ERROR_NOT_SUPPORTED
+ *                          if there is no model for this loop time.
+ */
+static pbio_error_t pbio_servo_select_model(pbio_servo_t *srv) {
+    const pbio_servo_settings_reduced_t *settings_reduced = srv->settings_reduced;
+    for (uint8_t i = 0; i < settings_reduced->num_models; i++) {
+        if (settings_reduced->models[i].loop_time == pbio_control_settings_get_loop_time()) {
+            srv->observer.model = &settings_reduced->models[i];
+            return PBIO_SUCCESS;
+        }
+    }
+    return PBIO_ERROR_NOT_SUPPORTED;
+}
 
-    // Read the physical and estimated state
+/**
+ * Selects the motor models of all servos that are set up for the current
+ * control loop time.
+ *
+ * This gets called after the loop time changed, while no controller is active.
+ * The models are generated for every available loop time, so this can't fail.
+ */
+void pbio_servo_select_model_all(void) {
+    for (uint8_t i = 0; i < PBIO_CONFIG_SERVO_NUM_DEV; i++) {
+        if (servos[i].settings_reduced) {
+            pbio_servo_select_model(&servos[i]);
+        }
+    }
+}
+
+/**
+ * Samples the state of all servos that have their update loop running.
+ *
+ * All tachos are read back to back before any controller is updated, so the
+ * servos and drive bases are all updated from one coherent snapshot. This
+ * gets called once on every control loop, before updating the controllers.
+ */
+void pbio_servo_sample_all(void) {
+    for (uint8_t i = 0; i < PBIO_CONFIG_SERVO_NUM_DEV; i++) {
+        pbio_servo_t *srv = &servos[i];
+        if (srv->run_update_loop) {
+            srv->state_sampled_err = pbio_servo_get_state_control(srv, &srv->state_sampled);
+        }
+    }
+}
+
+/**
+ * Gets the servo state sampled at the start of the ongoing control loop
+ * iteration, in units of control.
+ *
+ * This is only valid for use by the controllers, after the call to
+ * ::pbio_servo_sample_all in the same iteration.
+ *
+ * @param [in]  srv         The servo instance.
+ * @param [out] state       The system state object in units of control.
+ * @return                  Error code.
+ */
+pbio_error_t pbio_servo_get_state_sampled(pbio_servo_t *srv, pbio_control_state_t *state) {
+    *state = srv->state_sampled;
+    return srv->state_sampled_err;
+}
+
+static pbio_error_t pbio_servo_update(pbio_servo_t *srv, uint32_t time_now) {
+
+    // Get the physical and estimated state sampled for this iteration.
     pbio_control_state_t state;
-    pbio_error_t err = pbio_servo_get_state_control(srv, &state);
+    pbio_error_t err = pbio_servo_get_state_sampled(srv, &state);
     if (err != PBIO_SUCCESS) {
         return err;
     }
@@ -98,7 +175,19 @@ static pbio_error_t pbio_servo_update(pbio_servo_t *srv) {
         // Calculate feedback control signal
         pbio_dcmotor_actuation_t requested_actuation;
         bool external_pause = false;
+        #if PBIO_CONFIG_MOTION_GROUP_NUM_DEV > 0
+        // Servos in a motion group pause together, so they stay synchronized.
+        pbio_motion_group_t *group = pbio_motion_group_get_active(srv);
+        if (group) {
+            external_pause = group->control_paused;
+        }
+        #endif
         pbio_control_update(&srv->control, time_now, &state, &ref, &requested_actuation, &feedback_torque, &external_pause);
+        #if PBIO_CONFIG_MOTION_GROUP_NUM_DEV > 0
+        if (group) {
+            group->control_paused_next |= external_pause;
+        }
+        #endif
 
         // Get required feedforward torque for current reference
         feedforward_torque = pbio_observer_get_feedforward_torque(srv->observer.model, ref.speed, ref.acceleration);
@@ -165,9 +254,12 @@ static pbio_error_t pbio_servo_update(pbio_servo_t *srv) {
 /**
  * Updates the servo state and controller.
  *
- * This gets called once on every control loop.
+ * This gets called once on every control loop, after the state of all servos
+ * was sampled with ::pbio_servo_sample_all.
+ *
+ * @param [in]  time_now    Time at which the states were sampled.
  */
-void pbio_servo_update_all(void) {
+void pbio_servo_update_all(uint32_t time_now) {
     pbio_error_t err;
 
     // Go through all motors.
@@ -176,7 +268,7 @@ void pbio_servo_update_all(void) {
 
         // Run update loop only if registered.
         if (srv->run_update_loop) {
-            err = pbio_servo_update(srv);
+            err = pbio_servo_update(srv, time_now);
             if (err != PBIO_SUCCESS) {
                 // If the update failed, don't update it anymore.
                 pbio_servo_update_loop_set_state(srv, false);
@@ -192,6 +284,11 @@ void pbio_servo_update_all(void) {
             }
         }
     }
+
+    #if PBIO_CONFIG_MOTION_GROUP_NUM_DEV > 0
+    // If any servo in a motion group paused, pause all of them.
+    pbio_motion_group_update_all(time_now);
+    #endif
 }
 
 // This function is attached to a dcmotor object, so it is able to
@@ -255,8 +352,12 @@ static pbio_error_t pbio_servo_initialize_settings(pbio_servo_t *srv, pbdrv_lego
         return PBIO_ERROR_INVALID_ARG;
     }
 
-    // Save reference to motor model.
-    srv->observer.model = settings_reduced->model;
+    // Save reference to motor model for the current loop time.
+    srv->settings_reduced = settings_reduced;
+    pbio_error_t err = pbio_servo_select_model(srv);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
 
     // Initialize maximum torque as the stall torque for maximum voltage.
     // In practice, the nominal voltage is a bit lower than the 9V values.
@@ -279,6 +380,7 @@ static pbio_error_t pbio_servo_initialize_settings(pbio_servo_t *srv, pbdrv_lego
         .position_tolerance = DEG_TO_MDEG(precision_profile),
         .acceleration = DEG_TO_MDEG(2000),
         .deceleration = DEG_TO_MDEG(2000),
+        .trajectory_profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID,
         .actuation_max = pbio_observer_voltage_to_torque(srv->observer.model, max_voltage),
         .actuation_max_temporary = pbio_observer_voltage_to_torque(srv->observer.model, max_voltage),
         // The nominal voltage is an indication for the nominal torque limit. To
@@ -725,7 +827,7 @@ pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, int32_t speed, int32_t tar
     }
 
 
-    return pbio_control_start_position_control(&srv->control, time_now, &state, target, speed, on_completion);
+    return pbio_control_start_position_control(&srv->control, time_now, &state, target, speed, on_completion, true);
 }
 
 /**
@@ -778,6 +880,55 @@ pbio_error_t pbio_servo_run_angle(pbio_servo_t *srv, int32_t speed, int32_t angl
     return pbio_control_start_position_control_relative(&srv->control, time_now, &state, angle, speed, on_completion, true);
 }
 
+#if PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
+/**
+ * Queues a run by a given angle after the maneuvers queued before it.
+ *
+ * If the previous maneuver moves in the same direction, the servo keeps going
+ * at speed between the two instead of stopping. If nothing was queued, this
+ * starts right away like ::pbio_servo_run_angle. Any other command discards
+ * the queue.
+ *
+ * @param [in]  srv             The servo instance.
+ * @param [in]  speed           Top speed in degrees per second.
+ * @param [in]  angle           Angle to run by, relative to the previous target.
+ * @param [in]  on_completion   What to do when reaching the target, unless another maneuver follows.
+ * @return                      Error code.
+ */
+pbio_error_t pbio_servo_queue_angle(pbio_servo_t *srv, int32_t speed, int32_t angle, pbio_control_on_completion_t on_completion) {
+
+    // Don't allow new user command if update loop not registered.
+    if (!pbio_servo_update_loop_is_running(srv)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // Stop parent object that uses this motor, if any.
+    pbio_error_t err = pbio_parent_stop(&srv->parent, false);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Get current time.
+    uint32_t time_now = pbio_control_get_time_ticks();
+
+    // Read the physical and estimated state.
+    pbio_control_state_t state;
+    err = pbio_servo_get_state_control(srv, &state);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // As with pbio_servo_run_angle, zero speed means we're done right away.
+    if (speed == 0) {
+        angle = 0;
+    }
+
+    return pbio_control_queue_position_control_relative(&srv->control, time_now, &state, angle, speed, on_completion);
+}
+
+#endif // PBIO_CONFIG_CONTROL_QUEUE_SIZE
+
 /**
  * Steers the servo to the given target and holds it there.
  *
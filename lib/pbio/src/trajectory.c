@@ -10,6 +10,7 @@
 #include <stdlib.h>
 
 #include <pbio/angle.h>
+#include <pbio/config.h>
 #include <pbio/int_math.h>
 #include <pbio/trajectory.h>
 
@@ -343,6 +344,77 @@ static int32_t mul_a_by_t2(int32_t a, int32_t t) {
     return mul_w_by_t(mul_a_by_t(a, t), t) / 2;
 }
 
+/**
+ * Fixed point representation of 1 for the fraction of an S-curve ramp.
+ */
+#define S_CURVE_ONE (1 << 24)
+
+/**
+ * Gets the fraction of an S-curve ramp that has passed.
+ *
+ * @param [in]  t       The time since the start of the ramp in s*10^-4.
+ * @param [in]  t_ramp  The duration of the ramp in s*10^-4.
+ * @returns             The fraction of the ramp, from 0 to ::S_CURVE_ONE.
+ */
+static int64_t s_curve_fraction(int32_t t, int32_t t_ramp) {
+    if (t_ramp <= 0) {
+        return 0;
+    }
+    return (int64_t)pbio_int_math_bind(t, 0, t_ramp) * S_CURVE_ONE / t_ramp;
+}
+
+/**
+ * Gets the speed along an S-curve ramp.
+ *
+ * The speed follows w_start + (w_end - w_start) * (3x^2 - 2x^3), where x is
+ * the fraction of the ramp. The curve is symmetric around its midpoint, so the
+ * ramp travels the same angle as a linear ramp between the same speeds.
+ *
+ * @param [in]  w_start The speed at the start of the ramp in ddeg/s.
+ * @param [in]  w_end   The speed at the end of the ramp in ddeg/s.
+ * @param [in]  t       The time since the start of the ramp in s*10^-4.
+ * @param [in]  t_ramp  The duration of the ramp in s*10^-4.
+ * @returns             The speed in ddeg/s.
+ */
+static int32_t s_curve_speed(int32_t w_start, int32_t w_end, int32_t t, int32_t t_ramp) {
+    int64_t x = s_curve_fraction(t, t_ramp);
+    int64_t x2 = x * x / S_CURVE_ONE;
+    int64_t s = x2 * (3 * S_CURVE_ONE - 2 * x) / S_CURVE_ONE;
+    return w_start + (int32_t)((w_end - w_start) * s / S_CURVE_ONE);
+}
+
+/**
+ * Gets the angle traveled along an S-curve ramp, which is the integral of
+ * ::s_curve_speed.
+ *
+ * @param [in]  w_start The speed at the start of the ramp in ddeg/s.
+ * @param [in]  w_end   The speed at the end of the ramp in ddeg/s.
+ * @param [in]  t       The time since the start of the ramp in s*10^-4.
+ * @param [in]  t_ramp  The duration of the ramp in s*10^-4.
+ * @returns             The angle in mdeg.
+ */
+static int32_t s_curve_angle(int32_t w_start, int32_t w_end, int32_t t, int32_t t_ramp) {
+    int64_t x = s_curve_fraction(t, t_ramp);
+    int64_t x3 = x * x / S_CURVE_ONE * x / S_CURVE_ONE;
+    int64_t x4 = x3 * x / S_CURVE_ONE;
+    return mul_w_by_t(w_start, t) + (int32_t)(mul_w_by_t(w_end - w_start, t_ramp) * (x3 - x4 / 2) / S_CURVE_ONE);
+}
+
+/**
+ * Gets the acceleration along an S-curve ramp, which is the derivative of
+ * ::s_curve_speed.
+ *
+ * @param [in]  a       The average acceleration of the ramp in deg/s^2.
+ * @param [in]  t       The time since the start of the ramp in s*10^-4.
+ * @param [in]  t_ramp  The duration of the ramp in s*10^-4.
+ * @returns             The acceleration in deg/s^2, which peaks at 3/2 of
+ *                      the average halfway through the ramp.
+ */
+static int32_t s_curve_accel(int32_t a, int32_t t, int32_t t_ramp) {
+    int64_t x = s_curve_fraction(t, t_ramp);
+    return (int32_t)(a * 6 * (x * (S_CURVE_ONE - x) / S_CURVE_ONE) / S_CURVE_ONE);
+}
+
 /**
  * Gets starting speed to reach end speed within given angle and acceleration.
  *
@@ -671,6 +743,110 @@ static pbio_error_t pbio_trajectory_new_forward_angle_command(pbio_trajectory_t
     return PBIO_SUCCESS;
 }
 
+#if PBIO_CONFIG_TRAJECTORY_CACHE_SIZE
+
+/**
+ * Inputs that fully determine a forward trajectory relative to its starting
+ * point, in trajectory units. Commands that differ only in start time or
+ * start position give the same trajectory.
+ */
+typedef struct _pbio_trajectory_cache_key_t {
+    int32_t span;           /**<  Angle to travel (mdeg) for angle commands, duration (ticks) for time commands. */
+    int32_t w0;             /**<  Speed at start of maneuver in ddeg/s */
+    int32_t wt;             /**<  Target speed in ddeg/s */
+    int32_t accel;          /**<  Acceleration magnitude in deg/s^2 */
+    int32_t decel;          /**<  Deceleration magnitude in deg/s^2 */
+    bool angle_command;     /**<  Whether this is an angle command (true) or time command (false) */
+    bool continue_running;  /**<  Whether it movement continues after t3 (true) or not (false) */
+} pbio_trajectory_cache_key_t;
+
+/**
+ * Previously computed forward trajectory.
+ */
+typedef struct _pbio_trajectory_cache_entry_t {
+    pbio_trajectory_cache_key_t key;
+    pbio_trajectory_t trj;
+} pbio_trajectory_cache_entry_t;
+
+static pbio_trajectory_cache_entry_t cache[PBIO_CONFIG_TRAJECTORY_CACHE_SIZE];
+
+// Number of valid entries, and the entry that will be replaced next.
+static uint8_t cache_used;
+static uint8_t cache_next;
+
+static bool pbio_trajectory_cache_key_equals(const pbio_trajectory_cache_key_t *a, const pbio_trajectory_cache_key_t *b) {
+    return a->span == b->span &&
+           a->w0 == b->w0 &&
+           a->wt == b->wt &&
+           a->accel == b->accel &&
+           a->decel == b->decel &&
+           a->angle_command == b->angle_command &&
+           a->continue_running == b->continue_running;
+}
+
+#endif // PBIO_CONFIG_TRAJECTORY_CACHE_SIZE
+
+/**
+ * Forgets all previously computed trajectories.
+ */
+void pbio_trajectory_cache_clear(void) {
+    #if PBIO_CONFIG_TRAJECTORY_CACHE_SIZE
+    cache_used = 0;
+    cache_next = 0;
+    #endif
+}
+
+/**
+ * Computes a forward trajectory, or copies it from the cache if the same
+ * maneuver was computed before.
+ *
+ * @param [out] trj             An uninitialized trajectory to hold the result.
+ * @param [in]  c               The command to use.
+ * @param [in]  angle_command   Whether this is an angle command (true) or time command (false).
+ * @returns                     Same as ::pbio_trajectory_new_forward_angle_command
+ *                              or ::pbio_trajectory_new_forward_time_command.
+ */
+static pbio_error_t pbio_trajectory_new_forward_command(pbio_trajectory_t *trj, const pbio_trajectory_command_t *c, bool angle_command) {
+
+    #if PBIO_CONFIG_TRAJECTORY_CACHE_SIZE
+    pbio_trajectory_cache_key_t key = {
+        .span = angle_command ? pbio_angle_diff_mdeg(&c->position_end, &c->position_start) : TO_TRAJECTORY_TIME(c->duration),
+        .w0 = to_trajectory_speed(c->speed_start),
+        .wt = to_trajectory_speed(c->speed_target),
+        .accel = to_trajectory_accel(c->acceleration),
+        .decel = to_trajectory_accel(c->deceleration),
+        .angle_command = angle_command,
+        .continue_running = c->continue_running,
+    };
+
+    // The solution depends only on the key, so reuse it if we have it.
+    for (uint8_t i = 0; i < cache_used; i++) {
+        if (pbio_trajectory_cache_key_equals(&cache[i].key, &key)) {
+            *trj = cache[i].trj;
+            pbio_trajectory_set_start(&trj->start, c);
+            return PBIO_SUCCESS;
+        }
+    }
+    #endif // PBIO_CONFIG_TRAJECTORY_CACHE_SIZE
+
+    pbio_error_t err = angle_command ?
+        pbio_trajectory_new_forward_angle_command(trj, c) :
+        pbio_trajectory_new_forward_time_command(trj, c);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    #if PBIO_CONFIG_TRAJECTORY_CACHE_SIZE
+    // Store the result, replacing the oldest entry if the cache is full.
+    cache[cache_next].key = key;
+    cache[cache_next].trj = *trj;
+    cache_next = (cache_next + 1) % PBIO_CONFIG_TRAJECTORY_CACHE_SIZE;
+    cache_used = pbio_int_math_min(cache_used + 1, PBIO_CONFIG_TRAJECTORY_CACHE_SIZE);
+    #endif // PBIO_CONFIG_TRAJECTORY_CACHE_SIZE
+
+    return PBIO_SUCCESS;
+}
+
 /**
  * Stretches a trajectory to end at the same time as @p leader.
  *
@@ -746,11 +922,19 @@ pbio_error_t pbio_trajectory_new_time_command(pbio_trajectory_t *trj, const pbio
     // Bind target speed by maximum speed.
     c.speed_target = pbio_int_math_min(c.speed_target, c.speed_max);
 
+    // S-curves peak at 3/2 of the average acceleration of each ramp, so plan
+    // ramps with an average acceleration that makes this peak the given value.
+    if (c.profile == PBIO_TRAJECTORY_PROFILE_S_CURVE) {
+        c.acceleration = c.acceleration * 2 / 3;
+        c.deceleration = c.deceleration * 2 / 3;
+    }
+
     // Calculate the trajectory, assumed to be forward.
-    pbio_error_t err = pbio_trajectory_new_forward_time_command(trj, &c);
+    pbio_error_t err = pbio_trajectory_new_forward_command(trj, &c, false);
     if (err != PBIO_SUCCESS) {
         return err;
     }
+    trj->profile = c.profile;
 
     // Reverse the maneuver if the original arguments imposed backward motion.
     if (backward) {
@@ -809,11 +993,19 @@ pbio_error_t pbio_trajectory_new_angle_command(pbio_trajectory_t *trj, const pbi
         c.speed_start *= -1;
     }
 
+    // S-curves peak at 3/2 of the average acceleration of each ramp, so plan
+    // ramps with an average acceleration that makes this peak the given value.
+    if (c.profile == PBIO_TRAJECTORY_PROFILE_S_CURVE) {
+        c.acceleration = c.acceleration * 2 / 3;
+        c.deceleration = c.deceleration * 2 / 3;
+    }
+
     // Calculate the trajectory, assumed to be forward.
-    pbio_error_t err = pbio_trajectory_new_forward_angle_command(trj, &c);
+    pbio_error_t err = pbio_trajectory_new_forward_command(trj, &c, true);
     if (err != PBIO_SUCCESS) {
         return err;
     }
+    trj->profile = c.profile;
 
     // Reverse the maneuver if the original arguments imposed backward motion.
     if (backward) {
@@ -933,11 +1125,17 @@ void pbio_trajectory_get_reference(pbio_trajectory_t *trj, uint32_t time_ref, pb
 
     if (time - trj->t1 < 0 || (trj->t1 == 0 && time == 0)) {
         // If we are here, then we are still in the acceleration phase.
-        // Includes conversion from microseconds to seconds, in two steps to
-        // avoid overflows and round off errors
-        w = trj->w0 + mul_a_by_t(trj->a0, time);
-        th = mul_w_by_t(trj->w0, time) + mul_a_by_t2(trj->a0, time);
-        a = trj->a0;
+        if (trj->profile == PBIO_TRAJECTORY_PROFILE_S_CURVE) {
+            w = s_curve_speed(trj->w0, trj->w1, time, trj->t1);
+            th = s_curve_angle(trj->w0, trj->w1, time, trj->t1);
+            a = s_curve_accel(trj->a0, time, trj->t1);
+        } else {
+            // Includes conversion from microseconds to seconds, in two steps to
+            // avoid overflows and round off errors
+            w = trj->w0 + mul_a_by_t(trj->a0, time);
+            th = mul_w_by_t(trj->w0, time) + mul_a_by_t2(trj->a0, time);
+            a = trj->a0;
+        }
     } else if (time - trj->t2 < 0) {
         // If we are here, then we are in the constant speed phase
         w = trj->w1;
@@ -945,9 +1143,15 @@ void pbio_trajectory_get_reference(pbio_trajectory_t *trj, uint32_t time_ref, pb
         a = 0;
     } else if (time - trj->t3 < 0) {
         // If we are here, then we are in the deceleration phase
-        w = trj->w1 + mul_a_by_t(trj->a2, time - trj->t2);
-        th = trj->th2 + mul_w_by_t(trj->w1, time - trj->t2) + mul_a_by_t2(trj->a2, time - trj->t2);
-        a = trj->a2;
+        if (trj->profile == PBIO_TRAJECTORY_PROFILE_S_CURVE) {
+            w = s_curve_speed(trj->w1, trj->w3, time - trj->t2, trj->t3 - trj->t2);
+            th = trj->th2 + s_curve_angle(trj->w1, trj->w3, time - trj->t2, trj->t3 - trj->t2);
+            a = s_curve_accel(trj->a2, time - trj->t2, trj->t3 - trj->t2);
+        } else {
+            w = trj->w1 + mul_a_by_t(trj->a2, time - trj->t2);
+            th = trj->th2 + mul_w_by_t(trj->w1, time - trj->t2) + mul_a_by_t2(trj->a2, time - trj->t2);
+            a = trj->a2;
+        }
     } else {
         // If we are here, we are in the constant speed phase after the
         // maneuver completes
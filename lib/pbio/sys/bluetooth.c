@@ -8,6 +8,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <contiki-lib.h>
 #include <contiki.h>
@@ -27,6 +28,7 @@
 
 // REVISIT: this needs to be moved to a common place where it can be shared with USB
 static pbsys_bluetooth_stdin_event_callback_t stdin_event_callback;
+static pbsys_bluetooth_stdout_done_callback_t stdout_done_callback;
 static lwrb_t stdout_ring_buf;
 static lwrb_t stdin_ring_buf;
 
@@ -38,6 +40,7 @@ typedef struct {
 } send_msg_t;
 
 static send_msg_t stdout_msg;
+static send_msg_t app_data_msg;
 LIST(send_queue);
 static bool send_busy;
 
@@ -180,6 +183,59 @@ pbio_error_t pbsys_bluetooth_tx(const uint8_t *data, uint32_t *size) {
     return PBIO_SUCCESS;
 }
 
+/**
+ * Gets the largest data which can be sent by ::pbsys_bluetooth_tx_app_data.
+ * @return              The size in bytes.
+ */
+uint32_t pbsys_bluetooth_tx_app_data_get_max_size(void) {
+    return PBIO_ARRAY_SIZE(app_data_msg.payload) - 1;
+}
+
+/**
+ * Queues data to be transmitted in one application data event.
+ * @param data  [in]        The data to be sent.
+ * @param size  [in]        The size of @p data in bytes.
+ * @return                  ::PBIO_SUCCESS if @p data was queued, ::PBIO_ERROR_AGAIN
+ *                          if previous data was not sent yet, ::PBIO_ERROR_INVALID_ARG
+ *                          if @p size is too big, ::PBIO_ERROR_INVALID_OP if there
+ *                          is not an active Bluetooth connection or
+ *                          ::PBIO_ERROR_NOT_SUPPORTED if this platform does not
+ *                          support Bluetooth.
+ */
+pbio_error_t pbsys_bluetooth_tx_app_data(const uint8_t *data, uint32_t size) {
+    if (!pbdrv_bluetooth_is_connected(PBDRV_BLUETOOTH_CONNECTION_PYBRICKS)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    if (size > pbsys_bluetooth_tx_app_data_get_max_size()) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    if (app_data_msg.is_queued) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    app_data_msg.payload[0] = PBIO_PYBRICKS_EVENT_WRITE_APP_DATA;
+    memcpy(&app_data_msg.payload[1], data, size);
+    app_data_msg.context.size = size + 1;
+    app_data_msg.context.connection = PBDRV_BLUETOOTH_CONNECTION_PYBRICKS;
+    list_add(send_queue, &app_data_msg);
+    app_data_msg.is_queued = true;
+
+    process_poll(&pbsys_bluetooth_process);
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Sets the function called each time stdout data was sent. It can be used
+ * to write more data without polling ::pbsys_bluetooth_tx.
+ * @param callback  [in]    The callback or NULL.
+ */
+void pbsys_bluetooth_tx_set_callback(pbsys_bluetooth_stdout_done_callback_t callback) {
+    stdout_done_callback = callback;
+}
+
 /**
  * Tests if the Tx queue is empty and all data has been sent over the air.
  *
@@ -227,6 +283,10 @@ static void send_done(void) {
 
     send_busy = false;
     process_poll(&pbsys_bluetooth_process);
+
+    if (msg == &stdout_msg && stdout_done_callback) {
+        stdout_done_callback();
+    }
 }
 
 // drain all buffers and queues and reset global state
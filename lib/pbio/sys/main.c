@@ -66,7 +66,7 @@ int main(int argc, char **argv) {
         */
 
         if (pbdrv_bluetooth_is_connected(PBDRV_BLUETOOTH_CONNECTION_PYBRICKS)) {
-            start_automata();
+            start_automata(&program);
         }
 
         pbio_do_one_event();
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+// Bluetooth driver of automata tests. It replaces the BTStack driver, so
+// that tests can read what automata send without a Bluetooth stack. Each
+// message is sent 1 ms after pbsys queued it, like one connection event.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pbdrv/bluetooth.h>
+#include <pbio/protocol.h>
+
+#include "test-automata.h"
+
+static bool connected;
+static pbdrv_bluetooth_on_event_t bluetooth_on_event;
+static pbdrv_bluetooth_send_context_t *send_context;
+
+/**
+ * Received data of one kind of event.
+ */
+typedef struct {
+    uint8_t data[AUTOMATA_TEST_BLUETOOTH_SIZE];
+    uint32_t size;
+    uint32_t messages;
+} received_t;
+
+static received_t stdout_data;
+static received_t app_data;
+
+void pbdrv_bluetooth_init(void) {
+}
+
+void pbdrv_bluetooth_power_on(bool on) {
+}
+
+bool pbdrv_bluetooth_is_ready(void) {
+    return true;
+}
+
+void pbdrv_bluetooth_start_advertising(void) {
+}
+
+void pbdrv_bluetooth_stop_advertising(void) {
+}
+
+bool pbdrv_bluetooth_is_connected(pbdrv_bluetooth_connection_t connection) {
+    return connected && (connection == PBDRV_BLUETOOTH_CONNECTION_LE || connection == PBDRV_BLUETOOTH_CONNECTION_PYBRICKS);
+}
+
+void pbdrv_bluetooth_set_on_event(pbdrv_bluetooth_on_event_t on_event) {
+    bluetooth_on_event = on_event;
+}
+
+void pbdrv_bluetooth_set_receive_handler(pbdrv_bluetooth_receive_handler_t handler) {
+}
+
+void pbdrv_bluetooth_send(pbdrv_bluetooth_send_context_t *context) {
+    send_context = context;
+}
+
+void automata_test_bluetooth_connect(void) {
+    connected = true;
+    if (bluetooth_on_event) {
+        bluetooth_on_event();
+    }
+}
+
+void automata_test_bluetooth_send_pending(void) {
+    if (!send_context) {
+        return;
+    }
+    pbdrv_bluetooth_send_context_t *context = send_context;
+    send_context = NULL;
+
+    received_t *received = context->data[0] == PBIO_PYBRICKS_EVENT_WRITE_STDOUT ? &stdout_data :
+        (context->data[0] == PBIO_PYBRICKS_EVENT_WRITE_APP_DATA ? &app_data : NULL);
+    if (received) {
+        uint32_t size = context->size - 1;
+        if (size > sizeof(received->data) - received->size) {
+            size = sizeof(received->data) - received->size;
+        }
+        memcpy(&received->data[received->size], &context->data[1], size);
+        received->size += size;
+        received->messages++;
+    }
+    context->done();
+}
+
+uint32_t automata_test_bluetooth_read(uint8_t event, const uint8_t **data, uint32_t *messages) {
+    received_t *received = event == PBIO_PYBRICKS_EVENT_WRITE_STDOUT ? &stdout_data : &app_data;
+    *data = received->data;
+    if (messages) {
+        *messages = received->messages;
+    }
+    return received->size;
+}
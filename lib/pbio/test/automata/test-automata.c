@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+// Unit tests of automata. They use the platform of the automata simulator,
+// so that motors are on all ports and any automaton can set up its drive base.
+
+#include <stdint.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <contiki.h>
+
+#include <pbio/main.h>
+#include <pbio/motor_process.h>
+#include <pbsys/bluetooth.h>
+
+#include "../../drv/core.h"
+#include "../../drv/clock/clock_test.h"
+#include "../../drv/motor_driver/motor_driver_virtual_simulation.h"
+#include "../../sys/light_matrix.h"
+#include "../../../../automata/automata.h"
+
+#include "test-automata.h"
+
+// Normally set by the automata process, which is not tested here.
+int debug_mode = 0;
+
+// Print functions store their errors here.
+static pbio_error_t print_err;
+
+static int32_t inputs[AUTOMATA_NUM_INPUTS];
+
+static pbio_error_t test_input_source(uint8_t input, int32_t *value) {
+    *value = inputs[input];
+    return PBIO_SUCCESS;
+}
+
+void automata_test_set_input(uint8_t input, int32_t value) {
+    inputs[input] = value;
+}
+
+void automata_test_tick(automata_engine_t *engine) {
+    automata_snapshot_begin();
+    automata_engine_tick(engine);
+}
+
+void automata_test_sleep_ms(uint32_t duration) {
+    for (uint32_t i = 0; i < duration; i++) {
+        pbio_test_clock_tick(1);
+        automata_test_bluetooth_send_pending();
+        while (pbio_do_one_event()) {
+        }
+    }
+}
+
+static void *setup(const struct testcase_t *test_case) {
+    pbio_init();
+    pbsys_hub_light_matrix_init();
+    pbsys_bluetooth_init();
+
+    // Start motor driver simulation process and wait until it is ready.
+    pbdrv_motor_driver_init_manual();
+    while (pbdrv_init_busy()) {
+        pbio_do_one_event();
+    }
+    pbio_motor_process_start();
+
+    parameters[0] = &print_err;
+    automata_engine_set_input_source(test_input_source);
+    return test_case->setup_data;
+}
+
+static int cleanup(const struct testcase_t *test_case, void *env) {
+    return 1;
+}
+
+struct testcase_setup_t automata_test_setup = {
+    .setup_fn = setup,
+    .cleanup_fn = cleanup,
+};
+
+extern struct testcase_t automata_bytecode_tests[];
+extern struct testcase_t automata_compiled_tests[];
+extern struct testcase_t automata_engine_tests[];
+extern struct testcase_t automata_print_tests[];
+extern struct testcase_t automata_scheduler_tests[];
+extern struct testcase_t automata_telemetry_tests[];
+extern struct testcase_t automata_trace_tests[];
+
+static struct testgroup_t test_groups[] = {
+    { "automata/bytecode/", automata_bytecode_tests },
+    { "automata/compiled/", automata_compiled_tests },
+    { "automata/engine/", automata_engine_tests },
+    { "automata/print/", automata_print_tests },
+    { "automata/scheduler/", automata_scheduler_tests },
+    { "automata/telemetry/", automata_telemetry_tests },
+    { "automata/trace/", automata_trace_tests },
+    END_OF_GROUPS
+};
+
+int main(int argc, const char **argv) {
+    return tinytest_main(argc, argv, test_groups);
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#ifndef _TEST_AUTOMATA_H_
+#define _TEST_AUTOMATA_H_
+
+#include <stdint.h>
+
+#include <tinytest.h>
+
+#include "../../../../automata/engine.h"
+
+// Use this macro to define tests of automata. Each test starts from a fresh
+// hub on the simulator platform, with motors on all ports and sensor inputs
+// set by automata_test_set_input().
+#define AUTOMATA_TEST(name) \
+    { #name, name, TT_FORK, &automata_test_setup, NULL }
+
+extern struct testcase_setup_t automata_test_setup;
+
+/**
+ * Sets value which the engine reads for input instead of a sensor.
+ */
+void automata_test_set_input(uint8_t input, int32_t value);
+
+/**
+ * Ticks engine with new snapshot of inputs, like the scheduler does.
+ */
+void automata_test_tick(automata_engine_t *engine);
+
+/**
+ * Advances simulated time and runs all processes which became ready,
+ * including the motor control loop.
+ */
+void automata_test_sleep_ms(uint32_t duration);
+
+/**
+ * Data of each kind of event received by the fake Bluetooth driver [bytes].
+ */
+#define AUTOMATA_TEST_BLUETOOTH_SIZE (8192)
+
+/**
+ * Connects the fake Bluetooth driver. The hub is connected after the
+ * pbsys Bluetooth process starts advertising, see automata_test_sleep_ms().
+ */
+void automata_test_bluetooth_connect(void);
+
+/**
+ * Completes the message which is being sent, if any. Called every 1 ms
+ * by automata_test_sleep_ms().
+ */
+void automata_test_bluetooth_send_pending(void);
+
+/**
+ * Gets all data received since the hub connected for event
+ * PBIO_PYBRICKS_EVENT_WRITE_STDOUT or PBIO_PYBRICKS_EVENT_WRITE_APP_DATA,
+ * without the event byte of each message.
+ *
+ * @param [in]  event       Kind of event.
+ * @param [out] data        Received data.
+ * @param [out] messages    Number of messages, may be NULL.
+ * @return                  Size of @p data.
+ */
+uint32_t automata_test_bluetooth_read(uint8_t event, const uint8_t **data, uint32_t *messages);
+
+#endif // _TEST_AUTOMATA_H_
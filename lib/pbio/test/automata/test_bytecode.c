@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <string.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/util.h>
+
+#include "../../../../automata/automata.h"
+
+#include "test-automata.h"
+
+// Two states. Object closer than 100 mm switches to state 1 and sets a
+// pixel, object further away switches back to state 0 and clears matrix.
+static const uint8_t test_bytecode[] = {
+    // Header.
+    'A', 'U', 'T', 'B', AUTOMATA_BYTECODE_VERSION,
+    2, 2, 2, 2,
+    0, 3, AUTOMATA_DEVICE_ULTRASONIC,
+    20, 0, AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_DISTANCE), 0,
+    0, 0, 0, 0, PBIO_PORT_ID_C, 0,
+    0, 1, 0, 0,
+    0, 0,
+    // States.
+    0, 1,
+    1, 1,
+    // Transitions.
+    0, 1, 1, 1, 1,
+    1, 1, 0, 1, 0,
+    // Guards.
+    AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_LT, 100, 0,
+    AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_GE, 100, 0,
+    // Actions.
+    AUTOMATA_ACTION_MATRIX_CLEAR, 0, 0, 0, 0, 0, 0,
+    AUTOMATA_ACTION_MATRIX_SET_PIXEL, 1, 0, 2, 0, 100, 0,
+    // CRC, set by load_test_bytecode().
+    0, 0, 0, 0,
+};
+
+#define TEST_HEADER_SIZE (AUTOMATA_BYTECODE_HEADER_SIZE)
+#define TEST_TRANSITIONS (TEST_HEADER_SIZE + 2 * 2)
+#define TEST_GUARDS (TEST_TRANSITIONS + 2 * 5)
+#define TEST_ACTIONS (TEST_GUARDS + 2 * 4)
+
+static uint8_t data[sizeof(test_bytecode)];
+
+static uint32_t test_crc32(const uint8_t *buf, uint32_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= buf[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+// Loads data with valid CRC, so that only the tested change is wrong.
+static pbio_error_t load_data(uint32_t size, const automata_table_t **table) {
+    pbio_set_uint32_le(&data[size - 4], test_crc32(data, size - 4));
+    return automata_bytecode_load(data, size, table);
+}
+
+static void test_bytecode_load(void *env) {
+    const automata_table_t *table;
+    memcpy(data, test_bytecode, sizeof(data));
+    tt_int_op(load_data(sizeof(data), &table), ==, PBIO_SUCCESS);
+
+    tt_want_int_op(table->num_states, ==, 2);
+    tt_want_int_op(table->priority, ==, 3);
+    tt_want_int_op(table->period, ==, 20);
+    tt_want_int_op(table->devices, ==, AUTOMATA_DEVICE_ULTRASONIC);
+    tt_want_int_op(table->ports.ultrasonic, ==, PBIO_PORT_ID_C);
+    tt_want_int_op(table->start.first, ==, 0);
+    tt_want_int_op(table->start.count, ==, 1);
+    tt_want_int_op(table->transitions[1].target, ==, 0);
+    tt_want_int_op(table->guards[0].op, ==, AUTOMATA_OP_LT);
+    tt_want_int_op(table->guards[0].value, ==, 100);
+    tt_want_int_op(table->actions[1].code, ==, AUTOMATA_ACTION_MATRIX_SET_PIXEL);
+    tt_want_int_op(table->actions[1].args[2], ==, 100);
+end:
+    return;
+}
+
+static void test_bytecode_run(void *env) {
+    static automata_engine_t engine;
+    const automata_table_t *table;
+    memcpy(data, test_bytecode, sizeof(data));
+    tt_int_op(load_data(sizeof(data), &table), ==, PBIO_SUCCESS);
+
+    automata_test_set_input(AUTOMATA_INPUT_DISTANCE, 500);
+    tt_assert(automata_engine_start(&engine, table));
+    automata_test_tick(&engine);
+    tt_want_int_op(engine.state, ==, 0);
+
+    // Interpreted transitions follow the input both ways.
+    automata_test_set_input(AUTOMATA_INPUT_DISTANCE, 50);
+    automata_test_tick(&engine);
+    tt_want_int_op(engine.state, ==, 1);
+    automata_test_set_input(AUTOMATA_INPUT_DISTANCE, 150);
+    automata_test_tick(&engine);
+    tt_want_int_op(engine.state, ==, 0);
+    tt_want_int_op(engine.ctx.err, ==, PBIO_SUCCESS);
+
+    automata_engine_stop(&engine);
+end:
+    return;
+}
+
+static void test_bytecode_reject(void *env) {
+    const automata_table_t *table;
+
+    // Damaged data.
+    memcpy(data, test_bytecode, sizeof(data));
+    pbio_set_uint32_le(&data[sizeof(data) - 4], test_crc32(data, sizeof(data) - 4) ^ 1);
+    tt_want_int_op(automata_bytecode_load(data, sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Not an automaton.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[0] = 'M';
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Other version.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[4] = AUTOMATA_BYTECODE_VERSION + 1;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_NOT_SUPPORTED);
+
+    // Size does not match number of records.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[8] = 1;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Initial state out of range.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[9] = 2;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Input without its sensor.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[11] = 0;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Transition to state out of range.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[TEST_TRANSITIONS + 4] = 2;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Guard with unknown operator.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[TEST_GUARDS + 1] = AUTOMATA_OP_CHANGED + 1;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Drive base action without drive base.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[TEST_ACTIONS] = AUTOMATA_ACTION_BASE_STOP;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Unknown action.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[TEST_ACTIONS] = AUTOMATA_NUM_ACTIONS;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+
+    // Start actions out of range.
+    memcpy(data, test_bytecode, sizeof(data));
+    data[23] = 3;
+    tt_want_int_op(load_data(sizeof(data), &table), ==, PBIO_ERROR_INVALID_ARG);
+}
+
+struct testcase_t automata_bytecode_tests[] = {
+    AUTOMATA_TEST(test_bytecode_load),
+    AUTOMATA_TEST(test_bytecode_run),
+    AUTOMATA_TEST(test_bytecode_reject),
+    END_OF_TESTCASES
+};
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <string.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/drivebase.h>
+#include <pbio/util.h>
+
+#include "../../src/light/light_matrix.h"
+#include "../../../../automata/automata.h"
+
+#include "test-automata.h"
+
+// Distances which cross every threshold of follow in both directions.
+static const int32_t distances[] = {
+    500, 320, 200, 145, 130, 145, 160, 250, 305, 320, 2000, 299, 100, 151, 400, 290,
+};
+
+/**
+ * What the automaton did after one input: state and direction of the
+ * drive base, -1 backward, 0 stopped, 1 forward.
+ */
+typedef struct {
+    const char *state;
+    int8_t direction;
+} step_result_t;
+
+static void run_table(const automata_table_t *table, step_result_t *results) {
+    static automata_engine_t engine;
+    tt_assert(automata_engine_start(&engine, table));
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(distances); i++) {
+        automata_test_set_input(AUTOMATA_INPUT_DISTANCE, distances[i]);
+        automata_test_tick(&engine);
+        automata_test_sleep_ms(300);
+
+        int32_t distance, drive_speed, angle, turn_rate;
+        pbio_drivebase_get_state_user(engine.base, &distance, &drive_speed, &angle, &turn_rate);
+        results[i].state = table->states[engine.state].name;
+        results[i].direction = drive_speed > 50 ? 1 : (drive_speed < -50 ? -1 : 0);
+    }
+    tt_want_int_op(engine.ctx.err, ==, PBIO_SUCCESS);
+
+    automata_engine_stop(&engine);
+    automata_test_sleep_ms(1000);
+end:
+    return;
+}
+
+// Compiled description of follow must behave like the hand written table.
+static void test_compiled_follow(void *env) {
+    step_result_t expected[PBIO_ARRAY_SIZE(distances)];
+    step_result_t compiled[PBIO_ARRAY_SIZE(distances)];
+
+    run_table(&automata_follow_table, expected);
+    run_table(&automata_follow_compiled_table, compiled);
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(distances); i++) {
+        tt_want_str_op(compiled[i].state, ==, expected[i].state);
+        tt_want_int_op(compiled[i].direction, ==, expected[i].direction);
+    }
+
+    // Follow moves away from close objects and toward far ones.
+    tt_want_str_op(expected[4].state, ==, "back");
+    tt_want_int_op(expected[4].direction, ==, 1);
+    tt_want_str_op(expected[10].state, ==, "forward");
+    tt_want_int_op(expected[10].direction, ==, -1);
+}
+
+// Tilts as angle x, angle y [deg] which cross every threshold of tilt.
+static const int16_t tilts[][2] = {
+    {0, 0}, {0, 40}, {0, 30}, {0, 20}, {0, -40}, {10, -10}, {40, 0},
+    {30, 30}, {20, 20}, {-40, 0}, {-30, 0}, {0, 0}, {-40, 40}, {0, 0},
+};
+
+// Hub light matrix as set by the automaton, brightness of each pixel.
+static uint8_t pixels[5][5];
+
+static pbio_error_t record_pixel(pbio_light_matrix_t *light_matrix, uint8_t row, uint8_t col, uint8_t brightness) {
+    pixels[row][col] = brightness;
+    return PBIO_SUCCESS;
+}
+
+static const pbio_light_matrix_funcs_t record_funcs = {
+    .set_pixel = record_pixel,
+};
+
+/**
+ * What the automaton did after one tilt: state and image on the matrix.
+ */
+typedef struct {
+    const char *state;
+    uint8_t pixels[5][5];
+} tilt_result_t;
+
+static void run_tilt(const automata_table_t *table, tilt_result_t *results) {
+    static automata_engine_t engine;
+    pbsys_hub_light_matrix->funcs = &record_funcs;
+    memset(pixels, 0xFF, sizeof(pixels));
+    tt_assert(automata_engine_start(&engine, table));
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(tilts); i++) {
+        automata_test_set_input(AUTOMATA_INPUT_ANGLE_X, tilts[i][0]);
+        automata_test_set_input(AUTOMATA_INPUT_ANGLE_Y, tilts[i][1]);
+        automata_test_tick(&engine);
+        automata_test_sleep_ms(20);
+
+        results[i].state = table->states[engine.state].name;
+        memcpy(results[i].pixels, pixels, sizeof(pixels));
+    }
+    tt_want_int_op(engine.ctx.err, ==, PBIO_SUCCESS);
+
+    automata_engine_stop(&engine);
+end:
+    return;
+}
+
+// Compiled description of tilt must behave like the hand written table,
+// also in what it shows on the light matrix.
+static void test_compiled_tilt(void *env) {
+    tilt_result_t expected[PBIO_ARRAY_SIZE(tilts)];
+    tilt_result_t compiled[PBIO_ARRAY_SIZE(tilts)];
+
+    run_tilt(&automata_tilt_table, expected);
+    run_tilt(&automata_tilt_compiled_table, compiled);
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(tilts); i++) {
+        tt_want_str_op(compiled[i].state, ==, expected[i].state);
+        tt_want(memcmp(compiled[i].pixels, expected[i].pixels, sizeof(pixels)) == 0);
+    }
+
+    // The start actions light the middle pixel, tilting lights a side.
+    tt_want_str_op(expected[0].state, ==, "middle");
+    tt_want_int_op(expected[0].pixels[2][2], ==, 100);
+    tt_want_int_op(expected[0].pixels[0][2], ==, 0);
+    tt_want_str_op(expected[1].state, ==, "right");
+    tt_want_int_op(expected[1].pixels[2][2], ==, 0);
+    tt_want_int_op(expected[1].pixels[0][2], ==, 100);
+}
+
+struct testcase_t automata_compiled_tests[] = {
+    AUTOMATA_TEST(test_compiled_follow),
+    AUTOMATA_TEST(test_compiled_tilt),
+    END_OF_TESTCASES
+};
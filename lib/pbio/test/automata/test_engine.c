@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/drivebase.h>
+#include <pbio/util.h>
+
+#include "../../../../automata/automata.h"
+
+#include "test-automata.h"
+
+static void test_engine_no_light_matrix(void *env) {
+    automata_ctx_t ctx = AUTOMATA_CTX_INIT;
+
+    // Hubs without light matrix have no matrix to pass.
+    tt_want_int_op(automata_matrix_clear(&ctx, NULL), ==, PBIO_ERROR_NOT_SUPPORTED);
+    tt_want_int_op(ctx.err, ==, PBIO_ERROR_NOT_SUPPORTED);
+    tt_want_int_op(automata_matrix_set_pixel(&ctx, NULL, 0, 0, 100), ==, PBIO_ERROR_NOT_SUPPORTED);
+}
+
+/**
+ * nested states:<br>
+ * 0 => idle<br>
+ * 1 => first (in group)<br>
+ * 2 => second (in group)<br>
+ * 3 => group
+ */
+enum {
+    NESTED_IDLE,
+    NESTED_FIRST,
+    NESTED_SECOND,
+    NESTED_GROUP,
+};
+
+static const automata_guard_t nested_guards[] = {
+    /* 0 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_EQ, 1},
+    /* 1 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_GE, 2},
+    /* 2 */ {AUTOMATA_INPUT_DISTANCE, AUTOMATA_OP_EQ, 3},
+};
+
+static const automata_action_t nested_actions[] = {
+    /* 0 */ {AUTOMATA_ACTION_BASE_STOP, {0}},
+    /* 1 */ {AUTOMATA_ACTION_BASE_RUN_FOREVER, {100, 0}},
+    /* 2 */ {AUTOMATA_ACTION_BASE_RUN_FOREVER, {-100, 0}},
+};
+
+static const automata_transition_t nested_transitions[] = {
+    // idle
+    {.guards = {0, 1}, .actions = {0, 0}, .target = NESTED_GROUP},
+    // first, also true when transition of group is taken instead
+    {.guards = {1, 1}, .actions = {0, 0}, .target = NESTED_SECOND},
+    // group
+    {.guards = {2, 1}, .actions = {0, 0}, .target = NESTED_IDLE},
+};
+
+static const automata_state_t nested_states[] = {
+    [NESTED_IDLE] = {"idle", {0, 1}},
+    // Entered after its parent, so the drive base runs backward.
+    [NESTED_FIRST] = {"first", {1, 1}, .entry = {2, 1}},
+    [NESTED_SECOND] = {"second", {0, 0}},
+    [NESTED_GROUP] = {"group", {2, 1}, .entry = {1, 1}, .exit = {0, 1}},
+};
+
+static const uint8_t nested_parents[] = {
+    [NESTED_IDLE] = AUTOMATA_NO_STATE,
+    [NESTED_FIRST] = NESTED_GROUP,
+    [NESTED_SECOND] = NESTED_GROUP,
+    [NESTED_GROUP] = AUTOMATA_NO_STATE,
+};
+
+static const automata_table_t nested_table = {
+    .name = "nested",
+    .states = nested_states,
+    .transitions = nested_transitions,
+    .guards = nested_guards,
+    .actions = nested_actions,
+    .parents = nested_parents,
+    .num_states = PBIO_ARRAY_SIZE(nested_states),
+    .initial_state = NESTED_IDLE,
+    .inputs = AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_DISTANCE),
+    .devices = AUTOMATA_DEVICE_BASE,
+    .ports = {
+        .left_motor = PBIO_PORT_ID_A,
+        .left_direction = PBIO_DIRECTION_CLOCKWISE,
+        .right_motor = PBIO_PORT_ID_B,
+        .right_direction = PBIO_DIRECTION_COUNTERCLOCKWISE,
+    },
+};
+
+/**
+ * Tick with distance and return drive speed of the base once it settled.
+ */
+static int32_t nested_step(automata_engine_t *engine, int32_t distance) {
+    automata_test_set_input(AUTOMATA_INPUT_DISTANCE, distance);
+    automata_test_tick(engine);
+    automata_test_sleep_ms(300);
+
+    int32_t drive_distance, drive_speed, angle, turn_rate;
+    pbio_drivebase_get_state_user(engine->base, &drive_distance, &drive_speed, &angle, &turn_rate);
+    return drive_speed;
+}
+
+static void test_engine_nested(void *env) {
+    static automata_engine_t engine;
+    tt_assert(automata_engine_start(&engine, &nested_table));
+    tt_want_int_op(engine.state, ==, NESTED_IDLE);
+
+    // Transition to parent enters it and then its first child.
+    tt_want_int_op(nested_step(&engine, 1), <, -50);
+    tt_want_int_op(engine.state, ==, NESTED_FIRST);
+
+    // Transition between children does not leave the parent.
+    tt_want_int_op(nested_step(&engine, 2), <, -50);
+    tt_want_int_op(engine.state, ==, NESTED_SECOND);
+
+    // Transition of parent is taken from any child and leaves the parent.
+    tt_want_int_op(nested_step(&engine, 3), ==, 0);
+    tt_want_int_op(engine.state, ==, NESTED_IDLE);
+
+    // Transition of parent is checked before transitions of the child.
+    nested_step(&engine, 1);
+    tt_want_int_op(engine.state, ==, NESTED_FIRST);
+    tt_want_int_op(nested_step(&engine, 3), ==, 0);
+    tt_want_int_op(engine.state, ==, NESTED_IDLE);
+
+    tt_want_int_op(engine.ctx.err, ==, PBIO_SUCCESS);
+    automata_engine_stop(&engine);
+end:
+    return;
+}
+
+static void test_engine_invalid_parents(void *env) {
+    static automata_engine_t engine;
+    static const automata_state_t states[AUTOMATA_MAX_DEPTH + 1] = {0};
+    static const uint8_t too_deep[] = {AUTOMATA_NO_STATE, 0, 1, 2, 3};
+    static const uint8_t cycle[] = {AUTOMATA_NO_STATE, 2, 1, 2, 3};
+    static const uint8_t unknown[] = {AUTOMATA_NO_STATE, 0, 9, 1, 1};
+    static const uint8_t *const parents[] = {too_deep, cycle, unknown};
+    _Static_assert(PBIO_ARRAY_SIZE(too_deep) == PBIO_ARRAY_SIZE(states), "one parent per state");
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(parents); i++) {
+        automata_table_t table = {
+            .name = "invalid",
+            .states = states,
+            .parents = parents[i],
+            .num_states = PBIO_ARRAY_SIZE(states),
+        };
+        tt_want(!automata_engine_start(&engine, &table));
+        tt_want_int_op(engine.ctx.err, ==, PBIO_ERROR_INVALID_ARG);
+    }
+
+    // The deepest allowed nesting starts.
+    automata_table_t table = {
+        .name = "deepest",
+        .states = states,
+        .parents = too_deep,
+        .num_states = AUTOMATA_MAX_DEPTH,
+        .initial_state = AUTOMATA_MAX_DEPTH - 1,
+    };
+    tt_want(automata_engine_start(&engine, &table));
+    tt_want_int_op(engine.state, ==, AUTOMATA_MAX_DEPTH - 1);
+}
+
+struct testcase_t automata_engine_tests[] = {
+    AUTOMATA_TEST(test_engine_nested),
+    AUTOMATA_TEST(test_engine_invalid_parents),
+    AUTOMATA_TEST(test_engine_no_light_matrix),
+    END_OF_TESTCASES
+};
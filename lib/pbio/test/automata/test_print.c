@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <string.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/protocol.h>
+
+#include "../../../../automata/automata.h"
+
+#include "test-automata.h"
+
+// Time for pbsys Bluetooth process to reset the chip and advertise [ms].
+#define CONNECT_TIME (200)
+
+static uint32_t read_stdout(const uint8_t **data) {
+    return automata_test_bluetooth_read(PBIO_PYBRICKS_EVENT_WRITE_STDOUT, data, NULL);
+}
+
+static void test_print_format(void *env) {
+    automata_test_bluetooth_connect();
+    automata_test_sleep_ms(CONNECT_TIME);
+
+    tt_want_int_op(automata_print("%d|%5u|%03x|%ld|%c|%s|%%\r\n", -12, 34u, 0xau, -5l, 'a', "text"), ==, PBIO_SUCCESS);
+    tt_want_int_op(automata_print("%f|%.1f|%.0f|%f|%f\r\n", 1.5, -0.25, 2.6, 1e10, 0.0f / 0.0f), ==, PBIO_SUCCESS);
+    automata_test_sleep_ms(10);
+
+    const char *expected =
+        "-12|   34|00a|-5|a|text|%\r\n"
+        "1.500|-0.3|3|1.000e10|nan\r\n";
+    const uint8_t *data;
+    uint32_t size = read_stdout(&data);
+    tt_want_int_op(size, ==, strlen(expected));
+    tt_want(memcmp(data, expected, size) == 0);
+}
+
+static void test_print_ring(void *env) {
+    static char line[AUTOMATA_PRINT_LINE_SIZE];
+    automata_test_bluetooth_connect();
+    automata_test_sleep_ms(CONNECT_TIME);
+
+    // Lines of 100 bytes, which Bluetooth can not send right away.
+    memset(line, 'x', 97);
+    line[97] = '\0';
+    uint32_t printed = 0;
+    while (automata_print_get_dropped() == 0) {
+        tt_want_int_op(automata_print("%c%s\r\n", '0' + printed % 10, line), ==, PBIO_SUCCESS);
+        printed++;
+    }
+    tt_want_int_op(automata_print_get_free(), <, 100);
+    tt_want_uint_op(printed, >, AUTOMATA_PRINT_BUFFER_SIZE / 100);
+
+    // Buffered lines are sent each time Bluetooth sent previous data.
+    automata_test_sleep_ms(100);
+    tt_want_int_op(automata_print_get_free(), ==, AUTOMATA_PRINT_BUFFER_SIZE);
+
+    // Lines are never split, so only the whole last line was dropped.
+    const uint8_t *data;
+    uint32_t size = read_stdout(&data);
+    tt_want_int_op(size, ==, (printed - 1) * 100);
+    for (uint32_t i = 0; i + 1 < printed; i++) {
+        tt_want_int_op(data[i * 100], ==, '0' + i % 10);
+        tt_want_int_op(data[i * 100 + 99], ==, '\n');
+    }
+}
+
+static void test_print_stop(void *env) {
+    static char line[AUTOMATA_PRINT_LINE_SIZE];
+    automata_test_bluetooth_connect();
+    automata_test_sleep_ms(CONNECT_TIME);
+
+    memset(line, 'x', 97);
+    line[97] = '\0';
+    for (uint8_t i = 0; i < 4; i++) {
+        automata_print("%c%s\r\n", '0' + i, line);
+    }
+    tt_want_int_op(automata_print_get_free(), <, AUTOMATA_PRINT_BUFFER_SIZE);
+
+    // Data which Bluetooth did not take yet is dropped and Bluetooth no
+    // longer takes more data from automata.
+    automata_print_stop();
+    tt_want_int_op(automata_print_get_free(), ==, AUTOMATA_PRINT_BUFFER_SIZE);
+    const uint8_t *data;
+    uint32_t size = read_stdout(&data);
+    automata_test_sleep_ms(100);
+    tt_want_int_op(read_stdout(&data), <, 4 * 100);
+    tt_want_int_op(read_stdout(&data), >=, size);
+}
+
+struct testcase_t automata_print_tests[] = {
+    AUTOMATA_TEST(test_print_format),
+    AUTOMATA_TEST(test_print_ring),
+    AUTOMATA_TEST(test_print_stop),
+    END_OF_TESTCASES
+};
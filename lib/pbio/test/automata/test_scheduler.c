@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbdrv/legodev.h>
+
+#include "../../../../automata/automata.h"
+
+#include "test-automata.h"
+
+static void test_scheduler_ports_in_use(void *env) {
+    automata_instance_t *follow;
+    automata_instance_t *tilt;
+
+    tt_want_int_op(automata_scheduler_start(&automata_follow_table, &follow), ==, PBIO_SUCCESS);
+
+    // Same automaton and automata on the same drive base can not start.
+    tt_want_int_op(automata_scheduler_start(&automata_follow_table, NULL), ==, PBIO_ERROR_BUSY);
+    tt_want_int_op(automata_scheduler_start(&automata_discover_table, NULL), ==, PBIO_ERROR_BUSY);
+    tt_want_int_op(automata_scheduler_start(&automata_follow_compiled_table, NULL), ==, PBIO_ERROR_BUSY);
+
+    // Tilt uses only the hub, so it runs next to follow.
+    tt_want_int_op(automata_scheduler_start(&automata_tilt_table, &tilt), ==, PBIO_SUCCESS);
+    tt_want(follow->active);
+    tt_want(tilt->active);
+
+    // Ports are free again when follow stops.
+    automata_scheduler_stop(follow);
+    tt_want_int_op(automata_scheduler_start(&automata_discover_table, NULL), ==, PBIO_SUCCESS);
+
+    automata_scheduler_stop_all();
+    tt_want(!automata_scheduler_is_running());
+}
+
+static void test_scheduler_wake(void *env) {
+    automata_instance_t *follow;
+    automata_instance_t *tilt;
+    pbdrv_legodev_dev_t *sensor;
+
+    tt_want_int_op(automata_scheduler_start(&automata_follow_table, &follow), ==, PBIO_SUCCESS);
+    tt_want_int_op(automata_scheduler_start(&automata_tilt_table, &tilt), ==, PBIO_SUCCESS);
+
+    // Sensors are replaced by test inputs, so give follow a device in place
+    // of its ultrasonic sensor.
+    pbdrv_legodev_type_id_t id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
+    tt_want_int_op(pbdrv_legodev_get_device(PBIO_PORT_ID_E, &id, &sensor), ==, PBIO_SUCCESS);
+    follow->engine.ultrasonic = sensor;
+
+    uint32_t now = pbdrv_clock_get_ms();
+    automata_scheduler_run(now);
+    tt_want_int_op(follow->next_tick, ==, now + automata_follow_table.period);
+    tt_want_int_op(tilt->next_tick, ==, now + automata_tilt_table.period);
+
+    // Only the automaton which reads the sensor is woken by its data.
+    automata_scheduler_wake(now + 1, sensor);
+    tt_want_int_op(follow->next_tick, ==, now + 1);
+    tt_want_int_op(tilt->next_tick, ==, now + automata_tilt_table.period);
+
+    // Events of no device or of other devices wake none.
+    automata_scheduler_wake(now + 2, NULL);
+    tt_want_int_op(follow->next_tick, ==, now + 1);
+    tt_want_int_op(tilt->next_tick, ==, now + automata_tilt_table.period);
+
+    automata_scheduler_stop_all();
+}
+
+struct testcase_t automata_scheduler_tests[] = {
+    AUTOMATA_TEST(test_scheduler_ports_in_use),
+    AUTOMATA_TEST(test_scheduler_wake),
+    END_OF_TESTCASES
+};
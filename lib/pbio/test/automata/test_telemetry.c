@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbio/protocol.h>
+#include <pbio/util.h>
+
+#include "../../../../automata/automata.h"
+
+#include "test-automata.h"
+
+// Time for pbsys Bluetooth process to reset the chip and advertise [ms].
+#define CONNECT_TIME (200)
+
+/**
+ * Frames split from all received application data events.
+ */
+typedef struct {
+    uint8_t type;
+    uint32_t time;
+    uint8_t instance;
+    uint16_t dropped;
+} received_frame_t;
+
+static uint32_t read_frames(received_frame_t *frames, uint32_t max_frames, uint32_t *events) {
+    const uint8_t *data;
+    uint32_t size = automata_test_bluetooth_read(PBIO_PYBRICKS_EVENT_WRITE_APP_DATA, &data, events);
+    uint32_t count = 0;
+    uint32_t time = 0;
+
+    // Messages are stored back to back, but frames are never split between
+    // them, so the data can be split by frame sizes alone.
+    for (uint32_t offset = 0; offset < size && count < max_frames; count++) {
+        const uint8_t *frame = &data[offset];
+        received_frame_t *received = &frames[count];
+        received->type = frame[0];
+        if (frame[0] == AUTOMATA_TELEMETRY_FRAME_SYNC) {
+            time = pbio_get_uint32_le(&frame[1]);
+            received->dropped = pbio_get_uint16_le(&frame[5]);
+        } else {
+            time += pbio_get_uint16_le(&frame[1]);
+            received->instance = frame[3];
+        }
+        received->time = time;
+        offset += automata_telemetry_get_frame_size(frame);
+    }
+    return count;
+}
+
+/**
+ * Sends queued frames like the automata process does, until all are sent.
+ */
+static void send_queued(void) {
+    do {
+        automata_test_sleep_ms(AUTOMATA_TELEMETRY_FLUSH_WAIT_MS);
+    } while (automata_telemetry_flush());
+    automata_test_sleep_ms(AUTOMATA_TELEMETRY_FLUSH_WAIT_MS);
+}
+
+// Ticks of instances in the same millisecond must all be sent, also the
+// first frame after the sync frame.
+static void test_telemetry_instances(void *env) {
+    static const automata_table_t table = {
+        .inputs = AUTOMATA_INPUT_MASK(AUTOMATA_INPUT_DISTANCE),
+    };
+    static automata_engine_t engines[2];
+    received_frame_t frames[16];
+    uint32_t events;
+
+    automata_test_bluetooth_connect();
+    automata_test_sleep_ms(CONNECT_TIME);
+    automata_telemetry_enable(true);
+
+    for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(engines); i++) {
+        engines[i].table = &table;
+        engines[i].state = i;
+    }
+    for (uint8_t tick = 0; tick < 3; tick++) {
+        for (uint8_t i = 0; i < PBIO_ARRAY_SIZE(engines); i++) {
+            automata_telemetry_tick(i, &engines[i]);
+        }
+        send_queued();
+    }
+
+    tt_want_uint_op(read_frames(frames, PBIO_ARRAY_SIZE(frames), &events), ==, 7);
+    tt_want_uint_op(events, <, 7);
+    tt_want_int_op(frames[0].type, ==, AUTOMATA_TELEMETRY_FRAME_SYNC);
+    tt_want_int_op(frames[0].dropped, ==, 0);
+    for (uint8_t i = 1; i < 7; i++) {
+        tt_want_int_op(frames[i].type, ==, AUTOMATA_TELEMETRY_FRAME_TICK);
+        tt_want_int_op(frames[i].instance, ==, (i - 1) % 2);
+    }
+    for (uint8_t i = 1; i < 7; i += 2) {
+        // Instances ticked at the same time, ticks are a few ms apart.
+        tt_want_uint_op(frames[i + 1].time, ==, frames[i].time);
+        tt_want_uint_op(frames[i].time, >=, frames[0].time + (i - 1) / 2 * AUTOMATA_TELEMETRY_FLUSH_WAIT_MS);
+    }
+    tt_want_uint_op(automata_telemetry_get_dropped(), ==, 0);
+}
+
+// Frames which do not fit into the queue are counted in the next sync frame.
+static void test_telemetry_overflow(void *env) {
+    static received_frame_t frames[AUTOMATA_TELEMETRY_BUFFER_SIZE];
+    uint32_t events;
+
+    automata_test_bluetooth_connect();
+    automata_test_sleep_ms(CONNECT_TIME);
+    automata_telemetry_enable(true);
+
+    // Bluetooth sends nothing until the clock advances.
+    uint32_t queued = 0;
+    while (automata_telemetry_get_dropped() < 5) {
+        automata_telemetry_float(queued++, 1.0f);
+    }
+    send_queued();
+    automata_telemetry_float(0, 2.0f);
+    send_queued();
+
+    uint32_t count = read_frames(frames, PBIO_ARRAY_SIZE(frames), &events);
+    tt_want_uint_op(count, ==, 1 + (queued - 5) + 2);
+    tt_want_int_op(frames[count - 2].type, ==, AUTOMATA_TELEMETRY_FRAME_SYNC);
+    tt_want_int_op(frames[count - 2].dropped, ==, 5);
+    tt_want_int_op(frames[count - 1].type, ==, AUTOMATA_TELEMETRY_FRAME_FLOAT);
+    tt_want_uint_op(frames[count - 1].time, ==, frames[count - 2].time);
+}
+
+// Nothing is queued while the hub is not connected.
+static void test_telemetry_disconnected(void *env) {
+    automata_telemetry_enable(true);
+    automata_telemetry_float(0, 1.0f);
+    tt_want_uint_op(automata_telemetry_flush(), ==, false);
+    tt_want_uint_op(automata_telemetry_get_dropped(), ==, 1);
+}
+
+struct testcase_t automata_telemetry_tests[] = {
+    AUTOMATA_TEST(test_telemetry_instances),
+    AUTOMATA_TEST(test_telemetry_overflow),
+    AUTOMATA_TEST(test_telemetry_disconnected),
+    END_OF_TESTCASES
+};
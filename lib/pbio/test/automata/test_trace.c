@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbdrv/clock.h>
+#include <pbio/protocol.h>
+#include <pbio/util.h>
+
+#include "../../../../automata/automata.h"
+
+#include "test-automata.h"
+
+// Time for pbsys Bluetooth process to reset the chip and advertise [ms].
+#define CONNECT_TIME (200)
+
+/**
+ * Records transition of follow with distance as its only input, so each
+ * printed entry ends with @p distance.
+ */
+static void record(automata_engine_t *engine, int32_t distance) {
+    engine->values[AUTOMATA_INPUT_DISTANCE] = distance;
+    automata_trace_record(engine, 0, 0);
+}
+
+/**
+ * Prints the rest of the dump like the automata process does and waits
+ * until Bluetooth sent it.
+ */
+static void finish_dump(void) {
+    while (automata_trace_dump_continue()) {
+        automata_test_sleep_ms(AUTOMATA_TRACE_DUMP_WAIT_MS);
+    }
+    automata_test_sleep_ms(100);
+}
+
+/**
+ * Gets header and last value of each printed trace entry.
+ *
+ * @param [out] header      Number of transitions in header of last dump.
+ * @param [out] values      Last value of each entry, in order of printing.
+ * @param [in]  size        Size of @p values.
+ * @return                  Number of printed entries.
+ */
+static uint32_t read_entries(uint32_t *header, int32_t *values, uint32_t size) {
+    static char text[AUTOMATA_TEST_BLUETOOTH_SIZE + 1];
+    const uint8_t *data;
+    uint32_t length = automata_test_bluetooth_read(PBIO_PYBRICKS_EVENT_WRITE_STDOUT, &data, NULL);
+    memcpy(text, data, length);
+    text[length] = '\0';
+
+    uint32_t entries = 0;
+    for (char *line = strtok(text, "\r\n"); line; line = strtok(NULL, "\r\n")) {
+        if (strncmp(line, "Trace of ", 9) == 0) {
+            *header = strtoul(line + 9, NULL, 10);
+        } else if (strstr(line, "->") && entries < size) {
+            values[entries++] = strtol(strrchr(line, ' ') + 1, NULL, 10);
+        }
+    }
+    return entries;
+}
+
+static void test_trace_wrap(void *env) {
+    static automata_engine_t engine = { .table = &automata_follow_table };
+    static int32_t values[2 * AUTOMATA_TRACE_SIZE];
+    automata_test_bluetooth_connect();
+    automata_test_sleep_ms(CONNECT_TIME);
+
+    // Three more than fit, so the three oldest are overwritten.
+    for (int32_t i = 0; i < AUTOMATA_TRACE_SIZE + 3; i++) {
+        record(&engine, i);
+    }
+    automata_trace_dump_start();
+    finish_dump();
+
+    // Remaining entries are printed oldest first.
+    uint32_t header = 0;
+    tt_want_int_op(read_entries(&header, values, PBIO_ARRAY_SIZE(values)), ==, AUTOMATA_TRACE_SIZE);
+    tt_want_int_op(header, ==, AUTOMATA_TRACE_SIZE);
+    for (int32_t i = 0; i < AUTOMATA_TRACE_SIZE; i++) {
+        tt_want_int_op(values[i], ==, i + 3);
+    }
+}
+
+static void test_trace_partial_dump(void *env) {
+    static automata_engine_t engine = { .table = &automata_follow_table };
+    static int32_t values[2 * AUTOMATA_TRACE_SIZE];
+    automata_test_bluetooth_connect();
+    automata_test_sleep_ms(CONNECT_TIME);
+
+    for (int32_t i = 0; i < AUTOMATA_TRACE_SIZE; i++) {
+        record(&engine, i);
+    }
+
+    // Whole trace does not fit into print buffer at once.
+    automata_trace_dump_start();
+    tt_want(automata_trace_dump_continue());
+    automata_test_sleep_ms(100);
+    uint32_t header = 0;
+    uint32_t printed = read_entries(&header, values, PBIO_ARRAY_SIZE(values));
+    tt_want_int_op(printed, >, 0);
+    tt_want_int_op(printed, <, AUTOMATA_TRACE_SIZE / 2);
+
+    // New transitions overwrite the oldest entries which were not printed
+    // yet and also some which were printed already.
+    uint32_t overwritten = printed + 20;
+    for (uint32_t i = 0; i < overwritten; i++) {
+        record(&engine, 1000 + i);
+    }
+    finish_dump();
+
+    // Overwritten entries are skipped and the dump ends where it started.
+    uint32_t total = read_entries(&header, values, PBIO_ARRAY_SIZE(values));
+    tt_want_int_op(header, ==, AUTOMATA_TRACE_SIZE);
+    tt_want_int_op(total, ==, printed + AUTOMATA_TRACE_SIZE - overwritten);
+    for (uint32_t i = 0; i < total; i++) {
+        tt_want_int_op(values[i], ==, i < printed ? i : i - printed + overwritten);
+    }
+}
+
+static void test_trace_error_dump(void *env) {
+    static int32_t values[2 * AUTOMATA_TRACE_SIZE];
+    automata_instance_t *follow;
+    automata_test_bluetooth_connect();
+    automata_test_sleep_ms(CONNECT_TIME);
+
+    tt_want_int_op(automata_scheduler_start(&automata_follow_table, &follow), ==, PBIO_SUCCESS);
+    record(&follow->engine, 777);
+    record(&follow->engine, 778);
+
+    // Instance ending with error dumps the transitions which led to it,
+    // including any taken by its last tick.
+    follow->engine.ctx.err = PBIO_ERROR_FAILED;
+    automata_scheduler_run(follow->next_tick);
+    tt_want(!automata_scheduler_is_running());
+    finish_dump();
+
+    uint32_t header = 0;
+    uint32_t total = read_entries(&header, values, PBIO_ARRAY_SIZE(values));
+    tt_want_int_op(header, ==, total);
+    tt_want_int_op(total, >=, 2);
+    tt_want_int_op(values[0], ==, 777);
+    tt_want_int_op(values[1], ==, 778);
+}
+
+struct testcase_t automata_trace_tests[] = {
+    AUTOMATA_TEST(test_trace_wrap),
+    AUTOMATA_TEST(test_trace_partial_dump),
+    AUTOMATA_TEST(test_trace_error_dump),
+    END_OF_TESTCASES
+};
@@ -0,0 +1,339 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+// Host simulator of automata. Runs each scenario against the virtual motor
+// model with scripted sensor inputs, as fast as the host allows, and reports
+// transitions, time to goal and control loop statistics. Runs recorded on
+// the hub are replayed tick by tick and their states are compared.
+//
+// Usage: automata-sim <scenario>...
+//
+// Each scenario runs in its own process, so it starts from a fresh hub.
+// Exit status is nonzero if any automaton failed, missed its goal or
+// diverged from its recording.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <contiki.h>
+
+#include <pbio/drivebase.h>
+#include <pbio/main.h>
+#include <pbio/motor_process.h>
+
+#include "../../drv/core.h"
+#include "../../drv/clock/clock_test.h"
+#include "../../drv/motor_driver/motor_driver_virtual_simulation.h"
+#include "../../sys/light_matrix.h"
+#include "../../../../automata/automata.h"
+
+#include "replay.h"
+#include "scenario.h"
+
+// Normally set by the automata process, which is not simulated.
+int debug_mode = 0;
+
+// Print functions store their errors here. Nothing is printed without
+// Bluetooth connection, so they are ignored.
+static pbio_error_t print_err;
+
+/**
+ * Host time spent in one kind of work.
+ */
+typedef struct {
+    uint32_t count;
+    uint64_t total;
+    uint32_t max;
+} sim_timing_t;
+
+/**
+ * Progress and results of one run.
+ */
+typedef struct {
+    const sim_scenario_t *scenario;
+    /** Host time of automaton ticks. */
+    sim_timing_t ticks;
+    /** Host time of simulated 1 ms steps, which run the motor control loop. */
+    sim_timing_t control;
+    uint8_t state;
+    uint32_t transitions;
+    /** Simulated time when goal was reached, UINT32_MAX if not reached. */
+    uint32_t goal_time;
+} sim_run_t;
+
+static const sim_scenario_t *scenario;
+
+/**
+ * Recorded tick which is replayed now, NULL if inputs come from keyframes.
+ */
+static const sim_replay_tick_t *replay_tick;
+
+/**
+ * Drive base of the simulated automaton.
+ */
+static pbio_drivebase_t *base;
+
+static pbio_error_t sim_input_source(uint8_t input, int32_t *value) {
+    if (replay_tick) {
+        return sim_replay_get_value(replay_tick, input, value);
+    }
+    if (input == AUTOMATA_INPUT_BASE_DONE) {
+        *value = automata_base_is_done(base);
+        return PBIO_SUCCESS;
+    }
+    return sim_scenario_get_value(scenario, input, pbdrv_clock_get_ms(), value);
+}
+
+static uint64_t host_time_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void sim_timing_add(sim_timing_t *timing, uint64_t start) {
+    uint32_t duration = host_time_ns() - start;
+    timing->count++;
+    timing->total += duration;
+    if (duration > timing->max) {
+        timing->max = duration;
+    }
+}
+
+static void print_timing(const char *name, const sim_timing_t *timing) {
+    printf("  %-18s %8u runs, avg %6.2f us, max %8.2f us\n", name, timing->count,
+        timing->count ? timing->total / 1000.0 / timing->count : 0.0, timing->max / 1000.0);
+}
+
+static const char *state_name(const automata_table_t *table, uint8_t state) {
+    static char index[4];
+    if (table->states[state].name) {
+        return table->states[state].name;
+    }
+    snprintf(index, sizeof(index), "%u", state);
+    return index;
+}
+
+/**
+ * Advances simulated time by 1 ms and runs all processes which became ready,
+ * which includes the motor control loop.
+ */
+static void sim_clock_tick(sim_run_t *run) {
+    pbio_test_clock_tick(1);
+    uint64_t start = host_time_ns();
+    while (pbio_do_one_event()) {
+    }
+    sim_timing_add(&run->control, start);
+}
+
+/**
+ * Prints transition if state of engine changed after its tick.
+ */
+static void sim_check_state(sim_run_t *run, const automata_engine_t *engine) {
+    if (engine->state == run->state) {
+        return;
+    }
+    uint32_t now = pbdrv_clock_get_ms();
+    const automata_table_t *table = engine->table;
+    printf("  %6u ms  %s -> ", now, state_name(table, run->state));
+    printf("%s\n", state_name(table, engine->state));
+    run->state = engine->state;
+    run->transitions++;
+    if (run->state == run->scenario->goal && run->goal_time == UINT32_MAX) {
+        run->goal_time = now;
+    }
+}
+
+static void sim_init(void) {
+    pbio_init();
+    pbsys_hub_light_matrix_init();
+
+    // Start motor driver simulation process and wait until it is ready.
+    pbdrv_motor_driver_init_manual();
+    while (pbdrv_init_busy()) {
+        pbio_do_one_event();
+    }
+    pbio_motor_process_start();
+
+    parameters[0] = &print_err;
+    automata_engine_set_input_source(sim_input_source);
+}
+
+/**
+ * Runs automaton by scheduler with inputs from keyframes.
+ *
+ * @return                  Error which ended the automaton.
+ */
+static pbio_error_t sim_run_keyframes(sim_run_t *run) {
+    automata_instance_t *instance;
+    pbio_error_t err = automata_scheduler_start(run->scenario->table, &instance);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    base = instance->engine.base;
+    run->state = instance->engine.state;
+
+    uint32_t next_run = pbdrv_clock_get_ms();
+    while (pbdrv_clock_get_ms() < run->scenario->duration && instance->active) {
+        uint32_t now = pbdrv_clock_get_ms();
+        if ((int32_t)(now - next_run) >= 0) {
+            uint64_t start = host_time_ns();
+            uint32_t wait = automata_scheduler_run(now);
+            sim_timing_add(&run->ticks, start);
+            next_run = now + (wait == UINT32_MAX ? 1 : wait);
+            sim_check_state(run, &instance->engine);
+        }
+        sim_clock_tick(run);
+    }
+
+    err = instance->active ? PBIO_SUCCESS : automata_scheduler_get_last_error();
+    printf("  automaton ticks: %u, overruns: %u\n", instance->stats.ticks, instance->stats.overruns);
+    automata_scheduler_stop_all();
+    return err;
+}
+
+/**
+ * Ticks automaton at recorded times with recorded inputs.
+ *
+ * @param [out] diverged    Number of ticks after which state differs from recording.
+ * @return                  Error which ended the automaton.
+ */
+static pbio_error_t sim_run_replay(sim_run_t *run, uint32_t *diverged) {
+    static automata_engine_t engine;
+    const automata_table_t *table = run->scenario->table;
+    const sim_replay_t *replay = &run->scenario->replay;
+
+    if (!automata_engine_start(&engine, table)) {
+        return engine.ctx.err;
+    }
+    base = engine.base;
+    run->state = engine.state;
+
+    // First recorded tick is replayed at time 0.
+    uint32_t offset = replay->ticks[0].time;
+    *diverged = 0;
+    uint32_t skipped = 0;
+
+    for (uint32_t i = 0; i < replay->num_ticks && !automata_engine_should_end(&engine); i++) {
+        const sim_replay_tick_t *tick = &replay->ticks[i];
+        if (tick->inputs != table->inputs) {
+            printf("  recorded inputs do not match %s\n", table->name);
+            engine.ctx.err = PBIO_ERROR_INVALID_ARG;
+            break;
+        }
+        while (pbdrv_clock_get_ms() < tick->time - offset) {
+            sim_clock_tick(run);
+        }
+
+        replay_tick = tick;
+        uint64_t start = host_time_ns();
+        automata_snapshot_begin();
+        automata_engine_tick(&engine);
+        sim_timing_add(&run->ticks, start);
+        replay_tick = NULL;
+
+        if (tick->after_gap) {
+            // Ticks before this one may be missing from the recording, so
+            // continue from the recorded state instead of comparing with it.
+            engine.state = tick->state;
+            engine.moved = true;
+            skipped++;
+        }
+
+        sim_check_state(run, &engine);
+        if (engine.state != tick->state && ++*diverged <= 10) {
+            printf("  %6u ms  diverged, recorded %s", pbdrv_clock_get_ms(), state_name(table, tick->state));
+            printf(", replayed %s\n", state_name(table, engine.state));
+        }
+    }
+
+    pbio_error_t err = engine.ctx.err;
+    automata_engine_stop(&engine);
+    printf("  replayed ticks: %u, diverged: %u, gaps skipped: %u\n", run->ticks.count, *diverged, skipped);
+    return err;
+}
+
+/**
+ * Runs one scenario.
+ *
+ * @return                  0 if the automaton reached the goal without error.
+ */
+static int sim_run(const sim_scenario_t *run_scenario) {
+    scenario = run_scenario;
+    sim_init();
+
+    const automata_table_t *table = scenario->table;
+    printf("%s: %s\n", scenario->path, table->name);
+
+    sim_run_t run = {
+        .scenario = scenario,
+        .goal_time = UINT32_MAX,
+    };
+    uint32_t diverged = 0;
+    uint64_t start = host_time_ns();
+    pbio_error_t err = scenario->replay.num_ticks ?
+        sim_run_replay(&run, &diverged) :
+        sim_run_keyframes(&run);
+    double wall = (host_time_ns() - start) / 1e9;
+    uint32_t simulated = pbdrv_clock_get_ms();
+
+    if (base) {
+        int32_t distance, drive_speed, angle, turn_rate;
+        pbio_drivebase_get_state_user(base, &distance, &drive_speed, &angle, &turn_rate);
+        printf("  drive base: distance %d mm, angle %d deg\n", distance, angle);
+    }
+    printf("  transitions: %u\n", run.transitions);
+    if (scenario->goal != AUTOMATA_NO_STATE) {
+        if (run.goal_time == UINT32_MAX) {
+            printf("  goal %s: not reached\n", state_name(table, scenario->goal));
+        } else {
+            printf("  goal %s: reached in %u ms\n", state_name(table, scenario->goal), run.goal_time);
+        }
+    }
+    print_timing("automaton tick", &run.ticks);
+    print_timing("control loop 1 ms", &run.control);
+    printf("  simulated %u ms in %.3f s (%.0fx real time)\n", simulated, wall, wall > 0 ? simulated / 1000.0 / wall : 0.0);
+
+    if (err != PBIO_SUCCESS) {
+        printf("  ended with error %d\n", err);
+        return 1;
+    }
+    if (scenario->replay.num_gaps) {
+        // Skipped ticks are not checked, so the run proves nothing.
+        printf("  recording has %u gaps of dropped frames, not a baseline\n", scenario->replay.num_gaps);
+        return 1;
+    }
+    return diverged || (scenario->goal != AUTOMATA_NO_STATE && run.goal_time == UINT32_MAX);
+}
+
+int main(int argc, const char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <scenario>...\n", argv[0]);
+        return 2;
+    }
+
+    int failed = 0;
+    for (int i = 1; i < argc; i++) {
+        static sim_scenario_t run;
+        if (sim_scenario_load(&run, argv[i]) != PBIO_SUCCESS) {
+            failed++;
+            continue;
+        }
+
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            exit(sim_run(&run));
+        }
+        int status;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+            printf("%s: FAILED\n", argv[i]);
+            failed++;
+        }
+    }
+
+    printf("%d of %d scenarios passed\n", argc - 1 - failed, argc - 1);
+    return failed ? 1 : 0;
+}
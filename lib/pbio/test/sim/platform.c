@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+// Platform of the automata simulator. Motors are on all ports, so that any
+// automaton can set up its drive base. Sensors are simulated by scenarios.
+
+#include "../../drv/legodev/legodev_test.h"
+#include "../../drv/motor_driver/motor_driver_virtual_simulation.h"
+
+#include <pbdrv/legodev.h>
+
+#define SIM_LEGODEV(port, index) { \
+        .port_id = (port), \
+        .motor_driver_index = (index), \
+        .quadrature_index = (index), \
+        .type_id = PBDRV_LEGODEV_TYPE_ID_SPIKE_M_MOTOR, \
+}
+
+const pbdrv_legodev_test_platform_data_t pbdrv_legodev_test_platform_data[PBDRV_CONFIG_LEGODEV_TEST_NUM_DEV] = {
+    SIM_LEGODEV(PBIO_PORT_ID_A, 0),
+    SIM_LEGODEV(PBIO_PORT_ID_B, 1),
+    SIM_LEGODEV(PBIO_PORT_ID_C, 2),
+    SIM_LEGODEV(PBIO_PORT_ID_D, 3),
+    SIM_LEGODEV(PBIO_PORT_ID_E, 4),
+    SIM_LEGODEV(PBIO_PORT_ID_F, 5),
+};
+
+#define SIM_MOTOR(port) { \
+        .port_id = (port), \
+        .type_id = PBDRV_LEGODEV_TYPE_ID_SPIKE_M_MOTOR, \
+        .initial_angle = 0, \
+        .initial_speed = 0, \
+        .endstop_angle_negative = -PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP, \
+        .endstop_angle_positive = PBDRV_MOTOR_DRIVER_VIRTUAL_SIMULATION_NO_ENDSTOP, \
+}
+
+const pbdrv_motor_driver_virtual_simulation_platform_data_t
+    pbdrv_motor_driver_virtual_simulation_platform_data[PBDRV_CONFIG_MOTOR_DRIVER_NUM_DEV] = {
+    SIM_MOTOR(PBIO_PORT_ID_A),
+    SIM_MOTOR(PBIO_PORT_ID_B),
+    SIM_MOTOR(PBIO_PORT_ID_C),
+    SIM_MOTOR(PBIO_PORT_ID_D),
+    SIM_MOTOR(PBIO_PORT_ID_E),
+    SIM_MOTOR(PBIO_PORT_ID_F),
+};
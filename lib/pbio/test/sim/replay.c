@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pbio/util.h>
+
+#include "../../../../automata/automata.h"
+
+#include "replay.h"
+
+/**
+ * Decodes hex line into data of one event.
+ * <br><br> Returns size of data, 0 if line is not valid.
+ */
+static uint32_t decode_hex(const char *line, uint8_t *data, uint32_t max_size) {
+    uint32_t size = 0;
+    unsigned int byte;
+    while (size < max_size && sscanf(line, "%2x", &byte) == 1) {
+        data[size++] = byte;
+        line += 2;
+    }
+    return size;
+}
+
+static bool add_tick(sim_replay_t *replay, const sim_replay_tick_t *tick) {
+    if ((replay->num_ticks & (replay->num_ticks - 1)) == 0) {
+        // Capacity is doubled when it is full.
+        uint32_t capacity = replay->num_ticks ? replay->num_ticks * 2 : 64;
+        sim_replay_tick_t *ticks = realloc(replay->ticks, capacity * sizeof(*ticks));
+        if (!ticks) {
+            return false;
+        }
+        replay->ticks = ticks;
+    }
+    replay->ticks[replay->num_ticks++] = *tick;
+    return true;
+}
+
+/**
+ * State kept between frames, like on the hub.
+ */
+typedef struct {
+    /** Scheduler slot of the recorded automaton. */
+    uint8_t instance;
+    /** Time of the last frame [ms], valid after the first sync frame. */
+    uint32_t time;
+    bool synced;
+    /** Frames were dropped since the last tick of the instance. */
+    bool gap;
+} decoder_t;
+
+/**
+ * Decodes one frame.
+ * <br><br> Returns false if frame is not valid.
+ */
+static bool decode_frame(sim_replay_t *replay, const uint8_t *frame, decoder_t *decoder) {
+    if (frame[0] == AUTOMATA_TELEMETRY_FRAME_SYNC) {
+        decoder->time = pbio_get_uint32_le(&frame[1]);
+        decoder->synced = true;
+        if (pbio_get_uint16_le(&frame[5])) {
+            decoder->gap = true;
+            replay->num_gaps++;
+        }
+        return true;
+    }
+    if (frame[0] != AUTOMATA_TELEMETRY_FRAME_TICK && frame[0] != AUTOMATA_TELEMETRY_FRAME_FLOAT) {
+        return false;
+    }
+    if (!decoder->synced) {
+        // Frames before the first sync have no time.
+        return true;
+    }
+    decoder->time += pbio_get_uint16_le(&frame[1]);
+
+    if (frame[0] != AUTOMATA_TELEMETRY_FRAME_TICK || frame[3] != decoder->instance) {
+        return true;
+    }
+
+    sim_replay_tick_t tick = {
+        .time = decoder->time,
+        .state = frame[4],
+        .inputs = frame[5],
+        .after_gap = decoder->gap,
+    };
+    decoder->gap = false;
+    uint32_t offset = 6;
+    for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+        if (tick.inputs & AUTOMATA_INPUT_MASK(i)) {
+            tick.values[i] = pbio_get_uint16_le(&frame[offset]);
+            offset += 2;
+        }
+    }
+    return add_tick(replay, &tick);
+}
+
+/**
+ * Splits data of one event into frames and decodes them.
+ * <br><br> Returns false if data is not valid.
+ */
+static bool decode_event(sim_replay_t *replay, const uint8_t *data, uint32_t size, decoder_t *decoder) {
+    uint32_t offset = 0;
+    while (offset < size) {
+        if (size - offset < AUTOMATA_TELEMETRY_MIN_FRAME_SIZE) {
+            return false;
+        }
+        uint32_t frame_size = automata_telemetry_get_frame_size(&data[offset]);
+        if (offset + frame_size > size || !decode_frame(replay, &data[offset], decoder)) {
+            return false;
+        }
+        offset += frame_size;
+    }
+    return true;
+}
+
+pbio_error_t sim_replay_load(sim_replay_t *replay, const char *path, uint8_t instance) {
+    memset(replay, 0, sizeof(*replay));
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "%s: can not open file\n", path);
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    char line[256];
+    uint8_t data[64];
+    decoder_t decoder = {
+        .instance = instance,
+    };
+    int number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        uint32_t size = decode_hex(line, data, sizeof(data));
+        if (size == 0) {
+            continue;
+        }
+        if (!decode_event(replay, data, size, &decoder)) {
+            fprintf(stderr, "%s:%d: invalid event\n", path, number);
+            fclose(file);
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+    fclose(file);
+
+    if (replay->num_ticks == 0) {
+        fprintf(stderr, "%s: no ticks of instance %u\n", path, instance);
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t sim_replay_get_value(const sim_replay_tick_t *tick, uint8_t input, int32_t *value) {
+    if (!(tick->inputs & AUTOMATA_INPUT_MASK(input))) {
+        return PBIO_ERROR_NO_DEV;
+    }
+    *value = tick->values[input];
+    return PBIO_SUCCESS;
+}
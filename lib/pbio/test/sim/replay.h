@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+// Replay of automaton runs recorded as telemetry. Inputs are replayed as
+// the engine read them, saturated to int16, so a replay reproduces the
+// decisions of the automaton, not the exact run of the hub.
+//
+// Telemetry drops frames when Bluetooth can not keep up. A recording with
+// such gaps can still be replayed to look at it, but ticks in the gaps are
+// missing, so it is not a regression baseline and the replay fails.
+
+#ifndef _PBIO_TEST_SIM_REPLAY_H_
+#define _PBIO_TEST_SIM_REPLAY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/error.h>
+
+#include "../../../../automata/engine.h"
+
+/**
+ * One recorded tick of the automaton.
+ */
+typedef struct {
+    /** Hub time of the tick [ms]. */
+    uint32_t time;
+    /** State after the tick. */
+    uint8_t state;
+    /** Mask of recorded inputs. */
+    uint8_t inputs;
+    int16_t values[AUTOMATA_NUM_INPUTS];
+    /** Frames were dropped before this tick, so earlier ticks may be missing. */
+    bool after_gap;
+} sim_replay_tick_t;
+
+/**
+ * Recorded ticks of one automaton instance.
+ */
+typedef struct {
+    sim_replay_tick_t *ticks;
+    uint32_t num_ticks;
+    /** Number of sync frames which reported dropped frames. */
+    uint32_t num_gaps;
+} sim_replay_t;
+
+/**
+ * Loads ticks of one instance from telemetry saved by
+ * tools/automata_telemetry.py --save, one hex encoded event per line.
+ *
+ * Telemetry must be turned on before the automaton starts, so that
+ * recording starts from its initial state.
+ *
+ * @param [out] replay      The loaded ticks.
+ * @param [in]  path        Path of the saved telemetry.
+ * @param [in]  instance    Scheduler slot of the recorded automaton.
+ * @return                  ::PBIO_SUCCESS on success, ::PBIO_ERROR_INVALID_ARG
+ *                          if the file can not be read or has no ticks.
+ */
+pbio_error_t sim_replay_load(sim_replay_t *replay, const char *path, uint8_t instance);
+
+/**
+ * Gets recorded value of input.
+ *
+ * @param [in]  tick        The recorded tick.
+ * @param [in]  input       The input, ::automata_input_t.
+ * @param [out] value       The value.
+ * @return                  ::PBIO_SUCCESS on success, ::PBIO_ERROR_NO_DEV if
+ *                          the input was not recorded.
+ */
+pbio_error_t sim_replay_get_value(const sim_replay_tick_t *tick, uint8_t input, int32_t *value);
+
+#endif // _PBIO_TEST_SIM_REPLAY_H_
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../../../automata/automata.h"
+
+#include "scenario.h"
+
+static const char *const input_names[AUTOMATA_NUM_INPUTS] = {
+    [AUTOMATA_INPUT_DISTANCE] = "distance",
+    [AUTOMATA_INPUT_COLOR] = "color",
+    [AUTOMATA_INPUT_ANGLE_X] = "angle_x",
+    [AUTOMATA_INPUT_ANGLE_Y] = "angle_y",
+    [AUTOMATA_INPUT_ANGLE_Z] = "angle_z",
+};
+
+static uint8_t bytecode[1024];
+
+static bool parse_input(const char *name, uint8_t *input) {
+    for (uint8_t i = 0; i < AUTOMATA_NUM_INPUTS; i++) {
+        if (input_names[i] && strcmp(name, input_names[i]) == 0) {
+            *input = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_table(const char *name, const automata_table_t **table) {
+    for (uint8_t i = 0; i < automata_num_tables; i++) {
+        if (strcmp(name, automata_tables[i]->name) == 0) {
+            *table = automata_tables[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Path of file given in scenario relative to the scenario.
+ */
+static void resolve_path(const sim_scenario_t *scenario, const char *name, char *path, size_t size) {
+    const char *slash = strrchr(scenario->path, '/');
+    if (name[0] == '/' || !slash) {
+        snprintf(path, size, "%s", name);
+        return;
+    }
+    snprintf(path, size, "%.*s/%s", (int)(slash - scenario->path), scenario->path, name);
+}
+
+static bool load_bytecode(const sim_scenario_t *scenario, const char *name, const automata_table_t **table) {
+    char path[512];
+    resolve_path(scenario, name, path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    size_t size = fread(bytecode, 1, sizeof(bytecode), file);
+    fclose(file);
+    return automata_bytecode_load(bytecode, size, table) == PBIO_SUCCESS;
+}
+
+static bool parse_goal(sim_scenario_t *scenario, const char *name) {
+    const automata_table_t *table = scenario->table;
+    for (uint8_t i = 0; i < table->num_states; i++) {
+        if (table->states[i].name && strcmp(name, table->states[i].name) == 0) {
+            scenario->goal = i;
+            return true;
+        }
+    }
+    char *end;
+    long index = strtol(name, &end, 10);
+    if (*end || index < 0 || index >= table->num_states) {
+        return false;
+    }
+    scenario->goal = index;
+    return true;
+}
+
+static bool parse_line(sim_scenario_t *scenario, char *line, char *goal) {
+    char *comment = strchr(line, '#');
+    if (comment) {
+        *comment = '\0';
+    }
+
+    char key[32];
+    char arg[256];
+    char ramp[8];
+    int count = sscanf(line, "%31s %255s", key, arg);
+    if (count <= 0) {
+        // Empty line.
+        return true;
+    }
+    if (count != 2) {
+        return false;
+    }
+
+    if (strcmp(key, "table") == 0) {
+        return parse_table(arg, &scenario->table);
+    }
+    if (strcmp(key, "bytecode") == 0) {
+        return load_bytecode(scenario, arg, &scenario->table);
+    }
+    if (strcmp(key, "replay") == 0) {
+        char path[512];
+        unsigned int instance = 0;
+        sscanf(line, "%*s %*s %u", &instance);
+        resolve_path(scenario, arg, path, sizeof(path));
+        return sim_replay_load(&scenario->replay, path, instance) == PBIO_SUCCESS;
+    }
+    if (strcmp(key, "duration") == 0) {
+        scenario->duration = strtoul(arg, NULL, 10);
+        return scenario->duration > 0;
+    }
+    if (strcmp(key, "goal") == 0) {
+        strcpy(goal, arg);
+        return true;
+    }
+
+    // Otherwise it is a keyframe.
+    if (scenario->num_keyframes == SIM_SCENARIO_MAX_KEYFRAMES) {
+        return false;
+    }
+    sim_keyframe_t *keyframe = &scenario->keyframes[scenario->num_keyframes];
+    long value;
+    count = sscanf(line, "%" SCNu32 " %31s %ld %7s", &keyframe->time, key, &value, ramp);
+    if (count < 3 || !parse_input(key, &keyframe->input)) {
+        return false;
+    }
+    keyframe->value = value;
+    keyframe->ramp = count == 4 && strcmp(ramp, "ramp") == 0;
+    if (count == 4 && !keyframe->ramp) {
+        return false;
+    }
+
+    // Values are looked up in order of time.
+    if (scenario->num_keyframes && keyframe->time < keyframe[-1].time) {
+        return false;
+    }
+    scenario->num_keyframes++;
+    return true;
+}
+
+pbio_error_t sim_scenario_load(sim_scenario_t *scenario, const char *path) {
+    memset(scenario, 0, sizeof(*scenario));
+    scenario->path = path;
+    scenario->goal = AUTOMATA_NO_STATE;
+    scenario->duration = 10000;
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "%s: can not open file\n", path);
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    char line[256];
+    char goal[256] = "";
+    int number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        if (!parse_line(scenario, line, goal)) {
+            fprintf(stderr, "%s:%d: invalid line\n", path, number);
+            fclose(file);
+            return PBIO_ERROR_INVALID_ARG;
+        }
+    }
+    fclose(file);
+
+    if (!scenario->table) {
+        fprintf(stderr, "%s: no table or bytecode\n", path);
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    if (goal[0] && !parse_goal(scenario, goal)) {
+        fprintf(stderr, "%s: unknown goal state %s\n", path, goal);
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    return PBIO_SUCCESS;
+}
+
+pbio_error_t sim_scenario_get_value(const sim_scenario_t *scenario, uint8_t input, uint32_t time, int32_t *value) {
+    const sim_keyframe_t *last = NULL;
+
+    for (uint16_t i = 0; i < scenario->num_keyframes; i++) {
+        const sim_keyframe_t *keyframe = &scenario->keyframes[i];
+        if (keyframe->input != input) {
+            continue;
+        }
+        if (keyframe->time > time) {
+            if (!last) {
+                // Value before the first keyframe is its value.
+                *value = keyframe->value;
+            } else if (keyframe->ramp) {
+                int64_t progress = time - last->time;
+                *value = last->value + (keyframe->value - last->value) * progress / (keyframe->time - last->time);
+            } else {
+                *value = last->value;
+            }
+            return PBIO_SUCCESS;
+        }
+        last = keyframe;
+    }
+
+    if (!last) {
+        return PBIO_ERROR_NO_DEV;
+    }
+    *value = last->value;
+    return PBIO_SUCCESS;
+}
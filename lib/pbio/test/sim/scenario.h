@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+// Scripted sensor inputs for the automata simulator.
+
+#ifndef _PBIO_TEST_SIM_SCENARIO_H_
+#define _PBIO_TEST_SIM_SCENARIO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pbio/error.h>
+
+#include "../../../../automata/engine.h"
+
+#include "replay.h"
+
+#define SIM_SCENARIO_MAX_KEYFRAMES (256)
+
+/**
+ * Value of one input from the given time on.
+ */
+typedef struct {
+    /** Simulated time [ms]. */
+    uint32_t time;
+    uint8_t input;
+    int32_t value;
+    /** Input goes linearly to value from the previous keyframe of the input. */
+    bool ramp;
+} sim_keyframe_t;
+
+/**
+ * One simulated run of one automaton.
+ */
+typedef struct {
+    const char *path;
+    const automata_table_t *table;
+    /** Simulated time after which the run stops [ms]. */
+    uint32_t duration;
+    /** Run succeeds when a transition enters this state. AUTOMATA_NO_STATE if any run succeeds. */
+    uint8_t goal;
+    /** Recorded run which replaces keyframes, num_ticks is 0 if there is none. */
+    sim_replay_t replay;
+    /** Keyframes sorted by time. */
+    sim_keyframe_t keyframes[SIM_SCENARIO_MAX_KEYFRAMES];
+    uint16_t num_keyframes;
+} sim_scenario_t;
+
+/**
+ * Parses scenario file.
+ *
+ * Every line is one of the following, # starts a comment:
+ *
+ *     table <name>                     built-in automaton, e.g. follow
+ *     bytecode <file>                  automaton compiled by automata_compile.py
+ *     replay <file> [instance]         inputs and states recorded as telemetry
+ *     duration <ms>                    simulated time of the run
+ *     goal <state>                     state name or index the automaton must reach
+ *     <ms> <input> <value> [ramp]      value of input from given time on
+ *
+ * Inputs are distance, color, angle_x, angle_y and angle_z. Base done is read
+ * from the simulated drive base. Files are relative to the scenario. Replay
+ * ends with the recording, its states after each tick must match. Where
+ * the recording reports dropped frames, replay continues from the recorded
+ * state instead, but the run fails, since such a recording is not a
+ * regression baseline.
+ *
+ * @param [out] scenario    The parsed scenario.
+ * @param [in]  path        Path of the scenario file.
+ * @return                  ::PBIO_SUCCESS on success, ::PBIO_ERROR_INVALID_ARG
+ *                          if the file can not be read or parsed.
+ */
+pbio_error_t sim_scenario_load(sim_scenario_t *scenario, const char *path);
+
+/**
+ * Gets value of input at the given time.
+ *
+ * @param [in]  scenario    The scenario.
+ * @param [in]  input       The input, ::automata_input_t.
+ * @param [in]  time        Simulated time [ms].
+ * @param [out] value       The value.
+ * @return                  ::PBIO_SUCCESS on success, ::PBIO_ERROR_NO_DEV if
+ *                          the scenario has no value for the input.
+ */
+pbio_error_t sim_scenario_get_value(const sim_scenario_t *scenario, uint8_t input, uint32_t time, int32_t *value);
+
+#endif // _PBIO_TEST_SIM_SCENARIO_H_
@@ -2,6 +2,7 @@
 // Copyright (c) 2020-2022 The Pybricks Authors
 
 #include <errno.h>
+#include <math.h>
 #include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -20,6 +21,7 @@
 #include <pbio/control.h>
 #include <pbio/drivebase.h>
 #include <pbio/error.h>
+#include <pbio/imu.h>
 #include <pbio/logger.h>
 #include <pbio/int_math.h>
 #include <pbio/motor_process.h>
@@ -29,6 +31,7 @@
 #include "../src/processes.h"
 #include "../drv/core.h"
 #include "../drv/clock/clock_test.h"
+#include "../drv/imu/imu_test.h"
 #include "../drv/motor_driver/motor_driver_virtual_simulation.h"
 
 static PT_THREAD(test_drivebase_basics(struct pt *pt)) {
@@ -183,7 +186,271 @@ end:
     PT_END(pt);
 }
 
+static PT_THREAD(test_drivebase_queue(struct pt *pt)) {
+
+    static struct timer timer;
+
+    static pbio_servo_t *srv_left;
+    static pbio_servo_t *srv_right;
+    static pbdrv_legodev_dev_t *legodev_left;
+    static pbdrv_legodev_dev_t *legodev_right;
+    static pbio_drivebase_t *db;
+
+    static int32_t drive_distance;
+    static int32_t drive_distance_start;
+    static int32_t drive_speed;
+    static int32_t drive_speed_min;
+    static int32_t drive_speed_default;
+    static int32_t drive_acceleration;
+    static int32_t drive_deceleration;
+    static int32_t turn_acceleration;
+    static int32_t turn_deceleration;
+    static int32_t turn_angle;
+    static int32_t turn_rate;
+    static uint32_t time_start;
+    static uint32_t duration_separate;
+    static uint8_t i;
+    static pbio_control_t distance_before;
+    static pbio_control_t heading_before;
+
+    // Start motor driver simulation process.
+    pbdrv_motor_driver_init_manual();
+
+    PT_BEGIN(pt);
+
+    // Wait for motor simulation process to be ready.
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // Start motor control process manually.
+    pbio_motor_process_start();
+
+    // Set up the drivebase.
+    pbdrv_legodev_type_id_t id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
+    tt_uint_op(pbdrv_legodev_get_device(PBIO_PORT_ID_A, &id, &legodev_left), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_get_servo(legodev_left, &srv_left), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_setup(srv_left, id, PBIO_DIRECTION_COUNTERCLOCKWISE, 1000, true, 0), ==, PBIO_SUCCESS);
+    id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
+    tt_uint_op(pbdrv_legodev_get_device(PBIO_PORT_ID_B, &id, &legodev_right), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_get_servo(legodev_right, &srv_right), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_setup(srv_right, id, PBIO_DIRECTION_CLOCKWISE, 1000, true, 0), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_drivebase_get_drivebase(&db, srv_left, srv_right, 56000, 112000), ==, PBIO_SUCCESS);
+
+    // Drive three segments one by one, stopping after each.
+    time_start = pbdrv_clock_get_ms();
+    for (i = 0; i < 3; i++) {
+        tt_uint_op(pbio_drivebase_drive_straight(db, 300, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+        pbio_test_sleep_until(pbio_drivebase_is_done(db));
+    }
+    duration_separate = pbdrv_clock_get_ms() - time_start;
+
+    // Queue the same three segments at once. They blend into one another.
+    tt_uint_op(pbio_drivebase_get_drive_settings(db, &drive_speed_default, &drive_acceleration, &drive_deceleration,
+        &turn_rate, &turn_acceleration, &turn_deceleration), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_drivebase_get_state_user(db, &drive_distance_start, &drive_speed, &turn_angle, &turn_rate), ==, PBIO_SUCCESS);
+    time_start = pbdrv_clock_get_ms();
+    for (i = 0; i < 3; i++) {
+        tt_uint_op(pbio_drivebase_queue_straight(db, 300, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    }
+
+    // The speed must not drop between segments.
+    drive_speed_min = INT32_MAX;
+    while (!pbio_drivebase_is_done(db)) {
+        tt_uint_op(pbio_drivebase_get_state_user(db, &drive_distance, &drive_speed, &turn_angle, &turn_rate), ==, PBIO_SUCCESS);
+        if (drive_distance > drive_distance_start + 200 && drive_distance < drive_distance_start + 700) {
+            drive_speed_min = pbio_int_math_min(drive_speed_min, drive_speed);
+        }
+        pbio_test_sleep_ms(&timer, 1);
+    }
+    tt_want_int_op(pbdrv_clock_get_ms() - time_start, <, duration_separate - 500);
+    tt_want_int_op(drive_speed_min, >, drive_speed_default * 9 / 10);
+    tt_uint_op(pbio_drivebase_get_state_user(db, &drive_distance, &drive_speed, &turn_angle, &turn_rate), ==, PBIO_SUCCESS);
+    tt_want(pbio_test_int_is_close(drive_distance, drive_distance_start + 900, 20));
+
+    // A command that is not queued discards the queue.
+    for (i = 0; i < 3; i++) {
+        tt_uint_op(pbio_drivebase_queue_straight(db, 300, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    }
+    tt_uint_op(pbio_drivebase_stop(db, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    tt_uint_op(db->control_distance.queue.length, ==, 0);
+
+    // If either controller can't queue, neither one changes. Here the turn is
+    // too far to plan.
+    for (i = 0; i < 2; i++) {
+        tt_uint_op(pbio_drivebase_queue_straight(db, 300, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    }
+    memcpy(&distance_before, &db->control_distance, sizeof(distance_before));
+    memcpy(&heading_before, &db->control_heading, sizeof(heading_before));
+    tt_uint_op(pbio_drivebase_queue_curve(db, 0, 10000000, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want(memcmp(&distance_before, &db->control_distance, sizeof(distance_before)) == 0);
+    tt_want(memcmp(&heading_before, &db->control_heading, sizeof(heading_before)) == 0);
+
+    // The same goes for a full queue.
+    while (db->control_distance.queue.length < PBIO_CONFIG_CONTROL_QUEUE_SIZE) {
+        tt_uint_op(pbio_drivebase_queue_straight(db, 300, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    }
+    memcpy(&distance_before, &db->control_distance, sizeof(distance_before));
+    memcpy(&heading_before, &db->control_heading, sizeof(heading_before));
+    tt_uint_op(pbio_drivebase_queue_straight(db, 300, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_ERROR_BUSY);
+    tt_want(memcmp(&distance_before, &db->control_distance, sizeof(distance_before)) == 0);
+    tt_want(memcmp(&heading_before, &db->control_heading, sizeof(heading_before)) == 0);
+    tt_uint_op(pbio_drivebase_stop(db, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+
+end:
+
+    PT_END(pt);
+}
+
+/**
+ * Gets the physical heading of the simulated drivebase on ports A and B, with
+ * 56 mm wheels spaced 112 mm apart. Clockwise is positive.
+ *
+ * @return                  The heading in degrees.
+ */
+static float test_drivebase_get_true_heading(void) {
+    pbdrv_motor_driver_dev_t *driver;
+    int32_t rotations;
+    int32_t millidegrees;
+
+    pbdrv_motor_driver_get_dev(0, &driver);
+    pbdrv_motor_driver_virtual_simulation_get_angle(driver, &rotations, &millidegrees);
+    float left = rotations * 360.0f + millidegrees / 1000.0f;
+
+    pbdrv_motor_driver_get_dev(1, &driver);
+    pbdrv_motor_driver_virtual_simulation_get_angle(driver, &rotations, &millidegrees);
+    float right = rotations * 360.0f + millidegrees / 1000.0f;
+
+    // The motors are mounted in opposite directions, so the heading is half
+    // the sum of the raw motor angles, times wheel diameter over axle track.
+    // Turning clockwise makes both motors go backwards.
+    return -(left + right) / 2 * 56 / 112;
+}
+
+/**
+ * Gets the heading as seen by the drivebase heading controller.
+ *
+ * @return                  The heading in degrees.
+ */
+static float test_drivebase_get_gyro_heading(void) {
+    pbio_angle_t heading;
+    int32_t heading_rate;
+    pbio_imu_get_heading_scaled(&heading, &heading_rate, 1000);
+    return heading.rotations * 360.0f + heading.millidegrees / 1000.0f;
+}
+
+// Like pbio_test_sleep_until, but feeds the physical heading to the simulated
+// gyro. Keeps track of the biggest difference between the physical heading
+// and the gyro heading, with and without latency compensation, and of the
+// biggest physical heading.
+#define test_drivebase_sleep_until_with_gyro(condition) \
+    while (!(condition)) { \
+        while (pbio_do_one_event()) { \
+        } \
+        heading_true = test_drivebase_get_true_heading(); \
+        heading_error_max = fmaxf(heading_error_max, fabsf(test_drivebase_get_gyro_heading() - heading_true)); \
+        heading_error_raw_max = fmaxf(heading_error_raw_max, fabsf(pbio_imu_get_heading() - heading_true)); \
+        heading_peak = fmaxf(heading_peak, heading_true); \
+        pbio_test_imu_set_rotation(-heading_true); \
+        pbio_test_clock_tick(1); \
+        PT_YIELD(pt); \
+    }
+
+static PT_THREAD(test_drivebase_gyro(struct pt *pt)) {
+
+    static struct timer timer;
+
+    static pbio_servo_t *srv_left;
+    static pbio_servo_t *srv_right;
+    static pbdrv_legodev_dev_t *legodev_left;
+    static pbdrv_legodev_dev_t *legodev_right;
+    static pbio_drivebase_t *db;
+
+    static int32_t drive_speed;
+    static int32_t drive_acceleration;
+    static int32_t drive_deceleration;
+    static int32_t turn_rate;
+    static int32_t turn_acceleration;
+    static int32_t turn_deceleration;
+    static float heading_start;
+    static float heading_true;
+    static float heading_peak;
+    static float heading_error_max;
+    static float heading_error_raw_max;
+
+    // Start motor driver simulation process.
+    pbdrv_motor_driver_init_manual();
+
+    PT_BEGIN(pt);
+
+    // Wait for motor simulation process to be ready.
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // Start motor control process manually.
+    pbio_motor_process_start();
+
+    // Set up the drivebase.
+    pbdrv_legodev_type_id_t id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
+    tt_uint_op(pbdrv_legodev_get_device(PBIO_PORT_ID_A, &id, &legodev_left), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_get_servo(legodev_left, &srv_left), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_setup(srv_left, id, PBIO_DIRECTION_COUNTERCLOCKWISE, 1000, true, 0), ==, PBIO_SUCCESS);
+    id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
+    tt_uint_op(pbdrv_legodev_get_device(PBIO_PORT_ID_B, &id, &legodev_right), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_get_servo(legodev_right, &srv_right), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_setup(srv_right, id, PBIO_DIRECTION_CLOCKWISE, 1000, true, 0), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_drivebase_get_drivebase(&db, srv_left, srv_right, 56000, 112000), ==, PBIO_SUCCESS);
+
+    // Feed the gyro for a while so it has a steady stream of samples, and
+    // start it at the physical heading.
+    test_drivebase_sleep_until_with_gyro(pbdrv_clock_get_ms() > 100);
+    pbio_imu_set_heading(test_drivebase_get_true_heading());
+    tt_uint_op(pbio_drivebase_set_use_gyro(db, true), ==, PBIO_SUCCESS);
+
+    // Turn fast with steep acceleration, where latency matters most.
+    tt_uint_op(pbio_drivebase_get_drive_settings(db,
+        &drive_speed,
+        &drive_acceleration,
+        &drive_deceleration,
+        &turn_rate,
+        &turn_acceleration,
+        &turn_deceleration), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_drivebase_set_drive_settings(db,
+        drive_speed,
+        drive_acceleration,
+        drive_deceleration,
+        400,
+        2000,
+        2000), ==, PBIO_SUCCESS);
+
+    heading_start = test_drivebase_get_true_heading();
+    heading_peak = heading_start;
+    heading_error_max = 0;
+    heading_error_raw_max = 0;
+    tt_uint_op(pbio_drivebase_drive_curve(db, 0, 360, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+
+    // The heading used for control should stay close to the physical
+    // heading, also while turning at speed (millidegrees). The samples lag
+    // behind, so without compensation the error is several times bigger.
+    test_drivebase_sleep_until_with_gyro(pbio_drivebase_is_done(db));
+    tt_want_int_op(heading_error_max * 1000, <, 500);
+    tt_want_int_op(heading_error_max * 1000 * 3, <, heading_error_raw_max * 1000);
+
+    // Let it settle. It should not overshoot much, and end up on target.
+    timer_set(&timer, 500);
+    test_drivebase_sleep_until_with_gyro(timer_expired(&timer));
+    tt_want_int_op((heading_peak - heading_start - 360) * 1000, <, 2000);
+    tt_want_int_op(fabsf(heading_true - heading_start - 360) * 1000, <, 1000);
+
+end:
+
+    PT_END(pt);
+}
+
 struct testcase_t pbio_drivebase_tests[] = {
     PBIO_PT_THREAD_TEST(test_drivebase_basics),
+    PBIO_PT_THREAD_TEST(test_drivebase_queue),
+    PBIO_PT_THREAD_TEST(test_drivebase_gyro),
     END_OF_TESTCASES
 };
@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2024 The Pybricks Authors
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <contiki.h>
+#include <tinytest.h>
+#include <tinytest_macros.h>
+
+#include <pbdrv/imu.h>
+#include <pbio/error.h>
+#include <pbio/geometry.h>
+#include <pbio/imu.h>
+#include <test-pbio.h>
+
+#include "../drv/core.h"
+#include "../drv/clock/clock_test.h"
+#include "../drv/imu/imu_test.h"
+
+#define GRAVITY (9806.65f)
+
+#define DEG_TO_RAD (0.017453293f)
+
+static void test_quaternion_normalize(void *env) {
+    pbio_geometry_quaternion_t q = { .w = 2.0f };
+    tt_want_uint_op(pbio_geometry_quaternion_normalize(&q), ==, PBIO_SUCCESS);
+    tt_want_float_op(q.w, ==, 1.0f);
+    tt_want_float_op(q.x, ==, 0.0f);
+
+    q = (pbio_geometry_quaternion_t) { .w = 1.0f, .x = -1.0f, .y = 1.0f, .z = -1.0f };
+    tt_want_uint_op(pbio_geometry_quaternion_normalize(&q), ==, PBIO_SUCCESS);
+    tt_want_float_op(q.w, ==, 0.5f);
+    tt_want_float_op(q.x, ==, -0.5f);
+    tt_want_float_op(q.y, ==, 0.5f);
+    tt_want_float_op(q.z, ==, -0.5f);
+
+    q = (pbio_geometry_quaternion_t) { 0 };
+    tt_want_uint_op(pbio_geometry_quaternion_normalize(&q), ==, PBIO_ERROR_INVALID_ARG);
+}
+
+static void test_quaternion_rotate(void *env) {
+    pbio_geometry_matrix_3x3_t rotation;
+    pbio_geometry_xyz_t output;
+
+    // A quarter turn about z maps x to y, and y to -x.
+    pbio_geometry_quaternion_t q = { .w = cosf(M_PI / 4), .z = sinf(M_PI / 4) };
+    pbio_geometry_quaternion_to_rotation_matrix(&q, &rotation);
+    pbio_geometry_vector_map(&rotation, &(pbio_geometry_xyz_t) { .x = 1.0f }, &output);
+    tt_want_float_op(fabsf(output.x - 0.0f), <, 1e-6f);
+    tt_want_float_op(fabsf(output.y - 1.0f), <, 1e-6f);
+    tt_want_float_op(fabsf(output.z - 0.0f), <, 1e-6f);
+    pbio_geometry_vector_map(&rotation, &(pbio_geometry_xyz_t) { .y = 1.0f }, &output);
+    tt_want_float_op(fabsf(output.x + 1.0f), <, 1e-6f);
+    tt_want_float_op(fabsf(output.y - 0.0f), <, 1e-6f);
+
+    // A quarter turn about x maps y to z.
+    q = (pbio_geometry_quaternion_t) { .w = cosf(M_PI / 4), .x = sinf(M_PI / 4) };
+    pbio_geometry_quaternion_to_rotation_matrix(&q, &rotation);
+    pbio_geometry_vector_map(&rotation, &(pbio_geometry_xyz_t) { .y = 1.0f }, &output);
+    tt_want_float_op(fabsf(output.y - 0.0f), <, 1e-6f);
+    tt_want_float_op(fabsf(output.z - 1.0f), <, 1e-6f);
+
+    // The inverse rotation maps it back.
+    q.x = -q.x;
+    pbio_geometry_quaternion_to_rotation_matrix(&q, &rotation);
+    pbio_geometry_vector_map(&rotation, &(pbio_geometry_xyz_t) { .z = 1.0f }, &output);
+    tt_want_float_op(fabsf(output.y - 1.0f), <, 1e-6f);
+    tt_want_float_op(fabsf(output.z - 0.0f), <, 1e-6f);
+}
+
+/**
+ * Makes the simulated hub stand still at the given roll and pitch, so that
+ * the accelerometer measures just gravity.
+ *
+ * @param [in]  roll        Rotation about the X axis in degrees.
+ * @param [in]  pitch       Rotation about the Y axis in degrees.
+ */
+static void test_imu_set_tilt(float roll, float pitch) {
+    pbio_test_imu_set_acceleration(
+        -sinf(pitch * DEG_TO_RAD) * GRAVITY,
+        sinf(roll * DEG_TO_RAD) * cosf(pitch * DEG_TO_RAD) * GRAVITY,
+        cosf(roll * DEG_TO_RAD) * cosf(pitch * DEG_TO_RAD) * GRAVITY);
+}
+
+/**
+ * Lets the simulated hub stand still for a while, passing on all frames.
+ *
+ * @param [in]  duration    Duration in ms.
+ */
+static void test_imu_run(uint32_t duration) {
+    for (uint32_t i = 0; i < duration; i++) {
+        pbio_test_imu_set_rotation(0.0f);
+        pbio_test_clock_tick(1);
+    }
+}
+
+static PT_THREAD(test_imu_attitude_initial(struct pt *pt)) {
+
+    static float roll;
+    static float pitch;
+    static float yaw;
+
+    PT_BEGIN(pt);
+
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // The first frame sets the attitude to the measured tilt right away.
+    test_imu_set_tilt(30.0f, -20.0f);
+    test_imu_run(5);
+    pbio_imu_get_roll_pitch_yaw(&roll, &pitch, &yaw);
+    tt_want_float_op(fabsf(roll - 30.0f), <, 0.1f);
+    tt_want_float_op(fabsf(pitch + 20.0f), <, 0.1f);
+    tt_want_float_op(fabsf(yaw), <, 0.1f);
+
+    PT_END(pt);
+}
+
+static PT_THREAD(test_imu_attitude_convergence(struct pt *pt)) {
+
+    static float roll;
+    static float pitch;
+    static float yaw;
+
+    PT_BEGIN(pt);
+
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // Start flat.
+    test_imu_run(100);
+    pbio_imu_get_roll_pitch_yaw(&roll, &pitch, &yaw);
+    tt_want_float_op(fabsf(roll), <, 0.1f);
+    tt_want_float_op(fabsf(pitch), <, 0.1f);
+
+    // The hub tilts without the gyro noticing, as if the gyro had drifted.
+    // The estimate does not jump to the measured tilt.
+    test_imu_set_tilt(20.0f, -10.0f);
+    test_imu_run(500);
+    pbio_imu_get_roll_pitch_yaw(&roll, &pitch, &yaw);
+    tt_want_float_op(roll, >, 2.0f);
+    tt_want_float_op(roll, <, 15.0f);
+    tt_want_float_op(pitch, <, -1.0f);
+    tt_want_float_op(pitch, >, -7.5f);
+
+    // But it converges to it.
+    test_imu_run(7500);
+    pbio_imu_get_roll_pitch_yaw(&roll, &pitch, &yaw);
+    tt_want_float_op(fabsf(roll - 20.0f), <, 0.5f);
+    tt_want_float_op(fabsf(pitch + 10.0f), <, 0.5f);
+    tt_want_uint_op(pbio_imu_get_up_side(), ==, PBIO_GEOMETRY_SIDE_TOP);
+
+    PT_END(pt);
+}
+
+/**
+ * Lets the simulated hub stand still for one second.
+ *
+ * @return                  Heading drift during that second in degrees.
+ */
+static float test_imu_get_heading_drift(void) {
+    float heading_start = pbio_imu_get_heading();
+    test_imu_run(1000);
+    return fabsf(pbio_imu_get_heading() - heading_start);
+}
+
+static PT_THREAD(test_imu_zero_rate(struct pt *pt)) {
+
+    PT_BEGIN(pt);
+
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // The hub stands still, but it is not reported as stationary, as if it
+    // was on a vehicle. Without a first calibration, the bias is not learned
+    // while moving, so the heading keeps drifting at the full bias.
+    pbio_test_imu_set_gyro_bias(0.0f, 0.0f, 1.4f);
+    test_imu_run(30000);
+    tt_want(!pbio_imu_is_ready());
+    tt_want_float_op(test_imu_get_heading_drift(), >, 1.3f);
+
+    // Holding it still once calibrates it.
+    pbio_test_imu_set_stationary(true);
+    test_imu_run(1000);
+    pbio_test_imu_set_stationary(false);
+    tt_want(pbio_imu_is_ready());
+    tt_want_float_op(test_imu_get_heading_drift(), <, 0.05f);
+
+    // After that, a change of bias is learned also while moving.
+    pbio_test_imu_set_gyro_bias(0.0f, 0.0f, 2.1f);
+    tt_want_float_op(test_imu_get_heading_drift(), >, 0.6f);
+    test_imu_run(30000);
+    tt_want(pbio_imu_is_ready());
+    tt_want_float_op(test_imu_get_heading_drift(), <, 0.25f);
+
+    PT_END(pt);
+}
+
+static PT_THREAD(test_imu_attitude_benchmark(struct pt *pt)) {
+
+    static pbdrv_imu_dev_t *imu_dev;
+    static pbdrv_imu_config_t *imu_config;
+    pbdrv_imu_handler_stats_t stats;
+
+    PT_BEGIN(pt);
+
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // Tilted, so the attitude filter also corrects with gravity.
+    tt_want_uint_op(pbdrv_imu_get_imu(&imu_dev, &imu_config), ==, PBIO_SUCCESS);
+    test_imu_set_tilt(20.0f, -10.0f);
+    test_imu_run(100);
+    pbdrv_imu_reset_handler_stats(imu_dev);
+    test_imu_run(10000);
+
+    // All of the handler must fit well within the time between samples, which
+    // is what the cycle counter reports on the hub.
+    pbdrv_imu_get_handler_stats(imu_dev, &stats);
+    tt_want_uint_op(stats.frames, >, 16000);
+    float budget = imu_config->sample_time * 1000000.0f;
+    float average = (float)stats.cycles / stats.frames / stats.cycles_per_us;
+    tt_want_float_op(average, <, budget / 10);
+
+    TT_BLATHER(("frame handler: %.3f us avg, %.3f us max, budget %.0f us",
+        (double)average, (double)stats.max_frame_cycles / stats.cycles_per_us, (double)budget));
+
+    PT_END(pt);
+}
+
+struct testcase_t pbio_imu_tests[] = {
+    PBIO_TEST(test_quaternion_normalize),
+    PBIO_TEST(test_quaternion_rotate),
+    PBIO_PT_THREAD_TEST(test_imu_attitude_initial),
+    PBIO_PT_THREAD_TEST(test_imu_attitude_convergence),
+    PBIO_PT_THREAD_TEST(test_imu_zero_rate),
+    PBIO_PT_THREAD_TEST(test_imu_attitude_benchmark),
+    END_OF_TESTCASES
+};
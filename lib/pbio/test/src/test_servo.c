@@ -19,8 +19,10 @@
 #include <pbio/angle.h>
 #include <pbio/control.h>
 #include <pbio/error.h>
+#include <pbio/integrator.h>
 #include <pbio/logger.h>
 #include <pbio/int_math.h>
+#include <pbio/motion_group.h>
 #include <pbio/motor_process.h>
 #include <pbio/servo.h>
 #include <test-pbio.h>
@@ -31,12 +33,13 @@
 #include "../drv/motor_driver/motor_driver_virtual_simulation.h"
 #include "../drv/legodev/legodev_virtual.h"
 
-static PT_THREAD(test_servo_basics(struct pt *pt)) {
+static PT_THREAD(test_servo_basics_at_loop_time(struct pt *pt, uint32_t loop_time)) {
 
     static struct timer timer;
 
     static int32_t angle;
     static int32_t start_angle;
+    static uint32_t other_loop_time;
     static int32_t speed;
 
     static pbio_servo_t *srv;
@@ -55,6 +58,10 @@ static PT_THREAD(test_servo_basics(struct pt *pt)) {
     // Start motor control process manually.
     pbio_motor_process_start();
 
+    // Only loop times with motor models are available.
+    tt_uint_op(pbio_motor_process_set_loop_time(3), ==, PBIO_ERROR_INVALID_ARG);
+    tt_uint_op(pbio_motor_process_set_loop_time(loop_time), ==, PBIO_SUCCESS);
+
     // Get legodev.
     pbdrv_legodev_type_id_t id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
     tt_uint_op(pbdrv_legodev_get_device(PBIO_PORT_ID_A, &id, &legodev), ==, PBIO_SUCCESS);
@@ -63,6 +70,20 @@ static PT_THREAD(test_servo_basics(struct pt *pt)) {
     // Set up servo with given id.
     tt_uint_op(pbio_servo_get_servo(legodev, &srv), ==, PBIO_SUCCESS);
     tt_uint_op(pbio_servo_setup(srv, id, PBIO_DIRECTION_CLOCKWISE, 1000, true, 0), ==, PBIO_SUCCESS);
+    tt_uint_op(srv->observer.model->loop_time, ==, loop_time);
+
+    // Loop time can change while the servo is idle, which then uses the
+    // model for the new loop time.
+    other_loop_time = loop_time == 10 ? 2 : 10;
+    tt_uint_op(pbio_motor_process_set_loop_time(other_loop_time), ==, PBIO_SUCCESS);
+    tt_uint_op(srv->observer.model->loop_time, ==, other_loop_time);
+    tt_uint_op(pbio_motor_process_set_loop_time(loop_time), ==, PBIO_SUCCESS);
+    tt_uint_op(srv->observer.model->loop_time, ==, loop_time);
+
+    // Control loop should run at the new rate.
+    pbio_motor_process_reset_stats();
+    pbio_test_sleep_ms_all_events(&timer, 100);
+    tt_want(pbio_test_int_is_close(pbio_motor_process_get_stats()->count, 100 / loop_time, 2));
 
     // Assert not moving to begin with.
     tt_uint_op(pbio_servo_get_state_user(srv, &start_angle, &speed), ==, PBIO_SUCCESS);
@@ -70,25 +91,28 @@ static PT_THREAD(test_servo_basics(struct pt *pt)) {
 
     // Test running BY angle.
     tt_uint_op(pbio_servo_run_angle(srv, 500, 180, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
-    pbio_test_sleep_until(pbio_control_is_done(&srv->control));
+
+    // Loop time can't change while the servo is controlled.
+    tt_uint_op(pbio_motor_process_set_loop_time(other_loop_time), ==, PBIO_ERROR_BUSY);
+    pbio_test_sleep_until_all_events(pbio_control_is_done(&srv->control));
     tt_uint_op(pbio_servo_get_state_user(srv, &angle, &speed), ==, PBIO_SUCCESS);
     tt_want(pbio_test_int_is_close(angle, start_angle + 180, 5)); // Target should be close.
     tt_want(pbio_test_int_is_close(speed, 0, 100)); // Still allowed to move on completion.
-    pbio_test_sleep_ms(&timer, 500);
+    pbio_test_sleep_ms_all_events(&timer, 500);
     tt_uint_op(pbio_servo_get_state_user(srv, &angle, &speed), ==, PBIO_SUCCESS);
     tt_want(pbio_test_int_is_close(speed, 0, 50)); // Want further slowdown after holding.
 
     // Test running TO angle.
     tt_uint_op(pbio_servo_run_target(srv, 500, -90, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
-    pbio_test_sleep_until(pbio_control_is_done(&srv->control));
+    pbio_test_sleep_until_all_events(pbio_control_is_done(&srv->control));
     tt_uint_op(pbio_servo_get_state_user(srv, &angle, &speed), ==, PBIO_SUCCESS);
     tt_want(pbio_test_int_is_close(angle, -90, 5)); // Target should be close.
 
     // Test running for time.
     tt_uint_op(pbio_servo_run_time(srv, 500, 1000, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
-    pbio_test_sleep_ms(&timer, 500);
+    pbio_test_sleep_ms_all_events(&timer, 500);
     tt_want(!pbio_control_is_done(&srv->control));
-    pbio_test_sleep_until(pbio_control_is_done(&srv->control));
+    pbio_test_sleep_until_all_events(pbio_control_is_done(&srv->control));
     tt_want(pbio_test_int_is_close(speed, 0, 50));
 
 end:
@@ -96,6 +120,18 @@ end:
     PT_END(pt);
 }
 
+static PT_THREAD(test_servo_basics(struct pt *pt)) {
+    return test_servo_basics_at_loop_time(pt, PBIO_CONFIG_CONTROL_LOOP_TIME_MS);
+}
+
+static PT_THREAD(test_servo_basics_2ms(struct pt *pt)) {
+    return test_servo_basics_at_loop_time(pt, 2);
+}
+
+static PT_THREAD(test_servo_basics_10ms(struct pt *pt)) {
+    return test_servo_basics_at_loop_time(pt, 10);
+}
+
 static PT_THREAD(test_servo_stall(struct pt *pt)) {
 
     static struct timer timer;
@@ -219,9 +255,246 @@ end:
     PT_END(pt);
 }
 
+static PT_THREAD(test_servo_control_loop_stats(struct pt *pt)) {
+
+    static struct timer timer;
+    static pbio_servo_t *srv;
+    static pbdrv_legodev_dev_t *legodev;
+    static const pbio_motor_process_stats_t *stats;
+
+    // Start motor driver simulation process.
+    pbdrv_motor_driver_init_manual();
+
+    PT_BEGIN(pt);
+
+    // Wait for motor simulation process to be ready.
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // Start motor control process manually.
+    pbio_motor_process_start();
+
+    // Set up servo and keep it busy.
+    pbdrv_legodev_type_id_t id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
+    tt_uint_op(pbdrv_legodev_get_device(PBIO_PORT_ID_A, &id, &legodev), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_get_servo(legodev, &srv), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_setup(srv, id, PBIO_DIRECTION_CLOCKWISE, 1000, true, 0), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_run_forever(srv, 500), ==, PBIO_SUCCESS);
+
+    // Count the iterations of one second.
+    pbio_motor_process_reset_stats();
+    pbio_test_sleep_ms(&timer, 1000);
+    stats = pbio_motor_process_get_stats();
+    tt_want(pbio_test_int_is_close(stats->count, 1000 / PBIO_CONFIG_CONTROL_LOOP_TIME_MS, 1));
+
+    // Test clock does not advance during the update, so every update fits
+    // in the first bin and the loop runs exactly on time.
+    tt_want_uint_op(stats->total.histogram[0], ==, stats->count);
+    tt_want_uint_op(stats->total.max, ==, 0);
+    tt_want_uint_op(stats->overruns, ==, 0);
+    tt_want_uint_op(stats->missed, ==, 0);
+    tt_want_uint_op(stats->jitter_max, ==, 0);
+
+    // Delaying the loop by more than a period should be counted.
+    pbio_test_clock_tick(PBIO_CONFIG_CONTROL_LOOP_TIME_MS * 3);
+    pbio_test_sleep_ms(&timer, 100);
+    tt_want_uint_op(stats->missed, ==, 1);
+    tt_want_uint_op(stats->jitter_max, >=, PBIO_CONFIG_CONTROL_LOOP_TIME_MS * 2 * 1000);
+
+    pbio_motor_process_reset_stats();
+    tt_want_uint_op(stats->count, ==, 0);
+
+end:
+
+    PT_END(pt);
+}
+
+static PT_THREAD(test_servo_motion_group(struct pt *pt)) {
+
+    static struct timer timer;
+    static pbio_servo_t *servos[3];
+    static pbio_motion_group_t *group;
+    static uint32_t time_first_done;
+    static int32_t angle;
+    static int32_t speed;
+    static const pbio_port_id_t ports[] = { PBIO_PORT_ID_A, PBIO_PORT_ID_C, PBIO_PORT_ID_E };
+    static const int32_t targets[] = { 360, 90, -180 };
+    static const int32_t angles[] = { 720, -180, 90 };
+
+    // Start motor driver simulation process.
+    pbdrv_motor_driver_init_manual();
+
+    PT_BEGIN(pt);
+
+    // Wait for motor simulation process to be ready.
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // Start motor control process manually.
+    pbio_motor_process_start();
+
+    // Set up servos of different sizes, all starting at zero.
+    for (uint8_t i = 0; i < 3; i++) {
+        pbdrv_legodev_dev_t *legodev;
+        pbdrv_legodev_type_id_t id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
+        tt_uint_op(pbdrv_legodev_get_device(ports[i], &id, &legodev), ==, PBIO_SUCCESS);
+        tt_uint_op(pbio_servo_get_servo(legodev, &servos[i]), ==, PBIO_SUCCESS);
+        tt_uint_op(pbio_servo_setup(servos[i], id, PBIO_DIRECTION_CLOCKWISE, 1000, true, 0), ==, PBIO_SUCCESS);
+        tt_uint_op(pbio_servo_reset_angle(servos[i], 0, false), ==, PBIO_SUCCESS);
+    }
+
+    // A servo can be in a group only once, and only in one group.
+    tt_uint_op(pbio_motion_group_get_motion_group(&group, (pbio_servo_t *[]) { servos[0], servos[0] }, 2), ==, PBIO_ERROR_INVALID_ARG);
+    tt_uint_op(pbio_motion_group_get_motion_group(&group, servos, 3), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_motion_group_get_motion_group(&group, servos, 1), ==, PBIO_ERROR_BUSY);
+
+    // Run all servos to their targets. The shortest maneuver is stretched to
+    // take as long as the longest one.
+    tt_uint_op(pbio_motion_group_run_target(group, 500, targets, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    for (uint8_t i = 1; i < 3; i++) {
+        tt_want_uint_op(servos[i]->control.trajectory.start.time, ==, servos[0]->control.trajectory.start.time);
+        tt_want_uint_op(pbio_trajectory_get_duration(&servos[i]->control.trajectory), ==, pbio_trajectory_get_duration(&servos[0]->control.trajectory));
+    }
+
+    // So the servos should all complete at about the same time.
+    pbio_test_sleep_until(pbio_control_is_done(&servos[0]->control) || pbio_control_is_done(&servos[1]->control) || pbio_control_is_done(&servos[2]->control));
+    time_first_done = pbdrv_clock_get_ms();
+    pbio_test_sleep_until(pbio_motion_group_is_done(group));
+    tt_want_uint_op(pbdrv_clock_get_ms() - time_first_done, <, 50);
+    for (uint8_t i = 0; i < 3; i++) {
+        tt_uint_op(pbio_servo_get_state_user(servos[i], &angle, &speed), ==, PBIO_SUCCESS);
+        tt_want(pbio_test_int_is_close(angle, targets[i], 5));
+    }
+
+    // Running by relative angles also completes together.
+    tt_uint_op(pbio_motion_group_run_angle(group, 500, angles, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    pbio_test_sleep_until(pbio_control_is_done(&servos[0]->control) || pbio_control_is_done(&servos[1]->control) || pbio_control_is_done(&servos[2]->control));
+    time_first_done = pbdrv_clock_get_ms();
+    pbio_test_sleep_until(pbio_motion_group_is_done(group));
+    tt_want_uint_op(pbdrv_clock_get_ms() - time_first_done, <, 50);
+    for (uint8_t i = 0; i < 3; i++) {
+        tt_uint_op(pbio_servo_get_state_user(servos[i], &angle, &speed), ==, PBIO_SUCCESS);
+        tt_want(pbio_test_int_is_close(angle, targets[i] + angles[i], 5));
+    }
+
+    // The servo on port C hits its endstop on the way back to zero. When it
+    // stalls, the other servos must wait for it.
+    tt_uint_op(pbio_motion_group_run_target(group, 500, (int32_t[]) { 0, -360, 0 }, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    pbio_test_sleep_ms(&timer, 3000);
+    tt_want(!pbio_motion_group_is_done(group));
+
+    // All servos paused in the same iteration as the one that stalled.
+    for (uint8_t i = 0; i < 3; i++) {
+        tt_want(pbio_position_integrator_is_paused(&servos[i]->control.position_integrator));
+        tt_want_uint_op(servos[i]->control.position_integrator.time_pause_begin, ==, servos[1]->control.position_integrator.time_pause_begin);
+    }
+    tt_uint_op(pbio_servo_get_state_user(servos[0], &angle, &speed), ==, PBIO_SUCCESS);
+    tt_want_int_op(angle, >, 360);
+    tt_want(pbio_test_int_is_close(speed, 0, 20));
+
+    // A command to one servo stops the group, and coasts the others.
+    tt_uint_op(pbio_servo_run_angle(servos[1], 500, 90, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    tt_want(!group->active);
+    tt_want(!pbio_control_is_active(&servos[0]->control));
+    tt_want(pbio_control_is_active(&servos[1]->control));
+
+    // If one servo can't start, none of them run. Here the target of the
+    // second servo is too far away.
+    tt_uint_op(pbio_motion_group_run_target(group, 500, (int32_t[]) { 0, 10000000, 0 }, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want(!group->active);
+    for (uint8_t i = 0; i < 3; i++) {
+        tt_want(!pbio_control_is_active(&servos[i]->control));
+    }
+
+    // The group can start again and stop.
+    tt_uint_op(pbio_motion_group_run_angle(group, 0, angles, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    pbio_test_sleep_ms(&timer, 100);
+    tt_uint_op(pbio_motion_group_stop(group, PBIO_CONTROL_ON_COMPLETION_CONTINUE), ==, PBIO_ERROR_INVALID_ARG);
+    tt_uint_op(pbio_motion_group_stop(group, PBIO_CONTROL_ON_COMPLETION_COAST), ==, PBIO_SUCCESS);
+    tt_want(!pbio_control_is_active(&servos[0]->control));
+
+end:
+
+    PT_END(pt);
+}
+
+static PT_THREAD(test_servo_queue(struct pt *pt)) {
+
+    static pbio_servo_t *srv;
+    static pbdrv_legodev_dev_t *legodev;
+    static pbio_control_t before;
+    static int32_t angle;
+    static int32_t start_angle;
+    static int32_t speed;
+
+    // Start motor driver simulation process.
+    pbdrv_motor_driver_init_manual();
+
+    PT_BEGIN(pt);
+
+    // Wait for motor simulation process to be ready.
+    while (pbdrv_init_busy()) {
+        PT_YIELD(pt);
+    }
+
+    // Start motor control process manually.
+    pbio_motor_process_start();
+
+    // Set up servo.
+    pbdrv_legodev_type_id_t id = PBDRV_LEGODEV_TYPE_ID_ANY_ENCODED_MOTOR;
+    tt_uint_op(pbdrv_legodev_get_device(PBIO_PORT_ID_A, &id, &legodev), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_get_servo(legodev, &srv), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_setup(srv, id, PBIO_DIRECTION_CLOCKWISE, 1000, true, 0), ==, PBIO_SUCCESS);
+    tt_uint_op(pbio_servo_get_state_user(srv, &start_angle, &speed), ==, PBIO_SUCCESS);
+
+    // The first maneuver starts right away.
+    tt_uint_op(pbio_servo_queue_angle(srv, 500, 180, PBIO_CONTROL_ON_COMPLETION_COAST), ==, PBIO_SUCCESS);
+    tt_want(srv->control.queue.active);
+    tt_want_uint_op(srv->control.queue.length, ==, 0);
+
+    // A maneuver in the same direction makes the ongoing one keep going.
+    tt_uint_op(pbio_servo_queue_angle(srv, 500, 180, PBIO_CONTROL_ON_COMPLETION_COAST), ==, PBIO_SUCCESS);
+    tt_want_uint_op(srv->control.queue.length, ==, 1);
+    tt_want_uint_op(srv->control.on_completion, ==, PBIO_CONTROL_ON_COMPLETION_CONTINUE);
+
+    // A maneuver that reverses makes the last one stop and hold.
+    tt_uint_op(pbio_servo_queue_angle(srv, 500, -180, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    tt_want_uint_op(srv->control.queue.length, ==, 2);
+    tt_want_uint_op(srv->control.queue.segments[0].on_completion, ==, PBIO_CONTROL_ON_COMPLETION_HOLD);
+
+    // A maneuver that can't be planned leaves the controller as it was.
+    memcpy(&before, &srv->control, sizeof(before));
+    tt_uint_op(pbio_servo_queue_angle(srv, 500, 10000000, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want(memcmp(&before, &srv->control, sizeof(before)) == 0);
+
+    // So does a maneuver that does not fit in the queue.
+    while (srv->control.queue.length < PBIO_CONFIG_CONTROL_QUEUE_SIZE) {
+        tt_uint_op(pbio_servo_queue_angle(srv, 500, -90, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_SUCCESS);
+    }
+    memcpy(&before, &srv->control, sizeof(before));
+    tt_uint_op(pbio_servo_queue_angle(srv, 500, -90, PBIO_CONTROL_ON_COMPLETION_HOLD), ==, PBIO_ERROR_BUSY);
+    tt_want(memcmp(&before, &srv->control, sizeof(before)) == 0);
+
+    // All queued maneuvers run in order, and the servo ends up at the sum.
+    pbio_test_sleep_until(pbio_control_is_done(&srv->control));
+    tt_uint_op(pbio_servo_get_state_user(srv, &angle, &speed), ==, PBIO_SUCCESS);
+    tt_want(pbio_test_int_is_close(angle, start_angle + 180 + 180 - 180 - 90 * (PBIO_CONFIG_CONTROL_QUEUE_SIZE - 2), 5));
+
+end:
+
+    PT_END(pt);
+}
+
 struct testcase_t pbio_servo_tests[] = {
     PBIO_PT_THREAD_TEST(test_servo_basics),
+    PBIO_PT_THREAD_TEST(test_servo_basics_2ms),
+    PBIO_PT_THREAD_TEST(test_servo_basics_10ms),
     PBIO_PT_THREAD_TEST(test_servo_stall),
     PBIO_PT_THREAD_TEST(test_servo_gearing),
+    PBIO_PT_THREAD_TEST(test_servo_control_loop_stats),
+    PBIO_PT_THREAD_TEST(test_servo_motion_group),
+    PBIO_PT_THREAD_TEST(test_servo_queue),
     END_OF_TESTCASES
 };
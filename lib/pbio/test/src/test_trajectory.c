@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include <pbio/int_math.h>
 #include <pbio/trajectory.h>
@@ -191,6 +193,7 @@ static void get_infinite_command(uint32_t index, pbio_trajectory_command_t *c) {
     c->duration = DURATION_FOREVER_TICKS;
     c->speed_max = 1000 * MDEG_PER_DEG;
     c->continue_running = true;
+    c->profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
 
     c->position_start = angles[index % PBIO_ARRAY_SIZE(angles)];
     index /= PBIO_ARRAY_SIZE(angles);
@@ -287,6 +290,7 @@ static const uint32_t num_position_trajectories =
 static void get_position_command(uint32_t index, pbio_trajectory_command_t *c) {
 
     c->speed_max = 1000 * MDEG_PER_DEG;
+    c->profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
 
     c->continue_running = index % 2;
     index /= 2;
@@ -370,9 +374,183 @@ static void test_position_trajectory(void *env) {
     }
 }
 
+/**
+ * Tests that an S-curve visits the same vertices as the trapezoid with the
+ * same average acceleration, with smooth ramps in between.
+ */
+static void test_s_curve_trajectory(void *env) {
+
+    // Command: Run for 10000 degrees at 1000 deg/s with a peak acceleration
+    // of 3000 deg/s/s. This averages 2000 deg/s/s during the ramps, so the
+    // vertices are the same as in the simple trajectory.
+    pbio_trajectory_command_t command = {
+        .position_end = {
+            .rotations = 27,
+            .millidegrees = 280 * MDEG_PER_DEG,
+        },
+        .speed_target = 1000 * MDEG_PER_DEG,
+        .speed_max = 1000 * MDEG_PER_DEG,
+        .acceleration = 3000 * MDEG_PER_DEG,
+        .deceleration = 3000 * MDEG_PER_DEG,
+        .profile = PBIO_TRAJECTORY_PROFILE_S_CURVE,
+    };
+
+    pbio_trajectory_t trj;
+    pbio_error_t err = pbio_trajectory_new_angle_command(&trj, &command);
+    tt_want_int_op(err, ==, PBIO_SUCCESS);
+
+    tt_want_int_op(trj.t1, ==, 500 * 10);
+    tt_want_int_op(trj.t2, ==, 10000 * 10);
+    tt_want_int_op(trj.t3, ==, 10500 * 10);
+    tt_want_int_op(trj.th1, ==, 250 * MDEG_PER_DEG);
+    tt_want_int_op(trj.th2, ==, 9750 * MDEG_PER_DEG);
+    tt_want_int_op(trj.th3, ==, 10000 * MDEG_PER_DEG);
+
+    // Acceleration starts and ends at zero, and peaks halfway the ramp.
+    pbio_trajectory_reference_t ref;
+    pbio_trajectory_get_reference(&trj, 0, &ref);
+    tt_want_int_op(ref.acceleration, ==, 0);
+    tt_want_int_op(ref.speed, ==, 0);
+    pbio_trajectory_get_reference(&trj, 250 * 10, &ref);
+    tt_want_int_op(ref.acceleration, ==, command.acceleration);
+    tt_want_int_op(ref.speed, ==, 500 * MDEG_PER_DEG);
+    pbio_trajectory_get_reference(&trj, 500 * 10, &ref);
+    tt_want_int_op(ref.acceleration, ==, 0);
+    tt_want_int_op(ref.speed, ==, command.speed_target);
+    tt_want_int_op(pbio_angle_diff_mdeg(&ref.position, &command.position_start), ==, 250 * MDEG_PER_DEG);
+    pbio_trajectory_get_reference(&trj, 10250 * 10, &ref);
+    tt_want_int_op(ref.acceleration, ==, -command.deceleration);
+    tt_want_int_op(ref.speed, ==, 500 * MDEG_PER_DEG);
+
+    // Stretching to a slower leader keeps the profile and the endpoint.
+    pbio_trajectory_t leader;
+    command.position_end.rotations *= 2;
+    command.profile = PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
+    err = pbio_trajectory_new_angle_command(&leader, &command);
+    tt_want_int_op(err, ==, PBIO_SUCCESS);
+    pbio_trajectory_stretch(&trj, &leader);
+    tt_want_int_op(trj.profile, ==, PBIO_TRAJECTORY_PROFILE_S_CURVE);
+    pbio_trajectory_get_endpoint(&trj, &ref);
+    tt_want_int_op(ref.time, ==, pbio_trajectory_get_duration(&leader));
+    tt_want_int_op(pbio_angle_diff_mdeg(&ref.position, &command.position_start), ==, 10000 * MDEG_PER_DEG);
+    walk_trajectory(&trj);
+
+    // Walk a subset of the position commands along S-curves. They reach the
+    // same endpoints as trapezoids.
+    for (uint32_t i = 0; i < num_position_trajectories; i += 7) {
+        get_position_command(i, &command);
+        command.profile = PBIO_TRAJECTORY_PROFILE_S_CURVE;
+        err = pbio_trajectory_new_angle_command(&trj, &command);
+        if (err == PBIO_ERROR_INVALID_ARG) {
+            continue;
+        }
+        tt_want_int_op(err, ==, PBIO_SUCCESS);
+        pbio_trajectory_reference_t end;
+        pbio_trajectory_get_endpoint(&trj, &end);
+        if (command.speed_target != 0) {
+            tt_want_int_op(pbio_angle_diff_mdeg(&end.position, &command.position_end), ==, 0);
+        }
+
+        // Trajectories that are rebased while walking them become constant
+        // trajectories, which are covered by the position trajectory test.
+        if (pbio_trajectory_get_duration(&trj) < DURATION_FOREVER_TICKS) {
+            walk_trajectory(&trj);
+        }
+    }
+}
+
+static uint64_t get_time_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void test_trajectory_cache(void *env) {
+
+    pbio_trajectory_command_t command;
+    pbio_trajectory_t computed;
+    pbio_trajectory_t cached;
+
+    // A cached trajectory must be identical to one that is computed. Commands
+    // are visited in order of start position and time first, so most of them
+    // are found in the cache even without computing them twice.
+    pbio_trajectory_cache_clear();
+    for (uint32_t i = 0; i < num_position_trajectories; i++) {
+        get_position_command(i, &command);
+        pbio_error_t err_cached = pbio_trajectory_new_angle_command(&cached, &command);
+
+        pbio_trajectory_cache_clear();
+        pbio_error_t err_computed = pbio_trajectory_new_angle_command(&computed, &command);
+        tt_want_int_op(err_cached, ==, err_computed);
+        if (err_computed == PBIO_SUCCESS) {
+            tt_want(memcmp(&cached, &computed, sizeof(computed)) == 0);
+        }
+    }
+    pbio_trajectory_cache_clear();
+    for (uint32_t i = 0; i < num_infinite_trajectories; i++) {
+        get_infinite_command(i, &command);
+        pbio_error_t err_cached = pbio_trajectory_new_time_command(&cached, &command);
+
+        pbio_trajectory_cache_clear();
+        pbio_error_t err_computed = pbio_trajectory_new_time_command(&computed, &command);
+        tt_want_int_op(err_cached, ==, err_computed);
+        if (err_computed == PBIO_SUCCESS) {
+            tt_want(memcmp(&cached, &computed, sizeof(computed)) == 0);
+        }
+    }
+
+    // Benchmark a drive base that repeats the same turn many times.
+    const uint32_t repeats = 10000;
+    command = (pbio_trajectory_command_t) {
+        .speed_target = 500 * MDEG_PER_DEG,
+        .speed_max = 1000 * MDEG_PER_DEG,
+        .acceleration = 2000 * MDEG_PER_DEG,
+        .deceleration = 2000 * MDEG_PER_DEG,
+    };
+
+    uint64_t start = get_time_ns();
+    for (uint32_t i = 0; i < repeats; i++) {
+        pbio_trajectory_cache_clear();
+        command.position_end = command.position_start;
+        pbio_angle_add_mdeg(&command.position_end, 90 * MDEG_PER_DEG);
+        tt_want_int_op(pbio_trajectory_new_angle_command(&computed, &command), ==, PBIO_SUCCESS);
+        command.position_start = command.position_end;
+        command.time_start += pbio_trajectory_get_duration(&computed);
+    }
+    uint64_t duration_computed = get_time_ns() - start;
+
+    start = get_time_ns();
+    for (uint32_t i = 0; i < repeats; i++) {
+        command.position_end = command.position_start;
+        pbio_angle_add_mdeg(&command.position_end, 90 * MDEG_PER_DEG);
+        tt_want_int_op(pbio_trajectory_new_angle_command(&cached, &command), ==, PBIO_SUCCESS);
+        command.position_start = command.position_end;
+        command.time_start += pbio_trajectory_get_duration(&cached);
+    }
+    uint64_t duration_cached = get_time_ns() - start;
+
+    // Evaluating the reference of the last turn at each control tick.
+    pbio_trajectory_reference_t ref;
+    uint32_t ticks = 0;
+    start = get_time_ns();
+    for (uint32_t i = 0; i < repeats / 100; i++) {
+        for (uint32_t t = 0; t <= pbio_trajectory_get_duration(&cached); t += 5 * PBIO_TRAJECTORY_TICKS_PER_MS) {
+            pbio_trajectory_get_reference(&cached, cached.start.time + t, &ref);
+            ticks++;
+        }
+    }
+    uint64_t duration_reference = get_time_ns() - start;
+
+    TT_BLATHER(("new angle command: %.1f ns computed, %.1f ns cached",
+        (double)duration_computed / repeats, (double)duration_cached / repeats));
+    TT_BLATHER(("get reference: %.1f ns", (double)duration_reference / ticks));
+}
+
 struct testcase_t pbio_trajectory_tests[] = {
     PBIO_TEST(test_simple_trajectory),
     PBIO_TEST(test_position_trajectory),
     PBIO_TEST(test_infinite_trajectory),
+    PBIO_TEST(test_s_curve_trajectory),
+    PBIO_TEST(test_trajectory_cache),
     END_OF_TESTCASES
 };
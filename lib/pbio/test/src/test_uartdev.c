@@ -15,6 +15,7 @@
 #include <pbdrv/uart.h>
 #include <pbdrv/legodev.h>
 #include <pbdrv/legodev.h>
+#include <pbio/event.h>
 #include <pbio/main.h>
 #include <pbio/util.h>
 #include <test-pbio.h>
@@ -115,6 +116,48 @@ end:
         tt_assert_msg(ok, #msg); \
 } while (0)
 
+// Receives mode 1 data with the given value and gives the driver time to
+// parse it and to deliver a possible data event.
+static PT_THREAD(simulate_rx_mode_1_data(struct pt *pt, int8_t value, bool *ok)) {
+    static struct pt child;
+    static uint8_t msg[] = { 0xC1, 0x00, 0x00 };
+    static int i;
+
+    PT_BEGIN(pt);
+
+    msg[1] = value;
+    msg[2] = 0xFF ^ msg[0] ^ msg[1];
+    PT_SPAWN(pt, &child, simulate_rx_msg(&child, msg, PBIO_ARRAY_SIZE(msg), ok));
+
+    for (i = 0; i < 10; i++) {
+        PT_YIELD(pt);
+    }
+
+    PT_END(pt);
+}
+
+#define SIMULATE_RX_MODE_1_DATA(value) do { \
+        PT_SPAWN(pt, &child, simulate_rx_mode_1_data(&child, (value), &ok)); \
+        tt_assert_msg(ok, "mode 1 data " #value); \
+} while (0)
+
+PROCESS(test_legodev_data_process, "legodev data test");
+
+static uint32_t legodev_data_events;
+static process_data_t legodev_data_event_data;
+
+PROCESS_THREAD(test_legodev_data_process, ev, data) {
+    PROCESS_BEGIN();
+
+    for (;;) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PBIO_EVENT_LEGODEV_DATA);
+        legodev_data_events++;
+        legodev_data_event_data = data;
+    }
+
+    PROCESS_END();
+}
+
 static const uint8_t msg_speed_115200[] = { 0x52, 0x00, 0xC2, 0x01, 0x00, 0x6E }; // SPEED 115200
 static const uint8_t msg_ack[] = { 0x04 }; // ACK
 
@@ -228,10 +271,12 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     static pbdrv_legodev_dev_t *legodev;
     static pbdrv_legodev_info_t *info;
     static pbio_error_t err;
+    static pbdrv_legodev_data_filter_t filter;
 
     PT_BEGIN(pt);
 
     pbdrv_legodev_test_start_process();
+    process_start(&test_legodev_data_process);
 
     // Expect no device at first.
     pbdrv_legodev_type_id_t id = PBDRV_LEGODEV_TYPE_ID_NONE;
@@ -439,6 +484,45 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     tt_uint_op(pbdrv_legodev_get_info(legodev, &info), ==, PBIO_SUCCESS);
     tt_uint_op(info->mode, ==, 1);
 
+    // test data events
+
+    // without a filter, the first data is announced and then any change
+    tt_uint_op(pbdrv_legodev_set_data_notify(legodev, 1, NULL), ==, PBIO_SUCCESS);
+    legodev_data_events = 0;
+    SIMULATE_RX_MODE_1_DATA(0);
+    tt_want_uint_op(legodev_data_events, ==, 1);
+    tt_ptr_op(legodev_data_event_data, ==, legodev);
+    SIMULATE_RX_MODE_1_DATA(0);
+    tt_want_uint_op(legodev_data_events, ==, 1);
+    SIMULATE_RX_MODE_1_DATA(5);
+    tt_want_uint_op(legodev_data_events, ==, 2);
+
+    // filter must refer to existing value and have ordered thresholds
+    filter = (pbdrv_legodev_data_filter_t) { .index = 1, .lower = 10, .upper = 20 };
+    tt_want_uint_op(pbdrv_legodev_set_data_notify(legodev, 1, &filter), ==, PBIO_ERROR_INVALID_ARG);
+    filter = (pbdrv_legodev_data_filter_t) { .index = 0, .lower = 20, .upper = 10 };
+    tt_want_uint_op(pbdrv_legodev_set_data_notify(legodev, 1, &filter), ==, PBIO_ERROR_INVALID_ARG);
+    tt_want_uint_op(pbdrv_legodev_set_data_notify(legodev, 11, NULL), ==, PBIO_ERROR_INVALID_ARG);
+
+    // with a filter, the first data is announced and then only threshold crossings
+    filter = (pbdrv_legodev_data_filter_t) { .index = 0, .lower = 10, .upper = 20 };
+    tt_uint_op(pbdrv_legodev_set_data_notify(legodev, 1, &filter), ==, PBIO_SUCCESS);
+    SIMULATE_RX_MODE_1_DATA(5);
+    tt_want_uint_op(legodev_data_events, ==, 3);
+    SIMULATE_RX_MODE_1_DATA(15);
+    tt_want_uint_op(legodev_data_events, ==, 3);
+    SIMULATE_RX_MODE_1_DATA(25);
+    tt_want_uint_op(legodev_data_events, ==, 4);
+    SIMULATE_RX_MODE_1_DATA(15);
+    tt_want_uint_op(legodev_data_events, ==, 4);
+    SIMULATE_RX_MODE_1_DATA(5);
+    tt_want_uint_op(legodev_data_events, ==, 5);
+
+    // no more events once cleared
+    tt_uint_op(pbdrv_legodev_clear_data_notify(legodev), ==, PBIO_SUCCESS);
+    SIMULATE_RX_MODE_1_DATA(25);
+    tt_want_uint_op(legodev_data_events, ==, 5);
+
 
     // also do mode 8 since it requires the extended mode flag
     PT_WAIT_WHILE(pt, ({
@@ -465,6 +549,23 @@ static PT_THREAD(test_boost_color_distance_sensor(struct pt *pt)) {
     tt_uint_op(pbdrv_legodev_get_info(legodev, &info), ==, PBIO_SUCCESS);
     tt_uint_op(info->mode, ==, 8);
 
+    // subscribers are told when the device is lost
+    tt_uint_op(pbdrv_legodev_set_data_notify(legodev, 8, NULL), ==, PBIO_SUCCESS);
+    legodev_data_events = 0;
+    SIMULATE_RX_MSG(msg91);
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        legodev_data_events == 1;
+    }));
+
+    // the keep alive message is not answered, so the device is lost
+    PT_WAIT_UNTIL(pt, ({
+        pbio_test_clock_tick(1);
+        legodev_data_events == 2;
+    }));
+    tt_ptr_op(legodev_data_event_data, ==, legodev);
+    tt_uint_op(pbdrv_legodev_is_ready(legodev), !=, PBIO_SUCCESS);
+
     PT_YIELD(pt);
 
 end:
@@ -8,6 +8,7 @@
 
 #include <pbio/button.h>
 #include <pbio/int_math.h>
+#include <pbio/main.h>
 
 // Use this macro to define tests that _don't_ require a Contiki event loop
 #define PBIO_TEST(name) \
@@ -57,6 +58,26 @@ void pbio_test_counter_set_abs_angle(int32_t millidegrees);
         PT_YIELD(pt); \
     }
 
+// like the above, but all pending events are handled before each clock tick,
+// so that processes with short periods such as the motor control loop at 2 ms
+// don't fall behind. Use these in tests that change the control loop time.
+#define pbio_test_sleep_until_all_events(condition) \
+    while (!(condition)) { \
+        while (pbio_do_one_event()) { \
+        } \
+        pbio_test_clock_tick(1); \
+        PT_YIELD(pt); \
+    }
+
+#define pbio_test_sleep_ms_all_events(timer, duration) \
+    timer_set((timer), (duration)); \
+    while (!timer_expired(timer)) { \
+        while (pbio_do_one_event()) { \
+        } \
+        pbio_test_clock_tick(1); \
+        PT_YIELD(pt); \
+    }
+
 #define pbio_test_int_is_close(value, target, tolerance) (pbio_int_math_abs((value) - (target)) <= (tolerance))
 
 #endif // _TEST_PBIO_H_
@@ -117,6 +117,26 @@ STATIC mp_obj_t pb_type_Control_limits(size_t n_args, const mp_obj_t *pos_args,
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(pb_type_Control_limits_obj, 1, pb_type_Control_limits);
 
+// pybricks._common.Control.profile
+STATIC mp_obj_t pb_type_Control_profile(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+
+    PB_PARSE_ARGS_METHOD(n_args, pos_args, kw_args,
+        pb_type_Control_obj_t, self,
+        PB_ARG_DEFAULT_NONE(s_curve));
+
+    // If no value is given, return current value
+    if (s_curve_in == mp_const_none) {
+        return mp_obj_new_bool(pbio_control_settings_get_trajectory_profile(&self->control->settings) == PBIO_TRAJECTORY_PROFILE_S_CURVE);
+    }
+
+    // Set user setting
+    pbio_trajectory_profile_t profile = mp_obj_is_true(s_curve_in) ? PBIO_TRAJECTORY_PROFILE_S_CURVE : PBIO_TRAJECTORY_PROFILE_TRAPEZOID;
+    pb_assert(pbio_control_settings_set_trajectory_profile(&self->control->settings, profile));
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(pb_type_Control_profile_obj, 1, pb_type_Control_profile);
+
 // pybricks._common.Control.pid
 STATIC mp_obj_t pb_type_Control_pid(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
 
@@ -292,6 +312,7 @@ STATIC const pb_attr_dict_entry_t pb_type_Control_attr_dict[] = {
 STATIC const mp_rom_map_elem_t pb_type_Control_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_limits), MP_ROM_PTR(&pb_type_Control_limits_obj) },
     { MP_ROM_QSTR(MP_QSTR_pid), MP_ROM_PTR(&pb_type_Control_pid_obj) },
+    { MP_ROM_QSTR(MP_QSTR_profile), MP_ROM_PTR(&pb_type_Control_profile_obj) },
     { MP_ROM_QSTR(MP_QSTR_target_tolerances), MP_ROM_PTR(&pb_type_Control_target_tolerances_obj) },
     { MP_ROM_QSTR(MP_QSTR_stall_tolerances), MP_ROM_PTR(&pb_type_Control_stall_tolerances_obj) },
     { MP_ROM_QSTR(MP_QSTR_trajectory), MP_ROM_PTR(&pb_type_Control_trajectory_obj) },
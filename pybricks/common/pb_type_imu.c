@@ -5,7 +5,6 @@
 
 #if PYBRICKS_PY_COMMON && PYBRICKS_PY_COMMON_IMU
 
-#include <math.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -48,18 +47,13 @@ MP_DEFINE_CONST_FUN_OBJ_1(common_IMU_up_obj, common_IMU_up);
 // pybricks._common.IMU.tilt
 STATIC mp_obj_t common_IMU_tilt(mp_obj_t self_in) {
 
-    // Read acceleration in the user frame.
-    pbio_geometry_xyz_t accl;
-    pbio_imu_get_acceleration(&accl);
+    // Read estimated attitude in the user frame.
+    float roll, pitch, yaw;
+    pbio_imu_get_roll_pitch_yaw(&roll, &pitch, &yaw);
 
     mp_obj_t tilt[2];
-    // Pitch
-    float pitch = atan2f(-accl.x, sqrtf(accl.z * accl.z + accl.y * accl.y));
-    tilt[0] = mp_obj_new_int_from_float(pitch * 57.296f);
-
-    // Roll
-    float roll = atan2f(accl.y, accl.z);
-    tilt[1] = mp_obj_new_int_from_float(roll * 57.296f);
+    tilt[0] = mp_obj_new_int_from_float(pitch);
+    tilt[1] = mp_obj_new_int_from_float(roll);
     return mp_obj_new_tuple(2, tilt);
 }
 MP_DEFINE_CONST_FUN_OBJ_1(common_IMU_tilt_obj, common_IMU_tilt);
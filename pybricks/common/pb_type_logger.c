@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include <pbio/config.h>
+#include <pbio/control_settings.h>
 #include <pbio/logger.h>
 #include <pbio/int_math.h>
 #include <pbio/servo.h>
@@ -54,7 +55,7 @@ STATIC mp_obj_t tools_Logger_start(size_t n_args, const mp_obj_t *pos_args, mp_m
 
     // Log only one row per divisor samples.
     mp_uint_t down_sample = pbio_int_math_max(pb_obj_get_int(down_sample_in), 1);
-    mp_uint_t num_rows = pb_obj_get_int(duration_in) / PBIO_CONFIG_CONTROL_LOOP_TIME_MS / down_sample;
+    mp_uint_t num_rows = pb_obj_get_int(duration_in) / pbio_control_settings_get_loop_time() / down_sample;
 
     // Size is number of rows times column width. All data are int32.
     mp_int_t size = num_rows * self->num_cols;
@@ -0,0 +1,446 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2024 The Pybricks Authors
+
+"""
+Automaton compiler.
+
+Compiles JSON description of an automaton to C source with the table and its
+compiled step function (see automata/engine.h), or to bytecode which can be
+uploaded as user program (see automata/bytecode.h).
+
+Description:
+    name        string  name of automaton, used for C identifiers
+    priority    number  lower number runs first (optional, 0)
+    period      number  period of ticks [ms] (optional, 0 is default period)
+    devices     list    of "base", "ultrasonic", "color", "imu"
+    ports       object  left_motor, left_direction, right_motor,
+                        right_direction, ultrasonic, color
+                        (port letters, "clockwise" or "counterclockwise")
+    initial     string  name of initial state (optional, first state)
+    start       list    actions called after setup (optional)
+    exit        list    actions called at the end (optional)
+    states      object  state name => list of transitions
+
+Transition:
+    if          list    guards [input, op, value], all must be true (optional)
+    do          list    actions [name, args...] (optional)
+    goto        string  name of target state (optional, same state)
+
+Inputs:     distance, color, angle_x, angle_y, angle_z, base_done
+Operators:  <, <=, >, >=, ==, !=, changed (input changed since last tick)
+Actions:    base_stop, base_run_forever(speed, turn_rate),
+            base_run_angle(radius, angle), matrix_clear,
+            matrix_set_pixel(row, column, brightness)
+
+Generated C only compares inputs used by the reachable transitions. Guards of
+one transition on the same input are folded to one interval check, and
+transitions which can never be taken are left out.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import zlib
+
+INPUTS = ["distance", "color", "angle_x", "angle_y", "angle_z", "base_done"]
+
+OPS = {
+    "always": 0,
+    "<": 1,
+    "<=": 2,
+    ">": 3,
+    ">=": 4,
+    "==": 5,
+    "!=": 6,
+    "changed": 7,
+}
+
+# name => (opcode, number of args, device, C call with {0}, {1}, {2} args)
+ACTIONS = {
+    "base_stop": (0, 0, "base", "automata_base_stop(ctx, engine->base)"),
+    "base_run_forever": (
+        1,
+        2,
+        "base",
+        "automata_base_run_forever(ctx, engine->base, {0}, {1})",
+    ),
+    "base_run_angle": (
+        2,
+        2,
+        "base",
+        "automata_base_run_angle(ctx, engine->base, {0}, {1})",
+    ),
+    "matrix_clear": (
+        3,
+        0,
+        None,
+        "automata_matrix_clear(ctx, automata_engine_get_light_matrix())",
+    ),
+    "matrix_set_pixel": (
+        4,
+        3,
+        None,
+        "automata_matrix_set_pixel(ctx, automata_engine_get_light_matrix(), {0}, {1}, {2})",
+    ),
+}
+
+DEVICES = {"base": 1, "ultrasonic": 2, "color": 4, "imu": 8}
+
+INPUT_DEVICES = {
+    "distance": "ultrasonic",
+    "color": "color",
+    "angle_x": "imu",
+    "angle_y": "imu",
+    "angle_z": "imu",
+    "base_done": "base",
+}
+
+PORTS = [
+    "left_motor",
+    "left_direction",
+    "right_motor",
+    "right_direction",
+    "ultrasonic",
+    "color",
+]
+
+DIRECTIONS = {"clockwise": 0, "counterclockwise": 1}
+
+INT16_MIN = -(2**15)
+INT16_MAX = 2**15 - 1
+
+
+class CompileError(Exception):
+    pass
+
+
+def c_input(name):
+    return "AUTOMATA_INPUT_" + name.upper()
+
+
+def fold_guards(guards):
+    """
+    Folds guards of one transition. Returns None if they can never hold,
+    otherwise list of (input, op, value) without redundant comparisons.
+    """
+    for guard in guards:
+        if len(guard) != 3 or guard[0] not in INPUTS or guard[1] not in OPS:
+            raise CompileError("invalid guard {}".format(guard))
+    changed = [tuple(g) for g in guards if g[1] == "changed"]
+    guards = [tuple(g) for g in guards if g[1] not in ["always", "changed"]]
+
+    # Single comparison of an input is kept as written.
+    names = [g[0] for g in guards]
+    if len(set(names)) == len(names):
+        return changed + guards
+
+    intervals = {}
+    excluded = {}
+    for name, op, value in guards:
+        low, high = intervals.get(name, (-(2**31), 2**31 - 1))
+        if op == "<":
+            high = min(high, value - 1)
+        elif op == "<=":
+            high = min(high, value)
+        elif op == ">":
+            low = max(low, value + 1)
+        elif op == ">=":
+            low = max(low, value)
+        elif op == "==":
+            low, high = max(low, value), min(high, value)
+        else:
+            excluded.setdefault(name, set()).add(value)
+        intervals[name] = (low, high)
+
+    folded = []
+    for name, (low, high) in intervals.items():
+        values = {v for v in excluded.get(name, ()) if low <= v <= high}
+        if low > high or (low == high and low in values):
+            return None
+        if low == high:
+            folded.append((name, "==", low))
+            continue
+        if low > -(2**31):
+            folded.append((name, ">=", low))
+        if high < 2**31 - 1:
+            folded.append((name, "<=", high))
+        folded.extend((name, "!=", v) for v in sorted(values))
+    return changed + folded
+
+
+def check_action(action, devices):
+    if not action or action[0] not in ACTIONS:
+        raise CompileError("invalid action {}".format(action))
+    _, num_args, device, _ = ACTIONS[action[0]]
+    if len(action) != num_args + 1:
+        raise CompileError("action {} needs {} arguments".format(action[0], num_args))
+    if device and device not in devices:
+        raise CompileError("action {} needs device {}".format(action[0], device))
+
+
+def analyze(desc):
+    """
+    Checks description and returns (state names, transitions by state,
+    used inputs). Transitions are (folded guards, actions, target index).
+    """
+    states = list(desc["states"])
+    if not states:
+        raise CompileError("automaton has no states")
+    devices = desc.get("devices", [])
+    for device in devices:
+        if device not in DEVICES:
+            raise CompileError("unknown device {}".format(device))
+
+    for action in desc.get("start", []) + desc.get("exit", []):
+        check_action(action, devices)
+
+    compiled = []
+    inputs = set()
+    for name in states:
+        transitions = []
+        for transition in desc["states"][name]:
+            target = transition.get("goto", name)
+            if target not in states:
+                raise CompileError("unknown state {}".format(target))
+            for action in transition.get("do", []):
+                check_action(action, devices)
+            guards = fold_guards(transition.get("if", []))
+            if guards is None:
+                message = "warning: transition {} => {} is never taken"
+                print(message.format(name, target), file=sys.stderr)
+                continue
+            transitions.append((guards, transition.get("do", []), states.index(target)))
+            inputs.update(g[0] for g in guards)
+            if not guards:
+                # Following transitions are never checked.
+                break
+        compiled.append(transitions)
+
+    for name in inputs:
+        if INPUT_DEVICES[name] not in devices:
+            device = INPUT_DEVICES[name]
+            raise CompileError("input {} needs device {}".format(name, device))
+
+    return states, compiled, [i for i in INPUTS if i in inputs]
+
+
+def c_value(value):
+    if value < INT16_MIN or value > INT16_MAX:
+        # Values are compared as int32_t.
+        return "{}L".format(value)
+    return str(value)
+
+
+def c_guard(guard):
+    if guard[1] == "changed":
+        return "(engine->changed & AUTOMATA_INPUT_MASK({}))".format(c_input(guard[0]))
+    return "{} {} {}".format(guard[0], guard[1], c_value(guard[2]))
+
+
+def c_action(action):
+    return ACTIONS[action[0]][3].format(*action[1:])
+
+
+def c_ports(desc):
+    lines = []
+    ports = desc.get("ports", {})
+    for key in PORTS:
+        if key not in ports:
+            continue
+        if key.endswith("motor") or key in ["ultrasonic", "color"]:
+            lines.append("        .{} = PBIO_PORT_ID_{},".format(key, ports[key]))
+        else:
+            lines.append(
+                "        .{} = PBIO_DIRECTION_{},".format(key, ports[key].upper())
+            )
+    return lines
+
+
+def generate_c(desc, source):
+    states, transitions, inputs = analyze(desc)
+    name = desc["name"]
+    actions = desc.get("start", []) + desc.get("exit", [])
+    num_start = len(desc.get("start", []))
+
+    out = []
+    header = "// Generated by tools/automata_compile.py from {}, do not edit."
+    out.append(header.format(source))
+    out.append("")
+    out.append('#include "automata.h"')
+    out.append("")
+
+    # States are used for debug print and checking of range only.
+    out.append("static const automata_state_t {}_states[] = {{".format(name))
+    for state in states:
+        out.append('    {{"{}", {{0, 0}}}},'.format(state))
+    out.append("};")
+    out.append("")
+
+    if actions:
+        out.append("static const automata_action_t {}_actions[] = {{".format(name))
+        for action in actions:
+            args = ", ".join(str(a) for a in action[1:]) or "0"
+            code = "AUTOMATA_ACTION_" + action[0].upper()
+            out.append("    {{{}, {{{}}}}},".format(code, args))
+        out.append("};")
+        out.append("")
+
+    out.append("static bool {}_step(automata_engine_t *engine) {{".format(name))
+    out.append("    automata_ctx_t *ctx = &engine->ctx;")
+    for i in inputs:
+        out.append("    const int32_t {} = engine->values[{}];".format(i, c_input(i)))
+    out.append("")
+    out.append("    switch (engine->state) {")
+    for index, state in enumerate(states):
+        out.append("        case {}: // {}".format(index, state))
+        for guards, do, target in transitions[index]:
+            indent = "            "
+            if guards:
+                condition = " && ".join(c_guard(g) for g in guards)
+                out.append("            if ({}) {{".format(condition))
+                indent += "    "
+            if target != index:
+                out.append("{}engine->state = {};".format(indent, target))
+            # Like interpreted transitions, actions stop at first error.
+            for action in do[:-1]:
+                call = c_action(action)
+                out.append("{}if ({} != PBIO_SUCCESS) {{".format(indent, call))
+                out.append("{}    return true;".format(indent))
+                out.append("{}}}".format(indent))
+            if do:
+                out.append("{}{};".format(indent, c_action(do[-1])))
+            out.append("{}return true;".format(indent))
+            if guards:
+                out.append("            }")
+        if not transitions[index] or transitions[index][-1][0]:
+            out.append("            return false;")
+    out.append("        default:")
+    out.append("            return false;")
+    out.append("    }")
+    out.append("}")
+    out.append("")
+
+    masks = ["AUTOMATA_INPUT_MASK({})".format(c_input(i)) for i in inputs]
+    mask = " | ".join(masks) or "0"
+    devices = ["AUTOMATA_DEVICE_" + d.upper() for d in desc.get("devices", [])]
+    devices = " | ".join(devices) or "0"
+    out.append("const automata_table_t automata_{}_table = {{".format(name))
+    out.append('    .name = "{}",'.format(name))
+    out.append("    .states = {}_states,".format(name))
+    if actions:
+        out.append("    .actions = {}_actions,".format(name))
+    out.append("    .num_states = PBIO_ARRAY_SIZE({}_states),".format(name))
+    initial = states.index(desc.get("initial", states[0]))
+    out.append("    .initial_state = {},".format(initial))
+    out.append("    .priority = {},".format(desc.get("priority", 0)))
+    out.append("    .period = {},".format(desc.get("period", 0)))
+    out.append("    .inputs = {},".format(mask))
+    out.append("    .devices = {},".format(devices))
+    ports = c_ports(desc)
+    if ports:
+        out.append("    .ports = {")
+        out.extend(ports)
+        out.append("    },")
+    out.append("    .start = {{0, {}}},".format(num_start))
+    out.append("    .exit = {{{}, {}}},".format(num_start, len(actions) - num_start))
+    out.append("    .step = {}_step,".format(name))
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+
+def generate_bytecode(desc):
+    states, transitions, inputs = analyze(desc)
+    actions = desc.get("start", []) + desc.get("exit", [])
+    num_start = len(desc.get("start", []))
+    ports = desc.get("ports", {})
+
+    state_records = b""
+    transition_records = b""
+    guard_records = b""
+    num_transitions = 0
+    num_guards = 0
+    for state_transitions in transitions:
+        state_records += struct.pack("<BB", num_transitions, len(state_transitions))
+        for guards, do, target in state_transitions:
+            transition_records += struct.pack(
+                "<BBBBB", num_guards, len(guards), len(actions), len(do), target
+            )
+            for g in guards:
+                if g[2] < INT16_MIN or g[2] > INT16_MAX:
+                    message = "guard value {} does not fit in bytecode"
+                    raise CompileError(message.format(g[2]))
+                index = INPUTS.index(g[0])
+                guard_records += struct.pack("<BBh", index, OPS[g[1]], g[2])
+            actions.extend(do)
+            num_transitions += 1
+            num_guards += len(guards)
+
+    action_records = b""
+    for action in actions:
+        args = list(action[1:]) + [0] * (3 - len(action[1:]))
+        action_records += struct.pack("<Bhhh", ACTIONS[action[0]][0], *args)
+
+    sizes = [len(states), num_transitions, num_guards, len(actions)]
+    if max(sizes) > 255:
+        raise CompileError("automaton is too big for bytecode")
+
+    def port(key):
+        return ord(ports[key]) if key in ports else 0
+
+    def direction(key):
+        return DIRECTIONS[ports.get(key, "clockwise")]
+
+    header = b"AUTB" + struct.pack(
+        "<B4BBBBHH6B4Bxx",
+        1,
+        *sizes,
+        states.index(desc.get("initial", states[0])),
+        desc.get("priority", 0),
+        sum(DEVICES[d] for d in desc.get("devices", [])),
+        desc.get("period", 0),
+        sum(1 << INPUTS.index(i) for i in inputs),
+        port("left_motor"),
+        direction("left_direction"),
+        port("right_motor"),
+        direction("right_direction"),
+        port("ultrasonic"),
+        port("color"),
+        0,
+        num_start,
+        num_start,
+        len(desc.get("exit", [])),
+    )
+    data = header + state_records + transition_records + guard_records + action_records
+    return data + struct.pack("<I", zlib.crc32(data))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile automaton description.")
+    parser.add_argument(
+        "description", type=argparse.FileType("r"), help="JSON description"
+    )
+    parser.add_argument("output", help="output file")
+    parser.add_argument(
+        "--bytecode",
+        action="store_true",
+        help="generate bytecode for upload instead of C source",
+    )
+    args = parser.parse_args()
+
+    desc = json.load(args.description)
+    try:
+        if args.bytecode:
+            with open(args.output, "wb") as f:
+                f.write(generate_bytecode(desc))
+        else:
+            with open(args.output, "w") as f:
+                f.write(generate_c(desc, args.description.name))
+    except CompileError as e:
+        print("error: {}".format(e), file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
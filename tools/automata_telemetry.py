@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2024 The Pybricks Authors
+
+"""
+Automata telemetry decoder.
+
+Decodes binary telemetry frames (see automata/telemetry.h) sent by the hub in
+Pybricks application data events. One event carries one or more frames. Frames
+are printed one per line as CSV:
+
+    time, frame, instance or id, state or value, input values...
+
+Frames which the hub dropped because Bluetooth could not keep up are reported
+as a "dropped" line with their number.
+
+Without a file, the tool connects to the hub and decodes events live. Send 't'
+to the hub (e.g. from Pybricks Code terminal) to turn the telemetry on. Raw
+events can be saved with --save (one hex event per line) and decoded later
+with --file. Saved runs can
+also be replayed by the automata simulator, see lib/pbio/test/sim/scenario.h.
+Runs with "dropped" lines fail there, so save baselines without them.
+"""
+
+import argparse
+import asyncio
+import struct
+import sys
+
+INPUTS = ["distance", "color", "angle_x", "angle_y", "angle_z", "base_done"]
+
+FRAME_SYNC = 0
+FRAME_TICK = 1
+FRAME_FLOAT = 2
+
+EVENT_WRITE_APP_DATA = 2
+
+SYNC_SIZE = 7
+TICK_SIZE = 6
+FLOAT_SIZE = 8
+
+
+def frame_size(data, offset=0):
+    """Size of frame which starts at offset, from its type and inputs mask."""
+    kind = data[offset]
+    if kind == FRAME_SYNC:
+        return SYNC_SIZE
+    if kind == FRAME_TICK:
+        return TICK_SIZE + 2 * bin(data[offset + 5]).count("1")
+    if kind == FRAME_FLOAT:
+        return FLOAT_SIZE
+    raise ValueError("unknown frame type {}".format(kind))
+
+
+class Decoder:
+    """Keeps absolute time between frames."""
+
+    def __init__(self):
+        self.time = None
+
+    def decode(self, frame):
+        """
+        Decodes one frame. Returns dictionary with time and values of the
+        frame, or None for sync frame and frames before the first sync.
+        Sync frame after dropped frames is returned as "dropped" frame.
+        """
+        kind = frame[0]
+        if kind == FRAME_SYNC:
+            self.time, count = struct.unpack_from("<IH", frame, 1)
+            if count:
+                return dict(time=self.time, frame="dropped", count=count)
+            return None
+
+        (delta,) = struct.unpack_from("<H", frame, 1)
+        if self.time is None:
+            return None
+        self.time += delta
+
+        if kind == FRAME_TICK:
+            instance, state, mask = struct.unpack_from("<BBB", frame, 3)
+            names = [name for i, name in enumerate(INPUTS) if mask & (1 << i)]
+            values = struct.unpack_from("<{}h".format(len(names)), frame, 6)
+            return dict(
+                time=self.time,
+                frame="tick",
+                instance=instance,
+                state=state,
+                inputs=dict(zip(names, values)),
+            )
+
+        if kind == FRAME_FLOAT:
+            value_id, value = struct.unpack_from("<Bf", frame, 3)
+            return dict(time=self.time, frame="float", id=value_id, value=value)
+
+        raise ValueError("unknown frame type {}".format(kind))
+
+    def decode_event(self, data):
+        """Splits data of one event into frames and decodes them."""
+        frames = []
+        offset = 0
+        while offset < len(data):
+            size = frame_size(data, offset)
+            if offset + size > len(data):
+                raise ValueError("frame is cut at byte {}".format(offset))
+            frame = self.decode(data[offset : offset + size])
+            if frame:
+                frames.append(frame)
+            offset += size
+        return frames
+
+
+def format_frame(frame):
+    if frame["frame"] == "dropped":
+        fields = [frame["time"], "dropped", frame["count"]]
+    elif frame["frame"] == "tick":
+        values = ["{}={}".format(k, v) for k, v in frame["inputs"].items()]
+        fields = [frame["time"], "tick", frame["instance"], frame["state"]] + values
+    else:
+        fields = [frame["time"], "float", frame["id"], "{:.6g}".format(frame["value"])]
+    return ", ".join(str(f) for f in fields)
+
+
+def decode_file(path):
+    decoder = Decoder()
+    with open(path) as f:
+        for line in f:
+            if not line.strip():
+                continue
+            for frame in decoder.decode_event(bytes.fromhex(line)):
+                print(format_frame(frame))
+
+
+async def decode_live(name, save):
+    from bleak import BleakClient
+    from pybricksdev.ble import find_device
+    from pybricksdev.ble.pybricks import PYBRICKS_COMMAND_EVENT_UUID
+
+    decoder = Decoder()
+
+    def on_event(_, data):
+        if data[0] != EVENT_WRITE_APP_DATA:
+            return
+        if save:
+            print(data[1:].hex(), file=save, flush=True)
+        for frame in decoder.decode_event(data[1:]):
+            print(format_frame(frame))
+
+    device = await find_device(name)
+    async with BleakClient(device) as client:
+        await client.start_notify(PYBRICKS_COMMAND_EVENT_UUID, on_event)
+        print("Connected, press Ctrl+C to stop.", file=sys.stderr)
+        while client.is_connected:
+            await asyncio.sleep(0.5)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode automata telemetry.")
+    parser.add_argument("--file", help="decode saved events (one hex event per line)")
+    parser.add_argument("--name", help="name of the hub to connect to")
+    parser.add_argument(
+        "--save", type=argparse.FileType("w"), help="save raw events as hex lines"
+    )
+    args = parser.parse_args()
+
+    if args.file:
+        decode_file(args.file)
+        return
+
+    try:
+        asyncio.run(decode_live(args.name, args.save))
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+# Copyright (c) 2024 The Pybricks Authors
+
+"""
+Tests of automata telemetry decoder. Run with:
+
+    python3 tools/test_automata_telemetry.py
+"""
+
+import struct
+import unittest
+
+from automata_telemetry import (
+    FRAME_FLOAT,
+    FRAME_SYNC,
+    FRAME_TICK,
+    Decoder,
+    format_frame,
+    frame_size,
+)
+
+
+def sync(time, dropped=0):
+    return struct.pack("<BIH", FRAME_SYNC, time, dropped)
+
+
+def tick(delta, instance, state, mask, *values):
+    return struct.pack(
+        "<BHBBB{}h".format(len(values)), FRAME_TICK, delta, instance, state, mask, *values
+    )
+
+
+def value(delta, value_id, number):
+    return struct.pack("<BHBf", FRAME_FLOAT, delta, value_id, number)
+
+
+class TestDecoder(unittest.TestCase):
+    def test_frame_size(self):
+        self.assertEqual(frame_size(sync(0)), 7)
+        self.assertEqual(frame_size(tick(0, 0, 0, 0)), 6)
+        self.assertEqual(frame_size(tick(0, 0, 0, 0b101, 1, 2)), 10)
+        self.assertEqual(frame_size(value(0, 0, 1.0)), 8)
+        with self.assertRaises(ValueError):
+            frame_size(bytes([7, 0, 0, 0, 0, 0]))
+
+    def test_tick(self):
+        decoder = Decoder()
+        self.assertEqual(decoder.decode_event(sync(1000)), [])
+        frames = decoder.decode_event(tick(10, 1, 2, 0b100001, -5, 1))
+        self.assertEqual(
+            frames,
+            [
+                dict(
+                    time=1010,
+                    frame="tick",
+                    instance=1,
+                    state=2,
+                    inputs=dict(distance=-5, base_done=1),
+                )
+            ],
+        )
+        self.assertEqual(
+            format_frame(frames[0]), "1010, tick, 1, 2, distance=-5, base_done=1"
+        )
+
+    def test_float(self):
+        decoder = Decoder()
+        (frame,) = decoder.decode_event(sync(50) + value(5, 3, 0.5))
+        self.assertEqual(frame, dict(time=55, frame="float", id=3, value=0.5))
+        self.assertEqual(format_frame(frame), "55, float, 3, 0.5")
+
+    def test_frames_before_sync(self):
+        decoder = Decoder()
+        self.assertEqual(decoder.decode_event(tick(10, 0, 0, 1, 100)), [])
+        self.assertEqual(len(decoder.decode_event(sync(0) + tick(10, 0, 0, 1, 100))), 1)
+
+    def test_event_with_more_frames(self):
+        decoder = Decoder()
+        data = sync(100) + tick(0, 0, 1, 1, 200) + tick(10, 1, 0, 1, 300)
+        frames = decoder.decode_event(data)
+        self.assertEqual([f["time"] for f in frames], [100, 110])
+        self.assertEqual([f["instance"] for f in frames], [0, 1])
+        self.assertEqual([f["inputs"]["distance"] for f in frames], [200, 300])
+
+    def test_time_is_kept_between_events(self):
+        decoder = Decoder()
+        decoder.decode_event(sync(100))
+        decoder.decode_event(tick(10, 0, 0, 0))
+        (frame,) = decoder.decode_event(tick(20, 0, 0, 0))
+        self.assertEqual(frame["time"], 130)
+
+    def test_dropped(self):
+        decoder = Decoder()
+        decoder.decode_event(sync(100) + tick(10, 0, 0, 0))
+        frames = decoder.decode_event(sync(200, 3) + tick(10, 0, 0, 0))
+        self.assertEqual(frames[0], dict(time=200, frame="dropped", count=3))
+        self.assertEqual(format_frame(frames[0]), "200, dropped, 3")
+        self.assertEqual(frames[1]["time"], 210)
+
+    def test_cut_frame(self):
+        decoder = Decoder()
+        with self.assertRaises(ValueError):
+            decoder.decode_event(sync(0) + tick(10, 0, 0, 1, 100)[:-1])
+
+
+if __name__ == "__main__":
+    unittest.main()